@@ -0,0 +1,922 @@
+//
+//  DNRCoreBenchmark.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-12.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+/*
+ Micro-benchmark of the portable C core, for machines without Xcode,
+ Foundation or a GPU (e.g., Linux build servers). It is NOT the engine
+ benchmark: there are no nodes, scenes or tile maps here (for those, run
+ DNRBenchmark's -runSuite from an Objective-C host; see DNRBenchmark.h).
+
+ Each case is a set of solid sprites that only exist as transform store
+ entries (flat, or in deep parent/child chains). Every frame measures the C
+ kernels the engine's frame is built on, in a fixed order:
+
+    update      transformStoreSetLocalTranslation() on the moving entries
+    transform   transformStoreUpdateWorldTransforms()
+    submission  For every sprite, in creation order (opaque ones first):
+                culling, quad transform, spriteBatchAppendQuad() (through
+                DNRGLCache and glDispatch); spriteBatchFlush()
+    present     softwareRasterizerFinish()
+
+ The GL calls go to the null backend (kernel cost only), to the recorder
+ (forwarding to the null backend) or to the software rasterizer.
+
+ Usage:
+
+    DNRCoreBenchmark [-b null|recording|software] [-w width] [-h height]
+                     [-f frames] [-u warm-up frames] [-t threads]
+                     [-m key=value]... [-o report.json]
+
+ The report (format "DNRCoreBenchmark", otherwise laid out as DNRBenchmark's,
+ with only the phases above) goes to standard output unless -o is given.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+
+#include "DNRBase.h"
+#include "DNRGlobals.h"
+#include "DNRMatrix.h"
+#include "DNRTransformStore.h"
+#include "DNRSpriteBatch.h"
+#include "DNRGLCache.h"
+#include "DNRGLDispatch.h"
+#include "DNRGLRecorder.h"
+#include "DNRSoftwareRasterizer.h"
+#include "DNROpenGLUtilities.h"
+#include "DNRProfiler.h"
+
+
+#define FlatSpriteCount         10000u
+#define DeepHierarchyDepth      50u
+#define DeepHierarchyChainCount 20u
+
+#define GridPitch               12.0f   // Points between flat sprites
+#define SpriteSide              8.0f
+
+#define SpriteBatchCapacity     4096u   // Same as DNRSoftwareRenderer
+
+#define MetadataCapacity        32u
+
+
+typedef enum {
+
+    BackendNull = 0,                    // Discarded (kernel cost only)
+    BackendRecording,                   // Recorded, then discarded
+    BackendSoftware                     // Rasterized on the CPU
+
+}Backend;
+
+
+static const char* const backendNames[] = { "null", "recording", "software" };
+
+// The profiler phases measured, and their report keys
+static const ProfilerPhase measuredPhases[] = {
+    ProfilerPhaseTick,
+    ProfilerPhaseTransforms,
+    ProfilerPhaseRender,
+    ProfilerPhasePresent,
+};
+
+static const char* const phaseKeys[] = {
+    "update",
+    "transform",
+    "submission",
+    "present",
+};
+
+#define MeasuredPhaseCount      (sizeof(measuredPhases)/sizeof(measuredPhases[0]))
+
+
+// Unit quad, as DNRSprite's solid (untextured) sprites
+static const VertexData2D unitQuadVertices[4] = {
+    { { -0.5f, +0.5f }, { 0.0f, 0.0f } },     // Top Left
+    { { -0.5f, -0.5f }, { 0.0f, 1.0f } },     // Bottom Left
+    { { +0.5f, +0.5f }, { 1.0f, 0.0f } },     // Top Right
+    { { +0.5f, -0.5f }, { 1.0f, 1.0f } }      // Bottom Right
+};
+
+
+// .............................................................................
+
+/*
+ A solid sprite of SpriteSide x SpriteSide points.
+ */
+typedef struct tSprite {
+
+    TransformHandle handle;
+    TransformHandle parent;         // TransformHandleNone: top level
+    Color4f         color;
+    int             needsBlending;
+
+}Sprite;
+
+
+/*
+ The sprites (in creation order: parents before children), and those moved
+ on every frame.
+ */
+typedef struct tWorkload {
+
+    Sprite*     sprites;
+    uint32_t    spriteCount;
+    uint32_t    spriteCapacity;
+
+    uint32_t*   movingSprites;
+    Vertex2f*   origins;
+    uint32_t    movingSpriteCount;
+
+    double      time;
+
+}Workload;
+
+
+typedef struct tHost {
+
+    Backend             backend;
+    GLsizei             width;
+    GLsizei             height;
+    double              timeStep;
+    unsigned            warmUpFrameCount;
+    unsigned            frameCount;
+
+    SoftwareRasterizer* rasterizer;
+    SpriteBatch*        batch;
+    GLRecorder*         recorder;
+
+    const char*         metadataKeys[MetadataCapacity];
+    const char*         metadataValues[MetadataCapacity];
+    unsigned            metadataCount;
+
+}Host;
+
+
+#pragma mark - Workloads
+
+
+static void workloadDestroy(Workload* workload) {
+
+    if (!workload) {
+        return;
+    }
+
+    // Children before parents (the store requires unparented entries)
+    for (uint32_t i = workload->spriteCount; i > 0; i--) {
+
+        Sprite* sprite = &workload->sprites[i - 1];
+
+        if (sprite->parent != TransformHandleNone) {
+            transformStoreDetach(sprite->handle);
+        }
+        transformStoreDestroyEntry(sprite->handle);
+    }
+
+    free(workload->sprites);
+    free(workload->movingSprites);
+    free(workload->origins);
+    free(workload);
+}
+
+
+static Workload* workloadCreate(uint32_t spriteCapacity) {
+
+    Workload* workload = calloc(1, sizeof(Workload));
+
+    if (!workload) {
+        return NULL;
+    }
+
+    workload->spriteCapacity = spriteCapacity;
+    workload->sprites        = calloc(spriteCapacity, sizeof(Sprite));
+    workload->movingSprites  = calloc(spriteCapacity, sizeof(uint32_t));
+    workload->origins        = calloc(spriteCapacity, sizeof(Vertex2f));
+
+    if (!workload->sprites || !workload->movingSprites || !workload->origins) {
+        workloadDestroy(workload);
+        return NULL;
+    }
+
+    return workload;
+}
+
+
+/*
+ Adds a sprite at position (points, relative to parent, which is the index of
+ a sprite added before, or -1). Returns its index.
+ */
+static uint32_t workloadAddSprite(Workload* workload, int64_t parent, TransformHandle previousSibling, Color4f color, float x, float y) {
+
+    uint32_t index  = workload->spriteCount++;
+    Sprite*  sprite = &workload->sprites[index];
+
+    sprite->handle        = transformStoreCreateEntry();
+    sprite->parent        = (parent >= 0) ? workload->sprites[parent].handle : TransformHandleNone;
+    sprite->color         = color;
+    sprite->needsBlending = (color.a < 1.0f);
+
+    if (sprite->parent != TransformHandleNone) {
+        transformStoreAttach(sprite->handle, sprite->parent, previousSibling);
+    }
+
+    transformStoreSetLocalTranslation(sprite->handle, x * screenScaleFactor, y * screenScaleFactor);
+
+    return index;
+}
+
+
+static void workloadAddMovingSprite(Workload* workload, uint32_t index) {
+
+    const Affine2f* local = transformStoreLocalTransform(workload->sprites[index].handle);
+
+    workload->origins[workload->movingSpriteCount].x = local->tx / screenScaleFactor;
+    workload->origins[workload->movingSpriteCount].y = local->ty / screenScaleFactor;
+
+    workload->movingSprites[workload->movingSpriteCount++] = index;
+}
+
+
+/*
+ Spreads depths over [0, 1) in creation order (set once: there is no draw
+ order to maintain).
+ */
+static void workloadAssignDepths(Workload* workload) {
+
+    GLfloat step = 1.0f / workload->spriteCount;
+
+    for (uint32_t i = 0; i < workload->spriteCount; i++) {
+        transformStoreSetZ(workload->sprites[i].handle, i * step);
+    }
+}
+
+
+/*
+ spriteCount top level sprites, laid out on a grid larger than the surface
+ (half of them translucent). All of them move.
+ */
+static Workload* flatWorkloadCreate(uint32_t spriteCount) {
+
+    Workload* workload = workloadCreate(spriteCount);
+
+    if (!workload) {
+        return NULL;
+    }
+
+    uint32_t columnCount = (uint32_t)ceil(sqrt((double)spriteCount));
+    float    halfWidth   = 0.5f*GridPitch*columnCount;
+
+    for (uint32_t i = 0; i < spriteCount; i++) {
+
+        // (Every other sprite needs blending)
+        Color4f color = Color4fMake((i % 7)/6.0f, (i % 5)/4.0f, (i % 3)/2.0f, (i % 2) ? 0.5f : 1.0f);
+
+        uint32_t sprite = workloadAddSprite(workload, -1, TransformHandleNone, color,
+                                            GridPitch*(i % columnCount) - halfWidth,
+                                            GridPitch*(i / columnCount) - halfWidth);
+        workloadAddMovingSprite(workload, sprite);
+    }
+
+    workloadAssignDepths(workload);
+
+    return workload;
+}
+
+
+/*
+ chainCount chains of depth sprites, each the parent of the next. The root of
+ each chain moves (invalidating all of it).
+ */
+static Workload* deepWorkloadCreate(uint32_t depth, uint32_t chainCount) {
+
+    Workload* workload = workloadCreate(depth*chainCount);
+
+    if (!workload) {
+        return NULL;
+    }
+
+    for (uint32_t chain = 0; chain < chainCount; chain++) {
+
+        int64_t parent = -1;
+
+        for (uint32_t level = 0; level < depth; level++) {
+
+            Color4f color = Color4fMake(1.0f, level/(GLfloat)depth, 0.0f, 1.0f);
+
+            if (level == 0) {
+                // (Chains side by side, across the surface)
+                parent = workloadAddSprite(workload, -1, TransformHandleNone, color, GridPitch*chain - 0.5f*GridPitch*chainCount, 0.0f);
+                workloadAddMovingSprite(workload, (uint32_t)parent);
+            }
+            else{
+                // (Only child)
+                parent = workloadAddSprite(workload, parent, TransformHandleNone, color, 0.0f, 2.0f);
+            }
+        }
+    }
+
+    workloadAssignDepths(workload);
+
+    return workload;
+}
+
+
+/*
+ A small circle around each origin.
+ */
+static void workloadUpdate(Workload* workload, double dt) {
+
+    workload->time += dt;
+
+    float dx = 4.0f*cos(workload->time);
+    float dy = 4.0f*sin(workload->time);
+
+    for (uint32_t i = 0; i < workload->movingSpriteCount; i++) {
+
+        TransformHandle handle = workload->sprites[workload->movingSprites[i]].handle;
+
+        transformStoreSetLocalTranslation(handle,
+                                          (workload->origins[i].x + dx) * screenScaleFactor,
+                                          (workload->origins[i].y + dy) * screenScaleFactor);
+    }
+}
+
+
+#pragma mark - Frame
+
+
+/*
+ Culls the sprite against the visible box (world pixels: x0, y0, x1, y1), and
+ appends its quad to the batch. Returns 0 if culled.
+ */
+static int submitSprite(const Sprite* sprite, SpriteBatch* batch, const GLfloat* visibleBox) {
+
+    // 1. Modelview (in pixels): unit quad scaled to the sprite's size
+
+    Affine2f scale;
+    Affine2f modelview;
+
+    affine2f_LoadScale(SpriteSide * screenScaleFactor, SpriteSide * screenScaleFactor, &scale);
+    affine2f_MultiplyAffine2f(transformStoreWorldTransform(sprite->handle), &scale, &modelview);
+
+    // 2. Skip sprites that lie entirely off screen
+
+    GLfloat box[4] = { -0.5f, -0.5f, +0.5f, +0.5f };
+
+    affine2f_TransformAABB(&modelview, box, box);
+
+    if (box[2] < visibleBox[0] || box[0] > visibleBox[2] ||
+        box[3] < visibleBox[1] || box[1] > visibleBox[3]) {
+        return 0;
+    }
+
+    // 3. Transform to world coordinates and append
+
+    BatchVertexData2D vertices[4];
+
+    float    alpha = transformStoreAlpha(sprite->handle);
+    GLfloat  z     = transformStoreZ(sprite->handle);
+    Color4ub color = Color4ubFromColor4f(Color4fMake(sprite->color.r * alpha,
+                                                     sprite->color.g * alpha,
+                                                     sprite->color.b * alpha,
+                                                     sprite->color.a * alpha));
+
+    affine2f_TransformVec2Array(&modelview,
+                                &(unitQuadVertices[0].position), sizeof(VertexData2D),
+                                &(vertices[0].position),         sizeof(BatchVertexData2D),
+                                4);
+
+    for (int i = 0; i < 4; i++) {
+
+        vertices[i].position.z = z;
+
+        vertices[i].texCoords  = unitQuadVertices[i].texCoords;
+        vertices[i].color      = color;
+    }
+
+    spriteBatchAppendQuad(batch, spriteBatchWhiteTexture(batch), spriteBatchDefaultProgram(batch), vertices);
+
+    return 1;
+}
+
+
+static void tick(Host* host, Workload* workload) {
+
+    profilerBeginFrame();
+
+    // 1. Update
+
+    profilerBegin(ProfilerPhaseTick);
+
+    workloadUpdate(workload, host->timeStep);
+
+    profilerEnd(ProfilerPhaseTick);
+
+    bindFramebuffer(0);
+    clearColor4f(0.0f, 0.0f, 0.0f, 1.0f);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // 2. World transforms, in one linear pass
+
+    profilerBegin(ProfilerPhaseTransforms);
+
+    transformStoreUpdateWorldTransforms();
+
+    profilerEnd(ProfilerPhaseTransforms);
+
+    // 3. Submission: opaque sprites first, then translucent ones
+
+    GLfloat visibleBox[4] = {
+        -0.5f*host->width, -0.5f*host->height,
+        +0.5f*host->width, +0.5f*host->height
+    };
+
+    uint64_t culledCount = 0;
+
+    profilerBegin(ProfilerPhaseRender);
+
+    spriteBatchBegin(host->batch);
+
+    for (int blending = 0; blending < 2; blending++) {
+
+        spriteBatchSetBlendingEnabled(host->batch, blending ? GL_TRUE : GL_FALSE);
+
+        for (uint32_t i = 0; i < workload->spriteCount; i++) {
+
+            const Sprite* sprite = &workload->sprites[i];
+
+            if (sprite->needsBlending == blending && !submitSprite(sprite, host->batch, visibleBox)) {
+                culledCount++;
+            }
+        }
+    }
+
+    spriteBatchFlush(host->batch);
+
+    profilerEnd(ProfilerPhaseRender);
+    profilerCount(ProfilerCounterNodesCulled, culledCount);
+
+    // 4. Present
+
+    profilerBegin(ProfilerPhasePresent);
+
+    softwareRasterizerFinish(host->rasterizer);
+
+    profilerEnd(ProfilerPhasePresent);
+
+    profilerEndFrame();
+    glCacheEndFrame();
+}
+
+
+#pragma mark - Host
+
+
+static void hostDestroy(Host* host) {
+
+    if (host->recorder) {
+        glRecorderDestroy(host->recorder);
+    }
+    if (host->batch) {
+        spriteBatchDestroy(host->batch);
+    }
+
+    glCacheMakeCurrent(NULL);
+    glCacheContextRemove(host);
+
+    if (host->rasterizer) {
+        glDispatchSetBackend(NULL);
+        softwareRasterizerMakeCurrent(NULL);
+        softwareRasterizerDestroy(host->rasterizer);
+    }
+}
+
+
+/*
+ The rasterizer stands in for the context, with the sprite batch program and
+ the engine's default OpenGL state. Returns 0 on failure.
+ */
+static int hostInitialize(Host* host, unsigned threadCount) {
+
+    host->rasterizer = softwareRasterizerCreate(host->width, host->height, threadCount);
+
+    if (!host->rasterizer) {
+        return 0;
+    }
+
+    softwareRasterizerMakeCurrent(host->rasterizer);
+    glDispatchSetBackend(softwareRasterizerBackend());
+    glCacheMakeCurrent(host);
+
+    GLuint program = softwareRasterizerCreateProgram(SoftwareProgramSpriteBatch);
+
+    if (program == 0) {
+        return 0;
+    }
+
+    if (!(host->batch = spriteBatchCreate(program, SpriteBatchCapacity))) {
+        return 0;
+    }
+
+    if (host->backend == BackendRecording) {
+        if (!(host->recorder = glRecorderCreate())) {
+            return 0;
+        }
+    }
+
+    glDispatch.enable(GL_DEPTH_TEST);
+    glDispatch.enable(GL_BLEND);
+    glDispatch.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    viewPort(0, 0, host->width, host->height);
+
+    useProgram(program);
+    setOrthographicProjection(program,
+                              glDispatch.getUniformLocation(program, "Projection"),
+                              -0.5f*host->width,  +0.5f*host->width,
+                              -0.5f*host->height, +0.5f*host->height,
+                              -1.0f, +1.0f);
+    return 1;
+}
+
+
+static unsigned measuredFrameCount(const Host* host) {
+
+    unsigned count = host->frameCount;
+
+    if (count > ProfilerFrameCapacity) {
+        count = ProfilerFrameCapacity;
+    }
+    return (count > 0) ? count : 1;
+}
+
+
+#pragma mark - Report
+
+
+static void writeString(FILE* file, const char* string) {
+
+    fputc('"', file);
+
+    for (const unsigned char* c = (const unsigned char *)string; *c; c++) {
+
+        switch (*c) {
+            case '"':
+                fputs("\\\"", file);
+                break;
+
+            case '\\':
+                fputs("\\\\", file);
+                break;
+
+            case '\n':
+                fputs("\\n", file);
+                break;
+
+            case '\t':
+                fputs("\\t", file);
+                break;
+
+            default:
+                if (*c < 0x20) {
+                    fprintf(file, "\\u%04x", *c);
+                }
+                else{
+                    fputc(*c, file);
+                }
+                break;
+        }
+    }
+
+    fputc('"', file);
+}
+
+
+static void writeStats(FILE* file, const char* indent, const char* key, ProfilerStats stats, int last) {
+
+    fprintf(file, "%s\"%s\" : { \"p50\" : %llu, \"p99\" : %llu, \"mean\" : %llu, \"max\" : %llu }%s\n",
+            indent,
+            key,
+            (unsigned long long)stats.p50,
+            (unsigned long long)stats.p99,
+            (unsigned long long)stats.mean,
+            (unsigned long long)stats.max,
+            last ? "" : ",");
+}
+
+
+/*
+ Runs one case, and writes its entry in the report.
+ */
+static void runCase(Host* host, const char* name, Workload* workload, FILE* file, int first) {
+
+    // 1. Install the backend
+
+    if (host->backend == BackendNull) {
+        glDispatchSetBackend(glDispatchNullBackend());
+    }
+    else if (host->backend == BackendRecording) {
+        glRecorderReset(host->recorder);
+        glRecorderStart(host->recorder, NULL);
+    }
+
+    // 2. Warm up (buffers grow, caches fill)
+
+    for (unsigned i = 0; i < host->warmUpFrameCount; i++) {
+        tick(host, workload);
+    }
+
+    // 3. Measure
+
+    unsigned frameCount = measuredFrameCount(host);
+
+    profilerSetEnabled(0);
+    profilerSetEnabled(1);      // (Starts over)
+
+    glDispatchResetCounters();
+    glCacheResetStats();
+
+    if (host->recorder) {
+        glRecorderReset(host->recorder);
+    }
+
+    for (unsigned i = 0; i < frameCount; i++) {
+
+        tick(host, workload);
+
+        if (host->recorder) {
+            glRecorderMarkFrame(host->recorder);
+        }
+    }
+
+    // 4. Collect
+
+    fprintf(file, "%s    {\n", first ? "" : ",\n");
+    fprintf(file, "      \"name\" : ");
+    writeString(file, name);
+    fprintf(file, ",\n");
+    fprintf(file, "      \"spriteCount\" : %u,\n", workload->spriteCount);
+
+    writeStats(file, "      ", "frame", profilerFrameStats(), 0);
+
+    fprintf(file, "      \"phases\" : {\n");
+
+    for (unsigned i = 0; i < MeasuredPhaseCount; i++) {
+        writeStats(file, "        ", phaseKeys[i], profilerPhaseStats(measuredPhases[i]), (i == MeasuredPhaseCount - 1));
+    }
+
+    fprintf(file, "      },\n");
+    fprintf(file, "      \"counters\" : {\n");
+
+    for (int counter = 0; counter < ProfilerCounterCount; counter++) {
+        writeStats(file, "        ",
+                   profilerCounterName((ProfilerCounter)counter),
+                   profilerCounterStats((ProfilerCounter)counter),
+                   (counter == ProfilerCounterCount - 1));
+    }
+
+    fprintf(file, "      }");
+
+    if (host->backend != BackendSoftware) {
+        // (Only the null backend counts)
+        GLDispatchCounters gl = glDispatchCounters();
+
+        fprintf(file, ",\n      \"gl\" : { \"calls\" : %llu, \"drawCalls\" : %llu, \"elementCount\" : %llu, \"stateChanges\" : %llu, \"bytesUploaded\" : %llu",
+                (unsigned long long)(gl.calls / frameCount),
+                (unsigned long long)(gl.drawCalls / frameCount),
+                (unsigned long long)(gl.elementCount / frameCount),
+                (unsigned long long)(gl.stateChanges / frameCount),
+                (unsigned long long)(gl.bytesUploaded / frameCount));
+
+        if (host->recorder) {
+            size_t size = 0;
+            glRecorderBytes(host->recorder, &size);
+
+            fprintf(file, ", \"bytesRecorded\" : %llu", (unsigned long long)(size / frameCount));
+        }
+
+        fprintf(file, " }");
+    }
+
+#if DNR_GLCACHE_STATS
+    // (The frame's counts are rolled over by tick())
+    GLCacheStats cache = glCacheCumulativeStats();
+
+    fprintf(file, ",\n      \"glCache\" : { \"hits\" : %llu, \"misses\" : %llu }",
+            (unsigned long long)(cache.total.hits / frameCount),
+            (unsigned long long)(cache.total.misses / frameCount));
+#endif
+
+    fprintf(file, "\n    }");
+
+    // 5. Restore
+
+    profilerSetEnabled(0);
+
+    if (host->backend == BackendRecording) {
+        glRecorderStop(host->recorder);
+    }
+    glDispatchSetBackend(softwareRasterizerBackend());
+
+    // (The cache tracked the state of the other backend)
+    glCacheInvalidate();
+}
+
+
+/*
+ Runs the synthetic cases and writes the whole report. Returns 0 on failure.
+ */
+static int runSuite(Host* host, FILE* file) {
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"format\" : \"DNRCoreBenchmark\",\n");
+    fprintf(file, "  \"version\" : 1,\n");
+    fprintf(file, "  \"timeUnit\" : \"ns\",\n");
+    fprintf(file, "  \"backend\" : \"%s\",\n", backendNames[host->backend]);
+    fprintf(file, "  \"width\" : %d,\n", (int)host->width);
+    fprintf(file, "  \"height\" : %d,\n", (int)host->height);
+    fprintf(file, "  \"timeStep\" : %.17g,\n", host->timeStep);
+    fprintf(file, "  \"warmUpFrames\" : %u,\n", host->warmUpFrameCount);
+    fprintf(file, "  \"frames\" : %u,\n", measuredFrameCount(host));
+    fprintf(file, "  \"metadata\" : {");
+
+    for (unsigned i = 0; i < host->metadataCount; i++) {
+
+        fprintf(file, "%s\n    ", i ? "," : "");
+        writeString(file, host->metadataKeys[i]);
+        fprintf(file, " : ");
+        writeString(file, host->metadataValues[i]);
+    }
+
+    fprintf(file, "%s},\n", host->metadataCount ? "\n  " : "");
+    fprintf(file, "  \"cases\" : [\n");
+
+    Workload* workload = flatWorkloadCreate(FlatSpriteCount);
+
+    if (!workload) {
+        return 0;
+    }
+    runCase(host, "flat_10k", workload, file, 1);
+    workloadDestroy(workload);
+
+    workload = deepWorkloadCreate(DeepHierarchyDepth, DeepHierarchyChainCount);
+
+    if (!workload) {
+        return 0;
+    }
+    runCase(host, "deep_50", workload, file, 0);
+    workloadDestroy(workload);
+
+    fprintf(file, "\n  ]\n}\n");
+
+    return (ferror(file) == 0);
+}
+
+
+#pragma mark - Main
+
+
+static void printUsage(const char* program) {
+
+    fprintf(stderr,
+            "usage: %s [-b null|recording|software] [-w width] [-h height]\n"
+            "       %*s [-f frames] [-u warm-up frames] [-t threads]\n"
+            "       %*s [-m key=value]... [-o report.json]\n",
+            program, (int)strlen(program), "", (int)strlen(program), "");
+}
+
+
+int main(int argc, char* argv[]) {
+
+    Host host;
+
+    memset(&host, 0, sizeof(host));
+
+    host.backend          = BackendNull;
+    host.width            = 1024;
+    host.height           = 768;
+    host.timeStep         = 1.0/60.0;
+    host.warmUpFrameCount = 60;
+    host.frameCount       = ProfilerFrameCapacity;
+
+    unsigned    threadCount = 0;
+    const char* outputPath  = NULL;
+    int         option;
+
+    while ((option = getopt(argc, argv, "b:w:h:f:u:t:m:o:")) != -1) {
+
+        switch (option) {
+            case 'b':
+                if (strcmp(optarg, "null") == 0) {
+                    host.backend = BackendNull;
+                }
+                else if (strcmp(optarg, "recording") == 0) {
+                    host.backend = BackendRecording;
+                }
+                else if (strcmp(optarg, "software") == 0) {
+                    host.backend = BackendSoftware;
+                }
+                else{
+                    printUsage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'w':
+                host.width = (GLsizei)atoi(optarg);
+                break;
+
+            case 'h':
+                host.height = (GLsizei)atoi(optarg);
+                break;
+
+            case 'f':
+                host.frameCount = (unsigned)atoi(optarg);
+                break;
+
+            case 'u':
+                host.warmUpFrameCount = (unsigned)atoi(optarg);
+                break;
+
+            case 't':
+                threadCount = (unsigned)atoi(optarg);
+                break;
+
+            case 'm': {
+                char* separator = strchr(optarg, '=');
+
+                if (!separator || host.metadataCount == MetadataCapacity) {
+                    printUsage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                *separator = '\0';
+
+                host.metadataKeys[host.metadataCount]   = optarg;
+                host.metadataValues[host.metadataCount] = separator + 1;
+                host.metadataCount++;
+                break;
+            }
+
+            case 'o':
+                outputPath = optarg;
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind < argc || host.width <= 0 || host.height <= 0) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!hostInitialize(&host, threadCount)) {
+        fprintf(stderr, "%s: failed to set up the software rasterizer\n", argv[0]);
+        hostDestroy(&host);
+        return EXIT_FAILURE;
+    }
+
+    // Written next to the destination, and moved over it when complete
+
+    char  temporaryPath[4096];
+    FILE* file = stdout;
+
+    if (outputPath) {
+        snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", outputPath);
+
+        if (!(file = fopen(temporaryPath, "w"))) {
+            perror(temporaryPath);
+            hostDestroy(&host);
+            return EXIT_FAILURE;
+        }
+    }
+
+    int succeeded = runSuite(&host, file);
+
+    if (outputPath) {
+        succeeded = (fclose(file) == 0) && succeeded;
+
+        if (succeeded && rename(temporaryPath, outputPath) != 0) {
+            perror(outputPath);
+            succeeded = 0;
+        }
+        if (!succeeded) {
+            remove(temporaryPath);
+        }
+    }
+
+    if (!succeeded) {
+        fprintf(stderr, "%s: failed to write the report\n", argv[0]);
+    }
+
+    hostDestroy(&host);
+
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -51,6 +51,16 @@
 
 - (void) loadTilemap {
 
+    // Prefer the compiled map (see scripts/compile_tilemap.py), if bundled:
+    
+    NSString* compiledPath = [[NSBundle mainBundle] pathForResource:@"Stage06" ofType:@"tilemap"];
+    
+    if (compiledPath) {
+        _map = [[TileMap alloc] initWithContentsOfFile:compiledPath
+                                            dataSource:self];
+        return;
+    }
+    
     NSString* path = [[NSBundle mainBundle] pathForResource:@"Stage06" ofType:@"plist"];
     
     NSDictionary* mapDictionary = [NSDictionary dictionaryWithContentsOfFile:path];
@@ -9,7 +9,9 @@
 #ifndef DNREngineTest_DNRBase_h
 #define DNREngineTest_DNRBase_h
 
+#ifdef __APPLE__
 #include "TargetConditionals.h"
+#endif
 
 
 #include "Platform.h"       // Platform-specific constants.
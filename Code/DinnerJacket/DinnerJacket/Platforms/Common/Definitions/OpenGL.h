@@ -9,7 +9,9 @@
 #ifndef OpenGL_h
 #define OpenGL_h
 
+#ifdef __APPLE__
 #include "TargetConditionals.h"
+#endif
 
 /** 
  Imports the appropriate headers so that the basic OpenGL types (GLfloat,
@@ -26,6 +28,13 @@
 #include <OpenGL/gl3.h>
 #include <OpenGL/glu.h>
 
+#else
+
+// Other platforms (e.g., Linux): only the portable C parts are built there
+// (see CMakeLists.txt), against the core profile.
+#define GL_GLEXT_PROTOTYPES 1
+#include <GL/glcorearb.h>
+
 #endif
 
 
@@ -13,7 +13,9 @@
  Platform-dependent definitions (TODO: Implement Mac support).
  */
 
+#ifdef __APPLE__
 #include "TargetConditionals.h"
+#endif
 
 #if TARGET_OS_IPHONE || TARGET_IPHONE_SIMULATOR
 
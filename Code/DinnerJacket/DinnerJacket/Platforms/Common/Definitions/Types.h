@@ -94,6 +94,18 @@ typedef struct tVertexData2D {
 } VertexData2D;
 
 
+/**
+ Encapsulates all attributes for one vertex of a batched 2D sprite. The position
+ is already transformed to world coordinates (pixels), and the z component holds
+ the sprite's depth.
+ */
+typedef struct tBatchVertexData2D {
+    Vertex3f                position;
+    TextureCoordinates      texCoords;
+    Color4ub                color;
+} BatchVertexData2D;
+
+
 /**
  Creates an instance of Color4f from the given components. Akin to CGRectMake() etc.
  */
@@ -108,6 +120,22 @@ static inline Color4f Color4fMake(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
 }
 
 
+/**
+ Converts a color from float components to unsigned byte components (clamped to
+ the [0, 1] range, and rounded to nearest).
+ */
+static inline Color4ub Color4ubFromColor4f(Color4f color) {
+    Color4ub result;
+    
+    result.r = (GLubyte)(255.0f*(color.r > 1.0f ? 1.0f : (color.r < 0.0f ? 0.0f : color.r)) + 0.5f);
+    result.g = (GLubyte)(255.0f*(color.g > 1.0f ? 1.0f : (color.g < 0.0f ? 0.0f : color.g)) + 0.5f);
+    result.b = (GLubyte)(255.0f*(color.b > 1.0f ? 1.0f : (color.b < 0.0f ? 0.0f : color.b)) + 0.5f);
+    result.a = (GLubyte)(255.0f*(color.a > 1.0f ? 1.0f : (color.a < 0.0f ? 0.0f : color.a)) + 0.5f);
+    
+    return result;
+}
+
+
 /** 
  Blends two colors proportionally.
  */
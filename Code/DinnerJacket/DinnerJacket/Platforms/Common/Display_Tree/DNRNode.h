@@ -18,11 +18,20 @@
 
 #endif
 
+#import "DNRSpriteBatch.h"
+#import "DNRMatrix.h"       // Affine2f
+
 
 #define DNRNodeTagNotSet   -1
 
 
 @class DNRAction;
+@class DNRNode;
+
+/// Function called by -enumerateChildrenUsingFunction:context: on each child.
+/// Return 0 to stop the enumeration.
+typedef int (*DNRNodeVisitorFunction)(DNRNode* child, void* context);
+
 @class DNRPointerInput;
 
 /// Global variable that keeps track of live instances of the class/subclasses
@@ -43,9 +52,15 @@ extern NSInteger nodeInstanceCount;
 
 
 /// The node's children. Children are transformed according to the parent.
+/// (Returns a copy; when traversing every frame, use -childCount and 
+/// -childAtIndex: instead)
 @property (nonatomic, readonly) NSArray *children;
 
 
+/// Number of children (does not copy the children array).
+@property (nonatomic, readonly) NSUInteger childCount;
+
+
 /// The node's position, in the parent node's coordinate system.
 @property (nonatomic, readwrite) CGPoint position;
 
@@ -54,15 +69,18 @@ extern NSInteger nodeInstanceCount;
 @property (nonatomic, readwrite) CGPoint globalPosition;
 
 
-/// The node's transformation matrix (4x4), in the parent node's coordinate
-/// system.
-@property (nonatomic, readwrite) GLfloat* localTransform;
+/// The node's transformation (2D affine, in pixels), in the parent node's
+/// coordinate system.
+@property (nonatomic, readwrite) Affine2f localAffineTransform;
 
 
-/// The node's transformation matrix (4x4), in the global coordinate system.
-/// Effectively, it equals the parent's world transform multiplied by the node's
-/// local transform.
-@property (nonatomic, readonly ) GLfloat* worldTransform;
+/// The node's transformation (2D affine, in pixels), in the global coordinate
+/// system. Effectively, it equals the parent's world transform multiplied by the
+/// node's local transform. Recalculated lazily (only when requested after the
+/// local transform of the node or any of its ancestors changed). The pointer
+/// refers to the shared transform store: use it right away, before creating,
+/// destroying or reparenting any node.
+@property (nonatomic, readonly) const Affine2f* worldAffineTransform;
 
 
 /// Whether the node performs custom drawing of its contents or just acts as a
@@ -114,8 +132,34 @@ extern NSInteger nodeInstanceCount;
 + (DNRNode *)rootNode;
 
 
+// Transform (4x4 matrix form)
+
+/**
+ Copies the local transformation, expanded to a 4x4 matrix, into matrix (16
+ floats, column-major).
+ */
+- (void) getLocalTransform:(GLfloat *)matrix;
+
+/**
+ Sets the local transformation from a 4x4 matrix (16 floats, column-major).
+ Only its 2D affine part is kept.
+ */
+- (void) setLocalTransform:(const GLfloat *)matrix;
+
+/**
+ Copies the world transformation, expanded to a 4x4 matrix, into matrix (16
+ floats, column-major; e.g., for uploading as a uniform).
+ */
+- (void) getWorldTransform:(GLfloat *)matrix;
+
+
 // Node Graph Manipulation
 
+// NOTE: Insertions, removals and sorting of children requested while the tree
+// is being updated (i.e., from within -update: or an action) are deferred: they
+// are applied in the order requested, right after the frame update of the whole
+// tree completes. Until then, -parent and -children reflect the tree as it was.
+
 /** 
  */
 - (void) addChild:(DNRNode *)child;
@@ -133,6 +177,27 @@ extern NSInteger nodeInstanceCount;
 - (void) insertChild:(DNRNode *)newChild belowChild:(DNRNode *)existingChild;
 
 
+/**
+ The child at the specified position (does not copy the children array).
+ */
+- (DNRNode *)childAtIndex:(NSUInteger) index;
+
+
+/**
+ Calls the block on each child, in order, without copying the children array.
+ Set *stop to YES to end the enumeration early.
+ */
+- (void) enumerateChildrenUsingBlock:(void (^)(DNRNode* child, BOOL* stop)) block;
+
+
+/**
+ Calls the function on each child, in order, without copying the children
+ array (and without the overhead of blocks; for engine traversals).
+ */
+- (void) enumerateChildrenUsingFunction:(DNRNodeVisitorFunction) function
+                                context:(void *)context;
+
+
 /** 
  Removes the specified node from the receiver's children. If the node is not
  among the children of the receiver, the message is silently ignored.
@@ -218,6 +283,36 @@ extern NSInteger nodeInstanceCount;
 - (void) render;
 
 
+/**
+ Called every frame by the scene on nodes that draw themselves, instead of
+ -render. Subclasses that can express their contents as quads (e.g., sprites) 
+ override this method to append them to the batch; the base implementation 
+ flushes the batch (so pending quads are drawn first, preserving the order) and 
+ then calls -render.
+ */
+- (void) renderInBatch:(SpriteBatch *)batch;
+
+
+/**
+ What the scene actually calls on nodes that draw themselves. The interpolation
+ is the fraction of a simulation step elapsed since the last one, in [0, 1) (1
+ when not running at a fixed step). Nodes that keep their state as of the
+ previous step can override this method to draw it blended with the current
+ one by that amount; the base implementation ignores it and calls
+ -renderInBatch:.
+ */
+- (void) renderInBatch:(SpriteBatch *)batch interpolation:(CGFloat) interpolation;
+
+
+/**
+ Whether any part of the node's contents might lie within the specified rect (in 
+ pixels, world coordinates). Called every frame by the scene on nodes that draw
+ themselves, before rendering; nodes that return NO are skipped (culled). The 
+ base implementation is unbounded, and always returns YES.
+ */
+- (BOOL) intersectsRect:(CGRect) rect;
+
+
 /** 
  Sorts from furthest to closest (for rendering).
  */
@@ -250,6 +345,10 @@ extern NSInteger nodeInstanceCount;
 
 
 /** 
+ Recalculates the world transform if it is stale (the local transform of the
+ receiver or any of its ancestors changed since it was last calculated).
+ Cheapest when called on parents before their children (e.g., during the draw
+ traversal).
  */
 - (void) updateWorldTransform;
 
@@ -12,6 +12,8 @@
 
 #import "DNRMatrix.h"
 
+#import "DNRTransformStore.h"
+
 #import "DNRRenderer.h"
 
 #import "DNRGlobals.h"      // scaleFactor
@@ -30,6 +32,14 @@ NSInteger nodeInstanceCount = 0;
 
 static DNRNode*  rootNode = nil;
 
+// Nesting level of -tick: calls (non-zero while the tree is being updated)
+static NSUInteger tickDepth = 0;
+
+// Children insertions/removals requested while the tree is being updated.
+// Applied in order once the update of the whole tree completes, so that the
+// traversal never sees the children arrays change under its feet.
+static NSMutableArray* deferredMutations = nil;
+
 
 // .............................................................................
 
@@ -51,16 +61,10 @@ static DNRNode*  rootNode = nil;
     NSMutableArray*     _children;
     
     
-    // Copies children for recursive frame update
-    NSMutableArray*     _childrenCopy;
-    
-    
-    // Set directly
-    GLfloat             _localTransform[16];
-    
-    // Updated based on _localTransform of ancestors,
-    // all the way up to root node.
-    GLfloat             _worldTransform[16];
+    // Entry in the transform store, which holds our local/world transforms,
+    // alpha and z (contiguous with those of all other nodes, in depth-first
+    // order). World transforms are updated lazily.
+    TransformHandle     _transformHandle;
     
     NSMutableArray*     _actionsInProgress;
     NSMutableArray*     _actionsToRemove;
@@ -95,14 +99,16 @@ static DNRNode*  rootNode = nil;
         _localizedName          = @"Unnamed Node";
         _visibility             = YES;
         _needsBlending          = YES;    // Meaningless unless drawsSelf?
-        _alpha                  = 1.0f;
         _userInteractionEnabled = NO;     // contentless nodes should be transparent to touches
         
         _children = [NSMutableArray new];
-        _childrenCopy = [NSMutableArray new];
         
-        mat4f_LoadIdentity(_localTransform);
-        mat4f_LoadIdentity(_worldTransform);
+        _transformHandle = transformStoreCreateEntry();
+        
+        if (_transformHandle == TransformHandleNone) {
+            // Out of memory
+            return nil;
+        }
         
         _actionsInProgress = [NSMutableArray new];
         _actionsToRemove   = [NSMutableArray new];
@@ -120,7 +126,10 @@ static DNRNode*  rootNode = nil;
     // purposes:
     nodeInstanceCount--;
     
-    [self removeAllChildren];
+    // (Can't be deferred: we are going away)
+    [self removeAllChildrenImmediately];
+    
+    transformStoreDestroyEntry(_transformHandle);
 }
 
 
@@ -132,28 +141,44 @@ static DNRNode*  rootNode = nil;
 }
 
 
-- (GLfloat *)localTransform {
-    return _localTransform;
+- (void) getLocalTransform:(GLfloat *)matrix {
+
+    affine2f_ToMat4f(transformStoreLocalTransform(_transformHandle), matrix);
 }
 
 
-- (void) setLocalTransform:(GLfloat *)localTransform {
+- (void) setLocalTransform:(const GLfloat *)localTransform {
 
-    // Z scale of sprites must always be 1 in order for depth culling to work
-    // properly:
-    localTransform[10] = 1.0f;
+    // Only the 2D part is kept; Z scale of sprites is always 1 in order for
+    // depth culling to work properly.
     
-    // Copy new matrix:
-    memcpy(_localTransform, localTransform, 16*sizeof(GLfloat));
+    Affine2f transform;
     
-    // Propagate changes to own and descendant world transforms:
-    [self propagateLocalTransformChanges];
+    affine2f_FromMat4f(localTransform, &transform);
+    
+    // Own and descendant world transforms are recalculated lazily:
+    transformStoreSetLocalTransform(_transformHandle, &transform);
+}
+
+
+- (Affine2f) localAffineTransform {
+
+    return *transformStoreLocalTransform(_transformHandle);
+}
+
+
+- (void) setLocalAffineTransform:(Affine2f) localAffineTransform {
+
+    // Own and descendant world transforms are recalculated lazily:
+    transformStoreSetLocalTransform(_transformHandle, &localAffineTransform);
 }
 
 
 - (CGPoint) position {
 
-    CGPoint position = CGPointMake(_localTransform[12], _localTransform[13]);
+    const Affine2f* localTransform = transformStoreLocalTransform(_transformHandle);
+    
+    CGPoint position = CGPointMake(localTransform->tx, localTransform->ty);
     position.x /= screenScaleFactor;
     position.y /= screenScaleFactor;
     
@@ -163,62 +188,64 @@ static DNRNode*  rootNode = nil;
 
 - (void) setPosition:(CGPoint) position {
 
-    _localTransform[12] = (position.x) * screenScaleFactor;
-    _localTransform[13] = (position.y) * screenScaleFactor;
-    
-    // Propagate changes to own and descendant world transforms:
-    [self propagateLocalTransformChanges];
+    // Own and descendant world transforms are recalculated lazily:
+    transformStoreSetLocalTranslation(_transformHandle,
+                                      (position.x) * screenScaleFactor,
+                                      (position.y) * screenScaleFactor);
 }
 
 
 - (CGPoint) globalPosition {
 
-    [self updateWorldTransform];
+    const Affine2f* worldTransform = [self worldAffineTransform];
     
-    return CGPointMake(_worldTransform[12] / screenScaleFactor,
-                       _worldTransform[13] / screenScaleFactor);
+    return CGPointMake(worldTransform->tx / screenScaleFactor,
+                       worldTransform->ty / screenScaleFactor);
+}
+
+
+- (void) getWorldTransform:(GLfloat *)matrix {
+
+    affine2f_ToMat4f([self worldAffineTransform], matrix);
 }
 
 
-- (float *)worldTransform {
+- (const Affine2f *)worldAffineTransform {
 
-    return _worldTransform;
+    // Resolved on demand if stale (i.e., if the local transform of the node or 
+    // any of its ancestors changed since it was last calculated):
+    
+    return transformStoreWorldTransform(_transformHandle);
 }
 
 
 - (void) updateWorldTransform {
 
-    if (_parent) {
-        // Child node. Recalculate our world transform based on parent's world
-        //  transform and own local transform:
-        
-        GLfloat* parentWorldTransform = [_parent worldTransform];
-        
-        //                           A          x        B        =       C
-        mat4f_MultiplyMat4f(parentWorldTransform, _localTransform, _worldTransform);
-    }
-    else{
-        // Root node. Parent's "world transform" is assumed to be the identity:
-        
-        mat4f_CopyMat4f(_localTransform, _worldTransform);
-    }
+    transformStoreWorldTransform(_transformHandle);
 }
 
 
-- (void) propagateLocalTransformChanges {
+- (GLfloat) alpha {
 
-    // Called everytime our _localTransform is modified.
-    
-    // 1. Recalculate our own world transform, based on (unchanged) parent's
-    //     world transform and own (just changed) local transform.
-    
-    [self updateWorldTransform];
-    
-    
-    // 2. Make children update their world transforms, based on their
-    //     (unchanged) local transforms and our (just updated) world transform.
-    
-    [_children makeObjectsPerformSelector:@selector(propagateLocalTransformChanges)];
+    return transformStoreAlpha(_transformHandle);
+}
+
+
+- (void) setAlpha:(GLfloat) alpha {
+
+    transformStoreSetAlpha(_transformHandle, alpha);
+}
+
+
+- (GLfloat) z {
+
+    return transformStoreZ(_transformHandle);
+}
+
+
+- (void) setZ:(GLfloat) z {
+
+    transformStoreSetZ(_transformHandle, z);
 }
 
 
@@ -249,6 +276,45 @@ static DNRNode*  rootNode = nil;
 }
 
 
+- (NSUInteger) childCount {
+
+    return [_children count];
+}
+
+
+- (DNRNode *)childAtIndex:(NSUInteger) index {
+
+    return [_children objectAtIndex:index];
+}
+
+
+- (void) enumerateChildrenUsingBlock:(void (^)(DNRNode* child, BOOL* stop)) block {
+
+    BOOL stop = NO;
+    
+    for (DNRNode* child in _children) {
+        
+        block(child, &stop);
+        
+        if (stop) {
+            break;
+        }
+    }
+}
+
+
+- (void) enumerateChildrenUsingFunction:(DNRNodeVisitorFunction) function
+                                context:(void *)context {
+
+    for (DNRNode* child in _children) {
+        
+        if (!function(child, context)) {
+            break;
+        }
+    }
+}
+
+
 #pragma mark - Hit Test
 
 
@@ -279,7 +345,9 @@ static DNRNode*  rootNode = nil;
         
         target = self;
         
-        for (DNRNode* child in [[_children reverseObjectEnumerator] allObjects]) {
+        for (NSUInteger i = [_children count]; i > 0; i--) {
+            
+            DNRNode* child = _children[i - 1];
             
             DNRNode* childTarget = [child hitTestWithPointInGlobalCoordinates:globalPoint];
             
@@ -334,6 +402,11 @@ static DNRNode*  rootNode = nil;
      */
     
     
+    // (Changes to the tree made from here on are deferred until the whole tree
+    //  has been updated; see -insertChild:atIndex:, -removeChild:)
+    tickDepth++;
+    
+    
     // Advance running actions
     for (DNRAction* action in _actionsInProgress) {
     
@@ -362,18 +435,20 @@ static DNRNode*  rootNode = nil;
     
     // NOTE: Game logic is performed inside many nodes' frame update methods. This
     // could entail adding or removing nodes to the graph, potentially causing
-    // loop inconsistencies so we must iterate on a copy of the children array:
-    // that is, the array children as it was at the moment this method was
-    // called on their parent (before any additions/deletions are performed).
+    // loop inconsistencies. Instead of iterating on a copy of the children
+    // array, all such changes are deferred until the whole tree has been
+    // updated (see -insertChild:atIndex:, -removeChild:).
     
-    [_childrenCopy removeAllObjects];
-    [_childrenCopy addObjectsFromArray:_children];
-    
-    for (DNRNode* child in _childrenCopy) {
+    for (DNRNode* child in _children) {
         [child tick:dt];
     }
     
-    [_childrenCopy removeAllObjects];
+    tickDepth--;
+    
+    if (tickDepth == 0) {
+        // Done updating the whole tree
+        [DNRNode applyDeferredMutations];
+    }
 }
 
 
@@ -400,7 +475,7 @@ static DNRNode*  rootNode = nil;
 
     // Used for sorting nodes from farthest to closest (drawing)
     
-    if ( (self->_z) > (otherNode->_z) ) {
+    if ( transformStoreZ(self->_transformHandle) > transformStoreZ(otherNode->_transformHandle) ) {
         return NSOrderedDescending;
     }
     else{
@@ -413,7 +488,7 @@ static DNRNode*  rootNode = nil;
 
     // Used for sorting nodes from closest to furthest (hit test)
     
-    if ( (self->_z) < (otherNode->_z) ) {
+    if ( transformStoreZ(self->_transformHandle) < transformStoreZ(otherNode->_transformHandle) ) {
         return NSOrderedDescending;
     }
     else{
@@ -430,6 +505,31 @@ static DNRNode*  rootNode = nil;
 }
 
 
+- (BOOL) intersectsRect:(CGRect) rect {
+
+    // Unbounded (subclasses with known bounds should override, so they can be
+    // culled)
+    return YES;
+}
+
+
+- (void) renderInBatch:(SpriteBatch *)batch {
+
+    /* Nodes that issue their own draw calls must not overtake the quads still
+       pending in the batch (they have lower z, and might be translucent).
+     */
+    spriteBatchFlush(batch);
+    
+    [self render];
+}
+
+
+- (void) renderInBatch:(SpriteBatch *)batch interpolation:(CGFloat) interpolation {
+
+    [self renderInBatch:batch];
+}
+
+
 #pragma mark - Node Graph Manipulation
 
 
@@ -450,6 +550,14 @@ static DNRNode*  rootNode = nil;
         return;
     }
     
+    if (tickDepth > 0) {
+        // Tree is being updated; apply later.
+        [DNRNode deferMutation:^{
+            [self insertChild:newChild atIndex:insertIndex];
+        }];
+        return;
+    }
+    
     
     DNRNode* oldParent = [newChild parent];
     
@@ -482,6 +590,12 @@ static DNRNode*  rootNode = nil;
     
     // Parent it:
     newChild->_parent = self;
+    
+    DNRNode* previousSibling = (safeIndex > 0) ? _children[safeIndex - 1] : nil;
+    
+    transformStoreAttach(newChild->_transformHandle,
+                         _transformHandle,
+                         previousSibling ? previousSibling->_transformHandle : TransformHandleNone);
 }
 
 
@@ -526,29 +640,56 @@ static DNRNode*  rootNode = nil;
 
 - (void) removeChild:(DNRNode *)child {
 
+    if (tickDepth > 0) {
+        // Tree is being updated; apply later.
+        [DNRNode deferMutation:^{
+            [self removeChild:child];
+        }];
+        return;
+    }
+    
     if (child && child->_parent == self) {
         [_children removeObject:child];
         child->_parent = nil;
+        
+        transformStoreDetach(child->_transformHandle);
     }
 }
 
 
 - (void) removeAllChildren {
 
-    // Beter not to modify the very array being iterated; use a copy:
-    NSArray* childrenCopy = [NSArray arrayWithArray:_children];
+    if (tickDepth > 0) {
+        // Tree is being updated; apply later.
+        [DNRNode deferMutation:^{
+            [self removeAllChildrenImmediately];
+        }];
+        return;
+    }
     
-    for (DNRNode* child in childrenCopy) {
+    [self removeAllChildrenImmediately];
+}
+
+
+- (void) removeAllChildrenImmediately {
+
+    // Remove from the end (no need to copy the array being modified):
+    while ([_children count] > 0) {
+        
+        DNRNode* child = [_children lastObject];
+        
         child->_parent = nil;
-        [_children removeObject:child];
+        transformStoreDetach(child->_transformHandle);
+        
+        [_children removeLastObject];
     }
 }
 
 
 - (void) removeFromParent {
 
+    // (Deferred by -removeChild: if the tree is being updated)
     [_parent removeChild:self];
-    _parent = nil;
 }
 
 
@@ -580,13 +721,50 @@ static DNRNode*  rootNode = nil;
 
 - (void) sortChildrenUsingSelector:(SEL) selector {
 
+    if (tickDepth > 0) {
+        // Tree is being updated; apply later.
+        [DNRNode deferMutation:^{
+            [self sortChildrenUsingSelector:selector];
+        }];
+        return;
+    }
+    
     [_children sortUsingSelector:selector];
+    
+    [self relinkChildTransforms];
 }
 
 
 - (void) sortChildrenUsingComparator:(NSComparator) comparator {
 
+    if (tickDepth > 0) {
+        // Tree is being updated; apply later.
+        [DNRNode deferMutation:^{
+            [self sortChildrenUsingComparator:comparator];
+        }];
+        return;
+    }
+    
     [_children sortUsingComparator:comparator];
+    
+    [self relinkChildTransforms];
+}
+
+
+- (void) relinkChildTransforms {
+
+    // Keeps the sibling order in the transform store in sync with _children
+    // (it determines the depth-first order of the store's arrays):
+    
+    TransformHandle previousSibling = TransformHandleNone;
+    
+    for (DNRNode* child in _children) {
+        
+        transformStoreDetach(child->_transformHandle);
+        transformStoreAttach(child->_transformHandle, _transformHandle, previousSibling);
+        
+        previousSibling = child->_transformHandle;
+    }
 }
 
 
@@ -608,6 +786,31 @@ static DNRNode*  rootNode = nil;
 }
 
 
++ (void) deferMutation:(void (^)(void)) mutation {
+
+    if (!deferredMutations) {
+        deferredMutations = [NSMutableArray new];
+    }
+    
+    [deferredMutations addObject:[mutation copy]];
+}
+
+
++ (void) applyDeferredMutations {
+
+    // (Index loop: nothing new gets deferred while applying, but be safe)
+    
+    for (NSUInteger i = 0; i < [deferredMutations count]; i++) {
+        
+        void (^mutation)(void) = deferredMutations[i];
+        
+        mutation();
+    }
+    
+    [deferredMutations removeAllObjects];
+}
+
+
 - (void) becomeRootNode {
 
     rootNode = self;
@@ -28,9 +28,11 @@
 
 /** 
  Scenes and transitions draw themselves; the scene controller only orchestrates 
- them.
+ them. The interpolation is the fraction of a simulation step elapsed since the
+ last one (see -[DNRSceneController tick:steps:interpolation:]); it is handed
+ down to every node drawn.
  */
-- (void) draw;
+- (void) drawWithInterpolation:(CGFloat) interpolation;
 
 
 @end
@@ -20,7 +20,7 @@
 }
 
 
-- (void) draw {
+- (void) drawWithInterpolation:(CGFloat) interpolation {
     DLog(@"Override me! (without calling super)");
 }
 
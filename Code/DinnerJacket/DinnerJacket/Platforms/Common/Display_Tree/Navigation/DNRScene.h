@@ -29,6 +29,11 @@
 @property (nonatomic, readwrite) Color4f  clearColor;
 
 
+/// Number of self-drawing nodes skipped in the last frame for lying entirely
+/// outside the renderer's visible rect (for profiling purposes).
+@property (nonatomic, readonly) NSUInteger culledNodeCount;
+
+
 /** 
  Sent before the scene is displayed or starts a transition
  */
@@ -59,7 +64,7 @@
  Sent by scene controller or parent transition every frame, to render display
  hierarchy subtree (descendant nodes).
  */
-- (void) drawNodes;
+- (void) drawNodesWithInterpolation:(CGFloat) interpolation;
 
 @end
 
@@ -13,12 +13,16 @@
 #import "DNRSceneTransition.h"
 #import "DNRGLCache.h"
 #import "DNRRenderer.h"
+#import "DNRTransformStore.h"
+#import "DNRProfiler.h"
+#import "DNRSceneController.h"
 
 @interface DNRScene ()
 
 @property (nonatomic, readwrite) DNRNodeStack* nodeStack;
-@property (nonatomic, readwrite) NSMutableArray* opaqueNodes;
-@property (nonatomic, readwrite) NSMutableArray* translucentNodes;
+@property (nonatomic, readwrite) DNRNodeStack* visitedNodes;
+@property (nonatomic, readwrite) DNRNodeStack* opaqueNodes;
+@property (nonatomic, readwrite) DNRNodeStack* translucentNodes;
 
 @end
 
@@ -38,8 +42,10 @@
         
         _nodeStack = [DNRNodeStack new];
         
-        _opaqueNodes      = [[NSMutableArray alloc] init];
-        _translucentNodes = [[NSMutableArray alloc] init];
+        // (Reused every frame, in drawing order)
+        _visitedNodes     = [DNRNodeStack new];
+        _opaqueNodes      = [DNRNodeStack new];
+        _translucentNodes = [DNRNodeStack new];
         
         [self setAlpha:0.5];
         [self setUserInteractionEnabled:YES];
@@ -103,7 +109,7 @@
 #pragma mark - DNRNavigationNode Method Overrides
 
 
-- (void) draw {
+- (void) drawWithInterpolation:(CGFloat) interpolation {
 
     // Called by scene controller. Performs static scene drawing.
     
@@ -116,110 +122,110 @@
     
     [renderer beginFrame];
     
-    [self drawNodes];
+    [self drawNodesWithInterpolation:interpolation];
+    
+    profilerBegin(ProfilerPhasePresent);
     
     [renderer endFrame];
+    
+    profilerEnd(ProfilerPhasePresent);
 }
 
 
-- (void) drawNodes {
+- (void) drawNodesWithInterpolation:(CGFloat) interpolation {
 
     // Draws the specified scene. It can be either the only scene, or one of
     //  two scenes in a transition.
     
     
-    // 0. First, assign a Z (depth) value to each node in the hierarchy, by
-    //     traversing the display tree in a depth-first fashion. Also, separate
-    //     opaque nodes from translucent nodes to render in separate passes.
-    
-    
+    // 0. First, bring the world transforms of all nodes up to date in one 
+    //     linear pass over the transform store (parents first; unchanged nodes
+    //     are skipped):
     
-    NSUInteger treeSize = [self subtreeSize];   // (Recursive)
+    profilerBegin(ProfilerPhaseTransforms);
     
-    CGFloat    step     = 1.0 / treeSize;       // z goes from 0.0 to 1.0 (viewing volume's depth)
+    transformStoreUpdateWorldTransforms();
     
-    CGFloat    z        = 0.0f;                 // Begin drawing at the far back
+    profilerEnd(ProfilerPhaseTransforms);
     
     
     // .........................................................................
-    // [ 1 ] First pass: Assign depths
+    // [ 1 ] Single traversal: assign depths, and split self-drawing nodes into
+    //        opaque/non-opaque
     
     
-    // Traverse depth first, increasing z from 0 to 1 by <step> for each node.
+    // Traverse depth first, numbering each visible node in order (raw z). The
+    // tag of each stack entry tells whether the node lies below an ancestor
+    // that draws its descendants itself (in which case it is not collected
+    // for drawing, but still gets a depth).
     
-    DNRNode* currentNode = nil;
+    profilerBegin(ProfilerPhaseTraversal);
     
-    [_nodeStack pushNode:self];
+    DNRNode*   currentNode       = nil;
+    NSUInteger drawnByAncestor   = NO;
     
-    while ((currentNode = [_nodeStack popNode])) {
-        
-        // 0. Assign z (depth)
-        
-        [currentNode setZ:z];
+    [_nodeStack pushNode:self tag:NO];
+    
+    while ((currentNode = [_nodeStack popNodeWithTag:&drawnByAncestor])) {
         
-        // (...and increment z by <step> for
-        //  the next node:)
-        z += step;
+        // 1. Assign raw z (visit order; normalized below)
         
+        [currentNode setZ:(GLfloat)[_visitedNodes count]];
         
-        // Push children in reverse order
+        [_visitedNodes pushNode:currentNode];
         
-        NSEnumerator* reverseEnumerator = [[currentNode children] reverseObjectEnumerator];
-        NSArray*      reverseChildren   = [reverseEnumerator allObjects];
         
-        for (DNRNode* child in reverseChildren) {
-            
-            if ([child isVisible]) {
-                
-                [child updateWorldTransform];
-                
-                [_nodeStack pushNode:child];
-            }
-        }
-    }
-    
-    // (Done assigning depths)
-    
-    
-    // .........................................................................
-    // [ 2 ] Second pass: split self-drawing nodes into opaque/non-opaque
-    
-    
-    [_nodeStack pushNode:self];
-    
-    while ((currentNode = [_nodeStack popNode])) {
-        
-        // 1. Split self drawing nodes (e.g., GPSprite) into two groups,
+        // 2. Split self drawing nodes (e.g., DNRSprite) into two groups,
         //     according to opacity:
         
-        if ([currentNode drawsSelf]) {
+        if (!drawnByAncestor && [currentNode drawsSelf]) {
             if ([currentNode needsBlending]) {
                 
-                [_translucentNodes addObject:currentNode];
+                [_translucentNodes pushNode:currentNode];
             }
             else{
-                [_opaqueNodes addObject:currentNode];
+                [_opaqueNodes pushNode:currentNode];
             }
         }
         
-        // Push children in reverse order
         
-        if (![currentNode drawsDescendants]) {
-            
-            NSEnumerator* reverseEnumerator = [[currentNode children] reverseObjectEnumerator];
+        // 3. Push children in reverse order (no copies of the children array)
+        
+        NSUInteger childTag = (drawnByAncestor || [currentNode drawsDescendants]);
+        
+        for (NSUInteger i = [currentNode childCount]; i > 0; i--) {
             
-            NSArray*      reverseChildren   = [reverseEnumerator allObjects];
+            DNRNode* child = [currentNode childAtIndex:(i - 1)];
             
-            for (DNRNode* child in reverseChildren) {
+            if ([child isVisible]) {
                 
-                if ([child isVisible]) {
-                    
-                    [_nodeStack pushNode:child];
-                }
+                [_nodeStack pushNode:child tag:childTag];
             }
         }
     }
     
+    
+    profilerEnd(ProfilerPhaseTraversal);
+    
+    
+    // 4. Normalize depths: z goes from 0.0 (far back) to 1.0 (viewing volume's
+    //     depth), using the number of nodes visited.
+    
+    profilerBegin(ProfilerPhaseSort);
+    
+    NSUInteger nodeCount = [_visitedNodes count];
+    GLfloat    step      = 1.0f / nodeCount;
+    
+    for (NSUInteger i = 0; i < nodeCount; i++) {
+        
+        [[_visitedNodes nodeAtIndex:i] setZ:(i * step)];
+    }
+    
+    [_visitedNodes empty];
+    
+    profilerEnd(ProfilerPhaseSort);
+    profilerCount(ProfilerCounterNodesVisited, nodeCount);
+    
     // (done assigning Z and separating translucent from opaque nodes)
     
     
@@ -227,24 +233,69 @@
     // Draw all (drawable) nodes at once
     
     
+    // Sprites append their (CPU-transformed) quads to the renderer's batch,
+    // which groups consecutive quads sharing the same texture/program/blending
+    // into a single draw call. Nodes that draw themselves flush it first.
+    
+    // (Scenes that are part of a transition don't have a renderer of their own;
+    //  use the shared one)
+    id<DNRRenderer> renderer = [[DNRSceneController defaultController] renderer];
+    
+    SpriteBatch* batch       = [renderer spriteBatch];
+    CGRect       visibleRect = [renderer visibleRect];
+    
+    _culledNodeCount = 0;
+    
+    profilerBegin(ProfilerPhaseRender);
+    
+    spriteBatchBegin(batch);
+    
+    
     // 1. Render Opaque Nodes First
     
-    glDisable(GL_BLEND);
-    [_opaqueNodes makeObjectsPerformSelector:@selector(render)];
+    spriteBatchSetBlendingEnabled(batch, GL_FALSE);
+    
+    for (NSUInteger i = 0; i < [_opaqueNodes count]; i++) {
+        [self renderNode:[_opaqueNodes nodeAtIndex:i] inBatch:batch visibleRect:visibleRect interpolation:interpolation];
+    }
     
     
     // 2. Render Translucent Nodes Second
     
-    glEnable(GL_BLEND);
-    [_translucentNodes makeObjectsPerformSelector:@selector(render)];
+    spriteBatchSetBlendingEnabled(batch, GL_TRUE);
+    
+    for (NSUInteger i = 0; i < [_translucentNodes count]; i++) {
+        [self renderNode:[_translucentNodes nodeAtIndex:i] inBatch:batch visibleRect:visibleRect interpolation:interpolation];
+    }
+    
+    spriteBatchFlush(batch);
+    
+    profilerEnd(ProfilerPhaseRender);
+    profilerCount(ProfilerCounterNodesCulled, _culledNodeCount);
     
     
     // 3. Empty arrays in preparation for next frame:
-    [_opaqueNodes removeAllObjects];
-    [_translucentNodes removeAllObjects];
+    [_opaqueNodes empty];
+    [_translucentNodes empty];
     
     // (done rendering scene)
 }
 
 
+- (void) renderNode:(DNRNode *)node
+            inBatch:(SpriteBatch *)batch
+        visibleRect:(CGRect) visibleRect
+      interpolation:(CGFloat) interpolation {
+    
+    // Skip nodes that lie entirely off screen:
+    
+    if (![node intersectsRect:visibleRect]) {
+        _culledNodeCount++;
+        return;
+    }
+    
+    [node renderInBatch:batch interpolation:interpolation];
+}
+
+
 @end
@@ -13,6 +13,7 @@
 #import "DNRGLCache.h"
 
 #import "DNRRenderer.h"
+#import "DNRProfiler.h"
 
 
 @interface DNRSceneTransition ()
@@ -307,17 +308,17 @@
 }
 
 
-- (void) draw {
+- (void) drawWithInterpolation:(CGFloat) interpolation {
 
     // TODO: Use selectors and avoid the if statement every frame!
     
     if (_type == DNRSceneTransitionTypeSequentialFade) {
         
-        [self drawSequentialFade];
+        [self drawSequentialFadeWithInterpolation:interpolation];
     }
     else if(_type == DNRSceneTransitionTypeCrossDisolve){
 
-        [self drawCrossDissolve];
+        [self drawCrossDissolveWithInterpolation:interpolation];
     }
     else{
         // TODO: Add more transition types
@@ -325,7 +326,7 @@
 }
 
 
-- (void) drawSequentialFade {
+- (void) drawSequentialFadeWithInterpolation:(CGFloat) interpolation {
     
     id<DNRRenderer> renderer = [self renderer];
     
@@ -359,30 +360,38 @@
     // (Binds render-to-texture frambuffer and clears screen to scene color)
     
     
-    [targetScene drawNodes];
+    [targetScene drawNodesWithInterpolation:interpolation];
     // (Draws scene's contents)
     
     
+    profilerBegin(ProfilerPhasePresent);
+    
     [renderer blendSequentialFadePassWithOpacity:alpha];
     // (Blends scene texture to screen at the specified opacity)
+    
+    profilerEnd(ProfilerPhasePresent);
 }
 
 
-- (void) drawCrossDissolve {
+- (void) drawCrossDissolveWithInterpolation:(CGFloat) interpolation {
     
     id<DNRRenderer> renderer = [self renderer];
     
     [renderer setSceneClearColor:[_scene1 clearColor]];
     [renderer beginCrossDissolveFramePass1];
     
-    [_scene1 drawNodes];
+    [_scene1 drawNodesWithInterpolation:interpolation];
     
     [renderer setSceneClearColor:[_scene2 clearColor]];
     [renderer beginCrossDissolveFramePass2];
     
-    [_scene2 drawNodes];
+    [_scene2 drawNodesWithInterpolation:interpolation];
+    
+    profilerBegin(ProfilerPhasePresent);
     
     [renderer blendCrossDissolvePassesWithProgress:[self progress]];
+    
+    profilerEnd(ProfilerPhasePresent);
 }
 
 
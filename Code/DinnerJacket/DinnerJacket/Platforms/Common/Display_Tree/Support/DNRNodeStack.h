@@ -15,21 +15,45 @@
 
 /**
  Stack of nodes for traversing the display hierarchy tree when rendering each 
- frame.
+ frame. Storage is a plain C array that only grows, so pushing and popping do
+ not allocate once the stack has reached the size of the tree. Nodes are not
+ retained (they are owned by the tree being traversed).
  */
 @interface DNRNodeStack : NSObject
 
 
-/// Pretty much what it says on the tin.
 - (void) pushNode:(DNRNode *)node;
 
 
-/// Pretty much what it says on the tin.
+/**
+ Pushes the node along with a user defined value (e.g., traversal state) that
+ is returned when the node is popped.
+ */
+- (void) pushNode:(DNRNode *)node tag:(NSUInteger) tag;
+
+
 - (DNRNode *)popNode;
 
 
-/// Pretty much what it says on the tin. Empties the stack.
+/**
+ Pops the node on top, and the tag it was pushed with. Returns nil if empty.
+ */
+- (DNRNode *)popNodeWithTag:(NSUInteger *)tag;
+
+
+/**
+ Number of nodes currently in the stack.
+ */
+- (NSUInteger) count;
+
+
+/**
+ Node at the given position (0 is the bottom of the stack). Lets the stack 
+ double as a reusable list of nodes.
+ */
+- (DNRNode *)nodeAtIndex:(NSUInteger) index;
+
+
 - (void) empty;
 
 @end
-
@@ -9,10 +9,22 @@
 #import "DNRNodeStack.h"
 
 
+#define DNRNodeStackInitialCapacity     256u
+
+
+typedef struct tNodeStackEntry {
+    
+    __unsafe_unretained DNRNode*    node;
+    NSUInteger                      tag;
+    
+} NodeStackEntry;
+
 
 @implementation DNRNodeStack {
 
-    NSMutableArray* _stack; // Backing
+    NodeStackEntry* _entries;   // Backing
+    NSUInteger      _count;
+    NSUInteger      _capacity;
 }
 
 
@@ -20,40 +32,94 @@
 
     if ((self = [super init])) {
         
-        _stack = [[NSMutableArray alloc] init];
+        _capacity = DNRNodeStackInitialCapacity;
+        _entries  = calloc(_capacity, sizeof(NodeStackEntry));
+        
+        if (!_entries) {
+            return nil;
+        }
     }
     
     return self;
 }
 
 
+- (void) dealloc {
+
+    free(_entries);
+}
+
+
 - (void) pushNode:(DNRNode *)node {
 
-    if (node) {
+    [self pushNode:node tag:0];
+}
+
+
+- (void) pushNode:(DNRNode *)node tag:(NSUInteger) tag {
+
+    if (!node) {
+        return;
+    }
+    
+    if (_count == _capacity) {
+        // Grow (never shrinks):
         
-        [_stack addObject:node];
+        NodeStackEntry* entries = realloc(_entries, 2*_capacity*sizeof(NodeStackEntry));
+        
+        if (!entries) {
+            return;
+        }
+        
+        _entries   = entries;
+        _capacity *= 2;
     }
+    
+    _entries[_count].node = node;
+    _entries[_count].tag  = tag;
+    
+    _count++;
 }
 
 
 - (DNRNode *)popNode {
 
-    if ([_stack count]) {
+    return [self popNodeWithTag:NULL];
+}
+
+
+- (DNRNode *)popNodeWithTag:(NSUInteger *)tag {
+
+    if (_count) {
         
-        DNRNode* node = [_stack lastObject];
+        _count--;
         
-        [_stack removeLastObject];
+        if (tag) {
+            *tag = _entries[_count].tag;
+        }
         
-        return node;
+        return _entries[_count].node;
     }
     
     return nil;
 }
 
 
+- (NSUInteger) count {
+
+    return _count;
+}
+
+
+- (DNRNode *)nodeAtIndex:(NSUInteger) index {
+
+    return (index < _count) ? _entries[index].node : nil;
+}
+
+
 - (void) empty {
 
-    [_stack removeAllObjects];
+    _count = 0;
 }
 
 
@@ -0,0 +1,480 @@
+//
+//  DNRTransformStore.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-12.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "DNRTransformStore.h"
+
+
+#define InitialCapacity         256u
+
+#define NoParentIndex           -1
+
+
+// .............................................................................
+// Dense arrays (indexed by position; depth-first order once sorted)
+
+static TransformHandle* handleAt            = NULL;
+static int32_t*         parentIndex         = NULL;     // Valid only while !orderDirty
+static Affine2f*        localTransform      = NULL;
+static Affine2f*        worldTransform      = NULL;
+static float*           alpha               = NULL;
+static float*           z                   = NULL;
+static uint8_t*         localDirty          = NULL;     // Local transform (or parent) changed
+static uint64_t*        worldVersion        = NULL;     // Bumped each time world is recalculated
+static uint64_t*        parentWorldVersion  = NULL;     // Parent's version world was calculated from
+static uint64_t*        validatedCount      = NULL;     // mutationCount when world was last validated
+
+// Sparse arrays (indexed by handle; slot 0 is unused)
+
+static uint32_t*        indexOf             = NULL;
+static TransformHandle* parentOf            = NULL;
+static TransformHandle* firstChildOf        = NULL;
+static TransformHandle* nextSiblingOf       = NULL;
+static TransformHandle* previousSiblingOf   = NULL;
+
+static TransformHandle* freeHandles         = NULL;
+static uint32_t         freeHandleCount     = 0;
+static uint32_t         highestHandle       = 0;
+
+// Bookkeeping
+
+static uint32_t         count               = 0;
+static uint32_t         capacity            = 0;
+
+static int              orderDirty          = 0;
+
+// Bumped every time any local transform or the topology changes. An entry
+// validated at the current count is up to date, without checking ancestors.
+static uint64_t         mutationCount       = 1;
+
+static uint64_t         versionCount        = 0;
+
+// Re-sorting
+static TransformHandle* sortedHandles       = NULL;
+static uint32_t*        sortSource          = NULL;
+static void*            sortScratch         = NULL;
+
+
+#pragma mark - Internal
+
+
+static int grow(void) {
+
+    uint32_t newCapacity = (capacity ? 2*capacity : InitialCapacity);
+
+#define GROW(array, type, n) do { \
+        void* p = realloc((array), (n)*sizeof(type)); \
+        if (!p) { return 0; } \
+        (array) = (type *)p; \
+    } while (0)
+
+    GROW(handleAt,           TransformHandle, newCapacity);
+    GROW(parentIndex,        int32_t,         newCapacity);
+    GROW(localTransform,     Affine2f,        newCapacity);
+    GROW(worldTransform,     Affine2f,        newCapacity);
+    GROW(alpha,              float,           newCapacity);
+    GROW(z,                  float,           newCapacity);
+    GROW(localDirty,         uint8_t,         newCapacity);
+    GROW(worldVersion,       uint64_t,        newCapacity);
+    GROW(parentWorldVersion, uint64_t,        newCapacity);
+    GROW(validatedCount,     uint64_t,        newCapacity);
+
+    GROW(indexOf,            uint32_t,        newCapacity + 1);
+    GROW(parentOf,           TransformHandle, newCapacity + 1);
+    GROW(firstChildOf,       TransformHandle, newCapacity + 1);
+    GROW(nextSiblingOf,      TransformHandle, newCapacity + 1);
+    GROW(previousSiblingOf,  TransformHandle, newCapacity + 1);
+    GROW(freeHandles,        TransformHandle, newCapacity + 1);
+
+    GROW(sortedHandles,      TransformHandle, newCapacity);
+    GROW(sortSource,         uint32_t,        newCapacity);
+    GROW(sortScratch,        Affine2f,        newCapacity);     // (largest element)
+
+#undef GROW
+
+    capacity = newCapacity;
+
+    return 1;
+}
+
+
+static void permute(void* array, size_t elementSize) {
+
+    // Reorders one dense array so that element i comes from sortSource[i]:
+
+    char* source      = (char *)array;
+    char* destination = (char *)sortScratch;
+
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(destination + i*elementSize, source + sortSource[i]*elementSize, elementSize);
+    }
+
+    memcpy(array, sortScratch, count*elementSize);
+}
+
+
+static void sortDepthFirst(void) {
+
+    // 1. List handles in depth-first order: each root (in current order),
+    //     followed by its subtree (children in sibling order).
+
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+
+        TransformHandle root = handleAt[i];
+
+        if (parentOf[root] != TransformHandleNone) {
+            continue;
+        }
+
+        // Walk the subtree using the links (no stack needed):
+
+        TransformHandle current = root;
+
+        while (current != TransformHandleNone) {
+
+            sortedHandles[n++] = current;
+
+            if (firstChildOf[current] != TransformHandleNone) {
+                // Descend
+                current = firstChildOf[current];
+                continue;
+            }
+
+            // Ascend until a node with a next sibling is found (or we are back
+            //  at the root):
+
+            while (current != root && nextSiblingOf[current] == TransformHandleNone) {
+                current = parentOf[current];
+            }
+
+            current = (current == root) ? TransformHandleNone : nextSiblingOf[current];
+        }
+    }
+
+
+    // 2. Move all dense data into that order
+
+    for (uint32_t i = 0; i < n; i++) {
+        sortSource[i] = indexOf[sortedHandles[i]];
+    }
+
+    permute(localTransform,     sizeof(Affine2f));
+    permute(worldTransform,     sizeof(Affine2f));
+    permute(alpha,              sizeof(float));
+    permute(z,                  sizeof(float));
+    permute(localDirty,         sizeof(uint8_t));
+    permute(worldVersion,       sizeof(uint64_t));
+    permute(parentWorldVersion, sizeof(uint64_t));
+    permute(validatedCount,     sizeof(uint64_t));
+
+    memcpy(handleAt, sortedHandles, n*sizeof(TransformHandle));
+
+    for (uint32_t i = 0; i < n; i++) {
+        indexOf[handleAt[i]] = i;
+    }
+
+
+    // 3. Cache parent positions for the linear update pass
+
+    for (uint32_t i = 0; i < n; i++) {
+
+        TransformHandle parent = parentOf[handleAt[i]];
+
+        parentIndex[i] = (parent != TransformHandleNone) ? (int32_t)indexOf[parent] : NoParentIndex;
+    }
+
+    orderDirty = 0;
+}
+
+
+static void updateEntry(uint32_t i, int32_t parent) {
+
+    // Recalculates the world transform of entry i only if its local transform
+    // or its parent's world transform (assumed up to date) changed since the
+    // last time.
+
+    if (parent != NoParentIndex) {
+
+        if (localDirty[i] || parentWorldVersion[i] != worldVersion[parent]) {
+
+            affine2f_MultiplyAffine2f(&worldTransform[parent], &localTransform[i], &worldTransform[i]);
+
+            parentWorldVersion[i] = worldVersion[parent];
+            worldVersion[i]       = ++versionCount;
+        }
+    }
+    else if (localDirty[i]) {
+        // Root: parent's "world transform" is assumed to be the identity
+
+        worldTransform[i] = localTransform[i];
+
+        parentWorldVersion[i] = 0;
+        worldVersion[i]       = ++versionCount;
+    }
+
+    localDirty[i]     = 0;
+    validatedCount[i] = mutationCount;
+}
+
+
+static void resolveEntry(TransformHandle handle) {
+
+    // Brings a single entry up to date, making sure its ancestors are up to
+    // date first (does not depend on the depth-first order):
+
+    uint32_t i = indexOf[handle];
+
+    if (validatedCount[i] == mutationCount) {
+        return;
+    }
+
+    TransformHandle parent = parentOf[handle];
+
+    if (parent != TransformHandleNone) {
+        resolveEntry(parent);
+        updateEntry(i, (int32_t)indexOf[parent]);
+    }
+    else{
+        updateEntry(i, NoParentIndex);
+    }
+}
+
+
+static void invalidate(TransformHandle handle) {
+
+    localDirty[indexOf[handle]] = 1;
+
+    mutationCount++;
+}
+
+
+#pragma mark - Lifecycle
+
+
+TransformHandle transformStoreCreateEntry(void) {
+
+    if (count == capacity && !grow()) {
+        return TransformHandleNone;
+    }
+
+    TransformHandle handle = freeHandleCount ? freeHandles[--freeHandleCount] : ++highestHandle;
+
+    // New roots go at the end; depth-first order is preserved.
+
+    uint32_t i = count++;
+
+    handleAt[i] = handle;
+    parentIndex[i] = NoParentIndex;
+
+    affine2f_LoadIdentity(&localTransform[i]);
+    affine2f_LoadIdentity(&worldTransform[i]);
+
+    alpha[i]              = 1.0f;
+    z[i]                  = 0.0f;
+    localDirty[i]         = 1;
+    worldVersion[i]       = 0;
+    parentWorldVersion[i] = 0;
+    validatedCount[i]     = 0;
+
+    indexOf[handle]           = i;
+    parentOf[handle]          = TransformHandleNone;
+    firstChildOf[handle]      = TransformHandleNone;
+    nextSiblingOf[handle]     = TransformHandleNone;
+    previousSiblingOf[handle] = TransformHandleNone;
+
+    return handle;
+}
+
+
+void transformStoreDestroyEntry(TransformHandle handle) {
+
+    if (handle == TransformHandleNone) {
+        return;
+    }
+
+    // Fill the gap with the last entry:
+
+    uint32_t i    = indexOf[handle];
+    uint32_t last = count - 1;
+
+    if (i != last) {
+
+        handleAt[i]           = handleAt[last];
+        localTransform[i]     = localTransform[last];
+        worldTransform[i]     = worldTransform[last];
+        alpha[i]              = alpha[last];
+        z[i]                  = z[last];
+        localDirty[i]         = localDirty[last];
+        worldVersion[i]       = worldVersion[last];
+        parentWorldVersion[i] = parentWorldVersion[last];
+        validatedCount[i]     = validatedCount[last];
+
+        indexOf[handleAt[i]] = i;
+
+        // (The moved entry might now precede its parent)
+        orderDirty = 1;
+    }
+
+    count--;
+
+    freeHandles[freeHandleCount++] = handle;
+}
+
+
+#pragma mark - Topology
+
+
+void transformStoreAttach(TransformHandle handle,
+                          TransformHandle parent,
+                          TransformHandle previousSibling) {
+
+    parentOf[handle] = parent;
+
+    TransformHandle next;
+
+    if (previousSibling != TransformHandleNone) {
+        next = nextSiblingOf[previousSibling];
+        nextSiblingOf[previousSibling] = handle;
+    }
+    else{
+        next = firstChildOf[parent];
+        firstChildOf[parent] = handle;
+    }
+
+    previousSiblingOf[handle] = previousSibling;
+    nextSiblingOf[handle]     = next;
+
+    if (next != TransformHandleNone) {
+        previousSiblingOf[next] = handle;
+    }
+
+    orderDirty = 1;
+
+    invalidate(handle);
+}
+
+
+void transformStoreDetach(TransformHandle handle) {
+
+    TransformHandle parent   = parentOf[handle];
+    TransformHandle previous = previousSiblingOf[handle];
+    TransformHandle next     = nextSiblingOf[handle];
+
+    if (parent == TransformHandleNone) {
+        return;
+    }
+
+    if (previous != TransformHandleNone) {
+        nextSiblingOf[previous] = next;
+    }
+    else{
+        firstChildOf[parent] = next;
+    }
+
+    if (next != TransformHandleNone) {
+        previousSiblingOf[next] = previous;
+    }
+
+    parentOf[handle]          = TransformHandleNone;
+    previousSiblingOf[handle] = TransformHandleNone;
+    nextSiblingOf[handle]     = TransformHandleNone;
+
+    orderDirty = 1;
+
+    invalidate(handle);
+}
+
+
+#pragma mark - Transforms
+
+
+const Affine2f* transformStoreLocalTransform(TransformHandle handle) {
+
+    return &localTransform[indexOf[handle]];
+}
+
+
+void transformStoreSetLocalTransform(TransformHandle handle, const Affine2f* transform) {
+
+    localTransform[indexOf[handle]] = *transform;
+
+    invalidate(handle);
+}
+
+
+void transformStoreSetLocalTranslation(TransformHandle handle, float tx, float ty) {
+
+    Affine2f* transform = &localTransform[indexOf[handle]];
+
+    transform->tx = tx;
+    transform->ty = ty;
+
+    invalidate(handle);
+}
+
+
+const Affine2f* transformStoreWorldTransform(TransformHandle handle) {
+
+    resolveEntry(handle);
+
+    return &worldTransform[indexOf[handle]];
+}
+
+
+void transformStoreUpdateWorldTransforms(void) {
+
+    if (orderDirty) {
+        sortDepthFirst();
+    }
+
+    // Parents precede their descendants, so one pass suffices:
+
+    for (uint32_t i = 0; i < count; i++) {
+
+        if (validatedCount[i] != mutationCount) {
+            updateEntry(i, parentIndex[i]);
+        }
+    }
+}
+
+
+#pragma mark - Other Attributes
+
+
+float transformStoreAlpha(TransformHandle handle) {
+
+    return alpha[indexOf[handle]];
+}
+
+
+void transformStoreSetAlpha(TransformHandle handle, float value) {
+
+    alpha[indexOf[handle]] = value;
+}
+
+
+float transformStoreZ(TransformHandle handle) {
+
+    return z[indexOf[handle]];
+}
+
+
+void transformStoreSetZ(TransformHandle handle, float value) {
+
+    z[indexOf[handle]] = value;
+}
+
+
+uint32_t transformStoreEntryCount(void) {
+
+    return count;
+}
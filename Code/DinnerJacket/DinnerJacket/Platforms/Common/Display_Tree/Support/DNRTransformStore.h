@@ -0,0 +1,118 @@
+//
+//  DNRTransformStore.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-12.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRTransformStore_h__
+#define __DNRTransformStore_h__
+
+#include <stdint.h>
+
+#include "DNRMatrix.h"      // Affine2f
+
+
+/**
+ Structure-of-arrays storage for the transform state of every node in the
+ display tree (parent, local and world transforms, alpha and z), kept in
+ contiguous arrays in depth-first order.
+
+ Each node owns one entry, referenced through a stable handle (the entry's
+ position in the arrays changes whenever the tree topology changes and the
+ arrays are re-sorted).
+
+ Because parents always precede their descendants, bringing all the world
+ transforms up to date is a single linear pass over the arrays. In between
+ passes, the world transform of a single entry can also be resolved on demand
+ (walking up its ancestors).
+
+ Pointers returned by the accessors are only valid until the next entry is
+ created or destroyed, or the tree is re-sorted (i.e., use them immediately).
+
+ The store is global, and must only be accessed from the main thread.
+ */
+typedef uint32_t TransformHandle;
+
+#define TransformHandleNone     0u
+
+
+/**
+ Creates a new (unparented) entry with identity transforms, alpha 1 and z 0.
+ */
+TransformHandle transformStoreCreateEntry(void);
+
+
+/**
+ Destroys the entry. It must not have a parent or children.
+ */
+void transformStoreDestroyEntry(TransformHandle handle);
+
+
+/**
+ Makes the entry the child of parent, right after previousSibling (or as the
+ first child, if previousSibling is TransformHandleNone). The entry must be
+ unparented.
+ */
+void transformStoreAttach(TransformHandle handle,
+                          TransformHandle parent,
+                          TransformHandle previousSibling);
+
+
+/**
+ Removes the entry from its parent's children (it becomes a root).
+ */
+void transformStoreDetach(TransformHandle handle);
+
+
+/**
+ The local transform of the entry (read only; use
+ transformStoreSetLocalTransform() to modify).
+ */
+const Affine2f* transformStoreLocalTransform(TransformHandle handle);
+
+
+/**
+ Sets the local transform. World transforms of the entry and its descendants
+ are updated lazily.
+ */
+void transformStoreSetLocalTransform(TransformHandle handle, const Affine2f* transform);
+
+
+/**
+ Sets only the translation component of the local transform.
+ */
+void transformStoreSetLocalTranslation(TransformHandle handle, float tx, float ty);
+
+
+/**
+ The world transform of the entry, brought up to date if necessary.
+ */
+const Affine2f* transformStoreWorldTransform(TransformHandle handle);
+
+
+/**
+ Brings all world transforms up to date in one linear pass (re-sorting the
+ arrays in depth-first order first, if the topology changed). Call once per
+ frame, before drawing.
+ */
+void transformStoreUpdateWorldTransforms(void);
+
+
+float transformStoreAlpha(TransformHandle handle);
+
+void transformStoreSetAlpha(TransformHandle handle, float alpha);
+
+float transformStoreZ(TransformHandle handle);
+
+void transformStoreSetZ(TransformHandle handle, float z);
+
+
+/**
+ Number of live entries (for memory debugging purposes).
+ */
+uint32_t transformStoreEntryCount(void);
+
+
+#endif  // #defined (__DNRTransformStore_h__)
@@ -12,6 +12,9 @@
 #import "DNRShaderManager.h"
 
 #import "DNRGLCache.h"            // Graphics support
+#import "DNRGLDispatch.h"         // (All OpenGL calls go through it)
+#import "DNRSpriteBatch.h"
+#import "DNRProfiler.h"
 
 #import "DNRMatrix.h"                   // Math support
 
@@ -67,6 +70,16 @@ static GLint flatModelviewLocation         = -1;
 static GLuint flatVAO                      = 0u;
 
 
+// Origin-centered unit quad for batched flat sprites (shared among all
+// instances). Scaled to the native size by the modelview matrix.
+static const VertexData2D flatQuadVertices[4] = {
+    { { -0.5f, +0.5f }, { 0.0f, 0.0f } },     // Top Left
+    { { -0.5f, -0.5f }, { 0.0f, 1.0f } },     // Bottom Left
+    { { +0.5f, +0.5f }, { 1.0f, 0.0f } },     // Top Right
+    { { +0.5f, -0.5f }, { 1.0f, 1.0f } }      // Bottom Right
+};
+
+
 // -----------------------------------------------------------------------------
 
 #pragma mark - PUBLIC BASE CLASS (INTERNAL INTERFACE)
@@ -164,15 +177,25 @@ static GLuint flatVAO                      = 0u;
     GLfloat     _renderColor4f[4];
     
     
-    // Modelview matrix
-    GLfloat     _modelview4fv[16];
+    // Modelview matrix (2D affine; expanded to 4x4 only when uploaded)
+    Affine2f    _modelview;
+    
+    
+    // Native size quads (4 vertices per subimage, in the same order as
+    // _subimageNames). Transformed on the CPU when rendering in a batch.
+    VertexData2D*   _subimageVertices;
     
     
-    // Applied scale
-    GLfloat     _scale3f[3];
+    // Subimage IDs interned by the atlas (in the same order as _subimageNames)
+    DNRSubimageID*  _subimageIDs;
     
     
-    // Used for culling
+    // Set when the modelview matrix is calculated ahead of rendering (for
+    // culling); consumed by the next call to -render/-renderInBatch:.
+    BOOL        _modelviewIsCurrent;
+    
+    
+    // Used for culling (world AABB, in pixels)
     GLfloat     _boundsX0;
     GLfloat     _boundsX1;
     GLfloat     _boundsY0;
@@ -201,14 +224,14 @@ static GLuint flatVAO                      = 0u;
             //DLog(@"PROGRAM: %d", program);
             
             // Cache attributes
-            positionLocation  = glGetAttribLocation (program, "Position"    );
-            texCoordLocation  = glGetAttribLocation (program, "TextureCoord");
+            positionLocation  = glDispatch.getAttribLocation (program, "Position"    );
+            texCoordLocation  = glDispatch.getAttribLocation (program, "TextureCoord");
             
             // Cache uniforms
-            colorLocation     = glGetUniformLocation(program, "Color"    );
-            samplerLocation   = glGetUniformLocation(program, "Sampler"  );
-            modelviewLocation = glGetUniformLocation(program, "Modelview");
-            zLocation         = glGetUniformLocation(program, "Z"        );
+            colorLocation     = glDispatch.getUniformLocation(program, "Color"    );
+            samplerLocation   = glDispatch.getUniformLocation(program, "Sampler"  );
+            modelviewLocation = glDispatch.getUniformLocation(program, "Modelview");
+            zLocation         = glDispatch.getUniformLocation(program, "Z"        );
         }
         
         if (flatProgram == 0) {
@@ -217,12 +240,12 @@ static GLuint flatVAO                      = 0u;
             flatProgram = [[DNRShaderManager defaultManager] flatProgram];
             
             // Cache attributes
-            flatPositionLocation  = glGetAttribLocation (flatProgram, "Position" );
+            flatPositionLocation  = glDispatch.getAttribLocation (flatProgram, "Position" );
             
             // Cache uniforms
-            flatColorLocation     = glGetUniformLocation(flatProgram, "Color"    );
-            flatModelviewLocation = glGetUniformLocation(flatProgram, "Modelview");
-            flatZLocation         = glGetUniformLocation(flatProgram, "Z"        );
+            flatColorLocation     = glDispatch.getUniformLocation(flatProgram, "Color"    );
+            flatModelviewLocation = glDispatch.getUniformLocation(flatProgram, "Modelview");
+            flatZLocation         = glDispatch.getUniformLocation(flatProgram, "Z"        );
         }
         
         
@@ -253,30 +276,30 @@ static GLuint flatVAO                      = 0u;
             flatProgram = [[DNRShaderManager defaultManager] flatProgram];
             useProgram(flatProgram);
             
-            GLint flatPositionLocation = glGetAttribLocation(flatProgram, "Position");
+            GLint flatPositionLocation = glDispatch.getAttribLocation(flatProgram, "Position");
             
             GLuint vbo = 0;
             
             
-            glGenVertexArrays(1, &flatVAO);
+            glDispatch.genVertexArrays(1, &flatVAO);
             bindVertexArrayObject(flatVAO);
             
-            glGenBuffers(1, &vbo);
+            glDispatch.genBuffers(1, &vbo);
             bindVertexBufferObject(vbo);
             
-            glBufferData(GL_ARRAY_BUFFER,
-                         4*sizeof(VertexData2D),
-                         &vertices[0],
-                         GL_STATIC_DRAW);
+            glDispatch.bufferData(GL_ARRAY_BUFFER,
+                                  4*sizeof(VertexData2D),
+                                  &vertices[0],
+                                  GL_STATIC_DRAW);
             
             GLuint ibo = [DNRTextureAtlas sharedQuadIndexBufferObject];
             
             bindIndexBufferObject(ibo);
             
             
-            glEnableVertexAttribArray(flatPositionLocation);
+            glDispatch.enableVertexAttribArray(flatPositionLocation);
             
-            glVertexAttribPointer(flatPositionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
+            glDispatch.vertexAttribPointer(flatPositionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
             
             // At this point the VAO is set up with two vertex attributes
             // referencing the same buffer object, and another buffer object
@@ -285,7 +308,7 @@ static GLuint flatVAO                      = 0u;
             // with it.
             bindVertexArrayObject(0);
             
-            glDisableVertexAttribArray(flatPositionLocation);
+            glDispatch.disableVertexAttribArray(flatPositionLocation);
             
             bindIndexBufferObject(0);
             bindVertexBufferObject(0);
@@ -359,11 +382,18 @@ static GLuint flatVAO                      = 0u;
         
         _textureAtlas  = atlas;
         
-        _vao           = [_textureAtlas vertexArrayObjectForSubimageNames:_subimageNames];
+        NSUInteger subimageCount = [_subimageNames count];
+        
+        _subimageIDs = calloc(subimageCount, sizeof(DNRSubimageID));
+        
+        for (NSUInteger i = 0; i < subimageCount; i++) {
+            _subimageIDs[i] = [_textureAtlas subimageIDForName:_subimageNames[i]];
+        }
+        
+        _vao           = [_textureAtlas acquireVertexArrayObject];
         
         if (_vao == 0) {
-            // Texture atlas has not loaded the vertex array object for this
-            // sprite yet (can only be done in main OpenGL context/main thread);
+            // Texture atlas has not loaded its vertex array object yet (can only be done in main OpenGL context/main thread);
             // register to listen to the completion event:
             
             [[NSNotificationCenter defaultCenter] addObserver:self
@@ -376,9 +406,15 @@ static GLuint flatVAO                      = 0u;
         
         _textureName   = [_textureAtlas textureName]; // needed for...?
         
+        _subimageVertices = calloc(4*subimageCount, sizeof(VertexData2D));
+        
+        for (NSUInteger i = 0; i < subimageCount; i++) {
+            [_textureAtlas getVertices:&_subimageVertices[4*i] forSubimageWithID:_subimageIDs[i]];
+        }
+        
         _currentSubimageIndex = 0;
         
-        _nativeSize    = [_textureAtlas sizeForSubimageNamed:[_subimageNames objectAtIndex:0]];
+        _nativeSize    = [_textureAtlas sizeForSubimageWithID:_subimageIDs[0]];
     }
     
     return self;
@@ -437,7 +473,12 @@ static GLuint flatVAO                      = 0u;
 
 - (void) dealloc {
     
-    [_textureAtlas relinquishVertexArrayObjectForSubimageNames:_subimageNames];
+    if (_textureAtlas) {
+        [_textureAtlas relinquishVertexArrayObject];
+    }
+    
+    free(_subimageIDs);
+    free(_subimageVertices);
 }
 
 
@@ -595,9 +636,11 @@ static GLuint flatVAO                      = 0u;
 
 - (void) render {
     
-    [self updateModelviewMatrix];
+    static GLfloat modelview4fv[16];
     
-    float alpha = [self alpha]; // TODO: make alpha recursive (influenced by ancestors).
+    [self consumeModelviewMatrix];
+    
+    affine2f_ToMat4f(&_modelview, modelview4fv);
     
     
     if (_textureName) {
@@ -607,10 +650,7 @@ static GLuint flatVAO                      = 0u;
         
         // 1. Update color and opacity
         
-        _renderColor4f[0] = ((_colorBlendFactor*_tintColor.r) + (_complementaryColorBlendFactor * 1.0f))*alpha;
-        _renderColor4f[1] = ((_colorBlendFactor*_tintColor.g) + (_complementaryColorBlendFactor * 1.0f))*alpha;
-        _renderColor4f[2] = ((_colorBlendFactor*_tintColor.b) + (_complementaryColorBlendFactor * 1.0f))*alpha;
-        _renderColor4f[3] = ((_colorBlendFactor*_tintColor.a) + (_complementaryColorBlendFactor * 1.0f))*alpha;
+        [self updateRenderColor];
         
         
         // 2. Bind Texture
@@ -627,7 +667,7 @@ static GLuint flatVAO                      = 0u;
         
         uniform4fv(colorLocation, _renderColor4f);                  // Tint color and Opacity
         uniform1f(zLocation, [self z]);                             // Sprite Depth (Z order)
-        glUniformMatrix4fv(modelviewLocation, 1, 0, _modelview4fv); // Position/Rotation/Scale
+        glDispatch.uniformMatrix4fv(modelviewLocation, 1, 0, modelview4fv);  // Position/Rotation/Scale
         
         
         // 5. Bind geometry
@@ -637,10 +677,13 @@ static GLuint flatVAO                      = 0u;
         
         // 6. Draw
         
-        GLvoid* startIndex = (GLvoid *)(sizeof(GLushort) * 4 * _currentSubimageIndex);
-        // This should work (startIndex is in bytes, right? not shorts)
+        // (All subimages of the atlas share the vertex array object; draw the
+        //  current one's quad)
         
-        glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, (GLvoid *)startIndex);
+        GLint firstVertex = [_textureAtlas firstVertexForSubimageWithID:_subimageIDs[_currentSubimageIndex]];
+        
+        glDispatch.drawArrays(GL_TRIANGLE_STRIP, firstVertex, 4);
+        profilerCount(ProfilerCounterDrawCalls, 1);
         
         //bindVertexArrayObject(0);
         // -> This is inefficient when drawing several copies of the same sprite!
@@ -651,10 +694,7 @@ static GLuint flatVAO                      = 0u;
         // . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . ..
         // [ B ] SOLID
         
-        _renderColor4f[0] = ((_colorBlendFactor*_tintColor.r) + (_complementaryColorBlendFactor*_nativeColor.r))*alpha;
-        _renderColor4f[1] = ((_colorBlendFactor*_tintColor.g) + (_complementaryColorBlendFactor*_nativeColor.g))*alpha;
-        _renderColor4f[2] = ((_colorBlendFactor*_tintColor.b) + (_complementaryColorBlendFactor*_nativeColor.b))*alpha;
-        _renderColor4f[3] = ((_colorBlendFactor*_tintColor.a) + (_complementaryColorBlendFactor*_nativeColor.a))*alpha;
+        [self updateRenderColor];
         
         
         // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
@@ -668,7 +708,7 @@ static GLuint flatVAO                      = 0u;
         
         uniform4fv(flatColorLocation, _renderColor4f);                  // Tint color and Opacity
         uniform1f(flatZLocation, [self z]);                             // Sprite Depth (Z order)
-        glUniformMatrix4fv(flatModelviewLocation, 1, 0, _modelview4fv); // Position/Rotation/Scale
+        glDispatch.uniformMatrix4fv(flatModelviewLocation, 1, 0, modelview4fv);  // Position/Rotation/Scale
         
         
         // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
@@ -681,7 +721,8 @@ static GLuint flatVAO                      = 0u;
         // 6. Draw
         
         
-        glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
+        glDispatch.drawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
+        profilerCount(ProfilerCounterDrawCalls, 1);
         
         //bindVertexArrayObject(0);
         // -> This is inefficient when drawing several copies of the same sprite!
@@ -691,6 +732,81 @@ static GLuint flatVAO                      = 0u;
 }
 
 
+- (void) renderInBatch:(SpriteBatch *)batch {
+    
+    [self consumeModelviewMatrix];
+    
+    [self updateRenderColor];
+    
+    
+    // 1. Pick base geometry and texture
+    
+    const VertexData2D* quad;
+    GLuint              texture;
+    
+    if (_textureName) {
+        // [ A ] TEXTURED: Native size quad of the current subimage
+        
+        quad    = &_subimageVertices[4*_currentSubimageIndex];
+        texture = _textureName;
+    }
+    else{
+        // [ B ] SOLID: Unit quad (modelview includes the native size), drawn
+        //  with a white texel so it can share the textured program.
+        
+        quad    = flatQuadVertices;
+        texture = spriteBatchWhiteTexture(batch);
+    }
+    
+    
+    // 2. Transform to world coordinates (pixels). Z scale is always 1 and
+    //     sprites are flat, so the depth is just our z:
+    
+    BatchVertexData2D vertices[4];
+    
+    GLfloat        z     = [self z];
+    Color4ub       color = Color4ubFromColor4f(Color4fMake(_renderColor4f[0],
+                                                           _renderColor4f[1],
+                                                           _renderColor4f[2],
+                                                           _renderColor4f[3]));
+    
+    // (All four corners in one pass, vectorized where available)
+    affine2f_TransformVec2Array(&_modelview,
+                                &(quad[0].position),     sizeof(VertexData2D),
+                                &(vertices[0].position), sizeof(BatchVertexData2D),
+                                4);
+    
+    for (NSUInteger i = 0; i < 4; i++) {
+        
+        vertices[i].position.z = z;
+        
+        vertices[i].texCoords  = quad[i].texCoords;
+        vertices[i].color      = color;
+    }
+    
+    
+    // 3. Append (drawn when the batch is flushed)
+    
+    spriteBatchAppendQuad(batch, texture, spriteBatchDefaultProgram(batch), vertices);
+}
+
+
+- (void) updateRenderColor {
+    
+    // Blends the tint color with the base color (white for textured sprites),
+    // and premultiplies by the opacity.
+    
+    float alpha = [self alpha]; // TODO: make alpha recursive (influenced by ancestors).
+    
+    Color4f baseColor = (_textureName ? Color4fWhite : _nativeColor);
+    
+    _renderColor4f[0] = ((_colorBlendFactor*_tintColor.r) + (_complementaryColorBlendFactor*baseColor.r))*alpha;
+    _renderColor4f[1] = ((_colorBlendFactor*_tintColor.g) + (_complementaryColorBlendFactor*baseColor.g))*alpha;
+    _renderColor4f[2] = ((_colorBlendFactor*_tintColor.b) + (_complementaryColorBlendFactor*baseColor.b))*alpha;
+    _renderColor4f[3] = ((_colorBlendFactor*_tintColor.a) + (_complementaryColorBlendFactor*baseColor.a))*alpha;
+}
+
+
 #pragma mark - Custom Accessors
 
 
@@ -751,145 +867,95 @@ static GLuint flatVAO                      = 0u;
 
 - (void) updateModelviewMatrix {
     
+    // Calculates the current modelview transform, based on ancestors.
+    // Called just before rendering.
+    
+    static Affine2f scaleMatrix;
+    
     if (_textureName) {
-        // . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . ..
-        // [ A ] TEXTURED
-        
-        // Calculates the current modelview transform, based on ancestors.
-        // Called just before rendering.
-     
-        static GLfloat  scaleMatrix[16];
-        static GLfloat* worldTransform;
-        
-        
-        worldTransform = [self worldTransform];
-        
-        // Apply Scale
+        // [ A ] TEXTURED: Base geometry is already at the native size, so
+        //  _scale alone is used.
         
-        _scale3f[0] = _scale.x;
-        _scale3f[1] = _scale.y;
-        _scale3f[2] = 1.0f;
-        // Z-axis scale must always be 1.0f (otherwise depth gets f.ed up)
-        
-        mat4f_LoadScale(_scale3f, scaleMatrix);
-        
-        scaleMatrix[0] *= screenScaleFactor;
-        scaleMatrix[5] *= screenScaleFactor;
-        // (modelview matrix is in pixels)
-        
-        
-        mat4f_MultiplyMat4f(worldTransform, scaleMatrix, _modelview4fv);
+        affine2f_LoadScale(_scale.x, _scale.y, &scaleMatrix);
     }
     else{
-        // . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . .. . ..
-        // [ B ] SOLID
-
-        
-        // Calculates the current modelview transform, based on ancestors.
-        // Called just before rendering.
-        
-        static GLfloat  scaleMatrix[16];
-        static GLfloat* worldTransform;
-        
-        
-        worldTransform = [self worldTransform];
-        
-        // Apply Scale
-        
-        _scale3f[0] = _scale.x * _nativeSize.width;
-        _scale3f[1] = _scale.y * _nativeSize.height;
-        // Solid sprites use a (shared) unit quad as base geometry. Native size must
-        // be factored into this step. In contrast, textured sprites use geometry
-        // that is already at the native size, so _scale alone is used)
-        
-        _scale3f[2] = 1.0f;
-        // Z-axis scale must always be 1.0f (otherwise depth gets f.ed up)
-        
-        mat4f_LoadScale(_scale3f, scaleMatrix);
-        
-        scaleMatrix[0] *= screenScaleFactor;
-        scaleMatrix[5] *= screenScaleFactor;
-        // (modelview matrix is in pixels)
+        // [ B ] SOLID: Base geometry is a (shared) unit quad. Native size must
+        //  be factored into this step.
         
-        
-        mat4f_MultiplyMat4f(worldTransform, scaleMatrix, _modelview4fv);
+        affine2f_LoadScale(_scale.x * _nativeSize.width, _scale.y * _nativeSize.height, &scaleMatrix);
     }
     
-    // TODO: Move common code out of if/else blocks
+    scaleMatrix.a *= screenScaleFactor;
+    scaleMatrix.d *= screenScaleFactor;
+    // (modelview matrix is in pixels)
+    
+    affine2f_MultiplyAffine2f([self worldAffineTransform], &scaleMatrix, &_modelview);
 }
 
-// TEST
-
-- (void) updateBoundingFrame {
 
-    static GLfloat v0[4] = {0.0f};
-    static GLfloat v1[4] = {0.0f};
-    static GLfloat v2[4] = {0.0f};
-    static GLfloat v3[4] = {0.0f};
-    
-    static GLfloat p0[4] = {0.0f};
-    static GLfloat p1[4] = {0.0f};
-    static GLfloat p2[4] = {0.0f};
-    static GLfloat p3[4] = {0.0f};
-    
-    static GLfloat* outVectors[4] = {p0, p1, p2, p3};
-    
-    
+- (void) consumeModelviewMatrix {
     
-    GLfloat xMin = -0.5f*(_nativeSize.width)*screenScaleFactor;
-    GLfloat xMax = -xMin;
+    // Reuses the modelview calculated for culling this frame, if any:
     
-    GLfloat yMin = -0.5f*(_nativeSize.height)*screenScaleFactor;
-    GLfloat yMax = -yMin;
-    
-    
-    // top left
-    v0[0] = xMin;   v0[1] = yMax;   v0[2] = 0.0f;   v0[3] = 1.0f;
-    
-    // bottom left
-    v1[0] = xMin;   v1[1] = yMin;   v1[2] = 0.0f;   v1[3] = 1.0f;
-    
-    // top right
-    v2[0] = xMax;   v2[1] = yMax;   v2[2] = 0.0f;   v2[3] = 1.0f;
+    if (!_modelviewIsCurrent) {
+        [self updateModelviewMatrix];
+    }
     
-    // bottom right
-    v3[0] = xMax;   v3[1] = yMin;   v3[2] = 0.0f;   v3[3] = 1.0f;
+    _modelviewIsCurrent = NO;
+}
+
+
+- (void) updateBoundingFrame {
+
+    // Transforms the bounds of the base geometry by the modelview matrix (call
+    // -updateModelviewMatrix first).
     
+    GLfloat box[4];
     
-    mat4f_MultiplyVec4f(_modelview4fv, v0, p0);
-    mat4f_MultiplyVec4f(_modelview4fv, v1, p1);
-    mat4f_MultiplyVec4f(_modelview4fv, v2, p2);
-    mat4f_MultiplyVec4f(_modelview4fv, v3, p3);
+    if (_textureName) {
+        // Native size quad of the current subimage (bottom left, top right):
+        
+        const VertexData2D* quad = &_subimageVertices[4*_currentSubimageIndex];
+        
+        box[0] = quad[1].position.x;
+        box[1] = quad[1].position.y;
+        box[2] = quad[2].position.x;
+        box[3] = quad[2].position.y;
+    }
+    else{
+        // Unit quad:
+        
+        box[0] = -0.5f;
+        box[1] = -0.5f;
+        box[2] = +0.5f;
+        box[3] = +0.5f;
+    }
     
+    affine2f_TransformAABB(&_modelview, box, box);
     
-    xMin = +INFINITY;
-    xMax = -INFINITY;
-    yMin = +INFINITY;
-    yMax = -INFINITY;
+    _boundsX0 = box[0];
+    _boundsX1 = box[2];
+    _boundsY0 = box[1];
+    _boundsY1 = box[3];
+}
+
+
+- (BOOL) intersectsRect:(CGRect) rect {
+
+    [self updateModelviewMatrix];
+    [self updateBoundingFrame];
     
-    for (int i=0; i < 4; i++) {
-        
-        GLfloat* p = outVectors[i];
-     
-        if (p[0] < xMin) {
-            xMin = p[0];
-        }
-        if (p[0] > xMax) {
-            xMax = p[0];
-        }
-        
-        if (p[1] < yMin) {
-            yMin = p[1];
-        }
-        if (p[1] > yMax) {
-            yMax = p[1];
-        }
+    if (_boundsX1 < CGRectGetMinX(rect) || _boundsX0 > CGRectGetMaxX(rect) ||
+        _boundsY1 < CGRectGetMinY(rect) || _boundsY0 > CGRectGetMaxY(rect)) {
+        // Culled: not rendered this frame, so nothing will consume the matrix
+        // (keeping the flag set would let a later render reuse it stale)
+        _modelviewIsCurrent = NO;
+        return NO;
     }
     
-    _boundsX0 = xMin;
-    _boundsX1 = xMax;
-    _boundsY0 = yMin;
-    _boundsY1 = yMax;
+    _modelviewIsCurrent = YES;
+    
+    return YES;
 }
 
 
@@ -904,10 +970,10 @@ static GLuint flatVAO                      = 0u;
     
     // Update native size and alpha blending flag
     
-    NSString* currentName = _subimageNames[_currentSubimageIndex];
+    DNRSubimageID currentID = _subimageIDs[_currentSubimageIndex];
     
-    _nativeSize = [_textureAtlas sizeForSubimageNamed:currentName];
-    _opaque     = [_textureAtlas subimageIsOpaque:currentName];
+    _nativeSize = [_textureAtlas sizeForSubimageWithID:currentID];
+    _opaque     = [_textureAtlas subimageWithIDIsOpaque:currentID];
     
     [self setSize:_nativeSize];
 }
@@ -967,21 +1033,22 @@ static GLuint flatVAO                      = 0u;
 - (BOOL) pointInGlobalCoordinatesIsWithinBounds:(CGPoint) globalPoint
                                   withTolerance:(CGFloat) tolerance {
     
-    float inverseWorldMatrix[16] = { 0.0f };
+    Affine2f inverseWorldMatrix;
     
-    mat4f_Invert([self worldTransform], inverseWorldMatrix);
+    if (!affine2f_Invert([self worldAffineTransform], &inverseWorldMatrix)) {
+        // Degenerate (zero area); can't contain the point
+        return NO;
+    }
     
-    float vectorIn[4];
-    float vectorOut[4] = { 0.0f };
+    float vectorIn[2];
+    float vectorOut[2] = { 0.0f };
     
     // All matrices are in pixels:
     vectorIn[0] = globalPoint.x * screenScaleFactor;
     vectorIn[1] = globalPoint.y * screenScaleFactor;
-    vectorIn[2] = 0.0f;
-    vectorIn[3] = 1.0f;
     
 
-    mat4f_MultiplyVec4f(inverseWorldMatrix, vectorIn, vectorOut);
+    affine2f_TransformPoint(&inverseWorldMatrix, vectorIn, vectorOut);
     
     
     CGPoint localpoint = CGPointMake(vectorOut[0]/screenScaleFactor, vectorOut[1]/screenScaleFactor);
@@ -1034,16 +1101,10 @@ static GLuint flatVAO                      = 0u;
     if ([notification object] == _textureAtlas) {
         // Own atlas
         
-        NSArray* images = [[notification userInfo] objectForKey:kDNRAtlasLoadedVertexArrayObjectSumbimageNamesKey];
+        [[NSNotificationCenter defaultCenter] removeObserver:self];
         
-        if (images == _subimageNames) {
-            
-            // Own subscription
-            [[NSNotificationCenter defaultCenter] removeObserver:self];
-            
-            [[NSNotificationCenter defaultCenter] postNotificationName:DNRSpriteBecameReadyNotification
-                                                                object:self];
-        }
+        // (Posts DNRSpriteBecameReadyNotification)
+        [self setVertexArrayObject:[[[notification userInfo] objectForKey:kDNRAtlasLoadedVertexArrayObjectKey] unsignedIntValue]];
     }
 }
 
@@ -14,6 +14,25 @@
 #include "DNRMatrix.h"      // Own header
 
 
+// Vectorized kernels are selected at compile time (define DNR_MATRIX_NO_SIMD to
+// force the scalar ones). They perform the same multiplications and additions,
+// in the same order, as the scalar reference implementations, so results are
+// identical bit-for-bit (as long as multiply-adds aren't fused; see below).
+
+#if !defined(DNR_MATRIX_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define DNRMatrixUseNEON    1
+#elif !defined(DNR_MATRIX_NO_SIMD) && (defined(__SSE__) || defined(_M_X64))
+#include <xmmintrin.h>
+#define DNRMatrixUseSSE     1
+#endif
+
+// Keep the scalar code from being contracted into FMA instructions (which round
+// once instead of twice, and would break the bit-for-bit equivalence). GCC
+// ignores the pragma; the builds also pass -ffp-contract=off.
+#pragma STDC FP_CONTRACT OFF
+
+
 
 static inline float fastAbs(float x) {
 
@@ -420,7 +439,7 @@ void mat4f_LoadOrtho(float left, float right, float bottom, float top, float nea
 }
 
 
-void mat4f_MultiplyMat4f(const float* m1, const float* m2, float* mout) {
+void mat4f_MultiplyMat4f_Scalar(const float* m1, const float* m2, float* mout) {
 
     // 4x4行列のかけ算
     
@@ -446,6 +465,66 @@ void mat4f_MultiplyMat4f(const float* m1, const float* m2, float* mout) {
 }
 
 
+void mat4f_MultiplyMat4f(const float* m1, const float* m2, float* mout) {
+
+#if defined(DNRMatrixUseSSE) || defined(DNRMatrixUseNEON)
+    
+    // Each column of the product is a linear combination of the columns of m1,
+    // weighted by the elements of the corresponding column of m2:
+    
+    float result[16];
+    
+#if defined(DNRMatrixUseSSE)
+    
+    __m128 c0 = _mm_loadu_ps(&m1[ 0]);
+    __m128 c1 = _mm_loadu_ps(&m1[ 4]);
+    __m128 c2 = _mm_loadu_ps(&m1[ 8]);
+    __m128 c3 = _mm_loadu_ps(&m1[12]);
+    
+    for (int i = 0; i < 16; i += 4) {
+        
+        __m128 column = _mm_mul_ps(c0, _mm_set1_ps(m2[i + 0]));
+        column = _mm_add_ps(column, _mm_mul_ps(c1, _mm_set1_ps(m2[i + 1])));
+        column = _mm_add_ps(column, _mm_mul_ps(c2, _mm_set1_ps(m2[i + 2])));
+        column = _mm_add_ps(column, _mm_mul_ps(c3, _mm_set1_ps(m2[i + 3])));
+        
+        _mm_storeu_ps(&result[i], column);
+    }
+    
+#else // NEON
+    
+    float32x4_t c0 = vld1q_f32(&m1[ 0]);
+    float32x4_t c1 = vld1q_f32(&m1[ 4]);
+    float32x4_t c2 = vld1q_f32(&m1[ 8]);
+    float32x4_t c3 = vld1q_f32(&m1[12]);
+    
+    for (int i = 0; i < 16; i += 4) {
+        
+        float32x4_t column = vmulq_n_f32(c0, m2[i + 0]);
+        column = vaddq_f32(column, vmulq_n_f32(c1, m2[i + 1]));
+        column = vaddq_f32(column, vmulq_n_f32(c2, m2[i + 2]));
+        column = vaddq_f32(column, vmulq_n_f32(c3, m2[i + 3]));
+        
+        vst1q_f32(&result[i], column);
+    }
+    
+#endif
+    
+    // (Computed into a temporary, so mout can alias m1 or m2)
+    memcpy(mout, result, 16*sizeof(float));
+    
+#else
+    
+    float result[16];
+    
+    mat4f_MultiplyMat4f_Scalar(m1, m2, result);
+    
+    memcpy(mout, result, 16*sizeof(float));
+    
+#endif
+}
+
+
 void mat4f_CopyMat4f(const float* min, float* mout) {
 
 	memcpy(mout, min, 16*sizeof(float));
@@ -453,6 +532,7 @@ void mat4f_CopyMat4f(const float* min, float* mout) {
 
 
 void mat4f_PrintMatrix4x4( const float*a ) {
+    (void)a;
 
 #ifdef DEBUG
 	printf("%+2.3f  %+2.3f  %+2.3f  %+2.3f\n", a[ 0], a[ 1], a[ 2], a[ 3]);
@@ -464,6 +544,7 @@ void mat4f_PrintMatrix4x4( const float*a ) {
 
 
 void mat4f_PrintMatrix3x3( const float*a ) {
+    (void)a;
 
 #ifdef DEBUG
 	printf("%+2.3f  %+2.3f  %+2.3f\n", a[0], a[1], a[2]);
@@ -501,12 +582,381 @@ void mat4f_SubMatrix3x3(const float* a, float* mout) {
 }
 
 
+void mat4f_MultiplyVec4f_Scalar(const float* min, const float* vin, float* vout) {
+
+    // (Read in full before writing, so vout can alias vin)
+    float x = vin[0];
+    float y = vin[1];
+    float z = vin[2];
+    float w = vin[3];
+    
+	vout[ 0] = min[0] * x + min[4] * y  + min[ 8] * z + min[12] * w;
+    vout[ 1] = min[1] * x + min[5] * y  + min[ 9] * z + min[13] * w;
+    vout[ 2] = min[2] * x + min[6] * y  + min[10] * z + min[14] * w;
+    vout[ 3] = min[3] * x + min[7] * y  + min[11] * z + min[15] * w;
+}
+
+
 void mat4f_MultiplyVec4f(const float* min, const float* vin, float* vout) {
 
-	vout[ 0] = min[0] * vin[0] + min[4] * vin[1]  + min[ 8] * vin[2] + min[12] * vin[3];
-    vout[ 1] = min[1] * vin[0] + min[5] * vin[1]  + min[ 9] * vin[2] + min[13] * vin[3];
-    vout[ 2] = min[2] * vin[0] + min[6] * vin[1]  + min[10] * vin[2] + min[14] * vin[3];
-    vout[ 3] = min[3] * vin[0] + min[7] * vin[1]  + min[11] * vin[2] + min[15] * vin[3];
+#if defined(DNRMatrixUseSSE)
+    
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(&min[0]), _mm_set1_ps(vin[0]));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(&min[ 4]), _mm_set1_ps(vin[1])));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(&min[ 8]), _mm_set1_ps(vin[2])));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(&min[12]), _mm_set1_ps(vin[3])));
+    
+    _mm_storeu_ps(vout, v);
+    
+#elif defined(DNRMatrixUseNEON)
+    
+    float32x4_t v = vmulq_n_f32(vld1q_f32(&min[0]), vin[0]);
+    v = vaddq_f32(v, vmulq_n_f32(vld1q_f32(&min[ 4]), vin[1]));
+    v = vaddq_f32(v, vmulq_n_f32(vld1q_f32(&min[ 8]), vin[2]));
+    v = vaddq_f32(v, vmulq_n_f32(vld1q_f32(&min[12]), vin[3]));
+    
+    vst1q_f32(vout, v);
+    
+#else
+    
+    mat4f_MultiplyVec4f_Scalar(min, vin, vout);
+    
+#endif
+}
+
+
+/* Transforms count 2D points (z = 0, w = 1) and writes the resulting x and y.
+   Strides are in bytes (like glVertexAttribPointer's), so the points can be
+   read from/written to interleaved vertex data directly (e.g., the positions in
+   an array of VertexData2D). In and out may be the same array.
+ */
+void mat4f_TransformVec2Array_Scalar(const float* m,
+                                     const void* vin,  size_t inStride,
+                                     void*       vout, size_t outStride,
+                                     size_t count) {
+
+    const char* in  = (const char *)vin;
+    char*       out = (char *)vout;
+    
+    for (size_t i = 0; i < count; i++) {
+        
+        const float* p = (const float *)in;
+        float*       q = (float *)out;
+        
+        float x = p[0];
+        float y = p[1];
+        
+        q[0] = m[0] * x + m[4] * y + m[12];
+        q[1] = m[1] * x + m[5] * y + m[13];
+        
+        in  += inStride;
+        out += outStride;
+    }
+}
+
+
+void mat4f_TransformVec2Array(const float* m,
+                              const void* vin,  size_t inStride,
+                              void*       vout, size_t outStride,
+                              size_t count) {
+
+#if defined(DNRMatrixUseSSE) || defined(DNRMatrixUseNEON)
+    
+    const char* in  = (const char *)vin;
+    char*       out = (char *)vout;
+    
+#if defined(DNRMatrixUseSSE)
+    
+    // Both components of each point in one pass (lanes 2 and 3 are discarded):
+    
+    __m128 c0 = _mm_loadu_ps(&m[ 0]);
+    __m128 c1 = _mm_loadu_ps(&m[ 4]);
+    __m128 c3 = _mm_loadu_ps(&m[12]);
+    
+    for (size_t i = 0; i < count; i++) {
+        
+        const float* p = (const float *)in;
+        
+        __m128 q = _mm_mul_ps(c0, _mm_set1_ps(p[0]));
+        q = _mm_add_ps(q, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+        q = _mm_add_ps(q, c3);
+        
+        _mm_storel_pi((__m64 *)out, q);
+        
+        in  += inStride;
+        out += outStride;
+    }
+    
+#else // NEON
+    
+    float32x2_t c0 = vld1_f32(&m[ 0]);
+    float32x2_t c1 = vld1_f32(&m[ 4]);
+    float32x2_t c3 = vld1_f32(&m[12]);
+    
+    for (size_t i = 0; i < count; i++) {
+        
+        const float* p = (const float *)in;
+        
+        float32x2_t q = vmul_n_f32(c0, p[0]);
+        q = vadd_f32(q, vmul_n_f32(c1, p[1]));
+        q = vadd_f32(q, c3);
+        
+        vst1_f32((float *)out, q);
+        
+        in  += inStride;
+        out += outStride;
+    }
+    
+#endif
+    
+#else
+    
+    mat4f_TransformVec2Array_Scalar(m, vin, inStride, vout, outStride, count);
+    
+#endif
+}
+
+
+#pragma mark - 2D Affine
+
+
+void affine2f_LoadIdentity(Affine2f* m) {
+
+    m->a  = 1.0f;
+    m->b  = 0.0f;
+    m->c  = 0.0f;
+    m->d  = 1.0f;
+    m->tx = 0.0f;
+    m->ty = 0.0f;
 }
 
 
+void affine2f_LoadScale(float sx, float sy, Affine2f* m) {
+
+    m->a  = sx;
+    m->b  = 0.0f;
+    m->c  = 0.0f;
+    m->d  = sy;
+    m->tx = 0.0f;
+    m->ty = 0.0f;
+}
+
+
+void affine2f_MultiplyAffine2f(const Affine2f* m1, const Affine2f* m2, Affine2f* mout) {
+
+    // mout = m1 x m2 (m2 is applied first). 12 multiplications instead of the
+    // 64 of the full 4x4 product. Safe to use when mout aliases m1 or m2.
+    
+    Affine2f r;
+    
+    r.a  = m1->a * m2->a  + m1->c * m2->b;
+    r.b  = m1->b * m2->a  + m1->d * m2->b;
+    r.c  = m1->a * m2->c  + m1->c * m2->d;
+    r.d  = m1->b * m2->c  + m1->d * m2->d;
+    r.tx = m1->a * m2->tx + m1->c * m2->ty + m1->tx;
+    r.ty = m1->b * m2->tx + m1->d * m2->ty + m1->ty;
+    
+    *mout = r;
+}
+
+
+int affine2f_Invert(const Affine2f* m, Affine2f* invOut) {
+
+    float det = m->a * m->d - m->b * m->c;
+    
+    if (det == 0) {
+        return 0;
+    }
+    
+    float invDet = 1.0f / det;
+    
+    Affine2f r;
+    
+    r.a  =  m->d * invDet;
+    r.b  = -m->b * invDet;
+    r.c  = -m->c * invDet;
+    r.d  =  m->a * invDet;
+    r.tx = -(r.a * m->tx + r.c * m->ty);
+    r.ty = -(r.b * m->tx + r.d * m->ty);
+    
+    *invOut = r;
+    
+    return 1;
+}
+
+
+/* vin and vout are C arrays of two floats (x, y). They may alias.
+ */
+void affine2f_TransformPoint(const Affine2f* m, const float* vin, float* vout) {
+
+    float x = vin[0];
+    float y = vin[1];
+    
+    vout[0] = m->a * x + m->c * y + m->tx;
+    vout[1] = m->b * x + m->d * y + m->ty;
+}
+
+
+/* Same as mat4f_TransformVec2Array() (strides in bytes, in and out may be the
+   same array), reading the six affine components directly: no 4x4 expansion.
+   Bit-exact with mat4f_TransformVec2Array() of the affine2f_ToMat4f() matrix.
+ */
+void affine2f_TransformVec2Array_Scalar(const Affine2f* m,
+                                        const void* vin,  size_t inStride,
+                                        void*       vout, size_t outStride,
+                                        size_t count) {
+
+    const char* in  = (const char *)vin;
+    char*       out = (char *)vout;
+    
+    for (size_t i = 0; i < count; i++) {
+        
+        const float* p = (const float *)in;
+        float*       q = (float *)out;
+        
+        float x = p[0];
+        float y = p[1];
+        
+        q[0] = m->a * x + m->c * y + m->tx;
+        q[1] = m->b * x + m->d * y + m->ty;
+        
+        in  += inStride;
+        out += outStride;
+    }
+}
+
+
+void affine2f_TransformVec2Array(const Affine2f* m,
+                                 const void* vin,  size_t inStride,
+                                 void*       vout, size_t outStride,
+                                 size_t count) {
+
+#if defined(DNRMatrixUseSSE) || defined(DNRMatrixUseNEON)
+    
+    const char* in  = (const char *)vin;
+    char*       out = (char *)vout;
+    
+#if defined(DNRMatrixUseSSE)
+    
+    // Columns (a, b), (c, d) and (tx, ty); lanes 2 and 3 are discarded:
+    
+    __m128 c0 = _mm_setr_ps(m->a,  m->b,  0.0f, 0.0f);
+    __m128 c1 = _mm_setr_ps(m->c,  m->d,  0.0f, 0.0f);
+    __m128 c2 = _mm_setr_ps(m->tx, m->ty, 0.0f, 0.0f);
+    
+    for (size_t i = 0; i < count; i++) {
+        
+        const float* p = (const float *)in;
+        
+        __m128 q = _mm_mul_ps(c0, _mm_set1_ps(p[0]));
+        q = _mm_add_ps(q, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+        q = _mm_add_ps(q, c2);
+        
+        _mm_storel_pi((__m64 *)out, q);
+        
+        in  += inStride;
+        out += outStride;
+    }
+    
+#else // NEON
+    
+    // (Each column is two consecutive floats of the struct)
+    
+    float32x2_t c0 = vld1_f32(&m->a);
+    float32x2_t c1 = vld1_f32(&m->c);
+    float32x2_t c2 = vld1_f32(&m->tx);
+    
+    for (size_t i = 0; i < count; i++) {
+        
+        const float* p = (const float *)in;
+        
+        float32x2_t q = vmul_n_f32(c0, p[0]);
+        q = vadd_f32(q, vmul_n_f32(c1, p[1]));
+        q = vadd_f32(q, c2);
+        
+        vst1_f32((float *)out, q);
+        
+        in  += inStride;
+        out += outStride;
+    }
+    
+#endif
+    
+#else
+    
+    affine2f_TransformVec2Array_Scalar(m, vin, inStride, vout, outStride, count);
+    
+#endif
+}
+
+
+/* boxIn and boxOut are C arrays of four floats: (xMin, yMin, xMax, yMax).
+   Computes the axis-aligned bounds of the transformed box, without transforming
+   the four corners (each output extent only depends on the sign of the
+   corresponding matrix element).
+ */
+void affine2f_TransformAABB(const Affine2f* m, const float* boxIn, float* boxOut) {
+
+    float xMin = m->tx;
+    float xMax = m->tx;
+    float yMin = m->ty;
+    float yMax = m->ty;
+    
+    float e, f;
+    
+    e = m->a * boxIn[0];    f = m->a * boxIn[2];
+    if (e < f) { xMin += e; xMax += f; } else { xMin += f; xMax += e; }
+    
+    e = m->c * boxIn[1];    f = m->c * boxIn[3];
+    if (e < f) { xMin += e; xMax += f; } else { xMin += f; xMax += e; }
+    
+    e = m->b * boxIn[0];    f = m->b * boxIn[2];
+    if (e < f) { yMin += e; yMax += f; } else { yMin += f; yMax += e; }
+    
+    e = m->d * boxIn[1];    f = m->d * boxIn[3];
+    if (e < f) { yMin += e; yMax += f; } else { yMin += f; yMax += e; }
+    
+    boxOut[0] = xMin;
+    boxOut[1] = yMin;
+    boxOut[2] = xMax;
+    boxOut[3] = yMax;
+}
+
+
+/* Drops the Z row/column and the projective row of a column-major 4x4 matrix.
+ */
+void affine2f_FromMat4f(const float* min, Affine2f* mout) {
+
+    mout->a  = min[ 0];
+    mout->b  = min[ 1];
+    mout->c  = min[ 4];
+    mout->d  = min[ 5];
+    mout->tx = min[12];
+    mout->ty = min[13];
+}
+
+
+/* Expands to a column-major 4x4 matrix (Z scale 1), for uploading as a uniform.
+ */
+void affine2f_ToMat4f(const Affine2f* min, float* mout) {
+
+    mout[ 0] = min->a;
+    mout[ 1] = min->b;
+    mout[ 2] = 0.0f;
+    mout[ 3] = 0.0f;
+    
+    mout[ 4] = min->c;
+    mout[ 5] = min->d;
+    mout[ 6] = 0.0f;
+    mout[ 7] = 0.0f;
+    
+    mout[ 8] = 0.0f;
+    mout[ 9] = 0.0f;
+    mout[10] = 1.0f;
+    mout[11] = 0.0f;
+    
+    mout[12] = min->tx;
+    mout[13] = min->ty;
+    mout[14] = 0.0f;
+    mout[15] = 1.0f;
+}
@@ -9,6 +9,27 @@
 #ifndef __DNRMatrix_h__
 #define __DNRMatrix_h__
 
+#include <stddef.h>     // size_t
+
+
+/**
+ 2D affine transform (2x3 matrix). Maps (x, y) to:
+ 
+     x' = a*x + c*y + tx
+     y' = b*x + d*y + ty
+ 
+ The components match elements 0, 1, 4, 5, 12 and 13 of the equivalent
+ column-major 4x4 matrix (Z scale 1, no Z translation); use the 4x4 form only
+ when uploading to the GPU.
+ */
+typedef struct tAffine2f {
+    float a;
+    float b;
+    float c;
+    float d;
+    float tx;
+    float ty;
+} Affine2f;
 
 
 void mat4f_LoadIdentity(float* m);
@@ -43,6 +64,40 @@ void mat4f_SubMatrix3x3(const float* a, float* mout);
 
 void mat4f_MultiplyVec4f(const float* min, const float* vin, float* vout);
 
+void mat4f_TransformVec2Array(const float* m, const void* vin, size_t inStride, void* vout, size_t outStride, size_t count);
+
+
+// Scalar reference implementations of the kernels above (and of
+// affine2f_TransformVec2Array below). The default versions are vectorized
+// (SSE/NEON) where available, and produce identical results.
+
+void mat4f_MultiplyMat4f_Scalar(const float* m1, const float* m2, float* mout);
+
+void mat4f_MultiplyVec4f_Scalar(const float* min, const float* vin, float* vout);
+
+void mat4f_TransformVec2Array_Scalar(const float* m, const void* vin, size_t inStride, void* vout, size_t outStride, size_t count);
+
+
+void affine2f_LoadIdentity(Affine2f* m);
+
+void affine2f_LoadScale(float sx, float sy, Affine2f* m);
+
+void affine2f_MultiplyAffine2f(const Affine2f* m1, const Affine2f* m2, Affine2f* mout);
+
+int affine2f_Invert(const Affine2f* m, Affine2f* invOut);
+
+void affine2f_TransformPoint(const Affine2f* m, const float* vin, float* vout);
+
+void affine2f_TransformVec2Array(const Affine2f* m, const void* vin, size_t inStride, void* vout, size_t outStride, size_t count);
+
+void affine2f_TransformVec2Array_Scalar(const Affine2f* m, const void* vin, size_t inStride, void* vout, size_t outStride, size_t count);
+
+void affine2f_TransformAABB(const Affine2f* m, const float* boxIn, float* boxOut);
+
+void affine2f_FromMat4f(const float* min, Affine2f* mout);
+
+void affine2f_ToMat4f(const Affine2f* min, float* mout);
+
 
 
 #endif  // #defined (__DNRMatrix_h__)
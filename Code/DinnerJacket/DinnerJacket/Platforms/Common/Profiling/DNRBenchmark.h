@@ -0,0 +1,134 @@
+//
+//  DNRBenchmark.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-09.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "DNRSoftwareRenderer.h"
+
+@class DNRScene;
+
+
+/**
+ Where the OpenGL calls of the frames measured go.
+ */
+typedef NS_ENUM(NSUInteger, DNRBenchmarkBackend) {
+
+    DNRBenchmarkBackendNull = 0,    // Discarded (engine cost only)
+    DNRBenchmarkBackendRecording,   // Recorded, then discarded
+    DNRBenchmarkBackendSoftware     // Rasterized on the CPU
+};
+
+
+
+/**
+ @interface DNRBenchmark
+
+ @brief
+    Runs synthetic scenes headless, through DNRSceneController, and reports the
+    time spent per frame in each phase (see DNRProfiler.h).
+
+ @details
+    Each case ticks its scene at a fixed time step: first warmUpFrameCount
+    frames (not measured), then frameCount frames with the profiler enabled.
+    The report is a JSON object meant to be kept per commit and compared:
+
+        { "format": "DNRBenchmark", "version": 1, "timeUnit": "ns",
+          "backend": ..., "width": ..., "height": ..., "timeStep": ...,
+          "warmUpFrames": ..., "frames": ..., "metadata": { ... },
+          "cases": [ { "name": ..., "nodeCount": ...,
+                       "frame":  { "p50", "p99", "mean", "max" },
+                       "phases": { "update", "transform", "traversal",
+                                   "sort", "submission", "present" },
+                       "counters": { "drawCalls", ... },
+                       "gl": { ... }, "glCache": { ... } }, ... ] }
+
+    (Times in nanoseconds; gl and glCache hold means per frame, the latter
+    only when DNR_GLCACHE_STATS is compiled in.)
+
+    The benchmark owns a DNRSoftwareRenderer, which takes OpenGL over (the
+    glDispatch backend, the state cache and the current rasterizer) from
+    initialization to deallocation, when the previous ones are restored; each
+    case also takes over the default scene controller. Run it on the main
+    thread, from a host that is not drawing meanwhile (e.g., a command-line
+    tool or a test bundle linking the framework).
+
+    (Benchmark/DNRCoreBenchmark.c is not a substitute: it times the C kernels
+    the frame is built on, without nodes or tile maps, e.g. on Linux.)
+ */
+@interface DNRBenchmark : NSObject
+
+
+///
+@property (nonatomic, readonly) DNRBenchmarkBackend backend;
+
+/// Draws the scenes (its surface is the visible area).
+@property (nonatomic, readonly) DNRSoftwareRenderer* renderer;
+
+/// Passed to -tick: on every frame. Default is 1/60 s.
+@property (nonatomic, readwrite) CFTimeInterval timeStep;
+
+/// Default is 60.
+@property (nonatomic, readwrite) NSUInteger warmUpFrameCount;
+
+/// Default (and maximum) is ProfilerFrameCapacity.
+@property (nonatomic, readwrite) NSUInteger frameCount;
+
+/// Copied into the report as is (e.g., commit, device, build configuration).
+@property (nonatomic, copy) NSDictionary* metadata;
+
+
+/**
+ Returns nil if the renderer can not be created.
+ */
+- (instancetype) initWithBackend:(DNRBenchmarkBackend) backend
+                           width:(GLsizei) width
+                          height:(GLsizei) height;
+
+
+/**
+ Runs the standard cases: 10,000 flat sprites; 50-level deep hierarchies;
+ and the tile maps Stage00 to Stage09, those found in the main bundle (as
+ compiled .tilemap or as .plist). Returns the report.
+ */
+- (NSDictionary *)runSuite;
+
+
+/**
+ Runs one case, and returns its entry in the report.
+ */
+- (NSDictionary *)runCaseNamed:(NSString *)name scene:(DNRScene *)scene;
+
+
+/**
+ */
+- (BOOL) writeReport:(NSDictionary *)report
+              toFile:(NSString *)path
+               error:(NSError **)error;
+
+
+// Synthetic Scenes (every node moves, every frame)
+
+/**
+ spriteCount solid sprites, children of the scene, laid out on a grid larger
+ than the surface (half of them translucent).
+ */
++ (DNRScene *)flatSceneWithSpriteCount:(NSUInteger) spriteCount;
+
+/**
+ chainCount chains of depth sprites, each the parent of the next.
+ */
++ (DNRScene *)deepSceneWithDepth:(NSUInteger) depth chainCount:(NSUInteger) chainCount;
+
+/**
+ The named tile map, fully loaded (map objects are left out). Returns nil if
+ it is not found in the main bundle.
+ */
++ (DNRScene *)mapSceneNamed:(NSString *)mapName;
+
+
+@end
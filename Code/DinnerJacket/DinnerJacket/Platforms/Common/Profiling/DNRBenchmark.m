@@ -0,0 +1,505 @@
+//
+//  DNRBenchmark.m
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-09.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#import "DNRBenchmark.h"
+
+#import "DNRSceneController.h"
+#import "DNRScene.h"
+#import "DNRSprite.h"
+#import "TileMap.h"
+#import "TimeController.h"
+
+#import "DNRGLCache.h"
+#import "DNRGLDispatch.h"
+#import "DNRGLRecorder.h"
+#import "DNRProfiler.h"
+
+
+#define FlatSpriteCount         10000u
+#define DeepHierarchyDepth      50u
+#define DeepHierarchyChainCount 20u
+#define MapCount                10u
+
+#define GridPitch               12.0f   // Points between flat sprites
+#define SpriteSide              8.0f
+
+// Report keys of the profiler phases, in ProfilerPhase order
+static NSString* const phaseKeys[ProfilerPhaseCount] = {
+    @"update",
+    @"transform",
+    @"traversal",
+    @"sort",
+    @"submission",
+    @"present",
+};
+
+
+// .............................................................................
+
+/**
+ Scene that moves some of its nodes (and with them, their subtrees) on every
+ frame, so that the world transforms are always recomputed.
+ */
+@interface DNRBenchmarkScene : DNRScene
+
+///
+@property (nonatomic, copy) NSArray* movingNodes;
+
+@end
+
+
+@implementation DNRBenchmarkScene {
+    
+    CFTimeInterval  _time;
+    CGPoint*        _origins;
+}
+
+
+- (void) dealloc {
+    free(_origins);
+}
+
+
+- (void) setMovingNodes:(NSArray *)movingNodes {
+
+    _movingNodes = [movingNodes copy];
+    
+    free(_origins);
+    _origins = malloc(MAX([_movingNodes count], 1) * sizeof(CGPoint));
+    
+    [_movingNodes enumerateObjectsUsingBlock:^(DNRNode* node, NSUInteger index, BOOL* stop) {
+        self->_origins[index] = [node position];
+    }];
+}
+
+
+- (void) update:(CFTimeInterval) dt {
+
+    _time += dt;
+    
+    CGFloat dx = 4.0f*cos(_time);
+    CGFloat dy = 4.0f*sin(_time);
+    
+    NSUInteger index = 0;
+    
+    for (DNRNode* node in _movingNodes) {
+        [node setPosition:CGPointMake(_origins[index].x + dx, _origins[index].y + dy)];
+        index++;
+    }
+}
+
+@end
+
+
+// .............................................................................
+
+/**
+ What the benchmark's renderer takes over (see -[DNRSoftwareRenderer
+ makeCurrent]).
+ */
+typedef struct tGLState {
+    
+    GLDispatch          backend;
+    const void*         cacheContext;
+    SoftwareRasterizer* rasterizer;
+
+}GLState;
+
+
+static GLState saveGLState(void) {
+
+    GLState state;
+    
+    state.backend      = glDispatch;
+    state.cacheContext = glCacheCurrentGLContext();
+    state.rasterizer   = softwareRasterizerCurrent();
+    
+    return state;
+}
+
+
+static void restoreGLState(const GLState* state) {
+
+    softwareRasterizerMakeCurrent(state->rasterizer);
+    glDispatchSetBackend(&(state->backend));
+    glCacheMakeCurrent(state->cacheContext);
+}
+
+
+// .............................................................................
+
+@implementation DNRBenchmark {
+    
+    GLRecorder* _recorder;
+    GLState     _previousGLState;   // Before the renderer took over
+}
+
+
+#pragma mark - Initialization
+
+
+- (instancetype) initWithBackend:(DNRBenchmarkBackend) backend
+                           width:(GLsizei) width
+                          height:(GLsizei) height {
+    
+    if ((self = [super init])) {
+        
+        _backend = backend;
+        
+        // (The renderer takes OpenGL over until deallocation)
+        _previousGLState = saveGLState();
+        
+        _renderer = [[DNRSoftwareRenderer alloc] initWithWidth:width
+                                                        height:height
+                                                   threadCount:0];
+        if (!_renderer) {
+            restoreGLState(&_previousGLState);
+            return (self = nil);
+        }
+        
+        if (_backend == DNRBenchmarkBackendRecording) {
+            if (!(_recorder = glRecorderCreate())) {
+                return (self = nil);
+            }
+        }
+        
+        _timeStep         = 1.0/60.0;
+        _warmUpFrameCount = 60;
+        _frameCount       = ProfilerFrameCapacity;
+    }
+    
+    return self;
+}
+
+
+- (void) dealloc {
+
+    if (_recorder) {
+        glRecorderDestroy(_recorder);
+    }
+    
+    if (_renderer) {
+        // (The renderer deletes its objects through its own backend, and then
+        // installs the native one)
+        [_renderer makeCurrent];
+        _renderer = nil;
+        
+        restoreGLState(&_previousGLState);
+    }
+}
+
+
+#pragma mark - Operation
+
+
+- (NSDictionary *)runSuite {
+
+    NSMutableArray* cases = [NSMutableArray new];
+    
+    @autoreleasepool {
+        DNRScene* scene = [DNRBenchmark flatSceneWithSpriteCount:FlatSpriteCount];
+        
+        [cases addObject:[self runCaseNamed:@"flat_10k" scene:scene]];
+    }
+    
+    @autoreleasepool {
+        DNRScene* scene = [DNRBenchmark deepSceneWithDepth:DeepHierarchyDepth
+                                                chainCount:DeepHierarchyChainCount];
+        
+        [cases addObject:[self runCaseNamed:@"deep_50" scene:scene]];
+    }
+    
+    for (NSUInteger i = 0; i < MapCount; i++) {
+        @autoreleasepool {
+            NSString* mapName = [NSString stringWithFormat:@"Stage%02lu", (unsigned long)i];
+            
+            DNRScene* scene = [DNRBenchmark mapSceneNamed:mapName];
+            
+            if (scene) {
+                [cases addObject:[self runCaseNamed:[mapName lowercaseString] scene:scene]];
+            }
+        }
+    }
+    
+    static NSString* const backendNames[] = { @"null", @"recording", @"software" };
+    
+    return @{ @"format"       : @"DNRBenchmark",
+              @"version"      : @1,
+              @"timeUnit"     : @"ns",
+              @"backend"      : backendNames[_backend],
+              @"width"        : @([_renderer width]),
+              @"height"       : @([_renderer height]),
+              @"timeStep"     : @(_timeStep),
+              @"warmUpFrames" : @(_warmUpFrameCount),
+              @"frames"       : @([self measuredFrameCount]),
+              @"metadata"     : (_metadata ? _metadata : @{}),
+              @"cases"        : cases };
+}
+
+
+- (NSDictionary *)runCaseNamed:(NSString *)name scene:(DNRScene *)scene {
+
+    // (Normally the renderer's already; the caller's are restored at the end)
+    GLState callerGLState = saveGLState();
+    
+    [_renderer makeCurrent];
+    
+    DNRSceneController* controller = [DNRSceneController defaultController];
+    
+    // Take the controller over (nothing else must tick it meanwhile)
+    [[TimeController sharedController] removeSceneController:controller];
+    [controller setRenderer:_renderer];
+    [controller runScene:scene];
+    
+    int profilerWasEnabled = profilerIsEnabled();
+    
+    // 1. Install the backend (the scene is built and its textures uploaded)
+    if (_backend == DNRBenchmarkBackendNull) {
+        glDispatchSetBackend(glDispatchNullBackend());
+    }
+    else if (_backend == DNRBenchmarkBackendRecording) {
+        glRecorderReset(_recorder);
+        glRecorderStart(_recorder, NULL);
+    }
+    
+    // 2. Warm up (buffers grow, caches fill)
+    for (NSUInteger i = 0; i < _warmUpFrameCount; i++) {
+        [controller tick:_timeStep];
+    }
+    
+    // 3. Measure
+    NSUInteger frameCount = [self measuredFrameCount];
+    
+    profilerSetEnabled(0);
+    profilerSetEnabled(1);      // (Starts over)
+    
+    glDispatchResetCounters();
+    glCacheResetStats();
+    
+    if (_recorder) {
+        glRecorderReset(_recorder);
+    }
+    
+    for (NSUInteger i = 0; i < frameCount; i++) {
+        [controller tick:_timeStep];
+        
+        if (_recorder) {
+            glRecorderMarkFrame(_recorder);
+        }
+    }
+    
+    // 4. Collect
+    NSMutableDictionary* result = [NSMutableDictionary new];
+    
+    result[@"name"]      = name;
+    result[@"nodeCount"] = @([scene subtreeSize]);
+    result[@"frame"]     = [self dictionaryWithStats:profilerFrameStats()];
+    
+    NSMutableDictionary* phases = [NSMutableDictionary new];
+    
+    for (int phase = 0; phase < ProfilerPhaseCount; phase++) {
+        phases[phaseKeys[phase]] = [self dictionaryWithStats:profilerPhaseStats((ProfilerPhase)phase)];
+    }
+    result[@"phases"] = phases;
+    
+    NSMutableDictionary* counters = [NSMutableDictionary new];
+    
+    for (int counter = 0; counter < ProfilerCounterCount; counter++) {
+        NSString* key = [NSString stringWithUTF8String:profilerCounterName((ProfilerCounter)counter)];
+        
+        counters[key] = [self dictionaryWithStats:profilerCounterStats((ProfilerCounter)counter)];
+    }
+    result[@"counters"] = counters;
+    
+    if (_backend != DNRBenchmarkBackendSoftware) {
+        // (Only the null backend counts)
+        GLDispatchCounters gl = glDispatchCounters();
+        
+        NSMutableDictionary* glPerFrame = [@{ @"calls"         : @(gl.calls / frameCount),
+                                              @"drawCalls"     : @(gl.drawCalls / frameCount),
+                                              @"elementCount"  : @(gl.elementCount / frameCount),
+                                              @"stateChanges"  : @(gl.stateChanges / frameCount),
+                                              @"bytesUploaded" : @(gl.bytesUploaded / frameCount) } mutableCopy];
+        if (_recorder) {
+            size_t size = 0;
+            glRecorderBytes(_recorder, &size);
+            
+            glPerFrame[@"bytesRecorded"] = @(size / frameCount);
+        }
+        result[@"gl"] = glPerFrame;
+    }
+
+#if DNR_GLCACHE_STATS
+    // (The frame's counts are rolled over by the scene controller)
+    GLCacheStats cache = glCacheCumulativeStats();
+    
+    result[@"glCache"] = @{ @"hits"   : @(cache.total.hits / frameCount),
+                            @"misses" : @(cache.total.misses / frameCount) };
+#endif
+    
+    // 5. Restore
+    profilerSetEnabled(profilerWasEnabled);
+    
+    if (_backend == DNRBenchmarkBackendRecording) {
+        glRecorderStop(_recorder);
+    }
+    [_renderer makeCurrent];
+    glCacheInvalidate();                    // (It tracked the other backend)
+    
+    // (The last frame leaves the rasterizer idle)
+    [controller runScene:[DNRScene new]];
+    [controller setRenderer:nil];           // (Back to the view's, if any)
+    [[TimeController sharedController] addSceneController:controller];
+    
+    restoreGLState(&callerGLState);
+    
+    return result;
+}
+
+
+- (BOOL) writeReport:(NSDictionary *)report
+              toFile:(NSString *)path
+               error:(NSError **)error {
+    
+    NSData* data = [NSJSONSerialization dataWithJSONObject:report
+                                                   options:NSJSONWritingPrettyPrinted
+                                                     error:error];
+    if (!data) {
+        return NO;
+    }
+    
+    return [data writeToFile:path options:NSDataWritingAtomic error:error];
+}
+
+
+#pragma mark - Synthetic Scenes
+
+
++ (DNRScene *)flatSceneWithSpriteCount:(NSUInteger) spriteCount {
+
+    DNRBenchmarkScene* scene = [DNRBenchmarkScene new];
+    
+    NSMutableArray* sprites = [NSMutableArray arrayWithCapacity:spriteCount];
+    
+    NSUInteger columnCount = (NSUInteger)ceil(sqrt((double)spriteCount));
+    CGFloat    halfWidth   = 0.5f*GridPitch*columnCount;
+    
+    for (NSUInteger i = 0; i < spriteCount; i++) {
+        
+        // (Every other sprite needs blending)
+        Color4f color = Color4fMake((i % 7)/6.0f, (i % 5)/4.0f, (i % 3)/2.0f, (i % 2) ? 0.5f : 1.0f);
+        
+        DNRSprite* sprite = [[DNRSprite alloc] initWithSize:CGSizeMake(SpriteSide, SpriteSide)
+                                                      color:color];
+        
+        [sprite setPosition:CGPointMake(GridPitch*(i % columnCount) - halfWidth,
+                                        GridPitch*(i / columnCount) - halfWidth)];
+        [scene addChild:sprite];
+        [sprites addObject:sprite];
+    }
+    
+    [scene setMovingNodes:sprites];
+    
+    return scene;
+}
+
+
++ (DNRScene *)deepSceneWithDepth:(NSUInteger) depth chainCount:(NSUInteger) chainCount {
+
+    DNRBenchmarkScene* scene = [DNRBenchmarkScene new];
+    
+    NSMutableArray* chains = [NSMutableArray arrayWithCapacity:chainCount];
+    
+    for (NSUInteger chain = 0; chain < chainCount; chain++) {
+        
+        DNRNode* parent = scene;
+        
+        for (NSUInteger level = 0; level < depth; level++) {
+            
+            DNRSprite* sprite = [[DNRSprite alloc] initWithSize:CGSizeMake(SpriteSide, SpriteSide)
+                                                          color:Color4fMake(1.0f, level/(GLfloat)depth, 0.0f, 1.0f)];
+            if (level == 0) {
+                // (Chains side by side, across the surface)
+                [sprite setPosition:CGPointMake(GridPitch*chain - 0.5f*GridPitch*chainCount, 0.0f)];
+                [chains addObject:sprite];
+            }
+            else{
+                [sprite setPosition:CGPointMake(0.0f, 2.0f)];
+            }
+            
+            [parent addChild:sprite];
+            parent = sprite;
+        }
+    }
+    
+    // (Moving the root of each chain invalidates all of it)
+    [scene setMovingNodes:chains];
+    
+    return scene;
+}
+
+
++ (DNRScene *)mapSceneNamed:(NSString *)mapName {
+
+    // Prefer the compiled map (see scripts/compile_tilemap.py), if bundled:
+    NSString* compiledPath = [[NSBundle mainBundle] pathForResource:mapName ofType:@"tilemap"];
+    NSString* path         = [[NSBundle mainBundle] pathForResource:mapName ofType:@"plist"];
+    
+    TileMap* map = nil;
+    
+    if (compiledPath) {
+        map = [[TileMap alloc] initWithContentsOfFile:compiledPath dataSource:nil];
+    }
+    else if (path) {
+        map = [[TileMap alloc] initWithDictionary:[NSDictionary dictionaryWithContentsOfFile:path]
+                                       dataSource:nil];
+    }
+    
+    if (!map) {
+        return nil;
+    }
+    
+    // Wait for the load (completes on the main queue, hence the run loop)
+    __block BOOL loaded = NO;
+    
+    [map beginAsyncLoadingWithCompletionHandler:^(void){
+        loaded = YES;
+    }];
+    
+    while (!loaded) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    
+    DNRBenchmarkScene* scene = [DNRBenchmarkScene new];
+    
+    [scene addChild:map];
+    [scene setMovingNodes:@[map]];
+    
+    return scene;
+}
+
+
+#pragma mark - Internal Operation
+
+
+- (NSUInteger) measuredFrameCount {
+    return MAX(1, MIN(_frameCount, ProfilerFrameCapacity));
+}
+
+
+- (NSDictionary *)dictionaryWithStats:(ProfilerStats) stats {
+
+    return @{ @"p50"  : @(stats.p50),
+              @"p99"  : @(stats.p99),
+              @"mean" : @(stats.mean),
+              @"max"  : @(stats.max) };
+}
+
+
+@end
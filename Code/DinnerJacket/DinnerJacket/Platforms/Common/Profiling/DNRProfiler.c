@@ -0,0 +1,381 @@
+//
+//  DNRProfiler.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-08.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stddef.h>     // offsetof()
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>     // (clock_gettime() needs macOS 10.12/iOS 10)
+#endif
+
+#include "DNRProfiler.h"
+
+
+// Phase occurrences recorded per frame (further ones still add to the totals)
+#define MaxEventsPerFrame       64u
+
+// Phases open at once
+#define MaxNestingDepth         16u
+
+
+typedef struct tProfilerEvent {
+
+    uint64_t        start;          // Nanoseconds, since the profiler's epoch
+    uint64_t        duration;
+    ProfilerPhase   phase;
+
+}ProfilerEvent;
+
+
+typedef struct tProfilerFrame {
+
+    uint64_t        start;
+    uint64_t        duration;
+    uint64_t        phaseTotals[ProfilerPhaseCount];
+    uint64_t        counters[ProfilerCounterCount];
+    ProfilerEvent   events[MaxEventsPerFrame];
+    uint32_t        eventCount;
+
+}ProfilerFrame;
+
+
+static int              enabled = 0;
+
+static ProfilerFrame*   frames = NULL;      // Ring
+static uint32_t         frameCount = 0;     // Recorded (up to capacity)
+static uint32_t         nextFrame = 0;      // Ring position of the next frame
+
+static ProfilerFrame    currentFrame;
+
+// Open phases (indices into currentFrame.events, or ~0 once it is full)
+static uint32_t         openEvents[MaxNestingDepth];
+static uint8_t          openPhases[MaxNestingDepth];
+static uint32_t         openCount = 0;
+static uint64_t         openStarts[MaxNestingDepth];
+
+// Only the thread that began the frame is measured
+static _Thread_local int measuring = 0;
+
+static uint64_t         epoch = 0;
+
+
+static const char* phaseNames[ProfilerPhaseCount] = {
+    "Tick",
+    "Transforms",
+    "Traversal",
+    "Sort",
+    "Render",
+    "Present",
+};
+
+static const char* counterNames[ProfilerCounterCount] = {
+    "drawCalls",
+    "stateChangesSkipped",
+    "nodesVisited",
+    "nodesCulled",
+};
+
+
+// .............................................................................
+#pragma mark - Time
+
+
+static uint64_t now(void) {
+
+#ifdef __APPLE__
+    static mach_timebase_info_data_t timebase;
+
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+}
+
+
+// .............................................................................
+#pragma mark - Recording
+
+
+int profilerSetEnabled(int enable) {
+
+    if (enable && !frames) {
+        frames = (ProfilerFrame *)malloc(ProfilerFrameCapacity * sizeof(ProfilerFrame));
+
+        if (!frames) {
+            return 0;
+        }
+    }
+
+    if (enable && !enabled) {
+        frameCount = 0;
+        nextFrame  = 0;
+        epoch      = now();
+    }
+
+    enabled   = enable;
+    measuring = 0;
+
+    return 1;
+}
+
+
+int profilerIsEnabled(void) {
+    return enabled;
+}
+
+
+void profilerBeginFrame(void) {
+
+    if (!enabled) {
+        return;
+    }
+
+    memset(&currentFrame, 0, offsetof(ProfilerFrame, events));
+
+    currentFrame.eventCount = 0;
+    openCount = 0;
+    measuring = 1;
+
+    currentFrame.start = now() - epoch;
+}
+
+
+void profilerEndFrame(void) {
+
+    if (!enabled || !measuring) {
+        return;
+    }
+
+    uint64_t end = now() - epoch;
+
+    while (openCount > 0) {
+        profilerEnd((ProfilerPhase)openPhases[openCount - 1]);
+    }
+
+    currentFrame.duration = end - currentFrame.start;
+
+    // (Copy only the events used)
+    ProfilerFrame* frame = &frames[nextFrame];
+
+    memcpy(frame, &currentFrame, offsetof(ProfilerFrame, events));
+    memcpy(frame->events, currentFrame.events, currentFrame.eventCount * sizeof(ProfilerEvent));
+
+    frame->eventCount = currentFrame.eventCount;
+
+    nextFrame = (nextFrame + 1) % ProfilerFrameCapacity;
+
+    if (frameCount < ProfilerFrameCapacity) {
+        frameCount++;
+    }
+
+    measuring = 0;
+}
+
+
+void profilerBegin(ProfilerPhase phase) {
+
+    if (!enabled || !measuring || openCount == MaxNestingDepth) {
+        return;
+    }
+
+    uint64_t start = now() - epoch;
+    uint32_t event = ~0u;
+
+    if (currentFrame.eventCount < MaxEventsPerFrame) {
+        event = currentFrame.eventCount++;
+
+        currentFrame.events[event].start = start;
+        currentFrame.events[event].phase = phase;
+    }
+
+    openEvents[openCount] = event;
+    openPhases[openCount] = (uint8_t)phase;
+    openStarts[openCount] = start;
+    openCount++;
+}
+
+
+void profilerEnd(ProfilerPhase phase) {
+
+    if (!enabled || !measuring || openCount == 0 || openPhases[openCount - 1] != phase) {
+        return;
+    }
+
+    openCount--;
+
+    uint64_t duration = (now() - epoch) - openStarts[openCount];
+
+    if (openEvents[openCount] != ~0u) {
+        currentFrame.events[openEvents[openCount]].duration = duration;
+    }
+
+    // (Nested occurrences of the same phase are already counted by the
+    //  outer one)
+    for (uint32_t i = 0; i < openCount; i++) {
+        if (openPhases[i] == phase) {
+            return;
+        }
+    }
+
+    currentFrame.phaseTotals[phase] += duration;
+}
+
+
+void profilerCount(ProfilerCounter counter, uint64_t amount) {
+
+    if (measuring) {
+        currentFrame.counters[counter] += amount;
+    }
+}
+
+
+// .............................................................................
+#pragma mark - Statistics
+
+
+static int compareValues(const void* a, const void* b) {
+
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+static uint64_t percentile(const uint64_t* sortedValues, uint32_t count, uint32_t percent) {
+
+    // Nearest rank: the smallest value with at least percent% of the values
+    // at or below it
+    uint32_t rank = (uint32_t)(((uint64_t)percent * count + 99) / 100);
+
+    return sortedValues[(rank > 0) ? rank - 1 : 0];
+}
+
+
+/**
+ Statistics of the value at byte offset in each frame kept.
+ */
+static ProfilerStats statsAtOffset(size_t offset) {
+
+    ProfilerStats stats = { 0 };
+
+    if (frameCount == 0) {
+        return stats;
+    }
+
+    uint64_t* values = (uint64_t *)malloc(frameCount * sizeof(uint64_t));
+
+    if (!values) {
+        return stats;
+    }
+
+    uint64_t sum = 0;
+
+    for (uint32_t i = 0; i < frameCount; i++) {
+        memcpy(&values[i], (const uint8_t *)&frames[i] + offset, sizeof(uint64_t));
+        sum += values[i];
+    }
+
+    qsort(values, frameCount, sizeof(uint64_t), compareValues);
+
+    stats.frameCount = frameCount;
+    stats.p50        = percentile(values, frameCount, 50);
+    stats.p99        = percentile(values, frameCount, 99);
+    stats.mean       = sum / frameCount;
+    stats.max        = values[frameCount - 1];
+
+    free(values);
+
+    return stats;
+}
+
+
+ProfilerStats profilerPhaseStats(ProfilerPhase phase) {
+    return statsAtOffset(offsetof(ProfilerFrame, phaseTotals) + phase * sizeof(uint64_t));
+}
+
+
+ProfilerStats profilerFrameStats(void) {
+    return statsAtOffset(offsetof(ProfilerFrame, duration));
+}
+
+
+ProfilerStats profilerCounterStats(ProfilerCounter counter) {
+    return statsAtOffset(offsetof(ProfilerFrame, counters) + counter * sizeof(uint64_t));
+}
+
+
+const char* profilerPhaseName(ProfilerPhase phase) {
+    return (phase < ProfilerPhaseCount) ? phaseNames[phase] : "Unknown";
+}
+
+
+const char* profilerCounterName(ProfilerCounter counter) {
+    return (counter < ProfilerCounterCount) ? counterNames[counter] : "unknown";
+}
+
+
+// .............................................................................
+#pragma mark - Export
+
+
+int profilerWriteChromeTrace(const char* path) {
+
+    FILE* file = fopen(path, "w");
+
+    if (!file) {
+        return 0;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    const char* separator = "";
+
+    // Oldest first
+    uint32_t first = (frameCount < ProfilerFrameCapacity) ? 0 : nextFrame;
+
+    for (uint32_t n = 0; n < frameCount; n++) {
+
+        const ProfilerFrame* frame = &frames[(first + n) % ProfilerFrameCapacity];
+
+        // (Timestamps are in microseconds)
+        fprintf(file, "%s{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                separator, frame->start / 1000.0, frame->duration / 1000.0);
+        separator = ",\n";
+
+        for (uint32_t i = 0; i < frame->eventCount; i++) {
+            const ProfilerEvent* event = &(frame->events[i]);
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                    phaseNames[event->phase], event->start / 1000.0, event->duration / 1000.0);
+        }
+
+        fprintf(file, ",\n{\"name\":\"Counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{", frame->start / 1000.0);
+
+        for (uint32_t c = 0; c < ProfilerCounterCount; c++) {
+            fprintf(file, "%s\"%s\":%llu", c ? "," : "", counterNames[c], (unsigned long long)frame->counters[c]);
+        }
+
+        fprintf(file, "}}");
+    }
+
+    fprintf(file, "\n]}\n");
+
+    int failed = ferror(file);
+
+    return (fclose(file) == 0) && !failed;
+}
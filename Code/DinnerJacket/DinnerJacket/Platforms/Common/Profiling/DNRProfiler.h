@@ -0,0 +1,149 @@
+//
+//  DNRProfiler.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-08.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRProfiler_h__
+#define __DNRProfiler_h__
+
+#include <stdint.h>
+
+
+/*
+ Frame profiler: times the phases of each frame (see ProfilerPhase) with
+ nested begin/end pairs, and tallies per-frame counters. The last
+ ProfilerFrameCapacity frames are kept, for statistics and for export in the
+ Chrome trace event format (load the file in chrome://tracing or any viewer
+ that reads it).
+
+ Disabled by default; while disabled, every function returns right away. The
+ frame is delimited by DNRSceneController (profilerBeginFrame/EndFrame), and
+ only the thread that began it is measured: calls from other threads (e.g.,
+ texture loading) are ignored.
+ */
+
+
+/// Number of frames kept
+#define ProfilerFrameCapacity   300u
+
+
+/**
+ */
+typedef enum {
+
+    ProfilerPhaseTick = 0,      // -[DNRNode tick:] on the root (actions, updates)
+    ProfilerPhaseTransforms,    // World transform update
+    ProfilerPhaseTraversal,     // Depth-first visit, opaque/translucent split
+    ProfilerPhaseSort,          // Depth (z) assignment
+    ProfilerPhaseRender,        // Culling, node rendering, batch flush
+    ProfilerPhasePresent,       // -endFrame, transition compositing
+
+    ProfilerPhaseCount
+
+}ProfilerPhase;
+
+
+/**
+ */
+typedef enum {
+
+    ProfilerCounterDrawCalls = 0,
+    ProfilerCounterStateChangesSkipped,     // Redundant calls DNRGLCache elided
+    ProfilerCounterNodesVisited,
+    ProfilerCounterNodesCulled,
+
+    ProfilerCounterCount
+
+}ProfilerCounter;
+
+
+/**
+ Distribution of one quantity over the frames kept (nanoseconds for phases and
+ frames, occurrences for counters). Percentiles are nearest-rank.
+ */
+typedef struct tProfilerStats {
+
+    uint32_t    frameCount;
+    uint64_t    p50;
+    uint64_t    p99;
+    uint64_t    mean;
+    uint64_t    max;
+
+}ProfilerStats;
+
+
+/**
+ Enabling (re)starts with no frames recorded. Returns 0 if out of memory.
+ */
+int profilerSetEnabled(int enabled);
+
+/**
+ */
+int profilerIsEnabled(void);
+
+
+/**
+ Starts a frame on the calling thread. A frame left open is discarded.
+ */
+void profilerBeginFrame(void);
+
+/**
+ Closes the frame (and any phases still open) and adds it to the ring.
+ */
+void profilerEndFrame(void);
+
+
+/**
+ Phases nest (e.g., Render within a transition's pass); a phase that occurs
+ several times in a frame adds up.
+ */
+void profilerBegin(ProfilerPhase phase);
+
+/**
+ Closes the innermost open phase, which must be phase.
+ */
+void profilerEnd(ProfilerPhase phase);
+
+
+/**
+ */
+void profilerCount(ProfilerCounter counter, uint64_t amount);
+
+
+/**
+ Per-frame time spent in phase.
+ */
+ProfilerStats profilerPhaseStats(ProfilerPhase phase);
+
+/**
+ Whole frame time (begin to end).
+ */
+ProfilerStats profilerFrameStats(void);
+
+/**
+ Per-frame counts.
+ */
+ProfilerStats profilerCounterStats(ProfilerCounter counter);
+
+
+/**
+ */
+const char* profilerPhaseName(ProfilerPhase phase);
+
+/**
+ */
+const char* profilerCounterName(ProfilerCounter counter);
+
+
+/**
+ Writes the frames kept to path as Chrome trace JSON: one complete ("X")
+ event per frame and phase occurrence, and one counter ("C") event per frame.
+ Returns 0 on failure.
+ */
+int profilerWriteChromeTrace(const char* path);
+
+
+#endif  // #defined (__DNRProfiler_h__)
@@ -0,0 +1,103 @@
+//
+//  DNRResourceCache.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-01.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "DNRResourceCommon.h"
+
+
+/**
+ @interface DNRResourceCache
+ 
+ @brief
+    Keeps loaded resources (textures, texture atlases) for reuse, within a
+    memory budget.
+ 
+ @details
+    Each entry is charged its -memorySize. Whenever the total exceeds the
+    budget, the least recently used entries that are not in use are evicted
+    until it fits again (entries in use are kept even if that means staying
+    over budget; they are evicted later, once released and if still needed).
+    
+    All methods are thread safe. Evicted objects are always released on the
+    main thread, so that their OpenGL objects are deleted in the main context.
+ */
+@interface DNRResourceCache : NSObject
+
+
+/// Maximum total memory size of the cached objects, in bytes. Default is
+/// 64 MB. Lowering it evicts right away.
+@property (readwrite) NSUInteger budget;
+
+/// Total memory size of the cached objects, in bytes.
+@property (readonly ) NSUInteger totalSize;
+
+/// Number of cached objects.
+@property (readonly ) NSUInteger count;
+
+
+// Statistics (since creation or the last call to -resetStatistics)
+
+/// Lookups that found the object.
+@property (readonly ) NSUInteger hitCount;
+
+/// Lookups that did not.
+@property (readonly ) NSUInteger missCount;
+
+/// Objects removed to stay within budget or by -purgeUnusedObjects.
+@property (readonly ) NSUInteger evictionCount;
+
+
+/**
+ Used by DNRTexture and DNRTextureAtlas.
+ */
++ (instancetype) sharedCache;
+
+
+/**
+ Returns the object cached for key (and marks it as the most recently used),
+ or nil.
+ */
+- (id) objectForKey:(NSString *)key;
+
+
+/**
+ Caches the object (replacing any other object cached for the same key), and
+ evicts others if over budget. The object itself is not evicted until the
+ next trim (e.g., when its owner relinquishes it), even if not in use yet.
+ */
+- (void) setObject:(id<DNRCacheableResource>)object forKey:(NSString *)key;
+
+
+/**
+ */
+- (void) removeObjectForKey:(NSString *)key;
+
+
+/**
+ Evicts least recently used objects not in use until within budget. Called
+ automatically on insertion; owners should also call it when they stop using
+ an object (so that it can go, if needed).
+ */
+- (void) trimToBudget;
+
+
+/**
+ Evicts all the objects that are not in use, regardless of budget (e.g., on a
+ memory warning). Pass nil to consider all classes. Returns the number of
+ objects evicted.
+ */
+- (NSUInteger) purgeUnusedObjectsOfClass:(Class) objectClass;
+
+
+/**
+ Zeroes the hit, miss and eviction counts.
+ */
+- (void) resetStatistics;
+
+@end
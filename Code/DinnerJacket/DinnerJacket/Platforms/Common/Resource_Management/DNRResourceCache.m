@@ -0,0 +1,404 @@
+//
+//  DNRResourceCache.m
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-01.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#import "DNRResourceCache.h"
+
+#import <pthread.h>
+
+
+#define DNRResourceCacheDefaultBudget   (64u*1024u*1024u)
+
+
+// .............................................................................
+
+/**
+ Node of the recency list (most recently used first). Retained by the cache's
+ dictionary only; the links are unretained.
+ */
+@interface DNRResourceCacheEntry : NSObject {
+@public
+    NSString*                               _key;
+    id<DNRCacheableResource>                _object;
+    NSUInteger                              _cost;
+    
+    __unsafe_unretained DNRResourceCacheEntry*  _previous;
+    __unsafe_unretained DNRResourceCacheEntry*  _next;
+}
+@end
+
+@implementation DNRResourceCacheEntry
+@end
+
+
+// .............................................................................
+
+@implementation DNRResourceCache {
+    
+    pthread_mutex_t         _mutex;
+    
+    NSMutableDictionary*    _entriesByKey;
+    
+    __unsafe_unretained DNRResourceCacheEntry*  _head;    // Most recently used
+    __unsafe_unretained DNRResourceCacheEntry*  _tail;    // Least recently used
+    
+    NSUInteger              _budget;
+    NSUInteger              _totalSize;
+    
+    NSUInteger              _hitCount;
+    NSUInteger              _missCount;
+    NSUInteger              _evictionCount;
+}
+
+
+#pragma mark - Factory / Initialization
+
+
++ (instancetype) sharedCache {
+
+    static DNRResourceCache* sharedCache = nil;
+    
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedCache = [DNRResourceCache new];
+    });
+    
+    return sharedCache;
+}
+
+
+- (instancetype) init {
+
+    if ((self = [super init])) {
+        
+        pthread_mutex_init(&_mutex, NULL);
+        
+        _entriesByKey = [NSMutableDictionary new];
+        _budget       = DNRResourceCacheDefaultBudget;
+    }
+    
+    return self;
+}
+
+
+- (void) dealloc {
+
+    pthread_mutex_destroy(&_mutex);
+}
+
+
+#pragma mark - Custom Accessors
+
+
+- (NSUInteger) budget {
+
+    pthread_mutex_lock(&_mutex);
+    NSUInteger budget = _budget;
+    pthread_mutex_unlock(&_mutex);
+    
+    return budget;
+}
+
+
+- (void) setBudget:(NSUInteger) budget {
+
+    pthread_mutex_lock(&_mutex);
+    _budget = budget;
+    pthread_mutex_unlock(&_mutex);
+    
+    [self trimToBudget];
+}
+
+
+- (NSUInteger) totalSize {
+
+    pthread_mutex_lock(&_mutex);
+    NSUInteger totalSize = _totalSize;
+    pthread_mutex_unlock(&_mutex);
+    
+    return totalSize;
+}
+
+
+- (NSUInteger) count {
+
+    pthread_mutex_lock(&_mutex);
+    NSUInteger count = [_entriesByKey count];
+    pthread_mutex_unlock(&_mutex);
+    
+    return count;
+}
+
+
+- (NSUInteger) hitCount {
+
+    pthread_mutex_lock(&_mutex);
+    NSUInteger hitCount = _hitCount;
+    pthread_mutex_unlock(&_mutex);
+    
+    return hitCount;
+}
+
+
+- (NSUInteger) missCount {
+
+    pthread_mutex_lock(&_mutex);
+    NSUInteger missCount = _missCount;
+    pthread_mutex_unlock(&_mutex);
+    
+    return missCount;
+}
+
+
+- (NSUInteger) evictionCount {
+
+    pthread_mutex_lock(&_mutex);
+    NSUInteger evictionCount = _evictionCount;
+    pthread_mutex_unlock(&_mutex);
+    
+    return evictionCount;
+}
+
+
+#pragma mark - Recency List (Call With The Mutex Locked)
+
+
+- (void) unlinkEntry:(DNRResourceCacheEntry *)entry {
+
+    if (entry->_previous) {
+        entry->_previous->_next = entry->_next;
+    }
+    else{
+        _head = entry->_next;
+    }
+    
+    if (entry->_next) {
+        entry->_next->_previous = entry->_previous;
+    }
+    else{
+        _tail = entry->_previous;
+    }
+    
+    entry->_previous = nil;
+    entry->_next     = nil;
+}
+
+
+- (void) linkEntryAtHead:(DNRResourceCacheEntry *)entry {
+
+    entry->_previous = nil;
+    entry->_next     = _head;
+    
+    if (_head) {
+        _head->_previous = entry;
+    }
+    else{
+        _tail = entry;
+    }
+    
+    _head = entry;
+}
+
+
+- (void) removeEntry:(DNRResourceCacheEntry *)entry
+            intoArray:(NSMutableArray *)removedObjects {
+    
+    [removedObjects addObject:entry->_object];
+    
+    [self unlinkEntry:entry];
+    
+    _totalSize -= entry->_cost;
+    
+    [_entriesByKey removeObjectForKey:entry->_key];
+}
+
+
+/**
+ Evicts from the least recently used end, skipping objects in use (and
+ sparedEntry, if not nil), until the total fits in the budget (or, if purging,
+ until the end of the list).
+ */
+- (void) evictIntoArray:(NSMutableArray *)evictedObjects
+               purging:(BOOL) purging
+                 class:(Class) objectClass
+                sparing:(DNRResourceCacheEntry *)sparedEntry {
+    
+    DNRResourceCacheEntry* entry = _tail;
+    
+    while (entry && (purging || _totalSize > _budget)) {
+        
+        DNRResourceCacheEntry* previous = entry->_previous;
+        
+        BOOL eligible = (objectClass == nil || [entry->_object isKindOfClass:objectClass]);
+        
+        if (eligible && entry != sparedEntry && ![entry->_object isInUse]) {
+            [self removeEntry:entry intoArray:evictedObjects];
+            _evictionCount++;
+        }
+        
+        entry = previous;
+    }
+}
+
+
+/**
+ Releases the objects on the main thread (deleting OpenGL objects, if last
+ reference). Must be called with the mutex unlocked: releasing can cause
+ owners to call back into the cache.
+ */
+static void releaseObjectsOnMainThread(NSMutableArray* objects) {
+
+    if ([objects count] == 0 || [NSThread isMainThread]) {
+        return;  // (Released by the caller, on return)
+    }
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [objects removeAllObjects];
+    });
+}
+
+
+#pragma mark - Operation
+
+
+- (id) objectForKey:(NSString *)key {
+
+    if (!key) {
+        return nil;
+    }
+    
+    pthread_mutex_lock(&_mutex);
+    
+    DNRResourceCacheEntry* entry  = [_entriesByKey objectForKey:key];
+    id                     object = nil;
+    
+    if (entry) {
+        _hitCount++;
+        
+        [self unlinkEntry:entry];
+        [self linkEntryAtHead:entry];
+        
+        object = entry->_object;
+    }
+    else{
+        _missCount++;
+    }
+    
+    pthread_mutex_unlock(&_mutex);
+    
+    return object;
+}
+
+
+- (void) setObject:(id<DNRCacheableResource>)object forKey:(NSString *)key {
+
+    if (!object || !key) {
+        return;
+    }
+    
+    NSMutableArray* removedObjects = [NSMutableArray new];
+    
+    DNRResourceCacheEntry* entry = [DNRResourceCacheEntry new];
+    
+    entry->_key    = [key copy];
+    entry->_object = object;
+    entry->_cost   = [object memorySize];
+    
+    pthread_mutex_lock(&_mutex);
+    
+    DNRResourceCacheEntry* existing = [_entriesByKey objectForKey:key];
+    
+    if (existing) {
+        [self removeEntry:existing intoArray:removedObjects];
+    }
+    
+    [_entriesByKey setObject:entry forKey:entry->_key];
+    [self linkEntryAtHead:entry];
+    
+    _totalSize += entry->_cost;
+    
+    // (Not the new entry: its owner has yet to use it, and evicting it now
+    //  would have the next request load a second copy)
+    [self evictIntoArray:removedObjects purging:NO class:nil sparing:entry];
+    
+    pthread_mutex_unlock(&_mutex);
+    
+    releaseObjectsOnMainThread(removedObjects);
+}
+
+
+- (void) removeObjectForKey:(NSString *)key {
+
+    if (!key) {
+        return;
+    }
+    
+    NSMutableArray* removedObjects = [NSMutableArray new];
+    
+    pthread_mutex_lock(&_mutex);
+    
+    DNRResourceCacheEntry* entry = [_entriesByKey objectForKey:key];
+    
+    if (entry) {
+        [self removeEntry:entry intoArray:removedObjects];
+    }
+    
+    pthread_mutex_unlock(&_mutex);
+    
+    releaseObjectsOnMainThread(removedObjects);
+}
+
+
+- (void) trimToBudget {
+
+    NSMutableArray* evictedObjects = nil;
+    
+    pthread_mutex_lock(&_mutex);
+    
+    if (_totalSize > _budget) {
+        evictedObjects = [NSMutableArray new];
+        
+        [self evictIntoArray:evictedObjects purging:NO class:nil sparing:nil];
+    }
+    
+    pthread_mutex_unlock(&_mutex);
+    
+    releaseObjectsOnMainThread(evictedObjects);
+}
+
+
+- (NSUInteger) purgeUnusedObjectsOfClass:(Class) objectClass {
+
+    NSMutableArray* evictedObjects = [NSMutableArray new];
+    
+    pthread_mutex_lock(&_mutex);
+    
+    [self evictIntoArray:evictedObjects purging:YES class:objectClass sparing:nil];
+    
+    pthread_mutex_unlock(&_mutex);
+    
+    NSUInteger count = [evictedObjects count];
+    
+    releaseObjectsOnMainThread(evictedObjects);
+    
+    return count;
+}
+
+
+- (void) resetStatistics {
+
+    pthread_mutex_lock(&_mutex);
+    
+    _hitCount      = 0;
+    _missCount     = 0;
+    _evictionCount = 0;
+    
+    pthread_mutex_unlock(&_mutex);
+}
+
+
+@end
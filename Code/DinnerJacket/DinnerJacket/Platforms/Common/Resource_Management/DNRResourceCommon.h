@@ -14,3 +14,18 @@
 typedef void (^DNRResourceLoadingCompletionHandler) (NSArray* loadedObjects);
 
 
+
+
+/**
+ Resources that can be kept in a DNRResourceCache.
+ */
+@protocol DNRCacheableResource <NSObject>
+
+/// Memory used (video memory, mostly), in bytes. Charged against the cache's
+/// budget; must not change while cached.
+- (NSUInteger) memorySize;
+
+/// Resources in use are never evicted.
+- (BOOL) isInUse;
+
+@end
@@ -29,6 +29,11 @@
 @property (nonatomic, readonly) GLuint flatProgram;
 
 
+/// Renders pre-transformed, textured quads with per-vertex color (used by the
+/// sprite batch)
+@property (nonatomic, readonly) GLuint spriteBatchProgram;
+
+
 /**
  Singleton.
  */
@@ -40,6 +45,14 @@
 - (BOOL) initializeDefaultPrograms;
 
 
+/**
+ Fills the default program slots with programs of the current software
+ rasterizer (see DNRSoftwareRasterizer.h) instead of compiled shaders. Used by
+ DNRSoftwareRenderer.
+ */
+- (BOOL) initializeSoftwarePrograms;
+
+
 /**
  */
 - (GLuint) programNamed:(NSString *)programName;
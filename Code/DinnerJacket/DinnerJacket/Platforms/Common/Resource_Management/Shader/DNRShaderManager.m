@@ -10,6 +10,8 @@
 
 #import "DNRShaderManager.h"
 
+#import "DNRSoftwareRasterizer.h"       // Software programs
+
 
 #if defined(DNRPlatformPhone)
 
@@ -47,6 +49,9 @@ enum{
     ShaderFlatSprite,
     // Draws uniform color only, no texture
     
+    ShaderTexturedSpriteBatch,
+    // Vertices already in world coordinates, color specified per-vertex
+    
     
 	ShaderCount
 };
@@ -145,6 +150,14 @@ enum{
 }
 
 
+- (GLuint) spriteBatchProgram {
+
+    // (Declared as read-only @property)
+    
+    return [self programForObject:ShaderTexturedSpriteBatch];
+}
+
+
 
 
 
@@ -447,6 +460,40 @@ enum{
     _defaultPrograms[ShaderFlatSprite] = flatProgram;
     
     
+    // [ 5 ] Batched sprites (textured, per-vertex color, pre-transformed)
+    
+    GLuint spriteBatchProgram = [self buildProgramFromVertexShaderName:@"SpriteBatch"
+                                                    fragmentShaderName:@"Sprite"];
+    if (!spriteBatchProgram) {
+        return NO;
+    }
+    
+    _defaultPrograms[ShaderTexturedSpriteBatch] = spriteBatchProgram;
+    
+    
+    return YES;
+}
+
+
+- (BOOL) initializeSoftwarePrograms {
+    
+    // (Same slots as above; the per-vertex color and desaturated programs are
+    //  not built there either)
+    
+    GLuint spriteProgram      = softwareRasterizerCreateProgram(SoftwareProgramSprite);
+    GLuint alphaTestProgram   = softwareRasterizerCreateProgram(SoftwareProgramSpriteAlphaTest);
+    GLuint flatProgram        = softwareRasterizerCreateProgram(SoftwareProgramFlat);
+    GLuint spriteBatchProgram = softwareRasterizerCreateProgram(SoftwareProgramSpriteBatch);
+    
+    if (!spriteProgram || !alphaTestProgram || !flatProgram || !spriteBatchProgram) {
+        return NO;
+    }
+    
+    _defaultPrograms[ShaderTexturedSprite]              = spriteProgram;
+    _defaultPrograms[ShaderTexturedSpriteWithAlphaTest] = alphaTestProgram;
+    _defaultPrograms[ShaderFlatSprite]                  = flatProgram;
+    _defaultPrograms[ShaderTexturedSpriteBatch]         = spriteBatchProgram;
+    
     return YES;
 }
 
@@ -0,0 +1,187 @@
+//
+//  DNRKTXFile.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-28.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "DNRKTXFile.h"
+
+
+static const uint8_t ktxIdentifier[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+
+struct tKTXFile {
+
+    const uint8_t*  bytes;
+    size_t          size;
+
+    uint32_t        levelCount;
+    KTXFileLevel    levels[KTXFileMaxLevels];
+};
+
+
+// .............................................................................
+// Validation
+
+static int ktxFileParse(KTXFile* file) {
+
+    if (file->size < sizeof(KTXFileHeader)) {
+        return 0;
+    }
+
+    const KTXFileHeader* header = ktxFileHeader(file);
+
+    if (memcmp(header->identifier, ktxIdentifier, sizeof(ktxIdentifier)) != 0) {
+        return 0;
+    }
+    if (header->endianness != 0x04030201) {
+        // (Written on a machine of the opposite endianness; not supported)
+        return 0;
+    }
+
+
+    // 2D textures only:
+
+    if (header->pixelWidth == 0 || header->pixelHeight == 0) {
+        return 0;
+    }
+    if (header->pixelDepth != 0 || header->numberOfArrayElements != 0 || header->numberOfFaces != 1) {
+        return 0;
+    }
+
+
+    // (0 means "generate the mipmaps at runtime"; we just use the base level)
+
+    file->levelCount = (header->numberOfMipmapLevels > 0) ? header->numberOfMipmapLevels : 1;
+
+    if (file->levelCount > KTXFileMaxLevels) {
+        return 0;
+    }
+
+
+    // Levels: each one is preceded by its size, and padded to 4 bytes
+
+    if (header->bytesOfKeyValueData > file->size - sizeof(KTXFileHeader)) {
+        return 0;
+    }
+
+    size_t offset = sizeof(KTXFileHeader) + header->bytesOfKeyValueData;
+
+    for (uint32_t level = 0; level < file->levelCount; level++) {
+
+        if (offset > file->size || file->size - offset < 4) {
+            return 0;
+        }
+
+        uint32_t imageSize;
+        memcpy(&imageSize, file->bytes + offset, 4);
+
+        offset += 4;
+
+        if (imageSize == 0 || imageSize > file->size - offset) {
+            return 0;
+        }
+
+        uint32_t width  = header->pixelWidth  >> level;
+        uint32_t height = header->pixelHeight >> level;
+
+        file->levels[level].data   = file->bytes + offset;
+        file->levels[level].size   = imageSize;
+        file->levels[level].width  = (width  > 0) ? width  : 1;
+        file->levels[level].height = (height > 0) ? height : 1;
+
+        offset += (imageSize + 3) & ~(size_t)3;
+    }
+
+    return 1;
+}
+
+
+// .............................................................................
+// Opening/Closing
+
+KTXFile* ktxFileOpen(const char* path) {
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size  = (size_t)info.st_size;
+    void*  bytes = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd); // (The mapping stays valid)
+
+    if (bytes == MAP_FAILED) {
+        return NULL;
+    }
+
+    KTXFile* file = calloc(1, sizeof(KTXFile));
+
+    file->bytes = bytes;
+    file->size  = size;
+
+    if (!ktxFileParse(file)) {
+        ktxFileClose(file);
+        return NULL;
+    }
+
+    return file;
+}
+
+
+void ktxFileClose(KTXFile* file) {
+
+    if (file == NULL) {
+        return;
+    }
+
+    munmap((void *)file->bytes, file->size);
+
+    free(file);
+}
+
+
+// .............................................................................
+// Accessors
+
+const KTXFileHeader* ktxFileHeader(const KTXFile* file) {
+
+    return (const KTXFileHeader *)file->bytes;
+}
+
+
+uint32_t ktxFileLevelCount(const KTXFile* file) {
+
+    return file->levelCount;
+}
+
+
+KTXFileLevel ktxFileLevel(const KTXFile* file, uint32_t level) {
+
+    if (level >= file->levelCount) {
+        KTXFileLevel none = { NULL, 0, 0, 0 };
+        return none;
+    }
+
+    return file->levels[level];
+}
@@ -0,0 +1,94 @@
+//
+//  DNRKTXFile.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-28.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRKTXFile_h__
+#define __DNRKTXFile_h__
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/*
+ Reader for KTX (version 1.1) texture containers: pixel data laid out exactly
+ as OpenGL expects it (already swizzled, premultiplied and, if applicable,
+ compressed), optionally with a full chain of mipmap levels.
+
+ Only the subset produced by scripts/convert_textures.py is accepted: little
+ endian, 2D (no depth, arrays or cube faces).
+ */
+
+#define DNRKTXFileExtension         "ktx"
+
+#define KTXFileMaxLevels            16
+
+
+typedef struct tKTXFileHeader {
+
+    uint8_t     identifier[12];     // «KTX 11»\r\n\x1A\n
+    uint32_t    endianness;         // 0x04030201
+
+    uint32_t    glType;             // 0 for compressed formats
+    uint32_t    glTypeSize;
+    uint32_t    glFormat;           // 0 for compressed formats
+    uint32_t    glInternalFormat;
+    uint32_t    glBaseInternalFormat;
+
+    uint32_t    pixelWidth;
+    uint32_t    pixelHeight;
+    uint32_t    pixelDepth;
+    uint32_t    numberOfArrayElements;
+    uint32_t    numberOfFaces;
+    uint32_t    numberOfMipmapLevels;
+
+    uint32_t    bytesOfKeyValueData;
+
+}KTXFileHeader;
+
+
+typedef struct tKTXFileLevel {
+
+    const void* data;
+    uint32_t    size;               // In bytes (rows padded to 4 bytes)
+    uint32_t    width;
+    uint32_t    height;
+
+}KTXFileLevel;
+
+
+typedef struct tKTXFile KTXFile;
+
+
+/**
+ Maps the file at path into memory and validates its structure. Returns NULL
+ on failure.
+ */
+KTXFile* ktxFileOpen(const char* path);
+
+
+/**
+ Unmaps the file and frees the object.
+ */
+void ktxFileClose(KTXFile* file);
+
+
+const KTXFileHeader* ktxFileHeader(const KTXFile* file);
+
+
+/**
+ Number of mipmap levels stored (at least 1).
+ */
+uint32_t ktxFileLevelCount(const KTXFile* file);
+
+
+/**
+ Level 0 is the full size image.
+ */
+KTXFileLevel ktxFileLevel(const KTXFile* file, uint32_t level);
+
+
+#endif  // #defined (__DNRKTXFile_h__)
@@ -0,0 +1,720 @@
+//
+//  DNRPNGDecoder.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-03.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PNG_PREMULTIPLY_NEON    1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PNG_PREMULTIPLY_SSE2    1
+#endif
+
+#include "DNRPNGDecoder.h"
+
+
+static const uint8_t pngSignature[8] = {
+    0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'
+};
+
+// Color types (IHDR)
+enum {
+    PNGColorTypeGray        = 0,
+    PNGColorTypeRGB         = 2,
+    PNGColorTypePalette     = 3,
+    PNGColorTypeGrayAlpha   = 4,
+    PNGColorTypeRGBA        = 6
+};
+
+// Scanline filter types
+enum {
+    PNGFilterNone           = 0,
+    PNGFilterSub            = 1,
+    PNGFilterUp             = 2,
+    PNGFilterAverage        = 3,
+    PNGFilterPaeth          = 4
+};
+
+// (As big as any texture the GPU accepts; keeps the sizes from overflowing,
+// even 4*width*height in a 32-bit size_t)
+#define PNGMaxDimension         (1u << 14)
+
+_Static_assert(4ull * PNGMaxDimension * PNGMaxDimension <= SIZE_MAX, "PNGMaxDimension overflows size_t");
+
+
+typedef struct tPNGDecoder {
+
+    uint32_t    width;
+    uint32_t    height;
+    uint8_t     bitDepth;
+    uint8_t     colorType;
+
+    size_t      rowBytes;           // Scanline size, without the filter byte
+    size_t      filterStride;       // Bytes per complete pixel (at least 1)
+
+    uint8_t     palette[256*4];     // Premultiplied RGBA
+    uint32_t    paletteSize;
+
+    int         hasColorKey;        // tRNS for gray and RGB images: pixels of
+    uint16_t    colorKey[3];        //  this exact (raw) value are transparent
+
+}PNGDecoder;
+
+
+static inline uint32_t readUInt32(const uint8_t* bytes) {
+
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+
+static inline uint16_t readUInt16(const uint8_t* bytes) {
+
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+
+// .............................................................................
+// Premultiplication
+
+/*
+ round(c*a/255) without dividing: with x = c*a + 128, it equals
+ (x + (x >> 8)) >> 8 for every 8-bit c and a. The vector versions compute the
+ same (for a = 255 it leaves c unchanged, which also takes care of the alpha
+ component itself).
+ */
+
+static inline uint8_t premultiplyComponent(uint32_t c, uint32_t a) {
+
+    uint32_t x = c*a + 128;
+
+    return (uint8_t)((x + (x >> 8)) >> 8);
+}
+
+
+#if PNG_PREMULTIPLY_SSE2
+
+static inline __m128i premultiplyTwoPixels(__m128i pixels) {
+
+    // (pixels: two RGBA pixels, widened to 16 bits per component)
+
+    const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i opaque     = _mm_set1_epi16(255);
+    const __m128i bias       = _mm_set1_epi16(128);
+
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xFF), 0xFF);
+
+    alpha = _mm_or_si128(_mm_andnot_si128(alphaLanes, alpha), _mm_and_si128(alphaLanes, opaque));
+
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(pixels, alpha), bias);
+
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+#endif
+
+
+void pngPremultiplyRGBA(uint8_t* pixels, size_t pixelCount) {
+
+    size_t i = 0;
+
+#if PNG_PREMULTIPLY_NEON
+
+    // 8 pixels at a time, deinterleaved into R, G, B and A vectors:
+
+    for (; i + 8 <= pixelCount; i += 8) {
+
+        uint8_t*    p  = pixels + 4*i;
+        uint8x8x4_t px = vld4_u8(p);
+
+        uint16x8_t r = vmull_u8(px.val[0], px.val[3]);
+        uint16x8_t g = vmull_u8(px.val[1], px.val[3]);
+        uint16x8_t b = vmull_u8(px.val[2], px.val[3]);
+
+        // (vrshrq: (x + 128) >> 8; vraddhn: (x + that + 128) >> 8)
+        px.val[0] = vraddhn_u16(r, vrshrq_n_u16(r, 8));
+        px.val[1] = vraddhn_u16(g, vrshrq_n_u16(g, 8));
+        px.val[2] = vraddhn_u16(b, vrshrq_n_u16(b, 8));
+
+        vst4_u8(p, px);
+    }
+
+#elif PNG_PREMULTIPLY_SSE2
+
+    // 4 pixels at a time:
+
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= pixelCount; i += 4) {
+
+        __m128i* p  = (__m128i *)(pixels + 4*i);
+        __m128i  px = _mm_loadu_si128(p);
+
+        __m128i low  = premultiplyTwoPixels(_mm_unpacklo_epi8(px, zero));
+        __m128i high = premultiplyTwoPixels(_mm_unpackhi_epi8(px, zero));
+
+        _mm_storeu_si128(p, _mm_packus_epi16(low, high));
+    }
+
+#endif
+
+    // Remainder (or all, if no vector unit):
+
+    const uint8_t* end = pixels + 4*pixelCount;
+
+    for (uint8_t* p = pixels + 4*i; p < end; p += 4) {
+
+        uint32_t a = p[3];
+
+        p[0] = premultiplyComponent(p[0], a);
+        p[1] = premultiplyComponent(p[1], a);
+        p[2] = premultiplyComponent(p[2], a);
+    }
+}
+
+
+// .............................................................................
+// Header
+
+static int pngDecoderReadHeader(PNGDecoder* decoder, const uint8_t* data, uint32_t length) {
+
+    if (length != 13) {
+        return 0;
+    }
+
+    decoder->width     = readUInt32(data);
+    decoder->height    = readUInt32(data + 4);
+    decoder->bitDepth  = data[8];
+    decoder->colorType = data[9];
+
+    uint8_t compression = data[10];
+    uint8_t filter      = data[11];
+    uint8_t interlace   = data[12];
+
+    if (decoder->width == 0 || decoder->height == 0 || decoder->width > PNGMaxDimension || decoder->height > PNGMaxDimension) {
+        return 0;
+    }
+    if (compression != 0 || filter != 0) {
+        return 0;
+    }
+    if (interlace != 0) {
+        // (Adam7: not supported; see header)
+        return 0;
+    }
+
+
+    // Samples per pixel, and allowed bit depths for the color type:
+
+    uint32_t channels;
+    uint8_t  depth = decoder->bitDepth;
+
+    switch (decoder->colorType) {
+
+        case PNGColorTypeGray:
+            channels = 1;
+            if (depth != 1 && depth != 2 && depth != 4 && depth != 8 && depth != 16) {
+                return 0;
+            }
+            break;
+
+        case PNGColorTypePalette:
+            channels = 1;
+            if (depth != 1 && depth != 2 && depth != 4 && depth != 8) {
+                return 0;
+            }
+            break;
+
+        case PNGColorTypeRGB:
+            channels = 3;
+            if (depth != 8 && depth != 16) {
+                return 0;
+            }
+            break;
+
+        case PNGColorTypeGrayAlpha:
+            channels = 2;
+            if (depth != 8 && depth != 16) {
+                return 0;
+            }
+            break;
+
+        case PNGColorTypeRGBA:
+            channels = 4;
+            if (depth != 8 && depth != 16) {
+                return 0;
+            }
+            break;
+
+        default:
+            return 0;
+    }
+
+    size_t bitsPerPixel = (size_t)channels * depth;
+
+    decoder->rowBytes     = ((size_t)decoder->width * bitsPerPixel + 7) / 8;
+    decoder->filterStride = (bitsPerPixel >= 8) ? bitsPerPixel / 8 : 1;
+
+    return 1;
+}
+
+
+static void pngDecoderReadPalette(PNGDecoder* decoder, const uint8_t* data, uint32_t length) {
+
+    uint32_t count = length / 3;
+
+    if (count > 256) {
+        count = 256;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        decoder->palette[4*i + 0] = data[3*i + 0];
+        decoder->palette[4*i + 1] = data[3*i + 1];
+        decoder->palette[4*i + 2] = data[3*i + 2];
+        decoder->palette[4*i + 3] = 255;
+    }
+
+    decoder->paletteSize = count;
+}
+
+
+static void pngDecoderReadTransparency(PNGDecoder* decoder, const uint8_t* data, uint32_t length) {
+
+    switch (decoder->colorType) {
+
+        case PNGColorTypePalette:
+            // Alpha of the first entries
+            for (uint32_t i = 0; i < length && i < 256; i++) {
+                decoder->palette[4*i + 3] = data[i];
+            }
+            break;
+
+        case PNGColorTypeGray:
+            if (length >= 2) {
+                decoder->hasColorKey = 1;
+                decoder->colorKey[0] = readUInt16(data);
+            }
+            break;
+
+        case PNGColorTypeRGB:
+            if (length >= 6) {
+                decoder->hasColorKey = 1;
+                decoder->colorKey[0] = readUInt16(data);
+                decoder->colorKey[1] = readUInt16(data + 2);
+                decoder->colorKey[2] = readUInt16(data + 4);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+// .............................................................................
+// Scanlines
+
+static inline uint8_t paethPredictor(int a, int b, int c) {
+
+    int p  = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+
+    if (pa <= pb && pa <= pc) {
+        return (uint8_t)a;
+    }
+
+    return (uint8_t)((pb <= pc) ? b : c);
+}
+
+
+/**
+ Reverses the filter in place. row and prior point past the filter byte; prior
+ is all zeros for the first row.
+ */
+static int pngUnfilterRow(uint8_t* row, const uint8_t* prior, size_t length, size_t stride, uint8_t filter) {
+
+    size_t i;
+
+    switch (filter) {
+
+        case PNGFilterNone:
+            break;
+
+        case PNGFilterSub:
+            for (i = stride; i < length; i++) {
+                row[i] += row[i - stride];
+            }
+            break;
+
+        case PNGFilterUp:
+            for (i = 0; i < length; i++) {
+                row[i] += prior[i];
+            }
+            break;
+
+        case PNGFilterAverage:
+            for (i = 0; i < stride; i++) {
+                row[i] += prior[i] >> 1;
+            }
+            for (; i < length; i++) {
+                row[i] += (uint8_t)((row[i - stride] + prior[i]) >> 1);
+            }
+            break;
+
+        case PNGFilterPaeth:
+            for (i = 0; i < stride; i++) {
+                row[i] += prior[i];     // (a = c = 0)
+            }
+            for (; i < length; i++) {
+                row[i] += paethPredictor(row[i - stride], prior[i], prior[i - stride]);
+            }
+            break;
+
+        default:
+            return 0;
+    }
+
+    return 1;
+}
+
+
+/**
+ Sample at index i of a row with 1, 2 or 4 bits per sample.
+ */
+static inline uint32_t packedSample(const uint8_t* row, uint32_t i, uint32_t depth) {
+
+    uint32_t bit   = i * depth;
+    uint32_t shift = 8 - depth - (bit & 7);
+
+    return (row[bit >> 3] >> shift) & ((1u << depth) - 1);
+}
+
+
+/**
+ Expands an unfiltered scanline to premultiplied RGBA.
+ */
+static void pngDecoderConvertRow(const PNGDecoder* decoder, const uint8_t* row, uint8_t* output) {
+
+    uint32_t width = decoder->width;
+    uint32_t depth = decoder->bitDepth;
+    uint32_t x;
+
+    switch (decoder->colorType) {
+
+        case PNGColorTypeRGBA:
+            if (depth == 8) {
+                memcpy(output, row, 4*(size_t)width);
+            }
+            else{
+                // (16 bits: keep the most significant byte)
+                for (x = 0; x < 4*width; x++) {
+                    output[x] = row[2*x];
+                }
+            }
+            pngPremultiplyRGBA(output, width);
+            break;
+
+        case PNGColorTypeGrayAlpha:
+            for (x = 0; x < width; x++) {
+                uint8_t gray  = (depth == 8) ? row[2*x]     : row[4*x];
+                uint8_t alpha = (depth == 8) ? row[2*x + 1] : row[4*x + 2];
+
+                output[4*x + 0] = gray;
+                output[4*x + 1] = gray;
+                output[4*x + 2] = gray;
+                output[4*x + 3] = alpha;
+            }
+            pngPremultiplyRGBA(output, width);
+            break;
+
+        case PNGColorTypeRGB:
+            for (x = 0; x < width; x++) {
+                uint8_t* p = output + 4*x;
+
+                if (depth == 8) {
+                    const uint8_t* s = row + 3*x;
+
+                    if (decoder->hasColorKey && s[0] == decoder->colorKey[0] && s[1] == decoder->colorKey[1] && s[2] == decoder->colorKey[2]) {
+                        memset(p, 0, 4);
+                        continue;
+                    }
+                    p[0] = s[0];
+                    p[1] = s[1];
+                    p[2] = s[2];
+                }
+                else{
+                    const uint8_t* s = row + 6*x;
+
+                    if (decoder->hasColorKey && readUInt16(s) == decoder->colorKey[0] && readUInt16(s + 2) == decoder->colorKey[1] && readUInt16(s + 4) == decoder->colorKey[2]) {
+                        memset(p, 0, 4);
+                        continue;
+                    }
+                    p[0] = s[0];
+                    p[1] = s[2];
+                    p[2] = s[4];
+                }
+                p[3] = 255;
+            }
+            break;
+
+        case PNGColorTypeGray:
+            for (x = 0; x < width; x++) {
+                uint8_t* p = output + 4*x;
+                uint32_t sample;
+                uint8_t  gray;
+
+                if (depth == 16) {
+                    sample = readUInt16(row + 2*x);
+                    gray   = (uint8_t)(sample >> 8);
+                }
+                else if (depth == 8) {
+                    sample = row[x];
+                    gray   = (uint8_t)sample;
+                }
+                else{
+                    // (Scale 1, 2 and 4 bit samples to the full range)
+                    sample = packedSample(row, x, depth);
+                    gray   = (uint8_t)(sample * (255 / ((1u << depth) - 1)));
+                }
+
+                if (decoder->hasColorKey && sample == decoder->colorKey[0]) {
+                    memset(p, 0, 4);
+                    continue;
+                }
+                p[0] = gray;
+                p[1] = gray;
+                p[2] = gray;
+                p[3] = 255;
+            }
+            break;
+
+        case PNGColorTypePalette:
+            // (Entries are already premultiplied)
+            for (x = 0; x < width; x++) {
+                uint32_t index = (depth == 8) ? row[x] : packedSample(row, x, depth);
+
+                memcpy(output + 4*x, decoder->palette + 4*index, 4);
+            }
+            break;
+    }
+}
+
+
+// .............................................................................
+// Decoding
+
+int pngDecodeMemory(const void* bytes, size_t size, PNGImage* image) {
+
+    memset(image, 0, sizeof(PNGImage));
+
+    const uint8_t* data = bytes;
+
+    if (size < sizeof(pngSignature) || memcmp(data, pngSignature, sizeof(pngSignature)) != 0) {
+        return 0;
+    }
+
+    PNGDecoder decoder;
+    memset(&decoder, 0, sizeof(PNGDecoder));
+
+    // (Out of range indices decode as opaque black)
+    for (uint32_t i = 0; i < 256; i++) {
+        decoder.palette[4*i + 3] = 255;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(z_stream));
+
+    if (inflateInit(&stream) != Z_OK) {
+        return 0;
+    }
+
+    uint8_t* pixels    = NULL;
+    uint8_t* rows      = NULL;      // Current and prior scanlines, each with
+    uint8_t* current   = NULL;      //  its filter byte
+    uint8_t* prior     = NULL;
+    size_t   filled    = 0;         // Bytes of the current scanline inflated
+    uint32_t row       = 0;
+    int      hasHeader = 0;
+    int      hasData   = 0;
+    int      finished  = 0;
+    int      success   = 0;
+
+    size_t offset = sizeof(pngSignature);
+
+
+    // Chunks: length, type, data, CRC (not verified: the zlib stream has its
+    // own checksum, and ancillary chunks are skipped anyway)
+
+    while (!finished) {
+
+        if (size - offset < 12) {
+            goto cleanup;
+        }
+
+        uint32_t       length = readUInt32(data + offset);
+        const uint8_t* type   = data + offset + 4;
+        const uint8_t* chunk  = data + offset + 8;
+
+        if (length > size - offset - 12) {
+            goto cleanup;
+        }
+
+        offset += 12 + (size_t)length;
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+
+            if (hasHeader || !pngDecoderReadHeader(&decoder, chunk, length)) {
+                goto cleanup;
+            }
+            hasHeader = 1;
+
+            pixels = malloc(4 * (size_t)decoder.width * decoder.height);
+            rows   = calloc(2, decoder.rowBytes + 1);
+
+            if (pixels == NULL || rows == NULL) {
+                goto cleanup;
+            }
+
+            current = rows;
+            prior   = rows + decoder.rowBytes + 1;
+        }
+        else if (!hasHeader) {
+            // (IHDR must come first)
+            goto cleanup;
+        }
+        else if (memcmp(type, "PLTE", 4) == 0) {
+
+            pngDecoderReadPalette(&decoder, chunk, length);
+        }
+        else if (memcmp(type, "tRNS", 4) == 0) {
+
+            pngDecoderReadTransparency(&decoder, chunk, length);
+        }
+        else if (memcmp(type, "IDAT", 4) == 0) {
+
+            if (!hasData && decoder.colorType == PNGColorTypePalette) {
+                // First image data: palette and transparency are final
+                pngPremultiplyRGBA(decoder.palette, 256);
+            }
+            hasData = 1;
+
+            stream.next_in  = (Bytef *)chunk;
+            stream.avail_in = length;
+
+            while (stream.avail_in > 0 && row < decoder.height) {
+
+                size_t scanlineBytes = decoder.rowBytes + 1;
+
+                stream.next_out  = current + filled;
+                stream.avail_out = (uInt)(scanlineBytes - filled);
+
+                int status = inflate(&stream, Z_NO_FLUSH);
+
+                if (status != Z_OK && status != Z_STREAM_END) {
+                    goto cleanup;
+                }
+
+                filled = scanlineBytes - stream.avail_out;
+
+                if (filled == scanlineBytes) {
+                    // Complete scanline: unfilter, convert, and move on
+                    if (!pngUnfilterRow(current + 1, prior + 1, decoder.rowBytes, decoder.filterStride, current[0])) {
+                        goto cleanup;
+                    }
+
+                    pngDecoderConvertRow(&decoder, current + 1, pixels + 4 * (size_t)decoder.width * row);
+
+                    uint8_t* swap = prior;
+                    prior   = current;
+                    current = swap;
+                    filled  = 0;
+                    row++;
+                }
+
+                if (status == Z_STREAM_END) {
+                    break;
+                }
+            }
+        }
+        else if (memcmp(type, "IEND", 4) == 0) {
+
+            finished = 1;
+        }
+        else if ((type[0] & 0x20) == 0) {
+            // Unknown critical chunk
+            goto cleanup;
+        }
+    }
+
+    if (row == decoder.height) {
+        image->pixels = pixels;
+        image->width  = decoder.width;
+        image->height = decoder.height;
+
+        pixels  = NULL;
+        success = 1;
+    }
+
+cleanup:
+    inflateEnd(&stream);
+
+    free(rows);
+    free(pixels);
+
+    return success;
+}
+
+
+int pngDecodeFile(const char* path, PNGImage* image) {
+
+    memset(image, 0, sizeof(PNGImage));
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return 0;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return 0;
+    }
+
+    size_t size  = (size_t)info.st_size;
+    void*  bytes = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd); // (The mapping stays valid)
+
+    if (bytes == MAP_FAILED) {
+        return 0;
+    }
+
+    int success = pngDecodeMemory(bytes, size, image);
+
+    munmap(bytes, size);
+
+    return success;
+}
+
+
+void pngImageFree(PNGImage* image) {
+
+    free(image->pixels);
+
+    image->pixels = NULL;
+}
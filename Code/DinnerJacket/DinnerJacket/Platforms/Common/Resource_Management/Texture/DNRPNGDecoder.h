@@ -0,0 +1,71 @@
+//
+//  DNRPNGDecoder.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-03.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRPNGDecoder_h__
+#define __DNRPNGDecoder_h__
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/*
+ Decodes PNG files straight into the layout OpenGL expects for uploading:
+ RGBA, 8 bits per component, premultiplied alpha, rows tightly packed (and
+ thus 4-byte aligned), top row first.
+
+ The compressed stream is inflated one scanline at a time; each row is
+ unfiltered, expanded to RGBA and premultiplied while still in cache, so the
+ output buffer is written exactly once (no intermediate full-size image).
+
+ All color types and bit depths are supported (16-bit components are
+ truncated to 8), as is transparency (tRNS) for palette, grayscale and RGB
+ images. Interlaced (Adam7) images are not: the decoder fails, and the caller
+ is expected to fall back to the platform's image decoder. Color profiles and
+ gamma are ignored (as the assets are authored in sRGB).
+
+ Pure C and zlib, so it builds and runs anywhere (e.g., for benchmarking on
+ the desktop).
+ */
+
+
+typedef struct tPNGImage {
+
+    uint8_t*    pixels;             // malloc()'d; width*height*4 bytes
+    uint32_t    width;
+    uint32_t    height;
+
+}PNGImage;
+
+
+/**
+ Maps the file at path into memory and decodes it. Returns 0 on failure
+ (image is left zeroed).
+ */
+int pngDecodeFile(const char* path, PNGImage* image);
+
+
+/**
+ Decodes a complete PNG file held in memory. Returns 0 on failure.
+ */
+int pngDecodeMemory(const void* bytes, size_t size, PNGImage* image);
+
+
+/**
+ Frees the pixel buffer.
+ */
+void pngImageFree(PNGImage* image);
+
+
+/**
+ Multiplies the color components of each RGBA pixel by its alpha (rounded to
+ the nearest integer). Vectorized with NEON or SSE2 where available.
+ */
+void pngPremultiplyRGBA(uint8_t* pixels, size_t pixelCount);
+
+
+#endif  // #defined (__DNRPNGDecoder_h__)
@@ -11,6 +11,66 @@
 #import "DNRResourceCommon.h"
 
 
+#define DNRTextureImageMaxLevels    16
+
+
+/**
+ One mipmap level of a DNRTextureImage (level 0 is the full size image).
+ */
+typedef struct tDNRTextureImageLevel {
+    
+    const void* data;
+    size_t      size;               // In bytes (rows aligned to 4 bytes)
+    GLuint      width;
+    GLuint      height;
+    
+}DNRTextureImageLevel;
+
+
+/**
+ Image ready for upload: either decoded from a PNG file (RGBA, 8 bits per 
+ component, premultiplied alpha), or read from a KTX container (see 
+ DNRKTXFile.h) in any of the formats it supports, possibly with mipmaps.
+ */
+typedef struct tDNRTextureImage {
+    
+    void*       pixels;             // Decoded pixel buffer (owned), or NULL
+    void*       container;          // Mapped KTX file (owned), or NULL
+    
+    GLuint      pixelWidth;
+    GLuint      pixelHeight;
+    CGFloat     scaleFactor;        // Deduced from the file name ("@2x", etc.)
+    
+    GLenum      format;             // e.g. GL_RGBA, or the compressed format
+    GLenum      type;               // e.g. GL_UNSIGNED_BYTE; 0 if compressed
+    GLuint      bytesPerPixel;      // 0 if compressed
+    
+    GLuint                  levelCount;
+    DNRTextureImageLevel    levels[DNRTextureImageMaxLevels];
+    
+}DNRTextureImage;
+
+
+/**
+ Loads the image file that best matches the device's screen resolution. A KTX 
+ container next to it (same name, extension "ktx") is preferred to the PNG if 
+ its format is supported by the platform. Does not use OpenGL, so it is safe 
+ to call from any thread. Returns NO on failure.
+ */
+BOOL DNRTextureImageLoad(NSString* path, DNRTextureImage* image);
+
+/**
+ Frees the pixel buffer (or container) of an image loaded by 
+ DNRTextureImageLoad().
+ */
+void DNRTextureImageFree(DNRTextureImage* image);
+
+/**
+ Size in bytes of one row of the specified level (0 if compressed).
+ */
+size_t DNRTextureImageRowBytes(const DNRTextureImage* image, GLuint level);
+
+
 /**
  Represents an OpenGL texture that can be used to render a sprite or other 
  geometry.
@@ -18,8 +78,12 @@
  Initializers are private. Instead, use the factory methods that internally 
  enforce resource management (caching of textures already loaded for reuse, 
  purging of unused textires under low memory situations, etc.).
+ 
+ Loaded textures are kept in the shared DNRResourceCache, charged their
+ memorySize; those with a use count of zero are evicted (least recently used
+ first) whenever the cache goes over its budget.
  */
-@interface DNRTexture : NSObject
+@interface DNRTexture : NSObject <DNRCacheableResource>
 
 
 /// OpenGL texture name. For use in conjuction with glBindTexture().
@@ -30,8 +94,12 @@
 @property (nonatomic, readonly ) CGSize     size;
 
 
+/// Estimated video memory used, in bytes (all mipmap levels).
+@property (nonatomic, readonly ) NSUInteger memorySize;
+
+
 /// Helps manager determine which textures can be purged (those with a use
-/// count of zero).
+/// count of zero). Thread safe.
 @property (nonatomic, readwrite) NSInteger  useCount;
 
 
@@ -48,9 +116,10 @@
 /**
  Loading the specified texture asynchronously.
  If the texture was already loaded and cached, the completion handler block is 
- executed right away. Otherwise, the texture is loaded in the background 
- dispatch queue and the completion handler block is executed on completion. In 
- either case, the passed block ALWAYS runs on the main thread.
+ executed right away. Otherwise, the texture is loaded by the shared 
+ DNRTextureLoader (at normal priority) and the completion handler block is 
+ executed on completion. In either case, the passed block ALWAYS runs on the 
+ main thread.
  To load several textures from within a background thread, use e.g. a for-loop 
  and call: -textureWithContentsOfFile:options: instead, each time passing the 
  background OpenGL context to be used in the options dictionary (by the key 
@@ -75,8 +144,44 @@
  Renounces ownership of the receiver. A texture that is not owned by any object 
  can be dafely deleted during low memory situations.
  A texture may remain in memory indefinitely even if no object references it, as
- long as available system memory is not scarce.
+ long as the resource cache is within budget and available system memory is not
+ scarce.
  */
 - (void) relinquish;
 
 @end
+
+
+/**
+ Building blocks of the asynchronous loading pipeline (see DNRTextureLoader).
+ */
+@interface DNRTexture (Loading)
+
+/**
+ The texture already loaded from the specified file, if any.
+ */
++ (DNRTexture *) cachedTextureWithContentsOfFile:(NSString *)path;
+
+/**
+ Registers a loaded texture for reuse by the factory methods.
+ */
++ (void) cacheTexture:(DNRTexture *)texture forFile:(NSString *)path;
+
+/**
+ Creates the OpenGL texture object for the image (size, format and mipmap 
+ levels) and allocates its storage, without transferring any pixels. Uses the 
+ OpenGL context current on the calling thread.
+ */
+- (instancetype) initWithImage:(const DNRTextureImage *)image
+                       options:(NSDictionary *)options;
+
+/**
+ Transfers the specified rows (top to bottom) of one mipmap level of the image 
+ the receiver was created with. Large images can be uploaded in several calls, 
+ spread over several frames. Compressed levels are transferred whole.
+ */
+- (void) uploadRows:(NSRange) rows
+            ofLevel:(GLuint) level
+            ofImage:(const DNRTextureImage *)image;
+
+@end
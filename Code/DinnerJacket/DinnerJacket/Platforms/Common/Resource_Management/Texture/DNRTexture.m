@@ -8,10 +8,17 @@
 
 #import "DNRBase.h"
 
+#import <stdatomic.h>
+
 #import "DNRTexture.h"
+#import "DNRTextureLoader.h"
+#import "DNRKTXFile.h"
+#import "DNRPNGDecoder.h"
+#import "DNRResourceCache.h"
 
 
 #import "DNRGLCache.h"
+#import "DNRGLDispatch.h"
 
 #ifdef DNRPlatformPhone
 #import "../../../iOS/ViewController/DNRViewController.h"
@@ -28,7 +35,18 @@
 // .............................................................................
 //
 
-static NSMutableDictionary* texturesByName = nil;
+// (Not defined by the OpenGL ES 2 headers; the contexts are ES 3)
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2         0x9274
+#endif
+
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC    0x9278
+#endif
+
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL            GL_TEXTURE_MAX_LEVEL_APPLE
+#endif
 
 
 
@@ -135,6 +153,260 @@ CGFloat scaleFactorOfImageFileName(NSString* fileName){
     return  1.0;
 }
 
+
+BOOL compressedFormatIsSupported(GLenum format){
+    
+#ifdef DNRPlatformPhone
+    // (OpenGL ES 3)
+    return (format == GL_COMPRESSED_RGB8_ETC2 || format == GL_COMPRESSED_RGBA8_ETC2_EAC);
+#else
+    // (OpenGL 3.2 Core: ETC2 requires 4.3)
+    return NO;
+#endif
+}
+
+
+size_t DNRTextureImageRowBytes(const DNRTextureImage* image, GLuint level){
+    
+    if (image->bytesPerPixel == 0 || level >= image->levelCount) {
+        return 0;
+    }
+    
+    // (Rows are aligned to 4 bytes, like GL_UNPACK_ALIGNMENT)
+    size_t rowBytes = image->levels[level].width * image->bytesPerPixel;
+    
+    return (rowBytes + 3) & ~(size_t)3;
+}
+
+
+BOOL loadImageContainer(NSString* containerPath, DNRTextureImage* image){
+    
+    KTXFile* file = ktxFileOpen([containerPath fileSystemRepresentation]);
+    
+    if (file == NULL) {
+        return NO;
+    }
+    
+    const KTXFileHeader* header = ktxFileHeader(file);
+    
+    image->format        = header->glFormat;
+    image->type          = header->glType;
+    image->bytesPerPixel = 0;
+    
+    if (header->glType == 0) {
+        // Compressed
+        image->format = header->glInternalFormat;
+        
+        if (!compressedFormatIsSupported(image->format)) {
+            ktxFileClose(file);
+            return NO;
+        }
+    }
+    else if (header->glType == GL_UNSIGNED_BYTE && header->glFormat == GL_RGBA) {
+        image->bytesPerPixel = 4;
+    }
+    else if (header->glType == GL_UNSIGNED_SHORT_4_4_4_4 && header->glFormat == GL_RGBA) {
+        image->bytesPerPixel = 2;
+    }
+    else if (header->glType == GL_UNSIGNED_SHORT_5_6_5 && header->glFormat == GL_RGB) {
+        image->bytesPerPixel = 2;
+    }
+    else{
+        // Unsupported format
+        ktxFileClose(file);
+        return NO;
+    }
+    
+    image->pixelWidth  = header->pixelWidth;
+    image->pixelHeight = header->pixelHeight;
+    image->scaleFactor = scaleFactorOfImageFileName([containerPath lastPathComponent]);
+    image->levelCount  = ktxFileLevelCount(file);
+    
+    for (GLuint level = 0; level < image->levelCount; level++) {
+        
+        KTXFileLevel fileLevel = ktxFileLevel(file, level);
+        
+        image->levels[level].data   = fileLevel.data;
+        image->levels[level].size   = fileLevel.size;
+        image->levels[level].width  = fileLevel.width;
+        image->levels[level].height = fileLevel.height;
+        
+        // (Make sure OpenGL will not read past the end of the data)
+        
+        if (fileLevel.size < DNRTextureImageRowBytes(image, level) * fileLevel.height) {
+            ktxFileClose(file);
+            return NO;
+        }
+    }
+    
+    image->container = file;
+    
+    return YES;
+}
+
+
+void setDecodedPixels(DNRTextureImage* image, void* pixels, GLuint pixelWidth, GLuint pixelHeight){
+    
+    // (RGBA, premultiplied; rows are 4*width bytes and thus aligned)
+    
+    image->pixels        = pixels;
+    image->pixelWidth    = pixelWidth;
+    image->pixelHeight   = pixelHeight;
+    
+    image->format        = GL_RGBA;
+    image->type          = GL_UNSIGNED_BYTE;
+    image->bytesPerPixel = 4;
+    
+    image->levelCount       = 1;
+    image->levels[0].data   = pixels;
+    image->levels[0].size   = 4*pixelWidth*pixelHeight;
+    image->levels[0].width  = pixelWidth;
+    image->levels[0].height = pixelHeight;
+}
+
+
+/**
+ Decodes any image file the platform supports, by drawing it into a bitmap
+ context. Slower than the direct PNG path (two full size copies), so only used
+ when that one can not handle the file.
+ */
+BOOL decodeImageFileWithPlatformDecoder(NSString* imagePath, DNRTextureImage* image){
+    
+#ifdef DNRPlatformPhone
+    // iOS
+    UIImage* sourceImage = [[UIImage alloc] initWithContentsOfFile:imagePath];
+    
+    CGImageRef imageRef = [sourceImage CGImage];
+    
+    if (imageRef == NULL){
+        return NO;
+    }
+    
+    GLuint pixelWidth  = (GLuint) CGImageGetWidth(imageRef);
+    GLuint pixelHeight = (GLuint) CGImageGetHeight(imageRef);
+    
+#else
+    // macOS
+    NSArray* imageRepresentations = [NSBitmapImageRep imageRepsWithContentsOfFile:imagePath];
+    
+    GLuint maxWidth  = 0;
+    GLuint maxHeight = 0;
+    NSBitmapImageRep* largestImageRep;
+    
+    for (NSImageRep * imageRep in imageRepresentations) {
+        if ([imageRep pixelsWide] > maxWidth){
+            maxWidth  = (GLuint)[imageRep pixelsWide];
+            maxHeight = (GLuint)[imageRep pixelsHigh];
+            largestImageRep = (NSBitmapImageRep*) imageRep;
+        }
+    }
+    
+    GLuint pixelWidth  = maxWidth;
+    GLuint pixelHeight = maxHeight;
+    
+    CGImageRef imageRef = [largestImageRep CGImage];
+    
+    if (imageRef == NULL){
+        return NO;
+    }
+#endif
+    
+    // Redraw into a buffer of known layout (RGBA, premultiplied alpha):
+    
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    
+    void* imageData = malloc(pixelWidth*pixelHeight*4); // 4 bytes per pixel
+    
+    CGContextRef context = CGBitmapContextCreate(imageData,         // Buffer
+                                                 pixelWidth,        // Width
+                                                 pixelHeight,       // Height
+                                                 8,                 // Bits per component
+                                                 4* pixelWidth,     // Bytes per row
+                                                 colorSpace,        // Color space
+                                                 kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+    CGColorSpaceRelease(colorSpace);
+    
+    
+    CGContextSetBlendMode(context, kCGBlendModeCopy);// TEST
+    
+    CGContextClearRect( context, CGRectMake(0, 0, pixelWidth, pixelHeight));
+    
+    CGContextDrawImage( context, CGRectMake(0, 0, pixelWidth, pixelHeight), imageRef);
+    
+    CGContextRelease(context);
+    
+    setDecodedPixels(image, imageData, pixelWidth, pixelHeight);
+    
+    return YES;
+}
+
+
+BOOL decodeImageFile(NSString* imagePath, DNRTextureImage* image){
+    
+    NSString* fileName = [imagePath lastPathComponent];
+    
+    image->scaleFactor = scaleFactorOfImageFileName(fileName);
+    
+    // TODO: Rethink hi-res-from-file-name logic.
+    
+    // PNG files are decoded straight into the upload buffer (inflated,
+    // unfiltered and premultiplied a row at a time; see DNRPNGDecoder.h):
+    
+    if ([[[imagePath pathExtension] lowercaseString] isEqualToString:@"png"]) {
+        
+        PNGImage decoded;
+        
+        if (pngDecodeFile([imagePath fileSystemRepresentation], &decoded)) {
+            setDecodedPixels(image, decoded.pixels, decoded.width, decoded.height);
+            return YES;
+        }
+        
+        // (e.g., interlaced; let the platform try)
+    }
+    
+    return decodeImageFileWithPlatformDecoder(imagePath, image);
+}
+
+
+BOOL DNRTextureImageLoad(NSString* path, DNRTextureImage* image){
+    
+    memset(image, 0, sizeof(DNRTextureImage));
+    
+    NSString* imagePath     = imagePathWithBestResolutionAvailable(path);
+    NSString* containerPath = imagePathWithBestResolutionAvailable([[path stringByDeletingPathExtension] stringByAppendingPathExtension:@DNRKTXFileExtension]);
+    
+    // Prefer the container (already in the GPU's format), unless the PNG has
+    // a higher resolution or the container's format is not supported:
+    
+    if (containerPath != nil) {
+        
+        BOOL containerHasLowerResolution = (imagePath != nil) && (scaleFactorOfImageFileName([containerPath lastPathComponent]) < scaleFactorOfImageFileName([imagePath lastPathComponent]));
+        
+        if (!containerHasLowerResolution && loadImageContainer(containerPath, image)) {
+            return YES;
+        }
+        
+        memset(image, 0, sizeof(DNRTextureImage));
+    }
+    
+    if (imagePath == nil) {
+        return NO;
+    }
+    
+    return decodeImageFile(imagePath, image);
+}
+
+
+void DNRTextureImageFree(DNRTextureImage* image){
+    
+    free(image->pixels);
+    ktxFileClose(image->container);
+    
+    image->pixels     = NULL;
+    image->container  = NULL;
+    image->levelCount = 0;
+}
+
 // .............................................................................
 
 
@@ -154,26 +426,19 @@ CGFloat scaleFactorOfImageFileName(NSString* fileName){
 
 // .............................................................................
 
-@implementation DNRTexture
-
-#pragma mark - Factory / Instance Management
-
-
-+ (void) initialize {
+@implementation DNRTexture {
     
-    if (self == [DNRTexture class]) {
-        static dispatch_once_t onceToken;
-        dispatch_once(&onceToken, ^{
-            texturesByName = [NSMutableDictionary new];
-        });
-    }
+    // (Acquired and relinquished from any thread)
+    _Atomic(NSInteger)  _useCount;
 }
 
+#pragma mark - Factory / Instance Management
+
 
 + (DNRTexture*) textureWithContentsOfFile:(NSString *)path
                                   options:(NSDictionary *)options {
     
-    DNRTexture* texture = [texturesByName objectForKey:path];
+    DNRTexture* texture = [[DNRResourceCache sharedCache] objectForKey:path];
     
     if (!texture) {
         // Cache miss; Create:
@@ -182,7 +447,7 @@ CGFloat scaleFactorOfImageFileName(NSString* fileName){
         
         // Cache for next time:
         if (texture != nil) {
-            [texturesByName setObject:texture forKey:path];
+            [[DNRResourceCache sharedCache] setObject:texture forKey:path];
         }
     }
     
@@ -194,55 +459,31 @@ CGFloat scaleFactorOfImageFileName(NSString* fileName){
                                options:(NSDictionary *)options
                             completion:(DNRResourceLoadingCompletionHandler) completionHandler {
     
-    DNRTexture* texture = [texturesByName objectForKey:path];
+    // (Decoded by the shared loader's worker pool, uploaded in slices over the
+    //  following frames)
     
-    if (texture) {
-        // [ A ] CACHE HIT: Return it right away on the main thread.
-        
-        if ([NSThread isMainThread]) {
-            completionHandler(@[texture]);
-        }
-        else{
-            dispatch_async( dispatch_get_main_queue(), ^{
-                completionHandler(@[texture]);
-            });
-        }
-    }
-    else{
-        // [ B ] CACHE MISS: Create it, cache it, return in on the main thread.
-        
-        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(){
-            // (BACKGROUND THREAD)
-            
-            DNRTexture* texture = [[DNRTexture alloc] initWithContentsOfFile:path options:options];
-
-            if (texture) {
-               [texturesByName setObject:texture forKey:path];
-            }
-            
-            dispatch_async( dispatch_get_main_queue(), ^{
-                // (MAIN THREAD)
-                completionHandler(texture ? @[texture] : nil);
-            });
-        });
-    }
+    [[DNRTextureLoader sharedLoader] loadTextureWithContentsOfFile:path
+                                                           options:options
+                                                          priority:DNRTextureLoadPriorityNormal
+                                                        completion:completionHandler];
 }
 
 
-+ (void) purgeUnusedTextures {
++ (DNRTexture *) cachedTextureWithContentsOfFile:(NSString *)path {
     
-    NSMutableArray* keysToDelete = [NSMutableArray new];
+    return [[DNRResourceCache sharedCache] objectForKey:path];
+}
+
+
++ (void) cacheTexture:(DNRTexture *)texture forFile:(NSString *)path {
     
-    for (NSString* key in [texturesByName allKeys]) {
-        
-        DNRTexture* texture = [texturesByName objectForKey:key];
-        
-        if ([texture useCount] < 1) {
-            [keysToDelete addObject:key];
-        }
-    }
+    [[DNRResourceCache sharedCache] setObject:texture forKey:path];
+}
+
+
++ (void) purgeUnusedTextures {
     
-    [texturesByName removeObjectsForKeys:keysToDelete];
+    [[DNRResourceCache sharedCache] purgeUnusedObjectsOfClass:[DNRTexture class]];
 }
 
 
@@ -251,82 +492,65 @@ CGFloat scaleFactorOfImageFileName(NSString* fileName){
 - (instancetype) initWithContentsOfFile:(NSString *)path
                                 options:(NSDictionary *)options {
     
-    if ((self = [super init])) {
-        
-        _useCount = 0;
-        
-        
-        NSString* optimalPath = imagePathWithBestResolutionAvailable(path);
-        
-        NSString* fileName = [optimalPath lastPathComponent];
-        
-        _scaleFactor = scaleFactorOfImageFileName(fileName);
-        
-        // TODO: Rethink hi-res-from-file-name logic.
-        
-#ifdef DNRPlatformPhone
-        // iOS
-        UIImage* image = [[UIImage alloc] initWithContentsOfFile:optimalPath];
+    // 1. Decode (CPU)
+    
+    DNRTextureImage image;
+    
+    if (!DNRTextureImageLoad(path, &image)) {
+        return nil;
+    }
+    
+    
+    // 2. Upload (GPU). Off the main thread, use the background context:
+    
+    BOOL usingBackgroundContext = ([NSThread isMainThread] == NO);
+    
+    if (usingBackgroundContext) {
         
-        CGImageRef imageRef = [image CGImage];
+#ifdef DNRPlatformPhone     // iOS (OpenGL ES)
+        EAGLContext* backgroundContext = [[DNRViewController sharedController] backgroundRenderingContext];
+        [EAGLContext setCurrentContext:backgroundContext];
+#else                       // macOS (OpenGL)
+        NSOpenGLContext* backgroundContext = [[DNRViewController sharedController] backgroundRenderingContext];
+        [backgroundContext makeCurrentContext];
+#endif
+        glCacheMakeCurrent((__bridge const void *)backgroundContext);
+    }
+    
+    if ((self = [self initWithImage:&image options:options])) {
         
-        if (imageRef == NULL){
-            return nil;
+        for (GLuint level = 0; level < image.levelCount; level++) {
+            [self uploadRows:NSMakeRange(0, image.levels[level].height) ofLevel:level ofImage:&image];
         }
         
-        _pixelWidth  = (GLuint) CGImageGetWidth(imageRef);
-        _pixelHeight = (GLuint) CGImageGetHeight(imageRef);
-        
-#else
-        // macOS
-        NSArray* imageRepresentations = [NSBitmapImageRep imageRepsWithContentsOfFile:optimalPath];
-        
-        GLuint maxWidth  = 0;
-        GLuint maxHeight = 0;
-        NSBitmapImageRep* largestImageRep;
-        
-        for (NSImageRep * imageRep in imageRepresentations) {
-            if ([imageRep pixelsWide] > maxWidth){
-                maxWidth  = (GLuint)[imageRep pixelsWide];
-                maxHeight = (GLuint)[imageRep pixelsHigh];
-                largestImageRep = (NSBitmapImageRep*) imageRep;
-            }
+        if (usingBackgroundContext) {
+            glFlush();
         }
+    }
+    
+    DNRTextureImageFree(&image);
+    
+    return self;
+}
+
+
+- (instancetype) initWithImage:(const DNRTextureImage *)image
+                       options:(NSDictionary *)options {
+    
+    if ((self = [super init])) {
         
-        _pixelWidth = maxWidth;
-        _pixelHeight = maxHeight;
-        
-        CGImageRef imageRef = [largestImageRep CGImage];
+        atomic_init(&_useCount, 0);
         
-        if (imageRef == NULL){
-            return nil;
-        }
-#endif
+        _pixelWidth  = image->pixelWidth;
+        _pixelHeight = image->pixelHeight;
+        _scaleFactor = image->scaleFactor;
         
         BOOL isPOT = (IsPowerOfTwo(_pixelWidth) && IsPowerOfTwo(_pixelHeight));
-        BOOL usingBackgroundContext = ([NSThread isMainThread] == NO);
-
         
-        if (usingBackgroundContext) {
-            
-#ifdef DNRPlatformPhone     // iOS (OpenGL ES)
-            EAGLContext* backgroundContext = [[DNRViewController sharedController] backgroundRenderingContext];
-            [EAGLContext setCurrentContext:backgroundContext];
-#else                       // macOS (OpenGL)
-            NSOpenGLContext* backgroundContext = [[DNRViewController sharedController] backgroundRenderingContext];
-            [backgroundContext makeCurrentContext];
-#endif
-        }
         
-    
-        glGenTextures(1, &_name);
+        glDispatch.genTextures(1, &_name);
         
-        if (usingBackgroundContext) {
-            glBindTexture(GL_TEXTURE_2D, _name);
-        }
-        else{
-            bindTexture2D(_name);
-        }
+        bindTexture2D(_name);
         
         
         // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
@@ -341,74 +565,108 @@ CGFloat scaleFactorOfImageFileName(NSString* fileName){
             filter = [filterOption unsignedIntValue];
         }
         
-        // 3. Set the specified filtering:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        // 3. Set the specified filtering (and sample the mipmaps, if any):
+        unsigned int minFilter = filter;
+        
+        if (image->levelCount > 1) {
+            minFilter = (filter == GL_LINEAR) ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST;
+            
+            glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image->levelCount - 1);
+        }
+        
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
         
         
         if (filter == GL_LINEAR && !isPOT) {
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         }
         
         
         // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
-        // Transfer source image data to texture buffer
+        // Allocate storage (contents are transferred by 
+        //  -uploadRows:ofLevel:ofImage:; compressed levels are allocated on
+        //  upload)
         
-        CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-        
-        void* imageData = malloc(_pixelWidth*_pixelHeight*4); // 4 bytes per pixel
-        
-        CGContextRef context = CGBitmapContextCreate(imageData,         // Buffer
-                                                     _pixelWidth,       // Width
-                                                     _pixelHeight,      // Height
-                                                     8,                 // Bits per component
-                                                     4* _pixelWidth,    // Bytes per row
-                                                     colorSpace,        // Color space
-                                                     kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
-        CGColorSpaceRelease(colorSpace);
+        for (GLuint level = 0; level < image->levelCount; level++) {
+            
+            _memorySize += image->levels[level].size;
+            
+            if (image->type == 0) {
+                continue;
+            }
+            
+            glDispatch.texImage2D(GL_TEXTURE_2D,
+                                  level,
+                                  image->format,
+                                  image->levels[level].width,
+                                  image->levels[level].height,
+                                  0,
+                                  image->format,
+                                  image->type,
+                                  NULL);
+        }
         
+        bindTexture2D(0);
+    }
+    
+    return self;
+}
 
-        CGContextSetBlendMode(context, kCGBlendModeCopy);// TEST
-        
-        CGContextClearRect( context, CGRectMake(0, 0, _pixelWidth, _pixelHeight));
-        
-//        if(1){// TEST
-//            CGContextTranslateCTM(context, 0.0, _pixelHeight);
-//            CGContextScaleCTM(context, 1.0, -1.0);
-//        }
+
+- (void) uploadRows:(NSRange) rows
+            ofLevel:(GLuint) level
+            ofImage:(const DNRTextureImage *)image {
+    
+    if (level >= image->levelCount) {
+        return;
+    }
+    
+    const DNRTextureImageLevel* imageLevel = &image->levels[level];
+    
+    bindTexture2D(_name);
+    
+    if (image->type == 0) {
+        // [ A ] Compressed: whole level at once
+        
+        glDispatch.compressedTexImage2D(GL_TEXTURE_2D,
+                                        level,
+                                        image->format,
+                                        imageLevel->width,
+                                        imageLevel->height,
+                                        0,
+                                        (GLsizei)imageLevel->size,
+                                        imageLevel->data);
+    }
+    else if (rows.location < imageLevel->height) {
+        // [ B ] Uncompressed: the specified rows
         
-        CGContextDrawImage( context, CGRectMake(0, 0, _pixelWidth, _pixelHeight), imageRef);
+        if (NSMaxRange(rows) > imageLevel->height) {
+            rows.length = imageLevel->height - rows.location;
+        }
         
-        glTexImage2D(GL_TEXTURE_2D,
-                     0,
-                     GL_RGBA,
-                     _pixelWidth,
-                     _pixelHeight,
-                     0,
-                     GL_RGBA,
-                     GL_UNSIGNED_BYTE,
-                     imageData);
+        size_t rowBytes = DNRTextureImageRowBytes(image, level);
         
-        if (usingBackgroundContext) {
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glFlush();
-        }
-        else{
-            // TODO: use cache
-            bindTexture2D(0);
-        }
+        const uint8_t* firstRow = (const uint8_t *)imageLevel->data + rows.location * rowBytes;
         
-        CGContextRelease(context);
-        free(imageData);
+        glDispatch.texSubImage2D(GL_TEXTURE_2D,
+                                 level,
+                                 0,
+                                 (GLint)rows.location,
+                                 imageLevel->width,
+                                 (GLsizei)rows.length,
+                                 image->format,
+                                 image->type,
+                                 firstRow);
     }
     
-    return self;
+    bindTexture2D(0);
 }
 
 
 - (void) dealloc {
-    glDeleteTextures(1, &_name);
+    deleteTexture2D(_name);
 }
 
 
@@ -420,16 +678,35 @@ CGFloat scaleFactorOfImageFileName(NSString* fileName){
 }
 
 
+- (NSInteger) useCount {
+    return atomic_load(&_useCount);
+}
+
+
+- (void) setUseCount:(NSInteger) useCount {
+    atomic_store(&_useCount, useCount);
+}
+
+
 #pragma mark - Operation
 
 
 - (void) aquire {
-    _useCount++;
+    atomic_fetch_add(&_useCount, 1);
 }
 
 
 - (void) relinquish {
-    _useCount--;
+    
+    if (atomic_fetch_sub(&_useCount, 1) == 1) {
+        // No longer in use; can go if the cache is over budget
+        [[DNRResourceCache sharedCache] trimToBudget];
+    }
+}
+
+
+- (BOOL) isInUse {
+    return (atomic_load(&_useCount) > 0);
 }
 
 
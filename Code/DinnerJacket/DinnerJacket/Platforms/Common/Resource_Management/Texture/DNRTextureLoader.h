@@ -0,0 +1,113 @@
+//
+//  DNRTextureLoader.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-24.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "DNRResourceCommon.h"
+
+
+/**
+ Relative urgency of a texture load. Higher priority requests are decoded and
+ uploaded first.
+ */
+typedef NS_ENUM(NSInteger, DNRTextureLoadPriority) {
+
+    DNRTextureLoadPriorityLow       = -1,
+    DNRTextureLoadPriorityNormal    =  0,
+    DNRTextureLoadPriorityHigh      = +1
+};
+
+
+
+/**
+ Handle to an asynchronous texture load, returned by DNRTextureLoader.
+ */
+@interface DNRTextureLoadRequest : NSObject
+
+///
+@property (nonatomic, readonly) NSString*               path;
+
+/// Can be raised (or lowered) while the load is still pending.
+@property (nonatomic, readwrite) DNRTextureLoadPriority priority;
+
+///
+@property (nonatomic, readonly, getter=isCancelled) BOOL cancelled;
+
+
+/**
+ The completion handler will not be called. If no other request is waiting for
+ the same file, decoding (if not started yet) and uploading are abandoned.
+ */
+- (void) cancel;
+
+@end
+
+
+
+/**
+ @interface DNRTextureLoader
+ 
+ @brief
+    Loads textures asynchronously, in two stages:
+ 
+ @details
+    1. Decoding of the image file (CPU) runs in parallel on a bounded pool of
+       background workers, in priority order.
+    
+    2. Transferring the decoded pixels to OpenGL (GPU) is serialized on the
+       main thread, and time-sliced: -performPendingUploads is called once per
+       frame (by the time controller) and stops as soon as uploadBudget is
+       spent, resuming on the next frame. Large images are uploaded a band of
+       rows at a time.
+    
+    Requests for a file that is already being loaded are coalesced; completion
+    handlers always run on the main thread.
+ */
+@interface DNRTextureLoader : NSObject
+
+
+/// Maximum number of images decoded at the same time. Default is 2.
+@property (nonatomic, readwrite) NSInteger      maximumConcurrentDecodes;
+
+/// Time (in seconds) that uploads can take per frame. Default is 4 ms.
+@property (nonatomic, readwrite) CFTimeInterval uploadBudget;
+
+/// Decoded images waiting to be (fully) uploaded.
+@property (nonatomic, readonly) NSUInteger      pendingUploadCount;
+
+
+/**
+ */
++ (instancetype) sharedLoader;
+
+
+/**
+ If the texture is already loaded, the completion handler runs right away
+ (and the returned request is nil). Otherwise, it runs with an array containing
+ the texture, or nil if loading failed.
+ */
+- (DNRTextureLoadRequest *) loadTextureWithContentsOfFile:(NSString *)path
+                                                  options:(NSDictionary *)options
+                                                 priority:(DNRTextureLoadPriority) priority
+                                               completion:(DNRResourceLoadingCompletionHandler) completionHandler;
+
+
+/**
+ Cancels every pending request (e.g., when leaving a level that is still
+ loading).
+ */
+- (void) cancelAllRequests;
+
+
+/**
+ Uploads decoded images (highest priority first) until the budget is spent.
+ Must be called on the main thread, once per frame.
+ */
+- (void) performPendingUploads;
+
+@end
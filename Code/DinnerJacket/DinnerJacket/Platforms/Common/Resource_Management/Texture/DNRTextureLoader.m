@@ -0,0 +1,566 @@
+//
+//  DNRTextureLoader.m
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-24.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#import "DNRTextureLoader.h"
+
+#import "DNRTexture.h"
+
+
+// .............................................................................
+
+// Uploads are sliced into bands of rows of (about) this size:
+static const NSUInteger kUploadSliceBytes = 256 * 1024;
+
+
+static void performOnMainThread(dispatch_block_t block) {
+
+    if ([NSThread isMainThread]) {
+        block();
+    }
+    else{
+        dispatch_async(dispatch_get_main_queue(), block);
+    }
+}
+
+
+static NSOperationQueuePriority operationPriority(DNRTextureLoadPriority priority) {
+
+    switch (priority) {
+        case DNRTextureLoadPriorityLow:
+            return NSOperationQueuePriorityLow;
+        
+        case DNRTextureLoadPriorityHigh:
+            return NSOperationQueuePriorityHigh;
+        
+        default:
+            return NSOperationQueuePriorityNormal;
+    }
+}
+
+// .............................................................................
+
+
+/**
+ All pending requests for the same file share one job. Its state is only
+ accessed on the main thread (decoding works on a copy of the path).
+ */
+@interface DNRTextureLoadJob : NSObject {
+
+@public
+    DNRTextureImage _image;     // Valid from decoding until fully uploaded
+}
+
+///
+@property (nonatomic, readwrite) NSString*          path;
+
+///
+@property (nonatomic, readwrite) NSDictionary*      options;
+
+/// Requests waiting for the texture (not cancelled).
+@property (nonatomic, readwrite) NSMutableArray*    requests;
+
+///
+@property (nonatomic, readwrite) NSOperation*       decodeOperation;
+
+/// Created on the first upload slice.
+@property (nonatomic, readwrite) DNRTexture*        texture;
+
+/// Mipmap levels transferred so far.
+@property (nonatomic, readwrite) GLuint             uploadedLevels;
+
+/// Rows of the current level transferred so far.
+@property (nonatomic, readwrite) NSUInteger         uploadedRows;
+
+/// Set when no request waits for the job anymore.
+@property (nonatomic, readwrite) BOOL               abandoned;
+
+/// Highest among the job's requests.
+@property (nonatomic, readonly) DNRTextureLoadPriority priority;
+
+@end
+
+
+@implementation DNRTextureLoadJob
+
+- (instancetype) init {
+
+    if ((self = [super init])) {
+        _requests = [NSMutableArray new];
+    }
+    
+    return self;
+}
+
+
+- (void) dealloc {
+
+    DNRTextureImageFree(&_image);
+}
+
+
+- (DNRTextureLoadPriority) priority {
+
+    DNRTextureLoadPriority priority = DNRTextureLoadPriorityLow;
+    
+    for (DNRTextureLoadRequest* request in _requests) {
+        priority = MAX(priority, [request priority]);
+    }
+    
+    return priority;
+}
+
+@end
+
+
+// .............................................................................
+
+
+@interface DNRTextureLoader ()
+
+- (void) cancelRequest:(DNRTextureLoadRequest *)request;
+
+- (void) requestDidChangePriority:(DNRTextureLoadRequest *)request;
+
+@end
+
+
+// .............................................................................
+
+
+@interface DNRTextureLoadRequest ()
+
+///
+@property (nonatomic, readwrite) NSString*                              path;
+
+///
+@property (nonatomic, readwrite, getter=isCancelled) BOOL               cancelled;
+
+/// Released as soon as called (or cancelled).
+@property (nonatomic, copy) DNRResourceLoadingCompletionHandler         completionHandler;
+
+///
+@property (nonatomic, weak) DNRTextureLoader*                           loader;
+
+///
+@property (nonatomic, weak) DNRTextureLoadJob*                          job;
+
+
+- (instancetype) initWithPath:(NSString *)path
+                     priority:(DNRTextureLoadPriority) priority;
+
+@end
+
+
+@implementation DNRTextureLoadRequest
+
+- (instancetype) initWithPath:(NSString *)path
+                     priority:(DNRTextureLoadPriority) priority {
+    
+    if ((self = [super init])) {
+        _path     = [path copy];
+        _priority = priority;
+    }
+    
+    return self;
+}
+
+
+- (void) setPriority:(DNRTextureLoadPriority) priority {
+
+    _priority = priority;
+    
+    performOnMainThread(^{
+        [self.loader requestDidChangePriority:self];
+    });
+}
+
+
+- (void) cancel {
+
+    if (_cancelled) {
+        return;
+    }
+    
+    _cancelled = YES;
+    
+    performOnMainThread(^{
+        [self.loader cancelRequest:self];
+    });
+}
+
+@end
+
+
+// .............................................................................
+
+
+@implementation DNRTextureLoader {
+    
+    NSOperationQueue*       _decodeQueue;
+    
+    // (Main thread only:)
+    NSMutableDictionary*    _jobsByPath;        // Not finished yet
+    NSMutableArray*         _uploadQueue;       // Decoded, in order of arrival
+}
+
+
++ (instancetype) sharedLoader {
+
+    static id sharedInstance = nil;
+    
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedInstance = [self new];
+    });
+    
+    return sharedInstance;
+}
+
+
+#pragma mark - Initialization
+
+
+- (instancetype) init {
+
+    if ((self = [super init])) {
+        
+        _decodeQueue = [NSOperationQueue new];
+        
+        [_decodeQueue setName:@"DNRTextureLoader.Decode"];
+        [_decodeQueue setQualityOfService:NSQualityOfServiceUserInitiated];
+        [_decodeQueue setMaxConcurrentOperationCount:2];
+        
+        _jobsByPath  = [NSMutableDictionary new];
+        _uploadQueue = [NSMutableArray new];
+        
+        _uploadBudget = 0.004;
+    }
+    
+    return self;
+}
+
+
+#pragma mark - Custom Accessors
+
+
+- (NSInteger) maximumConcurrentDecodes {
+
+    return [_decodeQueue maxConcurrentOperationCount];
+}
+
+
+- (void) setMaximumConcurrentDecodes:(NSInteger) maximumConcurrentDecodes {
+
+    [_decodeQueue setMaxConcurrentOperationCount:MAX(1, maximumConcurrentDecodes)];
+}
+
+
+- (NSUInteger) pendingUploadCount {
+
+    return [_uploadQueue count];
+}
+
+
+#pragma mark - Exposed Operation
+
+
+- (DNRTextureLoadRequest *) loadTextureWithContentsOfFile:(NSString *)path
+                                                  options:(NSDictionary *)options
+                                                 priority:(DNRTextureLoadPriority) priority
+                                               completion:(DNRResourceLoadingCompletionHandler) completionHandler {
+    
+    DNRTexture* texture = [DNRTexture cachedTextureWithContentsOfFile:path];
+    
+    if (texture) {
+        // [ A ] CACHE HIT: Return it right away on the main thread.
+        
+        performOnMainThread(^{
+            completionHandler(@[texture]);
+        });
+        
+        return nil;
+    }
+    
+    // [ B ] CACHE MISS: Decode in the background, upload on the main thread
+    
+    DNRTextureLoadRequest* request = [[DNRTextureLoadRequest alloc] initWithPath:path
+                                                                        priority:priority];
+    request.completionHandler = completionHandler;
+    request.loader            = self;
+    
+    performOnMainThread(^{
+        [self enqueueRequest:request options:options];
+    });
+    
+    return request;
+}
+
+
+- (void) cancelAllRequests {
+
+    performOnMainThread(^{
+        
+        for (DNRTextureLoadJob* job in [_jobsByPath allValues]) {
+            
+            for (DNRTextureLoadRequest* request in job.requests) {
+                request.cancelled         = YES;
+                request.completionHandler = nil;
+            }
+            
+            [self abandonJob:job];
+        }
+    });
+}
+
+
+- (void) performPendingUploads {
+
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    
+    // (At least one slice per call, so that loading always progresses)
+    
+    while ([_uploadQueue count] > 0) {
+        
+        DNRTextureLoadJob* job = [self nextUploadJob];
+        
+        if (!job.texture) {
+            job.texture = [[DNRTexture alloc] initWithImage:&job->_image options:job.options];
+        }
+        
+        GLuint                      level      = job.uploadedLevels;
+        const DNRTextureImageLevel* imageLevel = &job->_image.levels[level];
+        
+        // (Compressed levels go in one piece)
+        size_t     rowBytes  = DNRTextureImageRowBytes(&job->_image, level);
+        NSUInteger sliceRows = (rowBytes > 0) ? MAX(1, kUploadSliceBytes / rowBytes) : imageLevel->height;
+        
+        [job.texture uploadRows:NSMakeRange(job.uploadedRows, sliceRows) ofLevel:level ofImage:&job->_image];
+        
+        job.uploadedRows = MIN(job.uploadedRows + sliceRows, imageLevel->height);
+        
+        if (job.uploadedRows >= imageLevel->height) {
+            job.uploadedLevels++;
+            job.uploadedRows = 0;
+        }
+        
+        if (job.uploadedLevels >= job->_image.levelCount) {
+            // Done:
+            
+            [_uploadQueue removeObject:job];
+            DNRTextureImageFree(&job->_image);
+            
+            [DNRTexture cacheTexture:job.texture forFile:job.path];
+            
+            [self finishJob:job texture:job.texture];
+        }
+        
+        if (CFAbsoluteTimeGetCurrent() - startTime >= _uploadBudget) {
+            // (Resume on the next frame)
+            break;
+        }
+    }
+}
+
+
+#pragma mark - Internal Operation
+
+
+- (void) enqueueRequest:(DNRTextureLoadRequest *)request options:(NSDictionary *)options {
+
+    // *!* MAIN THREAD *!*
+    
+    if ([request isCancelled]) {
+        return;
+    }
+    
+    // (Might have finished loading in the meantime)
+    
+    DNRTexture* texture = [DNRTexture cachedTextureWithContentsOfFile:request.path];
+    
+    if (texture) {
+        DNRResourceLoadingCompletionHandler completionHandler = request.completionHandler;
+        request.completionHandler = nil;
+        
+        completionHandler(@[texture]);
+        return;
+    }
+    
+    // Join the job for the same file, or start a new one:
+    
+    DNRTextureLoadJob* job = [_jobsByPath objectForKey:request.path];
+    
+    if (!job) {
+        job = [DNRTextureLoadJob new];
+        
+        job.path    = request.path;
+        job.options = options;
+        
+        [_jobsByPath setObject:job forKey:job.path];
+        
+        [job.requests addObject:request];
+        request.job = job;
+        
+        [self startDecodingJob:job];
+    }
+    else{
+        [job.requests addObject:request];
+        request.job = job;
+        
+        [self updatePriorityOfJob:job];
+    }
+}
+
+
+- (void) startDecodingJob:(DNRTextureLoadJob *)job {
+
+    NSString* path = job.path;
+    
+    NSBlockOperation* operation = [NSBlockOperation new];
+    
+    __weak NSBlockOperation* weakOperation = operation;
+    
+    [operation addExecutionBlock:^{
+        // (WORKER THREAD)
+        
+        if ([weakOperation isCancelled]) {
+            return;
+        }
+        
+        DNRTextureImage image;
+        BOOL decoded = DNRTextureImageLoad(path, &image);
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            // (MAIN THREAD)
+            [self job:job didDecodeImage:image successfully:decoded];
+        });
+    }];
+    
+    job.decodeOperation = operation;
+    
+    [operation setQueuePriority:operationPriority([job priority])];
+    
+    [_decodeQueue addOperation:operation];
+}
+
+
+- (void) job:(DNRTextureLoadJob *)job didDecodeImage:(DNRTextureImage) image successfully:(BOOL) decoded {
+
+    if ([job abandoned]) {
+        DNRTextureImageFree(&image);
+        return;
+    }
+    
+    if (!decoded) {
+        [self finishJob:job texture:nil];
+        return;
+    }
+    
+    job->_image = image;
+    
+    [_uploadQueue addObject:job];
+}
+
+
+- (DNRTextureLoadJob *) nextUploadJob {
+
+    // Highest priority; earliest decoded among equals
+    
+    DNRTextureLoadJob* nextJob = nil;
+    
+    for (DNRTextureLoadJob* job in _uploadQueue) {
+        if (nextJob == nil || [job priority] > [nextJob priority]) {
+            nextJob = job;
+        }
+    }
+    
+    return nextJob;
+}
+
+
+- (void) finishJob:(DNRTextureLoadJob *)job texture:(DNRTexture *)texture {
+
+    [_jobsByPath removeObjectForKey:job.path];
+    
+    NSArray* requests = [job.requests copy];
+    [job.requests removeAllObjects];
+    
+    NSArray* loadedObjects = texture ? @[texture] : nil;
+    
+    for (DNRTextureLoadRequest* request in requests) {
+        
+        DNRResourceLoadingCompletionHandler completionHandler = request.completionHandler;
+        request.completionHandler = nil;
+        
+        if (completionHandler && ![request isCancelled]) {
+            completionHandler(loadedObjects);
+        }
+    }
+}
+
+
+- (void) abandonJob:(DNRTextureLoadJob *)job {
+
+    // (If decoding already started, the result is discarded on arrival)
+    
+    job.abandoned = YES;
+    
+    [job.decodeOperation cancel];
+    [job.requests removeAllObjects];
+    
+    [_jobsByPath removeObjectForKey:job.path];
+    [_uploadQueue removeObject:job];
+    
+    DNRTextureImageFree(&job->_image);
+    
+    // (Deletes the partially uploaded texture object, if any)
+    job.texture = nil;
+}
+
+
+- (void) cancelRequest:(DNRTextureLoadRequest *)request {
+
+    request.completionHandler = nil;
+    
+    DNRTextureLoadJob* job = request.job;
+    
+    if (!job) {
+        // (Not enqueued yet, or already finished)
+        return;
+    }
+    
+    [job.requests removeObject:request];
+    
+    if ([job.requests count] == 0) {
+        [self abandonJob:job];
+    }
+    else{
+        [self updatePriorityOfJob:job];
+    }
+}
+
+
+- (void) requestDidChangePriority:(DNRTextureLoadRequest *)request {
+
+    DNRTextureLoadJob* job = request.job;
+    
+    if (job) {
+        [self updatePriorityOfJob:job];
+    }
+}
+
+
+- (void) updatePriorityOfJob:(DNRTextureLoadJob *)job {
+
+    // (Has effect only while waiting in the queue; the upload order is
+    //  decided by -nextUploadJob)
+    
+    [job.decodeOperation setQueuePriority:operationPriority([job priority])];
+}
+
+
+@end
@@ -0,0 +1,156 @@
+//
+//  DNRAtlasFile.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-21.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "DNRAtlasFile.h"
+
+
+struct tAtlasFile {
+
+    const uint8_t*  bytes;
+    size_t          size;
+};
+
+
+// .............................................................................
+// Validation
+
+static int atlasFileValidate(const AtlasFile* file) {
+
+    if (file->size < sizeof(AtlasFileHeader)) {
+        return 0;
+    }
+
+    const AtlasFileHeader* header = atlasFileHeader(file);
+
+    if (memcmp(header->magic, DNRAtlasFileMagic, 4) != 0) {
+        return 0;
+    }
+    if (header->version != DNRAtlasFileVersion) {
+        return 0;
+    }
+
+
+    // String table (must be NUL-terminated, so every string in it is)
+
+    if (header->stringsSize == 0 || header->stringsOffset > file->size || header->stringsSize > file->size - header->stringsOffset) {
+        return 0;
+    }
+    if (file->bytes[header->stringsOffset + header->stringsSize - 1] != '\0') {
+        return 0;
+    }
+    if (header->imageName >= header->stringsSize || header->imageDirectory >= header->stringsSize) {
+        return 0;
+    }
+
+
+    // Subimages
+
+    if (header->subimagesOffset % 4 != 0 || header->subimagesOffset > file->size) {
+        return 0;
+    }
+    if ((uint64_t)header->subimageCount * sizeof(AtlasFileSubimage) > file->size - header->subimagesOffset) {
+        return 0;
+    }
+
+    const AtlasFileSubimage* subimages = atlasFileSubimages(file);
+
+    for (uint32_t i = 0; i < header->subimageCount; i++) {
+        if (subimages[i].name >= header->stringsSize) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+// .............................................................................
+// Opening/Closing
+
+AtlasFile* atlasFileOpen(const char* path) {
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size  = (size_t)info.st_size;
+    void*  bytes = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd); // (The mapping stays valid)
+
+    if (bytes == MAP_FAILED) {
+        return NULL;
+    }
+
+    AtlasFile* file = calloc(1, sizeof(AtlasFile));
+
+    file->bytes = bytes;
+    file->size  = size;
+
+    if (!atlasFileValidate(file)) {
+        atlasFileClose(file);
+        return NULL;
+    }
+
+    return file;
+}
+
+
+void atlasFileClose(AtlasFile* file) {
+
+    if (file == NULL) {
+        return;
+    }
+
+    munmap((void *)file->bytes, file->size);
+
+    free(file);
+}
+
+
+// .............................................................................
+// Accessors
+
+const AtlasFileHeader* atlasFileHeader(const AtlasFile* file) {
+
+    return (const AtlasFileHeader *)file->bytes;
+}
+
+
+const AtlasFileSubimage* atlasFileSubimages(const AtlasFile* file) {
+
+    return (const AtlasFileSubimage *)(file->bytes + atlasFileHeader(file)->subimagesOffset);
+}
+
+
+const char* atlasFileString(const AtlasFile* file, uint32_t offset) {
+
+    const AtlasFileHeader* header = atlasFileHeader(file);
+
+    if (offset >= header->stringsSize) {
+        return "";
+    }
+
+    return (const char *)(file->bytes + header->stringsOffset + offset);
+}
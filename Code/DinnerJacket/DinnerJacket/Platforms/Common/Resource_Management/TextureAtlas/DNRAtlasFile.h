@@ -0,0 +1,111 @@
+//
+//  DNRAtlasFile.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-21.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRAtlasFile_h__
+#define __DNRAtlasFile_h__
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/*
+ Compiled (binary) texture atlas database.
+
+ Holds the same information as the atlas property list (ImageName,
+ ImageDirectory and the Database of subimages), with every rectangle already
+ parsed, so that it can be mapped into memory and read in place.
+
+ Files are produced offline from the property list by
+ scripts/compile_atlas.py, and placed next to it with the extension
+ DNRAtlasFileExtension. All values are little endian; offsets are in bytes,
+ from the beginning of the file. Strings are referenced by offset into the
+ string table (UTF-8, NUL-terminated; offset 0 is always the empty string).
+
+ Layout:
+
+    AtlasFileHeader
+    AtlasFileSubimage[subimageCount]
+    String table
+ */
+
+#define DNRAtlasFileMagic           "DNRA"
+#define DNRAtlasFileVersion         1u
+
+#define DNRAtlasFileExtension       "atlasdb"
+
+
+// Subimage flags
+#define AtlasSubimageFlagOpaque     (1u << 0)
+#define AtlasSubimageFlagRotated    (1u << 1)   // Stored turned 90° clockwise
+
+
+typedef struct tAtlasFileHeader {
+
+    char        magic[4];           // DNRAtlasFileMagic
+    uint16_t    version;            // DNRAtlasFileVersion
+    uint16_t    reserved;
+
+    uint32_t    imageName;          // (string)
+    uint32_t    imageDirectory;     // (string; empty if not specified)
+
+    uint32_t    subimageCount;
+    uint32_t    subimagesOffset;
+    uint32_t    stringsOffset;
+    uint32_t    stringsSize;
+
+}AtlasFileHeader;
+
+
+typedef struct tAtlasFileSubimage {
+
+    uint32_t    name;               // (string)
+
+    float       x;                  // Rectangle in the texture (points, top left
+    float       y;                  //  origin; if rotated, width and height are
+                                    //  those of the image, i.e. transposed)
+    float       width;
+    float       height;
+
+    float       sourceWidth;        // Size before trimming (equal to width and
+    float       sourceHeight;       //  height, if not trimmed)
+    float       trimX;              // Offset of the rectangle's top left corner
+    float       trimY;              //  within the untrimmed image
+
+    uint32_t    flags;              // AtlasSubimageFlag*
+
+}AtlasFileSubimage;
+
+
+typedef struct tAtlasFile AtlasFile;
+
+
+/**
+ Maps the file at path into memory and validates its structure. Returns NULL
+ on failure.
+ */
+AtlasFile* atlasFileOpen(const char* path);
+
+
+/**
+ Unmaps the file and frees the object.
+ */
+void atlasFileClose(AtlasFile* file);
+
+
+const AtlasFileHeader* atlasFileHeader(const AtlasFile* file);
+
+const AtlasFileSubimage* atlasFileSubimages(const AtlasFile* file);
+
+
+/**
+ The string at the specified offset in the string table.
+ */
+const char* atlasFileString(const AtlasFile* file, uint32_t offset);
+
+
+#endif  // #defined (__DNRAtlasFile_h__)
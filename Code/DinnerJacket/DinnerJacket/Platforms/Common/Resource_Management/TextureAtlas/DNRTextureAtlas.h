@@ -11,6 +11,16 @@
 
 #import "DNRResourceCommon.h"
 
+#import "Types.h"                       // VertexData2D
+
+
+
+/// Integer identifier assigned to each subimage name when the atlas loads.
+/// Valid only within the atlas that assigned it.
+typedef uint32_t DNRSubimageID;
+
+#define DNRSubimageIDNone   UINT32_MAX
+
 
 
 @class DNRTexture;
@@ -22,6 +32,9 @@ extern NSString* const DNRAtlasLoadedVertexArrayObjectNotification;
 
 extern NSString* const kDNRAtlasLoadedVertexArrayObjectSumbimageNamesKey;
 
+/// NSNumber with the name of the (atlas') vertex array object.
+extern NSString* const kDNRAtlasLoadedVertexArrayObjectKey;
+
 /**
     @interface DNRTextureAtlas
  
@@ -30,14 +43,32 @@ extern NSString* const kDNRAtlasLoadedVertexArrayObjectSumbimageNamesKey;
         used to create individual sprites that render more effciently.
  
     @details
-        An OpenGL ES vertex array object (VAO) is created lazily for each named
-        subimage. different sprite instances of the same subimage share the same
-        VAO. All sprite instances, regardless of the subimage, share the same 
-        index buffer object (IBO): vertex indices 0, 1, 2, 3.
+        Subimage names are interned to integer IDs when the atlas loads. At the
+        same time, a single static vertex buffer holding one quad for every 
+        subimage (in ID order) is built, along with an OpenGL ES vertex array
+        object (VAO) that sources it. All sprites of the atlas share that VAO;
+        each frame is drawn as the four vertices starting at 
+        -firstVertexForSubimageWithID:.
+ 
+        Atlases are usually produced from loose sprite images by 
+        scripts/pack_atlas.py, which trims each subimage to its visible 
+        pixels, turns it 90° clockwise where it packs better (the texture
+        coordinates are swapped back on load), and flags those that are
+        fully opaque.
+ 
+        The atlas' image can be shipped as a KTX container instead of (or in 
+        addition to) the PNG; scripts/convert_textures.py produces it in the
+        format named by the atlas' "TextureFormat" hint (RGBA8, RGBA4444, 
+        RGB565 or ETC2), with mipmaps if the "Mipmaps" hint is set.
+ 
+        Loaded atlases are kept in the shared DNRResourceCache (see 
+        +[DNRResourceCache sharedCache]) until evicted, which only happens
+        once no sprite uses their vertex array object. Evicting an atlas
+        relinquishes its texture.
  
     @since 1.0.0
  */
-@interface DNRTextureAtlas : NSObject
+@interface DNRTextureAtlas : NSObject <DNRCacheableResource>
 
 
 
@@ -50,9 +81,17 @@ extern NSString* const kDNRAtlasLoadedVertexArrayObjectSumbimageNamesKey;
 ///
 @property (nonatomic, readonly) GLuint      textureName;
 
+/// Shared by all subimages. 0 until created (if the atlas was loaded on a
+/// background thread, DNRAtlasLoadedVertexArrayObjectNotification is posted
+/// when it becomes available).
+@property (nonatomic, readonly) GLuint      vertexArrayObject;
+
 
 
 /**
+ Loads the atlas from the compiled database (<atlasName>.atlasdb, see
+ scripts/compile_atlas.py) if present in the main bundle, and from the property
+ list (<atlasName>.plist) otherwise.
  */
 + (DNRTextureAtlas *)atlasNamed:(NSString *)atlasName;
 
@@ -79,19 +118,66 @@ extern NSString* const kDNRAtlasLoadedVertexArrayObjectSumbimageNamesKey;
 + (void) purgeUnusedAtlases;
 
 
+/**
+ Returns the identifier interned for the subimage name, or DNRSubimageIDNone if
+ the atlas has no such subimage.
+ */
+- (DNRSubimageID) subimageIDForName:(NSString *)subimageName;
+
+
 /**
  */
 - (BOOL) subimageIsOpaque:(NSString *)subimageName;
 
+/**
+ */
+- (BOOL) subimageWithIDIsOpaque:(DNRSubimageID) subimageID;
+
 /**
  */
 - (CGSize) sizeForSubimageNamed:(NSString *)subimageName;
 
+/**
+ The size of the subimage before trimming (if it was trimmed when packed).
+ */
+- (CGSize) sizeForSubimageWithID:(DNRSubimageID) subimageID;
+
+
+/**
+ Writes the four vertices (triangle strip order: top left, bottom left, top 
+ right, bottom right) of a quad at the subimage's native size (in points), 
+ mapped to the subimage's region of the texture. The untrimmed subimage is 
+ centered on the origin.
+ */
+- (void) getVertices:(VertexData2D *)vertices forSubimageNamed:(NSString *)subimageName;
+
+/**
+ Same as above, by subimage ID.
+ */
+- (void) getVertices:(VertexData2D *)vertices forSubimageWithID:(DNRSubimageID) subimageID;
+
 
 /**
  */
 - (GLuint) vertexArrayObjectForSubimageNames:(NSArray *)subimageNames;
 
+/**
+ Index of the first of the subimage's four vertices (triangle strip) in the
+ atlas' vertex array object.
+ */
+- (GLint) firstVertexForSubimageWithID:(DNRSubimageID) subimageID;
+
+/**
+ Returns the atlas' vertex array object (or 0, if not created yet) and
+ increments its use count.
+ */
+- (GLuint) acquireVertexArrayObject;
+
+/**
+ Decrements the use count of the atlas' vertex array object.
+ */
+- (void) relinquishVertexArrayObject;
+
 /**
  */
 - (void) relinquishVertexArrayObjectForSubimageNames:(NSArray *)subimageNames;
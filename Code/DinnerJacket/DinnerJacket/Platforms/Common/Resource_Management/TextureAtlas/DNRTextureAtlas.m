@@ -10,41 +10,34 @@
 
 #import "DNRTexture.h"
 #import "DNRShaderManager.h"
+#import "DNRAtlasFile.h"
+#import "DNRResourceCache.h"
 
 #import "DNRGLCache.h"
+#import "DNRGLDispatch.h"
 #import "DNRGlobals.h"                                  // Stride, etc.
 
 #import "CGSupport.h"
 
-#import <CommonCrypto/CommonDigest.h>
 
 
 // Exported constants
 NSString* const kDNRTextureAtlasOptionsShareGroupKey              = @"ShareGroup";
 NSString* const DNRAtlasLoadedVertexArrayObjectNotification       = @"AtlasLoadedVertexArrayObject";
 NSString* const kDNRAtlasLoadedVertexArrayObjectSumbimageNamesKey = @"SubimageNames";
-
-// Private constants
-static NSString* const kDNRTextureAtlasVAOKey      = @"vao";
-static NSString* const kDNRTextureAtlasVBOKey      = @"vbo";
-static NSString* const kDNRTextureAtlasIBOKey      = @"ibo";
-static NSString* const kDNRTextureAtlasUseCountKey = @"useCount";
+NSString* const kDNRAtlasLoadedVertexArrayObjectKey               = @"VertexArrayObject";
 
 // Shared objects
 static GLuint textureAtlasSharedQuadIBO = 0u;
 static GLuint textureAtlasSharedMeshIBO = 0u;
-static NSMutableDictionary* textureAtlasesByName = nil;
 
 // Helper functions
-NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
-    
-    NSString* imageName      = [dictionary objectForKey:@"ImageName"];
+NSString* DNRTextureAtlasImagePath( NSString* imageName, NSString* imageDirectory ) {
     
     if ([[imageName pathExtension] length] == 0) {
         imageName = [imageName stringByAppendingPathExtension:@"png"];
     }
     
-    NSString* imageDirectory = [dictionary objectForKey:@"ImageDirectory"];
     NSString* imageFullPath = nil;
     
     if (!imageDirectory) {
@@ -64,9 +57,99 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
     return imageFullPath;
 }
 
+
+NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
+    
+    return DNRTextureAtlasImagePath([dictionary objectForKey:@"ImageName"],
+                                    [dictionary objectForKey:@"ImageDirectory"]);
+}
+
+
+NSString* DNRTextureAtlasImagePathInFile( const AtlasFile* file ) {
+    
+    const AtlasFileHeader* header = atlasFileHeader(file);
+    
+    NSString* imageName      = @(atlasFileString(file, header->imageName));
+    NSString* imageDirectory = @(atlasFileString(file, header->imageDirectory));
+    
+    return DNRTextureAtlasImagePath(imageName, [imageDirectory length] > 0 ? imageDirectory : nil);
+}
+
+
+NSString* DNRTextureAtlasCompiledFilePath( NSString* path ) {
+    
+    // The compiled database, if the file at path is one or has one next to it
+    // (see DNRAtlasFile.h); nil otherwise.
+    
+    NSString* extension = @DNRAtlasFileExtension;
+    
+    if ([[path pathExtension] isEqualToString:extension]) {
+        return path;
+    }
+    
+    NSString* compiledPath = [[path stringByDeletingPathExtension] stringByAppendingPathExtension:extension];
+    
+    if ([[NSFileManager defaultManager] fileExistsAtPath:compiledPath]) {
+        return compiledPath;
+    }
+    
+    return nil;
+}
+
+
+NSString* DNRTextureAtlasPathForResource( NSString* atlasName ) {
+    
+    NSBundle* bundle = [NSBundle mainBundle];
+    NSString* path   = [bundle pathForResource:atlasName ofType:@"plist"];
+    
+    if (!path) {
+        // (Shipped compiled only)
+        path = [bundle pathForResource:atlasName ofType:@DNRAtlasFileExtension];
+    }
+    
+    return path;
+}
+
+
+/// Atlases share the resource cache with textures (keyed by file path); the
+/// prefix keeps atlas names from clashing with those.
+NSString* DNRTextureAtlasCacheKey( NSString* atlasName ) {
+    
+    if (!atlasName) {
+        return nil;
+    }
+    
+    return [@"Atlas:" stringByAppendingString:atlasName];
+}
+
+
+/// Same key whether loaded by name or by path (plist or compiled database).
+NSString* DNRTextureAtlasCacheKeyForFile( NSString* path ) {
+    
+    return DNRTextureAtlasCacheKey([[path lastPathComponent] stringByDeletingPathExtension]);
+}
+
 // .............................................................................
 
 
+/// Everything the atlas needs to know about a subimage, parsed once on load.
+typedef struct tSubimageInfo {
+    
+    CGRect      rect;               // Region of the texture, in points
+    CGSize      sourceSize;         // Size before trimming (rect.size if not
+    CGPoint     trimOffset;         //  trimmed), and position of the region
+                                    //  within it
+    GLfloat     s0, s1;             // Texture coordinates of the region
+    GLfloat     t0, t1;
+    
+    BOOL        opaque;
+    BOOL        rotated;            // Stored turned 90° clockwise (occupies
+                                    //  rect.size transposed in the texture)
+    
+}SubimageInfo;
+
+
+
 @interface DNRTextureAtlas ()
 
 /// Status.
@@ -79,26 +162,26 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
 @property (nonatomic, readwrite) DNRTexture*            texture;
 
 
-/// Holds all the subimage rects (in points) keyed by subimage name
-@property (nonatomic, readwrite) NSMutableDictionary*   database;
-
-
-///
-@property (nonatomic, readwrite) NSMutableDictionary*   vaoDatabase;
-
+/// Interned subimage IDs (NSNumber), keyed by subimage name
+@property (nonatomic, readwrite) NSDictionary*          subimageIDsByName;
 
-///
-@property (nonatomic, readwrite) NSMutableDictionary*   iboDatabase;
 
-
-/// Cummulative use count of all Vertex Array Objects. (when 0, texture atlas
+/// Cummulative use count of the Vertex Array Object. (when 0, texture atlas
 /// can be safely deallocated)
 @property (nonatomic, readwrite) NSInteger vaoTotalUseCount;
 
 @end
 
 
-@implementation DNRTextureAtlas
+@implementation DNRTextureAtlas {
+
+    // Per-subimage data, indexed by subimage ID:
+    SubimageInfo*       _subimages;
+    NSUInteger          _subimageCount;
+    
+    // Geometry of all subimages (see -createVertexArrayObject)
+    GLuint              _vertexBufferObject;
+}
 
 
 #pragma mark - Factory / Management
@@ -111,8 +194,6 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
         static dispatch_once_t onceToken;
         dispatch_once(&onceToken, ^{
         
-            textureAtlasesByName = [NSMutableDictionary new];
-            
             // Initialize shared objects synchronously on main thread
             
             dispatch_block_t block = ^{
@@ -123,10 +204,10 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
                     
                     GLushort quadIndices[4] = {0, 1, 2, 3};
                     
-                    glGenBuffers(1, &textureAtlasSharedQuadIBO);
+                    glDispatch.genBuffers(1, &textureAtlasSharedQuadIBO);
                     bindIndexBufferObject(textureAtlasSharedQuadIBO);
                     
-                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 4*sizeof(GLushort), &quadIndices, GL_STATIC_DRAW);
+                    glDispatch.bufferData(GL_ELEMENT_ARRAY_BUFFER, 4*sizeof(GLushort), &quadIndices, GL_STATIC_DRAW);
                     
                     bindIndexBufferObject(0);
                 }
@@ -147,10 +228,10 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
                         16, 17, 18, 19, 20, 21, 22, 23
                     };
                     
-                    glGenBuffers(1, &textureAtlasSharedMeshIBO);
+                    glDispatch.genBuffers(1, &textureAtlasSharedMeshIBO);
                     bindIndexBufferObject(textureAtlasSharedMeshIBO);
                     
-                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 28*sizeof(GLushort), &meshIndices[0], GL_STATIC_DRAW);
+                    glDispatch.bufferData(GL_ELEMENT_ARRAY_BUFFER, 28*sizeof(GLushort), &meshIndices[0], GL_STATIC_DRAW);
                     
                     bindIndexBufferObject(0);
                 }
@@ -171,35 +252,54 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
 
     // Check if cached:
     
-    DNRTextureAtlas* atlas = [textureAtlasesByName objectForKey:atlasName];
+    DNRTextureAtlas* atlas = [[DNRResourceCache sharedCache] objectForKey:DNRTextureAtlasCacheKey(atlasName)];
     if(atlas){
         return atlas;
     }
     
     // Not cached; Create it:
     
-    NSString* path = [[NSBundle mainBundle] pathForResource:atlasName ofType:@"plist"];
+    NSString* path = DNRTextureAtlasPathForResource(atlasName);
     return [self textureAtlasWithContentsOfFile:path];
 }
 
 
 + (DNRTextureAtlas *)textureAtlasWithContentsOfFile:(nonnull NSString *)path {
     
-    NSDictionary* dictionary = [NSDictionary dictionaryWithContentsOfFile:path];
+    DNRTextureAtlas *textureAtlas = nil;
     
-    if (!dictionary) {
-        return nil;
-    }
+    NSString*  compiledPath = DNRTextureAtlasCompiledFilePath(path);
+    AtlasFile* file         = compiledPath ? atlasFileOpen([compiledPath fileSystemRepresentation]) : NULL;
     
-    DNRTexture *texture = [DNRTexture textureWithContentsOfFile:DNRTextureAtlasImageFilePath(dictionary)
+    if (file) {
+        // [ A ] Compiled database: no parsing needed
+        
+        DNRTexture *texture = [DNRTexture textureWithContentsOfFile:DNRTextureAtlasImagePathInFile(file)
+                                                            options:nil];
+        
+        textureAtlas = [[DNRTextureAtlas alloc] initWithTexture:texture atlasFile:file];
+        
+        atlasFileClose(file);
+    }
+    else{
+        // [ B ] Property list (also if the compiled database is corrupt)
+        
+        NSDictionary* dictionary = [NSDictionary dictionaryWithContentsOfFile:path];
+        
+        if (!dictionary) {
+            return nil;
+        }
+        
+        DNRTexture *texture = [DNRTexture textureWithContentsOfFile:DNRTextureAtlasImageFilePath(dictionary)
+                                                            options:nil];
+        
+        textureAtlas = [[DNRTextureAtlas alloc] initWithTexture:texture
+                                                       database:[dictionary objectForKey:@"Database"]
                                                         options:nil];
+    }
     
-    DNRTextureAtlas *textureAtlas = [[DNRTextureAtlas alloc] initWithTexture:texture
-                                                   database:[dictionary objectForKey:@"Database"]
-                                                    options:nil];
     if (textureAtlas) {
-        NSString* atlasName = [[path lastPathComponent] stringByDeletingPathExtension];
-        [textureAtlasesByName setObject:textureAtlas forKey:atlasName];
+        [[DNRResourceCache sharedCache] setObject:textureAtlas forKey:DNRTextureAtlasCacheKeyForFile(path)];
     }
     
     return textureAtlas;
@@ -209,7 +309,7 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
 + (void) loadTextureAtlasWithContentsOfFile:(NSString *)path
                                  completion:(DNRResourceLoadingCompletionHandler) completionHandler {
 
-    DNRTextureAtlas* textureAtlas = [textureAtlasesByName objectForKey:path];
+    DNRTextureAtlas* textureAtlas = [[DNRResourceCache sharedCache] objectForKey:DNRTextureAtlasCacheKeyForFile(path)];
     
     if (textureAtlas) {
         // CACHE HIT: Return it via completion handelr on the main thread.
@@ -227,7 +327,30 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
         // CACHE MISS: Load in the background and return via completion handler
         // on the main thread.
         
-        NSDictionary* dictionary = [NSDictionary dictionaryWithContentsOfFile:path];
+        // (Prefer the compiled database, if available; it stays mapped until
+        //  the texture loads)
+        
+        NSString*     compiledPath = DNRTextureAtlasCompiledFilePath(path);
+        AtlasFile*    file         = compiledPath ? atlasFileOpen([compiledPath fileSystemRepresentation]) : NULL;
+        NSDictionary* dictionary   = nil;
+        NSString*     imagePath    = nil;
+        
+        if (file) {
+            imagePath = DNRTextureAtlasImagePathInFile(file);
+        }
+        else{
+            dictionary = [NSDictionary dictionaryWithContentsOfFile:path];
+            imagePath  = dictionary ? DNRTextureAtlasImageFilePath(dictionary) : nil;
+        }
+        
+        if (!imagePath) {
+            // Database missing or corrupt.
+            
+            dispatch_async( dispatch_get_main_queue(), ^{ // (MAIN THREAD)
+                completionHandler(nil);
+            });
+            return;
+        }
         
         DNRResourceLoadingCompletionHandler completion = ^(NSArray* loadedObjects){
             
@@ -236,14 +359,19 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
             if ([loadedObjects count] == 1) {
                 // Texture is or was loaded: Proceed.
                 
-                DNRTexture*   texture  = [loadedObjects objectAtIndex:0];
-                NSDictionary* database = [dictionary objectForKey:@"Database"];
+                DNRTexture* texture = [loadedObjects objectAtIndex:0];
                 
-                textureAtlas = [[DNRTextureAtlas alloc] initWithTexture:texture
-                                                               database:database
-                                                                options:nil];
+                if (file) {
+                    textureAtlas = [[DNRTextureAtlas alloc] initWithTexture:texture atlasFile:file];
+                    atlasFileClose(file);
+                }
+                else{
+                    textureAtlas = [[DNRTextureAtlas alloc] initWithTexture:texture
+                                                                   database:[dictionary objectForKey:@"Database"]
+                                                                    options:nil];
+                }
                 
-                [textureAtlasesByName setObject:textureAtlas forKey:path];
+                [[DNRResourceCache sharedCache] setObject:textureAtlas forKey:DNRTextureAtlasCacheKeyForFile(path)];
                 
                 if ([NSThread isMainThread]) {
                     completionHandler(@[textureAtlas]);
@@ -259,13 +387,15 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
             else{
                 // Texture not loaded and failed to load.
                 
+                atlasFileClose(file);
+                
                 dispatch_async( dispatch_get_main_queue(), ^{ // (MAIN THREAD)
                     completionHandler(nil);
                 });
             }
         };
         
-        [DNRTexture loadTextureWithContentsOfFile:DNRTextureAtlasImageFilePath(dictionary)
+        [DNRTexture loadTextureWithContentsOfFile:imagePath
                                           options:nil
                                        completion:completion];
     }
@@ -275,7 +405,7 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
 + (void) loadTextureAtlasNamed:(NSString *)atlasName
                     completion:(DNRResourceLoadingCompletionHandler) completionHandler {
 
-    NSString* path = [[NSBundle mainBundle] pathForResource:atlasName ofType:@"plist"];
+    NSString* path = DNRTextureAtlasPathForResource(atlasName);
     
     return [DNRTextureAtlas loadTextureAtlasWithContentsOfFile:path
                                                     completion:completionHandler];
@@ -296,17 +426,7 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
 
 + (void) purgeUnusedAtlases {
     
-    NSMutableArray* keysToDelete = [NSMutableArray new];
-    
-    for (NSString* key in [textureAtlasesByName allKeys]) {
-        DNRTextureAtlas* textureAtlas = [textureAtlasesByName objectForKey:key];
-        
-        if ([textureAtlas canSafelyDelete]) {
-            [keysToDelete addObject:key];
-        }
-    }
-    
-    [textureAtlasesByName removeObjectsForKeys:keysToDelete];
+    [[DNRResourceCache sharedCache] purgeUnusedObjectsOfClass:[DNRTextureAtlas class]];
 }
 
 
@@ -319,32 +439,137 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
 }
 
 
-#pragma mark - Designated Initializer
+#pragma mark - Initialization
 
 
 - (instancetype) initWithTexture:(DNRTexture *)texture
                         database:(NSDictionary *)database
                          options:(NSDictionary *)options {
 
-    if ((self = [super init])) {
+    // Intern all subimage names (assign consecutive IDs), and parse the
+    //  properties of each subimage into a flat array, indexed by ID
+    
+    NSUInteger    subimageCount = [database count];
+    SubimageInfo* subimages     = calloc(subimageCount > 0 ? subimageCount : 1, sizeof(SubimageInfo));
+    
+    NSMutableDictionary* subimageIDsByName = [NSMutableDictionary dictionaryWithCapacity:subimageCount];
+    
+    DNRSubimageID subimageID = 0;
+    
+    for (NSString* subimageName in database) {
+        
+        NSDictionary* subimageDictionary = [database objectForKey:subimageName];
+        SubimageInfo* info               = &subimages[subimageID];
+        
+        info->rect    = CGRectFromString([subimageDictionary objectForKey:@"Rectangle"]);
+        info->opaque  = [[subimageDictionary objectForKey:@"Opaque"] boolValue];
+        info->rotated = [[subimageDictionary objectForKey:@"Rotated"] boolValue];
         
+        // Trimming (optional)
         
-        // Holds the subregion (rectangle), in points, for each named subimage
-        //  in the texture associated with this atlas
+        NSString* sourceSize = [subimageDictionary objectForKey:@"SourceSize"];
+        NSString* trimOffset = [subimageDictionary objectForKey:@"TrimOffset"];
+        
+        info->sourceSize = sourceSize ? CGSizeFromString(sourceSize) : info->rect.size;
+        info->trimOffset = trimOffset ? CGPointFromString(trimOffset) : CGPointZero;
+        
+        subimageIDsByName[subimageName] = @(subimageID);
+        
+        subimageID++;
+    }
+    
+    return [self initWithTexture:texture
+                       subimages:subimages
+                           count:subimageCount
+               subimageIDsByName:subimageIDsByName];
+}
+
+
+- (instancetype) initWithTexture:(DNRTexture *)texture
+                       atlasFile:(const AtlasFile *)file {
+    
+    // Same as above, from the compiled database (already parsed)
+    
+    const AtlasFileHeader*   header  = atlasFileHeader(file);
+    const AtlasFileSubimage* records = atlasFileSubimages(file);
+    
+    NSUInteger    subimageCount = header->subimageCount;
+    SubimageInfo* subimages     = calloc(subimageCount > 0 ? subimageCount : 1, sizeof(SubimageInfo));
+    
+    NSMutableDictionary* subimageIDsByName = [NSMutableDictionary dictionaryWithCapacity:subimageCount];
+    
+    for (DNRSubimageID subimageID = 0; subimageID < subimageCount; subimageID++) {
         
-        _database = [NSMutableDictionary dictionaryWithDictionary:database];
+        const AtlasFileSubimage* record = &records[subimageID];
+        SubimageInfo*            info   = &subimages[subimageID];
         
+        info->rect       = CGRectMake(record->x, record->y, record->width, record->height);
+        info->sourceSize = CGSizeMake(record->sourceWidth, record->sourceHeight);
+        info->trimOffset = CGPointMake(record->trimX, record->trimY);
+        info->opaque     = (record->flags & AtlasSubimageFlagOpaque ) != 0;
+        info->rotated    = (record->flags & AtlasSubimageFlagRotated) != 0;
         
-        // Holds all the geometry associated with each set of subimages
-        // Each entry is created on demand and cached.
+        subimageIDsByName[@(atlasFileString(file, record->name))] = @(subimageID);
+    }
+    
+    return [self initWithTexture:texture
+                       subimages:subimages
+                           count:subimageCount
+               subimageIDsByName:subimageIDsByName];
+}
+
+
+#pragma mark - Designated Initializer
+
+
+- (instancetype) initWithTexture:(DNRTexture *)texture
+                       subimages:(SubimageInfo *)subimages
+                           count:(NSUInteger) subimageCount
+               subimageIDsByName:(NSDictionary *)subimageIDsByName {
+    
+    // (Takes ownership of subimages)
+    
+    if ((self = [super init])) {
         
-        _vaoDatabase = [NSMutableDictionary new];
+        _subimages         = subimages;
+        _subimageCount     = subimageCount;
+        _subimageIDsByName = [subimageIDsByName copy];
         
         
         // Holds the associated texture
 
         _texture = texture;
         [_texture aquire];
+        
+        
+        // Precalculate the texture coordinates of each subimage
+        
+        CGSize imageSize = [_texture size];
+        
+        for (NSUInteger i = 0; i < _subimageCount; i++) {
+            
+            SubimageInfo* info = &_subimages[i];
+            
+            // (Region actually occupied in the texture)
+            CGRect region = info->rect;
+            
+            if (info->rotated) {
+                region.size = CGSizeMake(info->rect.size.height, info->rect.size.width);
+            }
+            
+            info->s0 = (GLfloat)(CGRectGetMinX(region) / imageSize.width );
+            info->s1 = (GLfloat)(CGRectGetMaxX(region) / imageSize.width );
+            info->t0 = (GLfloat)(CGRectGetMinY(region) / imageSize.height);
+            info->t1 = (GLfloat)(CGRectGetMaxY(region) / imageSize.height);
+        }
+        
+        
+        // Build the geometry for all subimages at once
+        
+        [self createVertexArrayObject];
+    }
+    else{
+        free(subimages);
     }
     
     return self;
@@ -356,20 +581,28 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
     [_texture relinquish];
     
     
-    // Delete all cached OpenGL ES objects:
+    // Delete the OpenGL ES objects (through the state cache, so the bindings
+    // it holds are forgotten before the names can be reused):
     
-    for (NSDictionary* entry in [_vaoDatabase allValues]) {
-        
-        GLuint vao = [[entry objectForKey:kDNRTextureAtlasVAOKey] unsignedIntValue];
-        //glDeleteVertexArraysOES(1, &vao);
-        glDeleteVertexArrays(1, &vao);
-        
-        GLuint vbo = [[entry objectForKey:kDNRTextureAtlasVBOKey] unsignedIntValue];
-        glDeleteBuffers(1, &vbo);
-        
-        GLuint ibo = [[entry objectForKey:kDNRTextureAtlasIBOKey] unsignedIntValue];
-        glDeleteBuffers(1, &ibo);
+    deleteVertexArrayObject(_vertexArrayObject);
+    deleteBufferObject(_vertexBufferObject);
+    
+    free(_subimages);
+}
+
+
+#pragma mark - Subimage IDs
+
+
+- (DNRSubimageID) subimageIDForName:(NSString *)subimageName {
+    
+    NSNumber* subimageID = [_subimageIDsByName objectForKey:subimageName];
+    
+    if (subimageID == nil) {
+        return DNRSubimageIDNone;
     }
+    
+    return (DNRSubimageID)[subimageID unsignedIntValue];
 }
 
 
@@ -383,35 +616,34 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
         set to an arbitrary point size.
      */
     
-    CGRect rectangle = CGRectNull;
-    
-    NSDictionary* subimageDictionary = [_database objectForKey:subimageName];
+    return [self rectangleForSubimageWithID:[self subimageIDForName:subimageName]];
+}
+
+
+- (CGRect) rectangleForSubimageWithID:(DNRSubimageID) subimageID {
     
-    if (subimageDictionary) {
-        // Found
-     
-        NSString* rectString = [subimageDictionary objectForKey:@"Rectangle"];
-        rectangle = CGRectFromString(rectString);
+    if (subimageID >= _subimageCount) {
+        // Not found
+        return CGRectNull;
     }
     
-    return rectangle;
+    return _subimages[subimageID].rect;
 }
 
 
 - (BOOL) subimageIsOpaque:(NSString *)subimageName {
 
-    NSDictionary* subimageDictionary = [_database objectForKey:subimageName];
+    return [self subimageWithIDIsOpaque:[self subimageIDForName:subimageName]];
+}
+
+
+- (BOOL) subimageWithIDIsOpaque:(DNRSubimageID) subimageID {
     
-    if (subimageDictionary) {
-        
-        NSNumber* number = [subimageDictionary objectForKey:@"Opaque"];
-        
-        if (number) {
-            return [number boolValue];
-        }
+    if (subimageID >= _subimageCount) {
+        return NO;
     }
     
-    return NO;
+    return _subimages[subimageID].opaque;
 }
 
 
@@ -422,353 +654,235 @@ NSString* DNRTextureAtlasImageFilePath( NSDictionary* dictionary ) {
      However, a sprite needs to know the point size of each of its frames in
      order to scale to the appropriate magnification factor when set to an arbitrary point size.
      */
-    CGRect rectangle = [self rectangleForSubimageNamed:subimageName];
-    
-    return (rectangle.size);
+    return [self sizeForSubimageWithID:[self subimageIDForName:subimageName]];
 }
 
 
-- (void) relinquishVertexArrayObjectForSubimageNames:(NSArray *)subimageNames {
-    
-    // Calcualte the dictionary key associated with the image name set:
-    NSString* key = [self dictionaryKeyForSubimageNames:subimageNames];
+- (CGSize) sizeForSubimageWithID:(DNRSubimageID) subimageID {
     
-    NSMutableDictionary* entry = [_vaoDatabase objectForKey:key];
-    
-    if (entry) {
-        
-        NSInteger useCount = [[entry objectForKey:kDNRTextureAtlasUseCountKey] integerValue];
-        useCount--;
-        
-        if (useCount < 0) {
-            // Error; handle it!
-        }
-        
-        [entry setObject:@(useCount) forKey:kDNRTextureAtlasUseCountKey];
-        
-        _vaoTotalUseCount--;
-        
-        if (_vaoTotalUseCount < 0) {
-            // Error; Handle it!
-        }
+    if (subimageID >= _subimageCount) {
+        return CGSizeZero;
     }
+    
+    // (Untrimmed)
+    return _subimages[subimageID].sourceSize;
 }
 
 
-- (BOOL) canSafelyDelete {
-    return (_vaoTotalUseCount == 0);
+- (void) getVertices:(VertexData2D *)vertices forSubimageNamed:(NSString *)subimageName {
+    
+    [self getVertices:vertices forSubimageWithID:[self subimageIDForName:subimageName]];
 }
 
 
-- (NSUInteger) purgeUnusedData {
+- (void) getVertices:(VertexData2D *)vertices forSubimageWithID:(DNRSubimageID) subimageID {
+
+    if (subimageID >= _subimageCount) {
+        memset(vertices, 0, 4*sizeof(VertexData2D));
+        return;
+    }
     
-    NSUInteger purgeCount = 0;
+    const SubimageInfo* info = &_subimages[subimageID];
     
-    NSArray* allKeys = [_vaoDatabase allKeys];
+    // 1. Texture coordinates (precalculated on load), per corner of the
+    //     quad. Rotated subimages are stored turned 90° clockwise, so the
+    //     quad's top left corner maps to the region's top right one, etc.:
     
-    for (NSString* key in allKeys) {
-        
-        NSMutableDictionary* entry    = [_vaoDatabase objectForKey:key];
-        NSInteger            useCount = [[entry objectForKey:kDNRTextureAtlasUseCountKey] integerValue];
-        
-        if (useCount < 1) {
-            // Unused; purge:
-            
-            // 1. Delete OpenGL ES object
-            GLuint vao = [[entry objectForKey:kDNRTextureAtlasVAOKey] unsignedIntValue];
-            //glDeleteVertexArraysOES(1, &vao);
-            glDeleteVertexArrays(1, &vao);
-            
-            GLuint vbo = [[entry objectForKey:kDNRTextureAtlasVBOKey] unsignedIntValue];
-            glDeleteBuffers(1, &vbo);
-            
-            
-            // 2. Delete database entry
-            [_vaoDatabase removeObjectForKey:key];
-            
-            
-            // 3. Method reports how many entries
-            //    were actually deleted:
-            purgeCount++;
-        }
+    TextureCoordinates topLeft     = { info->s0, info->t0 };
+    TextureCoordinates bottomLeft  = { info->s0, info->t1 };
+    TextureCoordinates topRight    = { info->s1, info->t0 };
+    TextureCoordinates bottomRight = { info->s1, info->t1 };
+    
+    if (info->rotated) {
+        topLeft     = (TextureCoordinates){ info->s1, info->t0 };
+        bottomLeft  = (TextureCoordinates){ info->s0, info->t0 };
+        topRight    = (TextureCoordinates){ info->s1, info->t1 };
+        bottomRight = (TextureCoordinates){ info->s0, info->t1 };
     }
     
-    return purgeCount;
+    
+    // 2. Build quad, texture-mapped to the specified subimage, at the
+    //     subimage's native size. The untrimmed image is centered on the
+    //     origin (so, for trimmed subimages, the quad is offset by the
+    //     trimmed region's position within it; y axis up):
+    
+    GLfloat subimageHalfWidth  = 0.5f * info->rect.size.width;
+    GLfloat subimageHalfHeight = 0.5f * info->rect.size.height;
+    
+    GLfloat centerX = (GLfloat)(info->trimOffset.x - 0.5f*info->sourceSize.width ) + subimageHalfWidth;
+    GLfloat centerY = (GLfloat)(0.5f*info->sourceSize.height - info->trimOffset.y) - subimageHalfHeight;
+    
+    // Top Left
+    vertices[0].position.x  = centerX - subimageHalfWidth;
+    vertices[0].position.y  = centerY + subimageHalfHeight;
+    vertices[0].texCoords   = topLeft;
+    
+    // Bottom Left
+    vertices[1].position.x  = centerX - subimageHalfWidth;
+    vertices[1].position.y  = centerY - subimageHalfHeight;
+    vertices[1].texCoords   = bottomLeft;
+    
+    // Top Right
+    vertices[2].position.x  = centerX + subimageHalfWidth;
+    vertices[2].position.y  = centerY + subimageHalfHeight;
+    vertices[2].texCoords   = topRight;
+    
+    // Bottom Right
+    vertices[3].position.x  = centerX + subimageHalfWidth;
+    vertices[3].position.y  = centerY - subimageHalfHeight;
+    vertices[3].texCoords   = bottomRight;
+    
+    // (no scaling needed to render each sprite frame at native size)
 }
 
 
-- (NSString *)dictionaryKeyForSubimageNames:(NSArray *)names {
-    /* 
-     Generates a key to store (cache) the vertex array object associated with a 
-     specific set of subimage names (frames). The concatenation of all subimage 
-     names should guarantee uniqueness for a given set, but it risks becoming 
-     too long (hence the MD5 hashing)
-     */
+- (GLint) firstVertexForSubimageWithID:(DNRSubimageID) subimageID {
     
+    // (Four vertices per subimage, in ID order)
+    return (GLint)(4 * subimageID);
+}
+
+
+- (GLuint) acquireVertexArrayObject {
     
-    // Sort name array to ensure that different permutations of the same set of
-    //  names don't yield different keys:
-    NSArray* sortedNames = [names sortedArrayUsingComparator:^ NSComparisonResult (NSString* obj1, NSString* obj2){
-        return [obj1 compare:obj2];
-    }];
+    _vaoTotalUseCount++;
     
+    return _vertexArrayObject;
+}
+
+
+- (void) relinquishVertexArrayObject {
     
-    // Concatenate all strings into one, to serve as input to the hash function:
-    NSMutableString* longString = [NSMutableString new];
+    _vaoTotalUseCount--;
     
-    for (NSString* name in sortedNames) {
-        [longString appendString:name];
+    if (_vaoTotalUseCount < 0) {
+        // Error; Handle it!
     }
+    else if (_vaoTotalUseCount == 0) {
+        // No longer in use; can go if the cache is over budget
+        [[DNRResourceCache sharedCache] trimToBudget];
+    }
+}
+
+
+- (GLuint) vertexArrayObjectForSubimageNames:(NSArray *)subimageNames {
     
-    // Convert concatenated string to char array (C string):
-    const char* cstr = [longString UTF8String];
-    
-    // Hash it:
-    unsigned char result[16];
-    unsigned int length = (unsigned int) strlen(cstr);
+    // (All subimages share the atlas' vertex array object)
+    return [self acquireVertexArrayObject];
+}
+
 
-    CC_MD5(cstr, length, result);
+- (void) relinquishVertexArrayObjectForSubimageNames:(NSArray *)subimageNames {
     
-    // convert back to NSString:
-    NSString* key =[NSString stringWithFormat:@"%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X",
-                    result[0],
-                    result[1],
-                    result[2],
-                    result[3],
-                    result[4],
-                    result[5],
-                    result[6],
-                    result[7],
-                    result[8],
-                    result[9],
-                    result[10],
-                    result[11],
-                    result[12],
-                    result[13],
-                    result[14],
-                    result[15]];
+    [self relinquishVertexArrayObject];
+}
+
+
+- (BOOL) canSafelyDelete {
+    return (_vaoTotalUseCount == 0);
+}
+
+
+#pragma mark - DNRCacheableResource
+
+
+- (NSUInteger) memorySize {
     
-    // Done:
-    return key;
+    // (The texture is cached, and charged, separately)
+    return 4*_subimageCount*sizeof(VertexData2D);
 }
 
 
-- (GLuint) vertexArrayObjectForSubimageNames:(NSArray *)subimageNames {
-    /* 
-     Returns the (cached) vertex array object associated with a given set of
-     image names (frames). It creates it the first time, and returns the 
-     existing object the second time on. Single-frame sprites are handled as a 
-     special case in which the array contains only one subimage name.
+- (BOOL) isInUse {
+    return ![self canSafelyDelete];
+}
+
+
+- (void) createVertexArrayObject {
+    /*
+     Creates the atlas' vertex buffer object, holding one (native size) quad 
+     for every subimage in the database, in ID order, and the vertex array 
+     object that sources it. Sprites draw their current frame as the four 
+     vertices starting at -firstVertexForSubimageWithID:, so all sprites of 
+     the atlas share the same objects.
      */
     
-    // Calcualte the dictionary key associated with the image name set:
-    NSString* key = [self dictionaryKeyForSubimageNames:subimageNames];
-    
-    NSMutableDictionary* entry = [_vaoDatabase objectForKey:key];
+    NSUInteger    vertexCount = 4 * _subimageCount;
+    VertexData2D* vertices    = calloc(vertexCount > 0 ? vertexCount : 1, sizeof(VertexData2D));
     
-    if (entry) {
-        // [ A ] Already cached: Increase use count.
-        
-        NSUInteger vaoUseCount = [[entry objectForKey:kDNRTextureAtlasUseCountKey] unsignedIntegerValue];
-        vaoUseCount++;
-        [entry setObject:@(vaoUseCount) forKey:kDNRTextureAtlasUseCountKey];
-        
-        _vaoTotalUseCount++;
+    for (DNRSubimageID subimageID = 0; subimageID < _subimageCount; subimageID++) {
         
-        return [[entry objectForKey:kDNRTextureAtlasVAOKey] unsignedIntValue];
+        [self getVertices:&vertices[4*subimageID] forSubimageWithID:subimageID];
     }
-    else{
-        // [ B ] Non-existing; create (and cache) it:
+    
+    
+    // (Vertex Array Objects can not be shared between OpenGL contexts, so we
+    //  must create them on the same context they will be drawn in: the main
+    //  one)
+    
+    void (^task)(void) = ^(void){
+        // *!* MUST RUN ON MAIN THREAD *!*
         
-        entry = [NSMutableDictionary new];
+        GLuint program = [[DNRShaderManager defaultManager] spriteProgram];
+        useProgram(program);
         
+        GLint positionLocation = glDispatch.getAttribLocation(program, "Position");
+        GLint texCoordLocation = glDispatch.getAttribLocation(program, "TextureCoord");
         
-        // 1. Generate vertex data (position and texture coordinates)
+        GLuint vao = 0;
+        GLuint vbo = 0;
         
-        NSUInteger subimageCount = [subimageNames count];
-        NSUInteger vertexCount   = 4 * subimageCount;
+        // VAO
+        glDispatch.genVertexArrays(1, &vao);
+        bindVertexArrayObject(vao);
         
-        CGSize imageSize = [_texture size];
+        // VBO
+        glDispatch.genBuffers(1, &vbo);
+        bindVertexBufferObject(vbo);
+        glDispatch.bufferData(GL_ARRAY_BUFFER,
+                              vertexCount*sizeof(VertexData2D),
+                              &vertices[0],
+                              GL_STATIC_DRAW);
         
-        VertexData2D* vertices = calloc(sizeof(VertexData2D), vertexCount);
-        GLushort*     indices  = calloc(sizeof(  GLushort  ), vertexCount);
+        glDispatch.enableVertexAttribArray(positionLocation);
+        glDispatch.enableVertexAttribArray(texCoordLocation);
         
-        for (NSUInteger i = 0; i < subimageCount; i++) {
+        glDispatch.vertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
+        glDispatch.vertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, stride2D, textureOffset2D);
         
-            NSString* subimageName = [subimageNames objectAtIndex:i];
-            
-            CGRect rectangle = [self rectangleForSubimageNamed:subimageName];
-            
-            CGFloat subimageWidth  = rectangle.size.width;
-            CGFloat subimageHeight = rectangle.size.height;
-            
-            // 1.1 Calculate texture coordinates
-            
-            float s0 = (float)(rectangle.origin.x);
-            float s1 = s0 + (float)(subimageWidth);
-            float t0 = (float)(rectangle.origin.y);
-            float t1 = t0 + (float)(subimageHeight);
-            
-            s0 = (float)(s0 / imageSize.width );
-            s1 = (float)(s1 / imageSize.width );
-            t0 = (float)(t0 / imageSize.height);
-            t1 = (float)(t1 / imageSize.height);
-            
-            // (TODO: implement rotation, by means of texture coordinate swap)
-            
-            
-            // 1.2 Build origin-centered quad, texture-mapped to the specified
-            //      subimage, at the subimage's native size:
-            
-            CGFloat subimageHalfWidth  = 0.5f * subimageWidth;
-            CGFloat subimageHalfHeight = 0.5f * subimageHeight;
-            
-            NSUInteger indexOfCurrentVertex = 4*i;
-            
-            
-            // Top Left
-            indices[indexOfCurrentVertex] = indexOfCurrentVertex;
-            
-            vertices[indexOfCurrentVertex].position.x  = -subimageHalfWidth;
-            vertices[indexOfCurrentVertex].position.y  = +subimageHalfHeight;
-            vertices[indexOfCurrentVertex].texCoords.s = s0;
-            vertices[indexOfCurrentVertex].texCoords.t = t0;
-            indexOfCurrentVertex++;
-            
-            
-            // Bottom Left
-            indices[indexOfCurrentVertex] = indexOfCurrentVertex;
-            
-            vertices[indexOfCurrentVertex].position.x  = -subimageHalfWidth;
-            vertices[indexOfCurrentVertex].position.y  = -subimageHalfHeight;
-            vertices[indexOfCurrentVertex].texCoords.s = s0;
-            vertices[indexOfCurrentVertex].texCoords.t = t1;
-            indexOfCurrentVertex++;
-            
-            // Top Right
-            indices[indexOfCurrentVertex] = indexOfCurrentVertex;
-            
-            vertices[indexOfCurrentVertex].position.x  = +subimageHalfWidth;
-            vertices[indexOfCurrentVertex].position.y  = +subimageHalfHeight;
-            vertices[indexOfCurrentVertex].texCoords.s = s1;
-            vertices[indexOfCurrentVertex].texCoords.t = t0;
-            indexOfCurrentVertex++;
-            
-            // Bottom Right
-            indices[indexOfCurrentVertex] = indexOfCurrentVertex;
-            
-            vertices[indexOfCurrentVertex].position.x  = +subimageHalfWidth;
-            vertices[indexOfCurrentVertex].position.y  = -subimageHalfHeight;
-            vertices[indexOfCurrentVertex].texCoords.s = s1;
-            vertices[indexOfCurrentVertex].texCoords.t = t1;
-            indexOfCurrentVertex++;
-            
-            // (no scaling needed to render each sprite frame at native size)
-        }
+        bindVertexArrayObject(0);
         
+        glDispatch.disableVertexAttribArray(positionLocation);
+        glDispatch.disableVertexAttribArray(texCoordLocation);
         
-        // (This is how far we can get in the background thread/context. Vertex
-        //  Array Objects can not be shared between OpenGL contexts, so we must
-        //  create them on the same context they will be drawn in: the main one)
+        bindVertexBufferObject(0);
         
+        free(vertices);
         
-        // . .. .. .. .. .. .. .. .. .. .. .. .. .. .. .. .. .. .. .. .. .. .. .
-        // 2. Create Vertex Array Object on main thread
-        
-        
-        GLuint __block vao = 0;
-        
-        void (^task)(void) = ^(void){
-            // *!* MUST RUN ON MAIN THREAD *!*
-            
-            GLuint program = [[DNRShaderManager defaultManager] spriteProgram];
-            useProgram(program);
-            
-            GLint positionLocation = glGetAttribLocation(program, "Position");
-            GLint texCoordLocation = glGetAttribLocation(program, "TextureCoord");
-            
-            GLuint vbo = 0;
-            GLuint ibo = 0;
-            
-            
-            // VAO
-            glGenVertexArrays(1, &vao);
-            bindVertexArrayObject(vao);
-            
-            // VBO
-            glGenBuffers(1, &vbo);
-            bindVertexBufferObject(vbo);
-            glBufferData(GL_ARRAY_BUFFER,
-                         vertexCount*sizeof(VertexData2D),
-                         &vertices[0],
-                         GL_STATIC_DRAW);
-            // IBO
-            glGenBuffers(1, &ibo);
-            bindIndexBufferObject(ibo);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                         vertexCount*sizeof(GLushort),
-                         &indices[0],
-                         GL_STATIC_DRAW);
-            
-            
-            glEnableVertexAttribArray(positionLocation);
-            glEnableVertexAttribArray(texCoordLocation);
-            
-            glVertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
-            glVertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, stride2D, textureOffset2D);
-            
-            bindVertexArrayObject(0);
-            
-            glDisableVertexAttribArray(positionLocation);
-            glDisableVertexAttribArray(texCoordLocation);
-            
-            bindIndexBufferObject(0);
-            bindVertexBufferObject(0);
-            
-            
-            entry[kDNRTextureAtlasVAOKey] = @(vao);
-            entry[kDNRTextureAtlasVBOKey] = @(vbo);
-            entry[kDNRTextureAtlasIBOKey] = @(ibo);
-            entry[kDNRTextureAtlasUseCountKey] = @(1);
-            // (0 means "can safely delete when memory is scarce")
-            
-            free(vertices);
-            free(indices);
-            
-            
-            // Store the entry into the dictionary (database)
-            [self.vaoDatabase setObject:entry forKey:key];
-            
-        };
+        self->_vertexBufferObject = vbo;
+        self->_vertexArrayObject  = vao;
+    };
+    
+    
+    if ([NSThread isMainThread]) {
+        // [ A ] We are already on the main thread/OpenGL context; go ahead:
         
+        task();
+    }
+    else{
+        // [ B ] We are on a background thread/OpenGL context; enqueue task in
+        //  main thread's queue and notify on completion (sprites created in
+        //  the meantime get 0, and listen to the notification):
         
-        if ([NSThread isMainThread]) {
-            // . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .
-            // [ A ] We are already on the main thread/OpenGL context;
-            //   go ahead:
+        dispatch_async( dispatch_get_main_queue(), ^{
+            // (Main Thread)
             
             task();
             
-            return vao;
-        }
-        else{
-            // . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .
-            // [ B ] We are on a background thread/OpenGL context;
-            //   enqueue task in main thread's queue and notify on completion:
-            
-            dispatch_async( dispatch_get_main_queue(), ^{
-                // (Main Thread)
-                
-                task();
-                
-                [[NSNotificationCenter defaultCenter] postNotificationName:DNRAtlasLoadedVertexArrayObjectNotification
-                                                                    object:self
-                                                                  userInfo:@{kDNRAtlasLoadedVertexArrayObjectSumbimageNamesKey : subimageNames}];
-            });
-            
-            // 0 signals the caller to listen to the above notification:
-            return 0;
-        }
+            [[NSNotificationCenter defaultCenter] postNotificationName:DNRAtlasLoadedVertexArrayObjectNotification
+                                                                object:self
+                                                              userInfo:@{kDNRAtlasLoadedVertexArrayObjectKey : @(self->_vertexArrayObject)}];
+        });
     }
 }
 
@@ -0,0 +1,53 @@
+//
+//  DNRFixedTimestep.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-10.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <math.h>
+
+#include "DNRFixedTimestep.h"
+
+
+void fixedTimestepInit(FixedTimestep* timestep, double rate, unsigned maxStepsPerFrame) {
+
+    timestep->step             = 1.0 / rate;
+    timestep->maxStepsPerFrame = (maxStepsPerFrame > 0) ? maxStepsPerFrame : 1;
+
+    fixedTimestepReset(timestep);
+}
+
+
+void fixedTimestepReset(FixedTimestep* timestep) {
+    timestep->accumulator = 0.0;
+}
+
+
+unsigned fixedTimestepAdvance(FixedTimestep* timestep, double elapsed, double* alpha) {
+
+    if (elapsed > 0.0) {
+        timestep->accumulator += elapsed;
+    }
+
+    double   step      = timestep->step;
+    unsigned stepCount = 0;
+
+    while (timestep->accumulator >= step && stepCount < timestep->maxStepsPerFrame) {
+        timestep->accumulator -= step;
+        stepCount++;
+    }
+
+    if (timestep->accumulator >= step) {
+        // Over the limit: drop the whole steps left (keep the fraction, so the
+        // interpolation stays continuous)
+        timestep->accumulator = fmod(timestep->accumulator, step);
+    }
+
+    if (alpha) {
+        *alpha = timestep->accumulator / step;
+    }
+
+    return stepCount;
+}
@@ -0,0 +1,55 @@
+//
+//  DNRFixedTimestep.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-10.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRFixedTimestep_h__
+#define __DNRFixedTimestep_h__
+
+
+/**
+ Accumulator that turns the (variable) time elapsed between display refreshes
+ into a whole number of simulation steps of fixed duration, plus the fraction
+ of a step left over (the interpolation alpha to draw with).
+
+ The simulation always advances by exactly the same step, so it does not
+ depend on the display rate (e.g., 60 Hz simulation on a 120 Hz display: one
+ step every other refresh), and replays the same given the same inputs per
+ step. At most maxStepsPerFrame steps are taken per refresh: after a hitch,
+ the time beyond that is dropped (the simulation slows down for a moment
+ instead of spending ever longer catching up).
+ */
+typedef struct tFixedTimestep {
+
+    double      step;               // Seconds
+    double      accumulator;        // Time not yet simulated
+    unsigned    maxStepsPerFrame;
+
+}FixedTimestep;
+
+
+/**
+ Sets the simulation rate (steps per second; must be positive) and the
+ catch-up limit (at least 1), and resets the accumulator.
+ */
+void fixedTimestepInit(FixedTimestep* timestep, double rate, unsigned maxStepsPerFrame);
+
+
+/**
+ Discards the accumulated time (e.g., on resuming after a pause).
+ */
+void fixedTimestepReset(FixedTimestep* timestep);
+
+
+/**
+ Adds elapsed seconds (negative values count as zero) and returns the number
+ of steps to simulate now. On return, alpha (if not NULL) holds the fraction
+ of a step accumulated after them, in [0, 1).
+ */
+unsigned fixedTimestepAdvance(FixedTimestep* timestep, double elapsed, double* alpha);
+
+
+#endif  // #defined (__DNRFixedTimestep_h__)
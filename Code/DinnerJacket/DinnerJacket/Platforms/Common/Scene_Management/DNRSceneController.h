@@ -14,6 +14,8 @@ extern NSString* const SceneDidTickNotification;
 
 @class DNRScene;
 
+@protocol DNRRenderer;
+
 
 /**
  Manages scene transitions. View and drawinf are managed by the view controller.
@@ -41,6 +43,11 @@ extern NSString* const SceneDidTickNotification;
 @property (nonatomic, readwrite) DNREasingType  defaultTransitionEasingType;
 
 
+/// Renderer the scenes draw with; unless set, that of the view controller's
+/// view. Set it (e.g., to a DNRSoftwareRenderer) to run scenes with no view.
+@property (nonatomic, readwrite, strong) id<DNRRenderer> renderer;
+
+
 ///
 
 
@@ -57,10 +64,21 @@ extern NSString* const SceneDidTickNotification;
 
 
 /** 
+ Advances the scene by dt and draws it.
  */
 - (void) tick:(CFTimeInterval) dt;
 
 
+/**
+ Advances the scene stepCount times (zero included) by dt each, then draws it
+ once with the given interpolation: the fraction of a step elapsed since the
+ last one, handed down to every node drawn (see -[DNRNode renderInBatch:
+ interpolation:]). Used by the time controller when running at a fixed time
+ step; -tick: draws with 1.
+ */
+- (void) tick:(CFTimeInterval) dt steps:(NSUInteger) stepCount interpolation:(CGFloat) alpha;
+
+
 /** 
  */
 - (void) transitionToScene:(DNRScene *)nextScene
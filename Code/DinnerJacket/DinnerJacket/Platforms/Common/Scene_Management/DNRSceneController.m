@@ -21,6 +21,9 @@
 
 #import "DNRRenderer.h"
 
+#import "DNRGLCache.h"
+#import "DNRProfiler.h"
+
 
 NSString* const SceneDidTickNotification = @"SceneDidTickNotification";
 
@@ -92,9 +95,7 @@ NSString* const SceneDidTickNotification = @"SceneDidTickNotification";
 
         [node becomeRootNode];
 
-        id<DNRRenderer> renderer = [[DNRViewController sharedController] renderer];
-
-        [node setRenderer:renderer];
+        [node setRenderer:[self renderer]];
         
         _rootNode = node;
     }
@@ -113,6 +114,25 @@ NSString* const SceneDidTickNotification = @"SceneDidTickNotification";
 }
 
 
+- (id<DNRRenderer>) renderer {
+    
+    if (_renderer) {
+        return _renderer;
+    }
+    return [[DNRViewController sharedController] renderer];
+}
+
+
+- (void) setRenderer:(id<DNRRenderer>) renderer {
+    
+    _renderer = renderer;
+    
+    [_renderer setBackgroundClearColor:_clearColor];
+    
+    [_rootNode setRenderer:[self renderer]];
+}
+
+
 - (void) setClearColor:(Color4f)clearColor {
     
     _clearColor = clearColor;
@@ -192,12 +212,52 @@ NSString* const SceneDidTickNotification = @"SceneDidTickNotification";
 
 - (void) tick:(CFTimeInterval) dt {
     
+    [self tick:dt steps:1 interpolation:1.0f];
+}
+
+
+- (void) tick:(CFTimeInterval) dt steps:(NSUInteger) stepCount interpolation:(CGFloat) alpha {
+    
+    profilerBeginFrame();
+    
+    for (NSUInteger i = 0; i < stepCount; i++) {
+        [self step:dt];
+    }
+    
+    // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
+    // Render
+    
+    [_rootNode drawWithInterpolation:alpha];
+    
+    profilerEndFrame();
+    glCacheEndFrame();
+    
+
+#ifdef DNRPlatformMac
+    
+    [[NSNotificationCenter defaultCenter] postNotificationName:SceneDidTickNotification object:self];
+    // TEST
+    //NSView* view = [[DNRViewController sharedController] view];
+    //[view setNeedsDisplay: YES];
+#endif
+}
+
+
+#pragma mark - Internal Operation
+
+
+- (void) step:(CFTimeInterval) dt {
+    
+    profilerBegin(ProfilerPhaseTick);
+    
     [_rootNode tick:dt];
     /* 
      Calls itself recursively on whole tree, and calls -update: once on each
      node (parent before child)
     */
     
+    profilerEnd(ProfilerPhaseTick);
+    
     if ([_rootNode isKindOfClass:[DNRScene class]]) {
         // Static scene: do nothing
     }
@@ -217,21 +277,6 @@ NSString* const SceneDidTickNotification = @"SceneDidTickNotification";
             //[[[DNRViewController sharedController] view] setUserInteractionEnabled:YES];
         }
     }
-    
-    // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
-    // Render
-    
-    [_rootNode draw];
-    
-
-#ifdef DNRPlatformMac
-
-    [[NSNotificationCenter defaultCenter] postNotificationName:SceneDidTickNotification object:self];
-    // TEST
-    //NSView* view = [[DNRViewController sharedController] view];
-    //[view setNeedsDisplay: YES];
-#endif
 }
 
-
 @end
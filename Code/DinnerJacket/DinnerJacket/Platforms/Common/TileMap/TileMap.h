@@ -78,6 +78,20 @@
                          dataSource:(id<TileMapDataSource>) dataSource;
 
 
+/**
+ Instantiates the tile map object from a compiled (binary) map file, as 
+ produced from the property list by scripts/compile_tilemap.py. The file is 
+ mapped into memory and the layers are built straight from its tile records,
+ which is much faster than parsing the property list. Returns nil if the file
+ can not be opened or is not a valid map file.
+ 
+ As with `-initWithDictionary:dataSource:`, the actual map data is not created
+ until `-beginAsyncLoadingWithCompletionHandler:` is called.
+ */
+- (instancetype) initWithContentsOfFile:(NSString *)path
+                             dataSource:(id<TileMapDataSource>) dataSource;
+
+
 /**
  Initializes all resources associated with the tile map (geometry, bitmap data)
  using a background thread and associated secondary graphics context whenever 
@@ -10,9 +10,11 @@
 #import "Platform.h"
 #import "Tileset.h"             // Child object
 #import "TileMapLayer.h"        // Child object
+#import "TileMapFile.h"         // Compiled maps
 #import "DNRTexture.h"
 #import "Platform.h"
 #import "CGSupport.h"
+#import "DNRGLCache.h"          // State cache (background context)
 
 #import "DNRSceneController.h"  // App diagnostics
 
@@ -42,6 +44,7 @@ static NSString* const  kTileMapBaseDirectoryPathKey =    @"BaseDirectory";
 @property (nonatomic, readwrite, weak) id <TileMapDataSource> dataSource;
 @property (nonatomic, readwrite) NSString* baseDirectoryPath;
 @property (nonatomic, readwrite) NSDictionary* sourceDictionary;
+@property (nonatomic, readwrite) TileMapFile* sourceFile;
 @property (nonatomic, readwrite) NSMutableDictionary* tilesetsByName;
 @property (nonatomic, readwrite) NSMutableDictionary* mapLayersByName;
 @property (nonatomic, readwrite) NSMutableArray* mapLayersInStackingOrder; // bottom to top
@@ -75,23 +78,69 @@ static NSString* const  kTileMapBaseDirectoryPathKey =    @"BaseDirectory";
         _tileSize = [[dictionary objectForKey:kTileMapTileSizeKey] unsignedIntegerValue];
         _layerSize = CGSizeFromString([dictionary objectForKey:kTileMapLayerSizeKey]);
         
+        [self calculatePositionLimits];
         
-        // Calculate limits for map position:
-        CGSize screenSize = [[DNRViewController sharedController] screenSize];
-        CGSize pointSize  = CGSizeMake(_tileSize*(_layerSize.width), _tileSize*_layerSize.height);
+        // (the rest is loaded/initialized asynchronously)
+    }
+    
+    return self;
+}
+
+
+- (instancetype) initWithContentsOfFile:(NSString *)path
+                             dataSource:(id<TileMapDataSource>) dataSource {
+    
+    TileMapFile* file = tileMapFileOpen([path fileSystemRepresentation]);
+    
+    if (file == NULL) {
+        return (self = nil);
+    }
+    
+    if (self = [super init]) {
+        
+        // Keep the (mapped) file for later background loading:
+        _sourceFile = file;
+        
+        _dataSource = dataSource;
+        
+        // Read basic attributes right away:
+        const TileMapFileHeader* header = tileMapFileHeader(file);
+        
+        _tileSize  = header->tileSize;
+        _layerSize = CGSizeMake(header->layerWidth, header->layerHeight);
         
-        _xMax = (pointSize.width - screenSize.width) / 2.0f;
-        _yMax = (pointSize.height - screenSize.height) / 2.0f;
-        _xMin = -_xMax;
-        _yMin = -_yMax;
+        [self calculatePositionLimits];
         
         // (the rest is loaded/initialized asynchronously)
     }
+    else{
+        tileMapFileClose(file);
+    }
     
     return self;
 }
 
 
+- (void) dealloc {
+    
+    // (Normally closed as soon as loading completes)
+    tileMapFileClose(_sourceFile);
+}
+
+
+- (void) calculatePositionLimits {
+    
+    // Calculate limits for map position:
+    CGSize screenSize = [[DNRViewController sharedController] screenSize];
+    CGSize pointSize  = CGSizeMake(_tileSize*(_layerSize.width), _tileSize*_layerSize.height);
+    
+    _xMax = (pointSize.width - screenSize.width) / 2.0f;
+    _yMax = (pointSize.height - screenSize.height) / 2.0f;
+    _xMin = -_xMax;
+    _yMin = -_yMax;
+}
+
+
 #pragma mark - Initialization
 
 
@@ -123,27 +172,19 @@ static NSString* const  kTileMapBaseDirectoryPathKey =    @"BaseDirectory";
         NSOpenGLContext* backgroundContext = [[DNRViewController sharedController] backgroundRenderingContext];
         [backgroundContext makeCurrentContext];
         #endif
+        glCacheMakeCurrent((__bridge const void *)backgroundContext);
         
         
         // [ 1 ] Load all tilesets
 
        self.tilesetsByName = [NSMutableDictionary new];
        
-        NSDictionary* tilesetDictionariesByName = self.sourceDictionary[kTileMapTilesetsKey];
-        
-        for (NSString* tilesetName in [tilesetDictionariesByName allKeys]){
-            
-            NSDictionary* tilesetDictionary = tilesetDictionariesByName[tilesetName];
-            NSArray* paletteArray = tilesetDictionary[@"Palette"];
-            
-            Tileset* tileset = [[Tileset alloc] initWithImageNamed:tilesetName
-                                                       inDirectory:nil
-                                                          tileSize: self.tileSize
-                                                           palette:paletteArray];
-            
-            self.tilesetsByName[tilesetName] = tileset;
+        if (self.sourceFile) {
+            [self loadTilesetsFromFile];
+        }
+        else{
+            [self loadTilesetsFromDictionary];
         }
-                                                   
        
        
        // [ 2 ] Create map layers (minus VAO):
@@ -151,17 +192,16 @@ static NSString* const  kTileMapBaseDirectoryPathKey =    @"BaseDirectory";
         self->_mapLayersByName  = [NSMutableDictionary new];
         self->_mapLayersInStackingOrder = [NSMutableArray new];
        
-        for (NSDictionary* layerDictionary in self->_sourceDictionary[kTileMapLayersKey]) {
-           
-           TileMapLayer* layer = [[TileMapLayer alloc] initWithContentsOfDictionary:layerDictionary
-                                                                    forUseInTileMap:self];
-           
-           [self->_mapLayersInStackingOrder addObject:layer];
-           
-           NSString* layerName = [layer localizedName];
-           
-           [self->_mapLayersByName setObject:layer forKey:layerName];
-       }
+        if (self.sourceFile) {
+            [self loadLayersFromFile];
+            
+            // Done with the file; unmap it:
+            tileMapFileClose(self->_sourceFile);
+            self->_sourceFile = NULL;
+        }
+        else{
+            [self loadLayersFromDictionary];
+        }
        
        
        // 3. Create VAOs for all map layers, and add them to display hierarchy:
@@ -194,6 +234,99 @@ static NSString* const  kTileMapBaseDirectoryPathKey =    @"BaseDirectory";
 }
 
 
+- (void) loadTilesetsFromDictionary {
+    
+    NSDictionary* tilesetDictionariesByName = _sourceDictionary[kTileMapTilesetsKey];
+    
+    for (NSString* tilesetName in [tilesetDictionariesByName allKeys]){
+        
+        NSDictionary* tilesetDictionary = tilesetDictionariesByName[tilesetName];
+        NSArray* paletteArray = tilesetDictionary[@"Palette"];
+        
+        Tileset* tileset = [[Tileset alloc] initWithImageNamed:tilesetName
+                                                   inDirectory:nil
+                                                      tileSize:_tileSize
+                                                       palette:paletteArray];
+        
+        _tilesetsByName[tilesetName] = tileset;
+    }
+}
+
+
+- (void) loadTilesetsFromFile {
+    
+    const TileMapFileHeader* header = tileMapFileHeader(_sourceFile);
+    
+    for (uint32_t i = 0; i < header->tilesetCount; i++) {
+        
+        const TileMapFileTileset*      record  = tileMapFileTileset(_sourceFile, i);
+        const TileMapFilePaletteEntry* entries = tileMapFilePalette(_sourceFile, record);
+        
+        // (Named brushes only; a handful per tileset)
+        NSMutableArray* paletteArray = [NSMutableArray arrayWithCapacity:record->paletteCount];
+        
+        for (uint32_t j = 0; j < record->paletteCount; j++) {
+            
+            const char* className = tileMapFileString(_sourceFile, entries[j].className);
+            
+            if (className[0] == '\0') {
+                // No class: leave the key out, as in the property list (Tileset
+                // takes its presence to mean a named brush)
+                [paletteArray addObject:@{ @"Index" : @(entries[j].index) }];
+                continue;
+            }
+            
+            [paletteArray addObject:@{ @"Index" : @(entries[j].index),
+                                       @"Class" : [NSString stringWithUTF8String:className] }];
+        }
+        
+        NSString* tilesetName = [NSString stringWithUTF8String:tileMapFileString(_sourceFile, record->name)];
+        
+        Tileset* tileset = [[Tileset alloc] initWithImageNamed:tilesetName
+                                                   inDirectory:nil
+                                                      tileSize:_tileSize
+                                                       palette:paletteArray];
+        
+        _tilesetsByName[tilesetName] = tileset;
+    }
+}
+
+
+- (void) loadLayersFromDictionary {
+    
+    for (NSDictionary* layerDictionary in _sourceDictionary[kTileMapLayersKey]) {
+        
+        TileMapLayer* layer = [[TileMapLayer alloc] initWithContentsOfDictionary:layerDictionary
+                                                                 forUseInTileMap:self];
+        [self registerLayer:layer];
+    }
+}
+
+
+- (void) loadLayersFromFile {
+    
+    const TileMapFileHeader* header = tileMapFileHeader(_sourceFile);
+    
+    for (uint32_t i = 0; i < header->layerCount; i++) {
+        
+        TileMapLayer* layer = [[TileMapLayer alloc] initWithLayer:tileMapFileLayer(_sourceFile, i)
+                                                           inFile:_sourceFile
+                                                  forUseInTileMap:self];
+        [self registerLayer:layer];
+    }
+}
+
+
+- (void) registerLayer:(TileMapLayer *)layer {
+    
+    [_mapLayersInStackingOrder addObject:layer];
+    
+    NSString* layerName = [layer localizedName];
+    
+    [_mapLayersByName setObject:layer forKey:layerName];
+}
+
+
 #pragma mark - Operation
 
 
@@ -0,0 +1,237 @@
+//
+//  TileMapFile.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-19.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "TileMapFile.h"
+
+
+struct tTileMapFile {
+
+    const uint8_t*  bytes;
+    size_t          size;
+};
+
+
+// .............................................................................
+// Validation
+
+static int rangeIsValid(const TileMapFile* file, uint32_t offset, uint32_t count, size_t recordSize) {
+
+    // The range [offset, offset + count*recordSize) must lie within the file,
+    // and be suitably aligned for the records:
+
+    if (offset % 4 != 0) {
+        return 0;
+    }
+    if (offset > file->size) {
+        return 0;
+    }
+    if ((uint64_t)count * recordSize > file->size - offset) {
+        return 0;
+    }
+
+    return 1;
+}
+
+
+static int stringIsValid(const TileMapFile* file, uint32_t offset) {
+
+    return offset < tileMapFileHeader(file)->stringsSize;
+}
+
+
+static int tileMapFileValidate(const TileMapFile* file) {
+
+    if (file->size < sizeof(TileMapFileHeader)) {
+        return 0;
+    }
+
+    const TileMapFileHeader* header = tileMapFileHeader(file);
+
+    if (memcmp(header->magic, TileMapFileMagic, 4) != 0) {
+        return 0;
+    }
+    if (header->version != TileMapFileVersion) {
+        return 0;
+    }
+
+
+    // String table (must be NUL-terminated, so every string in it is)
+
+    if (header->stringsSize == 0 || header->stringsOffset > file->size || header->stringsSize > file->size - header->stringsOffset) {
+        return 0;
+    }
+    if (file->bytes[header->stringsOffset + header->stringsSize - 1] != '\0') {
+        return 0;
+    }
+
+
+    // Tilesets
+
+    if (!rangeIsValid(file, header->tilesetsOffset, header->tilesetCount, sizeof(TileMapFileTileset))) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < header->tilesetCount; i++) {
+
+        const TileMapFileTileset* tileset = tileMapFileTileset(file, i);
+
+        if (!stringIsValid(file, tileset->name)) {
+            return 0;
+        }
+        if (!rangeIsValid(file, tileset->paletteOffset, tileset->paletteCount, sizeof(TileMapFilePaletteEntry))) {
+            return 0;
+        }
+
+        const TileMapFilePaletteEntry* palette = tileMapFilePalette(file, tileset);
+
+        for (uint32_t j = 0; j < tileset->paletteCount; j++) {
+            if (!stringIsValid(file, palette[j].className)) {
+                return 0;
+            }
+        }
+    }
+
+
+    // Layers
+
+    if (!rangeIsValid(file, header->layersOffset, header->layerCount, sizeof(TileMapFileLayer))) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < header->layerCount; i++) {
+
+        const TileMapFileLayer* layer = tileMapFileLayer(file, i);
+
+        if (!stringIsValid(file, layer->name) || !stringIsValid(file, layer->tilesetName)) {
+            return 0;
+        }
+        if (!rangeIsValid(file, layer->tilesOffset, layer->tileCount, sizeof(TileMapFileTile))) {
+            return 0;
+        }
+        if (!rangeIsValid(file, layer->objectsOffset, layer->objectCount, sizeof(TileMapFileTile))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+// .............................................................................
+// Opening/Closing
+
+TileMapFile* tileMapFileOpen(const char* path) {
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size  = (size_t)info.st_size;
+    void*  bytes = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd); // (The mapping stays valid)
+
+    if (bytes == MAP_FAILED) {
+        return NULL;
+    }
+
+    TileMapFile* file = calloc(1, sizeof(TileMapFile));
+
+    file->bytes = bytes;
+    file->size  = size;
+
+    if (!tileMapFileValidate(file)) {
+        tileMapFileClose(file);
+        return NULL;
+    }
+
+    return file;
+}
+
+
+void tileMapFileClose(TileMapFile* file) {
+
+    if (file == NULL) {
+        return;
+    }
+
+    munmap((void *)file->bytes, file->size);
+
+    free(file);
+}
+
+
+// .............................................................................
+// Accessors
+
+const TileMapFileHeader* tileMapFileHeader(const TileMapFile* file) {
+
+    return (const TileMapFileHeader *)file->bytes;
+}
+
+
+const TileMapFileTileset* tileMapFileTileset(const TileMapFile* file, uint32_t index) {
+
+    const TileMapFileHeader* header = tileMapFileHeader(file);
+
+    return &((const TileMapFileTileset *)(file->bytes + header->tilesetsOffset))[index];
+}
+
+
+const TileMapFilePaletteEntry* tileMapFilePalette(const TileMapFile* file, const TileMapFileTileset* tileset) {
+
+    return (const TileMapFilePaletteEntry *)(file->bytes + tileset->paletteOffset);
+}
+
+
+const TileMapFileLayer* tileMapFileLayer(const TileMapFile* file, uint32_t index) {
+
+    const TileMapFileHeader* header = tileMapFileHeader(file);
+
+    return &((const TileMapFileLayer *)(file->bytes + header->layersOffset))[index];
+}
+
+
+const TileMapFileTile* tileMapFileLayerTiles(const TileMapFile* file, const TileMapFileLayer* layer) {
+
+    return (const TileMapFileTile *)(file->bytes + layer->tilesOffset);
+}
+
+
+const TileMapFileTile* tileMapFileLayerObjects(const TileMapFile* file, const TileMapFileLayer* layer) {
+
+    return (const TileMapFileTile *)(file->bytes + layer->objectsOffset);
+}
+
+
+const char* tileMapFileString(const TileMapFile* file, uint32_t offset) {
+
+    const TileMapFileHeader* header = tileMapFileHeader(file);
+
+    if (offset >= header->stringsSize) {
+        return "";
+    }
+
+    return (const char *)(file->bytes + header->stringsOffset + offset);
+}
@@ -0,0 +1,157 @@
+//
+//  TileMapFile.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-19.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __TileMapFile_h__
+#define __TileMapFile_h__
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/*
+ Compiled (binary) tile map format.
+
+ Holds the same information as the property list schema (LayerSize, TileSize,
+ Tilesets/Palette, Layers/Tiles/Objects), laid out so that it can be mapped
+ into memory and used in place: the tile records of each layer are read
+ straight from the mapped pages, without creating any objects.
+
+ Files are produced offline from the property list by
+ scripts/compile_tilemap.py. All values are little endian; offsets are in
+ bytes, from the beginning of the file (records are 4-byte aligned). Strings
+ are referenced by offset into the string table (UTF-8, NUL-terminated;
+ offset 0 is always the empty string).
+
+ Layout:
+
+    TileMapFileHeader
+    TileMapFileTileset[tilesetCount]
+    TileMapFilePaletteEntry[...]        (named brushes of all tilesets)
+    TileMapFileLayer[layerCount]
+    TileMapFileTile[...]                (tiles and objects of all layers)
+    String table
+ */
+
+#define TileMapFileMagic            "DNRM"
+#define TileMapFileVersion          1u
+
+#define TileMapFileExtension        "tilemap"
+
+
+// Layer flags
+#define TileMapLayerFlagNeedsBlending   (1u << 0)
+#define TileMapLayerFlagSymbolic        (1u << 1)
+
+// Tile flags
+#define TileMapTileFlagFlipX            (1u << 0)
+#define TileMapTileFlagFlipY            (1u << 1)
+
+
+typedef struct tTileMapFileHeader {
+
+    char        magic[4];           // TileMapFileMagic
+    uint16_t    version;            // TileMapFileVersion
+    uint16_t    tileSize;           // Side of the (square) tiles, in points
+    uint16_t    layerWidth;         // Layer grid size, in tiles
+    uint16_t    layerHeight;
+
+    uint32_t    tilesetCount;
+    uint32_t    tilesetsOffset;
+    uint32_t    layerCount;
+    uint32_t    layersOffset;
+    uint32_t    stringsOffset;
+    uint32_t    stringsSize;
+
+}TileMapFileHeader;
+
+
+typedef struct tTileMapFileTileset {
+
+    uint32_t    name;               // (string) Image name
+    uint32_t    paletteCount;       // Number of named brushes
+    uint32_t    paletteOffset;      // -> TileMapFilePaletteEntry[paletteCount]
+
+}TileMapFileTileset;
+
+
+typedef struct tTileMapFilePaletteEntry {
+
+    uint32_t    index;              // Brush index
+    uint32_t    className;          // (string) Map object identifier; empty if none
+
+}TileMapFilePaletteEntry;
+
+
+typedef struct tTileMapFileLayer {
+
+    uint32_t    name;               // (string)
+    uint32_t    tilesetName;        // (string)
+    float       scrollFactor;
+    uint32_t    flags;              // TileMapLayerFlag*
+
+    uint32_t    tileCount;
+    uint32_t    tilesOffset;        // -> TileMapFileTile[tileCount]
+    uint32_t    objectCount;
+    uint32_t    objectsOffset;      // -> TileMapFileTile[objectCount]
+
+}TileMapFileLayer;
+
+
+/**
+ Packed tile (or map object) record: grid position, brush and reflection.
+ */
+typedef struct tTileMapFileTile {
+
+    uint16_t    x;
+    uint16_t    y;
+    uint16_t    paletteIndex;
+    uint16_t    flags;              // TileMapTileFlag*
+
+}TileMapFileTile;
+
+
+/**
+ A compiled tile map file, mapped into memory.
+ */
+typedef struct tTileMapFile TileMapFile;
+
+
+/**
+ Maps the file at path into memory and validates its structure (all offsets
+ and counts must lie within the file). Returns NULL on failure.
+ */
+TileMapFile* tileMapFileOpen(const char* path);
+
+
+/**
+ Unmaps the file and frees the object. Pointers obtained through the accessors
+ below become invalid.
+ */
+void tileMapFileClose(TileMapFile* file);
+
+
+const TileMapFileHeader* tileMapFileHeader(const TileMapFile* file);
+
+const TileMapFileTileset* tileMapFileTileset(const TileMapFile* file, uint32_t index);
+
+const TileMapFilePaletteEntry* tileMapFilePalette(const TileMapFile* file, const TileMapFileTileset* tileset);
+
+const TileMapFileLayer* tileMapFileLayer(const TileMapFile* file, uint32_t index);
+
+const TileMapFileTile* tileMapFileLayerTiles(const TileMapFile* file, const TileMapFileLayer* layer);
+
+const TileMapFileTile* tileMapFileLayerObjects(const TileMapFile* file, const TileMapFileLayer* layer);
+
+
+/**
+ The string at the specified offset in the string table.
+ */
+const char* tileMapFileString(const TileMapFile* file, uint32_t offset);
+
+
+#endif  // #defined (__TileMapFile_h__)
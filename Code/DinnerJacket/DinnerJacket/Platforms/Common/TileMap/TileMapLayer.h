@@ -8,6 +8,7 @@
 
 #import "DNRNode.h"
 #import "Tileset.h"
+#import "TileMapFile.h"
 
 
 
@@ -35,6 +36,15 @@
 - (instancetype) initWithContentsOfDictionary:(NSDictionary *)dictionary
                               forUseInTileMap:(TileMap *)tileMap;
 
+/**
+ Initializes the layer from its record in a compiled (binary) map file. The
+ mesh is built directly from the file's tile records; the file only needs to
+ stay open for the duration of this call.
+ */
+- (instancetype) initWithLayer:(const TileMapFileLayer *)layer
+                        inFile:(const TileMapFile *)file
+               forUseInTileMap:(TileMap *)tileMap;
+
 /**
  */
 - (void) createVertexArrayObject;
@@ -16,8 +16,16 @@
 
 #import "DNRShaderManager.h"
 #import "DNRGLCache.h"
+#import "DNRGLDispatch.h"
+#import "DNRProfiler.h"
 
 #import "DNRGlobals.h"          // Stride, etc.
+#import "DNRRenderer.h"
+#import "Platform.h"
+#import "DNRMatrix.h"
+#import "DNRSceneController.h"
+
+#include <float.h>              // FLT_MAX
 
 
 
@@ -26,12 +34,39 @@ typedef struct tLayerTile {
     GLfloat     x;
     GLfloat     y;
     
-    //BOOL        flipX;
-    //BOOL        flipY;
+    NSUInteger  paletteIndex;
+    NSUInteger  chunk;
+    
+    BOOL        flipX;
+    BOOL        flipY;
 
 }LayerTile;
 
 
+/* Tile mesh chunk: a square region of the layer grid, drawn as a triangle strip
+   (range of the layer's index array).
+ */
+typedef struct tLayerChunk {
+
+    GLsizei     indexOffset;    // First index of the chunk's strip
+    GLsizei     indexCount;     // (Not counting the bridge to the next chunk)
+    
+    GLfloat     bounds[4];      // xMin, yMin, xMax, yMax (in layer pixels)
+
+}LayerChunk;
+
+
+// Side of the (square) mesh chunks, in tiles.
+static const NSUInteger kChunkSize = 16;
+
+
+static inline BOOL tilesAreContiguous(const LayerTile* tile, const LayerTile* nextTile) {
+
+    // Tiles on the same row, one column apart:
+    return (tile->y == nextTile->y) && ((tile->x + 1) == nextTile->x);
+}
+
+
 
 static GLuint       program                     = 0u;
 
@@ -64,6 +99,36 @@ static NSString* const kObjectLibraryIndexKey = @"Index";
 static NSString* const kObjectPositionKey     = @"Position";
 
 
+/* Converts the tile (or map object) dictionaries of a property list layer into
+   packed records, so that both map formats share the same code path.
+ */
+static TileMapFileTile* createTileRecords(NSArray* tileDictionaries) {
+
+    TileMapFileTile* tiles = calloc(sizeof(TileMapFileTile), [tileDictionaries count]);
+    NSUInteger       index = 0;
+    
+    for (NSDictionary* tileDictionary in tileDictionaries) {
+        
+        CGPoint gridPosition = CGPointFromString([tileDictionary objectForKey:kTilePositionKey]);
+        
+        tiles[index].x            = gridPosition.x;
+        tiles[index].y            = gridPosition.y;
+        tiles[index].paletteIndex = [[tileDictionary objectForKey:kTilePaletteIndexKey] unsignedIntegerValue];
+        
+        if ([[tileDictionary objectForKey:kTileHorizontalReflectionKey] boolValue]) {
+            tiles[index].flags |= TileMapTileFlagFlipX;
+        }
+        if ([[tileDictionary objectForKey:kTileVerticalReflectionKey] boolValue]) {
+            tiles[index].flags |= TileMapTileFlagFlipY;
+        }
+        
+        index++;
+    }
+    
+    return tiles;
+}
+
+
 // .............................................................................
 
 @interface TileMapLayer ()
@@ -74,8 +139,12 @@ static NSString* const kObjectPositionKey     = @"Position";
 @property (nonatomic, readwrite) void***       objectGrid;
 @property (nonatomic, readwrite) VertexData2D* vertices;
 @property (nonatomic, readwrite) GLsizei       vertexCount;
-@property (nonatomic, readwrite) GLushort*     indices;
+@property (nonatomic, readwrite) void*         indices;
 @property (nonatomic, readwrite) GLsizei       indexCount;
+@property (nonatomic, readwrite) GLenum        indexType;
+@property (nonatomic, readwrite) size_t        indexSize;
+@property (nonatomic, readwrite) LayerChunk*   chunks;
+@property (nonatomic, readwrite) NSUInteger    chunkCount;
 @property (nonatomic, readwrite) GLuint        vbo;
 @property (nonatomic, readwrite) GLuint        ibo;
 @property (nonatomic, readwrite) GLuint        vao;
@@ -88,7 +157,12 @@ static NSString* const kObjectPositionKey     = @"Position";
 // .............................................................................
 
 
-@implementation TileMapLayer
+@implementation TileMapLayer {
+
+    // Bounds of the whole mesh (xMin, yMin, xMax, yMax; in layer pixels)
+    GLfloat _bounds[4];
+}
+
 
 
 #pragma mark - Static Methods
@@ -105,13 +179,13 @@ static NSString* const kObjectPositionKey     = @"Position";
             
             program = [[DNRShaderManager defaultManager] spriteProgram];
             
-            positionLocation            = glGetAttribLocation(program, "Position");
-            textureCoordinateLocation   = glGetAttribLocation(program, "TextureCoord");
+            positionLocation            = glDispatch.getAttribLocation(program, "Position");
+            textureCoordinateLocation   = glDispatch.getAttribLocation(program, "TextureCoord");
             
-            colorLocation       = glGetUniformLocation(program, "Color");
-            samplerLocation     = glGetUniformLocation(program, "Sampler");
-            modelviewLocation   = glGetUniformLocation(program, "Modelview");
-            zLocation           = glGetUniformLocation(program, "Z");
+            colorLocation       = glDispatch.getUniformLocation(program, "Color");
+            samplerLocation     = glDispatch.getUniformLocation(program, "Sampler");
+            modelviewLocation   = glDispatch.getUniformLocation(program, "Modelview");
+            zLocation           = glDispatch.getUniformLocation(program, "Z");
         });
     }
 }
@@ -135,8 +209,8 @@ static NSString* const kObjectPositionKey     = @"Position";
  [2]
  Begin with a tentative ammount of indices of 4n (one per vertex);
  neighbouring quads yield the necessary degenerate triangles as is.
- for each gap between successive quads, add 2 indices to the total.
- Allocate index array.
+ for each gap between successive quads of the same chunk, and between 
+ successive chunks, add 2 indices to the total. Allocate index array.
  
  [3]
  Finally, Initialize indices.
@@ -165,8 +239,12 @@ static NSString* const kObjectPositionKey     = @"Position";
         NSArray* tileDictionaries = dictionary[kTileMapLayerTilesKey];
         
         if (tileDictionaries){
-            [self createMeshWithTiles:tileDictionaries forUseInTileMap:tileMap];
+            TileMapFileTile* tiles = createTileRecords(tileDictionaries);
+            
+            [self createMeshWithTiles:tiles count:[tileDictionaries count] forUseInTileMap:tileMap];
             self.needsBlending = [[dictionary objectForKey:kTileMapLayerNonOpaqueKey] boolValue];
+            
+            free(tiles);
         }
         else{
             _symbolic = YES;
@@ -176,7 +254,43 @@ static NSString* const kObjectPositionKey     = @"Position";
         NSArray* objectDictionaries = dictionary[kTileMapLayerMapObjectsKey];
         
         if (objectDictionaries){
-            [self loadMapObjects:objectDictionaries fromMap:tileMap];
+            TileMapFileTile* objects = createTileRecords(objectDictionaries);
+            
+            [self loadMapObjects:objects count:[objectDictionaries count] fromMap:tileMap];
+            
+            free(objects);
+        }
+    }
+    
+    return self;
+}
+
+
+- (instancetype) initWithLayer:(const TileMapFileLayer *)layer
+                        inFile:(const TileMapFile *)file
+               forUseInTileMap:(TileMap *)tileMap {
+    
+    if (self = [super init]) {
+        
+        // Basic attributes:
+        self.localizedName = [NSString stringWithUTF8String:tileMapFileString(file, layer->name)];
+        _scrollFactor  = layer->scrollFactor;
+        _tileset       = [tileMap tilesetNamed:[NSString stringWithUTF8String:tileMapFileString(file, layer->tilesetName)]];
+        
+        _layerSize     = [tileMap layerSize];
+        
+        // Tile Mesh (built straight from the mapped tile records)
+        if ((layer->flags & TileMapLayerFlagSymbolic) == 0) {
+            [self createMeshWithTiles:tileMapFileLayerTiles(file, layer) count:layer->tileCount forUseInTileMap:tileMap];
+            self.needsBlending = (layer->flags & TileMapLayerFlagNeedsBlending) != 0;
+        }
+        else{
+            _symbolic = YES;
+        }
+        
+        // Map Objects
+        if (layer->objectCount > 0) {
+            [self loadMapObjects:tileMapFileLayerObjects(file, layer) count:layer->objectCount fromMap:tileMap];
         }
     }
     
@@ -185,9 +299,19 @@ static NSString* const kObjectPositionKey     = @"Position";
 
 
 /**
- Build the geometry to render (if present)
+ Build the geometry to render (if present).
+ 
+ The layer is divided into square chunks of kChunkSize x kChunkSize grid cells.
+ Tiles are grouped by chunk (vertices and indices of each chunk are contiguous)
+ and each chunk gets its own triangle strip and bounding box, so that chunks 
+ lying outside the visible region can be skipped when rendering.
+ 
+ Consecutive chunks are joined by degenerate triangles (two extra indices at
+ the end of each chunk's range), so runs of visible chunks can be drawn with a
+ single call.
  */
-- (void) createMeshWithTiles:( NSArray* __nonnull) tileDictionaries
+- (void) createMeshWithTiles:(const TileMapFileTile *)tiles
+                       count:(NSUInteger) tileCount
              forUseInTileMap:(TileMap *)tileMap {
 
     _textureName   = [[_tileset texture] name];
@@ -206,57 +330,95 @@ static NSString* const kObjectPositionKey     = @"Position";
     // The actual number of tiles is normally much less than that of grid cells
     // (map width x map height), typically much less, because the mesh is sparse
     // (not all grid cells are "painted").
-    int tileCount = (int)[tileDictionaries count];
-    
-    LayerTile* layerTiles = calloc(sizeof(LayerTile), tileCount);
+    if (tileCount == 0) {
+        return;
+    }
     
     TilesetSwatch* palette = [_tileset palette];
     NSUInteger paletteSize = [_tileset paletteSize];
     
     
-    _vertexCount = 4*tileCount; // One quad per tile
-    _vertices = calloc(sizeof(VertexData2D), _vertexCount);
+    // 1. Read all tiles, and count the tiles in each chunk:
     
-    NSUInteger tileIndex    = 0; // indexes array layerTiles[]
-    NSUInteger vertexIndex  = 0; // indexes array _vertices[]
-    NSUInteger paletteIndex = 0; // indexes array palette[]
+    NSUInteger chunkColumns = ((NSUInteger)sizeInTiles.width  + kChunkSize - 1) / kChunkSize;
+    NSUInteger chunkRows    = ((NSUInteger)sizeInTiles.height + kChunkSize - 1) / kChunkSize;
+    NSUInteger gridChunks   = chunkColumns * chunkRows;
     
-    BOOL flipX = false;
-    BOOL flipY = false;
+    LayerTile*  fileTiles    = calloc(sizeof(LayerTile), tileCount);
+    NSUInteger* chunkOffsets = calloc(sizeof(NSUInteger), gridChunks + 1);
     
-    GLfloat s0, s1, t0, t1;
+    NSUInteger tileIndex = 0;
     
-    // Draw...
-    
-    for (NSDictionary* tileDictionary in tileDictionaries) {
+    for (tileIndex = 0; tileIndex < tileCount; tileIndex++) {
+        
+        LayerTile* tile = &fileTiles[tileIndex];
         
         // ...What (which subregion of the texture):
-        paletteIndex = [[tileDictionary objectForKey:kTilePaletteIndexKey] unsignedIntegerValue];
+        tile->paletteIndex = tiles[tileIndex].paletteIndex;
+        
+        if (tile->paletteIndex >= paletteSize) { // Error! - For now, use first pattern:
+            tile->paletteIndex = 0;
+        }
         
         // ...Where (in the layer grid):
-        CGPoint gridPosition = CGPointFromString([tileDictionary objectForKey:kTilePositionKey]);
+        tile->x = tiles[tileIndex].x;
+        tile->y = tiles[tileIndex].y;
         
         // ...How (vertical and horizontal reflection):
-        flipX = [[tileDictionary objectForKey:kTileHorizontalReflectionKey] boolValue];
-        flipY = [[tileDictionary objectForKey:kTileVerticalReflectionKey] boolValue];
+        tile->flipX = (tiles[tileIndex].flags & TileMapTileFlagFlipX) != 0;
+        tile->flipY = (tiles[tileIndex].flags & TileMapTileFlagFlipY) != 0;
         
+        // (Out-of-grid positions are clamped to the edge chunks)
+        NSUInteger chunkColumn = MIN((NSUInteger)tile->x / kChunkSize, chunkColumns - 1);
+        NSUInteger chunkRow    = MIN((NSUInteger)tile->y / kChunkSize, chunkRows    - 1);
         
-        layerTiles[tileIndex].x = gridPosition.x;
-        layerTiles[tileIndex].y = gridPosition.y;
-        // (used later to calculate index array)
+        tile->chunk = chunkRow * chunkColumns + chunkColumn;
         
-        if (paletteIndex >= paletteSize) { // Error! - For now, use first pattern:
-            paletteIndex = 0;
-        }
+        chunkOffsets[tile->chunk + 1]++;
+    }
+    
+    
+    // 2. Sort tiles by chunk (counting sort; stable, so the order of the tiles
+    //    within each chunk is that of the file):
+    
+    for (NSUInteger i = 0; i < gridChunks; i++) {
+        chunkOffsets[i + 1] += chunkOffsets[i];
+    }
+    
+    LayerTile*  layerTiles = calloc(sizeof(LayerTile), tileCount);
+    NSUInteger* cursors    = calloc(sizeof(NSUInteger), gridChunks);
+    
+    memcpy(cursors, chunkOffsets, gridChunks*sizeof(NSUInteger));
+    
+    for (NSUInteger i = 0; i < tileCount; i++) {
+        layerTiles[cursors[fileTiles[i].chunk]++] = fileTiles[i];
+    }
+    
+    free(cursors);
+    free(fileTiles);
+    
+    
+    // 3. Configure actual vertex data (one quad per tile):
+    
+    _vertexCount = (GLsizei)(4*tileCount);
+    _vertices = calloc(sizeof(VertexData2D), _vertexCount);
+    
+    NSUInteger vertexIndex  = 0; // indexes array _vertices[]
+    
+    GLfloat s0, s1, t0, t1;
+    
+    for (tileIndex = 0; tileIndex < tileCount; tileIndex++) {
+        
+        LayerTile* tile = &layerTiles[tileIndex];
         
-        // 2. Configure actual vertex data
+        NSUInteger paletteIndex = tile->paletteIndex;
         
         // Index of first vertex of the tile, in _vertices[]:
         vertexIndex = 4 * tileIndex;
         
         // Position of current tile's center:
-        GLfloat cx = left + (gridPosition.x * tileSize);
-        GLfloat cy = top  - (gridPosition.y * tileSize);
+        GLfloat cx = left + (tile->x * tileSize);
+        GLfloat cy = top  - (tile->y * tileSize);
         
         // X and Y coordinates of the four vertices:
         GLfloat x0 = (cx - halfTileSize) * screenScaleFactor; // (Coords are in pixels)
@@ -267,7 +429,7 @@ static NSString* const kObjectPositionKey     = @"Position";
         // (We achieve horizontal and/or vertical reflection by swapping texture
         // coordinates among the four vertices of the quad:)
         
-        if (flipX) { // Reflect Horizontally
+        if (tile->flipX) { // Reflect Horizontally
             s0 = palette[paletteIndex].s1;
             s1 = palette[paletteIndex].s0;
         }
@@ -276,7 +438,7 @@ static NSString* const kObjectPositionKey     = @"Position";
             s1 = palette[paletteIndex].s1;
         }
         
-        if (flipY) { // Reflect Vertically
+        if (tile->flipY) { // Reflect Vertically
             t0 = palette[paletteIndex].t1;
             t1 = palette[paletteIndex].t0;
         }
@@ -307,107 +469,157 @@ static NSString* const kObjectPositionKey     = @"Position";
         _vertices[vertexIndex].position.y  = y1;
         _vertices[vertexIndex].texCoords.s = s1;
         _vertices[vertexIndex].texCoords.t = t1;
-        
-        // Next tile:
-        tileIndex++;
     }
     
     
-    // Configure index array
-    
-    // Start with one index per vertex, at least:
-    _indexCount = _vertexCount;
+    // 4. Configure index array
     
-    // 1. First pass: count 'gaps' between adjascent tiles in order to calculate
-    //    the total number of indices needed.
+    // First pass: count non-empty chunks, and 'gaps' between successive tiles
+    // of the same chunk in order to calculate the total number of indices
+    // needed (one per vertex, plus two per gap for the degenerate triangles,
+    // plus two to bridge each chunk to the next):
     
-    LayerTile* pThisTile = NULL;
-    LayerTile* pNextTile = NULL;
-    
-    BOOL tilesAreOnSameRow       = false;
-    BOOL tilesAreOneColumnAppart = false;
+    _chunkCount = 0;
+    _indexCount = _vertexCount;
     
-    for (NSUInteger i = 0; i < tileCount - 1; i++) { // Loop all tiles except last
+    for (NSUInteger i = 0; i < gridChunks; i++) {
         
-        pThisTile = &(layerTiles[  i  ]); // Current tile
-        pNextTile = &(layerTiles[i + 1]); // next tile
+        NSUInteger first = chunkOffsets[i];
+        NSUInteger last  = chunkOffsets[i + 1];
         
-        // Test for tile adjascency:
-        tilesAreOnSameRow       = ( pThisTile->y      == pNextTile->y );
-        tilesAreOneColumnAppart = ((pThisTile->x + 1) == pNextTile->x );
+        if (first == last) {
+            continue; // (empty chunk)
+        }
         
-        if (tilesAreOnSameRow && tilesAreOneColumnAppart) {
-            // Tiles are contiguous; No special treatment.
+        for (NSUInteger j = first; j < last - 1; j++) {
+            if (!tilesAreContiguous(&layerTiles[j], &layerTiles[j + 1])) {
+                _indexCount += 2;
+            }
         }
-        else{
-            // There is a gap between the two tiles; Add two extra indices to
-            // account for a degenerate triangle:
+        
+        if (last < tileCount) {
             _indexCount += 2;
         }
+        
+        _chunkCount++;
     }
     
-    _indices = calloc(sizeof(GLushort), _indexCount);
+    _chunks = calloc(sizeof(LayerChunk), _chunkCount);
     
+    // (Built with 32 bit indices; narrowed to 16 bit below if possible)
+    GLuint* indices = calloc(sizeof(GLuint), _indexCount);
     
-    // 2. Second pass: Calculate actual indices
+    
+    // Second pass: Calculate actual indices, and the bounds of each chunk.
     
     // Keeps track of at which position of the index array we are writing to
-    NSUInteger slot = 0;
+    GLsizei slot = 0;
     
-    // Holds the index, in the vertex array, of the first vertex of the current tile
-    NSUInteger indexOfFirstVertex;
+    LayerChunk* chunk = _chunks;
     
-    for (NSUInteger i = 0; i < tileCount - 1; i++) { // Loop all tiles except last
+    for (NSUInteger i = 0; i < gridChunks; i++) {
+        
+        NSUInteger first = chunkOffsets[i];
+        NSUInteger last  = chunkOffsets[i + 1];
         
-        pThisTile = &(layerTiles[  i  ]);
-        pNextTile = &(layerTiles[i + 1]);
+        if (first == last) {
+            continue; // (empty chunk)
+        }
         
-        // Set the indices that point to the 4 vertices of the current tile:
+        chunk->indexOffset = slot;
         
-        indexOfFirstVertex = 4*i; // (Four vertices per tile, so starts at a 4-boundary)
+        chunk->bounds[0] = +FLT_MAX;
+        chunk->bounds[1] = +FLT_MAX;
+        chunk->bounds[2] = -FLT_MAX;
+        chunk->bounds[3] = -FLT_MAX;
+        
+        for (NSUInteger j = first; j < last; j++) {
+            
+            // Holds the index, in the vertex array, of the first vertex of the
+            // current tile (Four vertices per tile, so starts at a 4-boundary):
+            GLuint indexOfFirstVertex = (GLuint)(4*j);
+            
+            // Set the indices that point to the 4 vertices of the current tile:
+            indices[slot++] = indexOfFirstVertex;
+            indices[slot++] = indexOfFirstVertex + 1;
+            indices[slot++] = indexOfFirstVertex + 2;
+            indices[slot++] = indexOfFirstVertex + 3;
+            
+            if (j < last - 1 && !tilesAreContiguous(&layerTiles[j], &layerTiles[j + 1])) {
+                // There is a gap between the tiles; Repeat index of current
+                // tile's last vertex, and of next tile's first vertex:
+                indices[slot++] = indexOfFirstVertex + 3;
+                indices[slot++] = indexOfFirstVertex + 4;
+            }
+            
+            // Grow the chunk's bounds (top-left and bottom-right vertices):
+            VertexData2D* topLeft     = &_vertices[indexOfFirstVertex];
+            VertexData2D* bottomRight = &_vertices[indexOfFirstVertex + 3];
+            
+            chunk->bounds[0] = MIN(chunk->bounds[0], topLeft->position.x);
+            chunk->bounds[1] = MIN(chunk->bounds[1], bottomRight->position.y);
+            chunk->bounds[2] = MAX(chunk->bounds[2], bottomRight->position.x);
+            chunk->bounds[3] = MAX(chunk->bounds[3], topLeft->position.y);
+        }
         
-        _indices[slot    ] = indexOfFirstVertex;
-        _indices[slot + 1] = indexOfFirstVertex + 1;
-        _indices[slot + 2] = indexOfFirstVertex + 2;
-        _indices[slot + 3] = indexOfFirstVertex + 3;
+        chunk->indexCount = slot - chunk->indexOffset;
         
-        // Conditions for tile adjascency:
-        tilesAreOnSameRow       = ( pThisTile->y      == pNextTile->y );
-        tilesAreOneColumnAppart = ((pThisTile->x + 1) == pNextTile->x );
+        if (last < tileCount) {
+            // Bridge to the next chunk (not part of this chunk's count):
+            indices[slot++] = (GLuint)(4*last - 1);
+            indices[slot++] = (GLuint)(4*last);
+        }
         
-        if (tilesAreOnSameRow && tilesAreOneColumnAppart) {
-            // Tiles are contiguous; Move the 'writing head' forward by just
-            // the FOUR vertices we wrote:
-            slot += 4;
+        // Grow the layer's bounds:
+        if (chunk == _chunks) {
+            memcpy(_bounds, chunk->bounds, sizeof(_bounds));
         }
         else{
-            // The is a gap between the tiles; Repeat index of current tile's
-            // last vertex:
-            _indices[slot + 4] = indexOfFirstVertex + 3;
-            
-            // Repeat index of next tile's first vertex:
-            _indices[slot + 5] = indexOfFirstVertex + 4;
-            
-            // Move writing head forward by the two extra vertices we just wrote:
-            slot += 6;
+            _bounds[0] = MIN(_bounds[0], chunk->bounds[0]);
+            _bounds[1] = MIN(_bounds[1], chunk->bounds[1]);
+            _bounds[2] = MAX(_bounds[2], chunk->bounds[2]);
+            _bounds[3] = MAX(_bounds[3], chunk->bounds[3]);
         }
+        
+        chunk++;
     }
     
-    // Indices for last tile:
-    _indices[_indexCount - 4] = _vertexCount - 4;
-    _indices[_indexCount - 3] = _vertexCount - 3;
-    _indices[_indexCount - 2] = _vertexCount - 2;
-    _indices[_indexCount - 1] = _vertexCount - 1;
-    
+    free(chunkOffsets);
     free(layerTiles);
     
+    
+    // 5. Use 16 bit indices whenever the vertex count allows it (large layers
+    //    need 32 bit indices; OpenGL ES 2.0 devices support them through the
+    //    OES_element_index_uint extension):
+    
+    if (_vertexCount <= 65536) {
+        
+        GLushort* shortIndices = calloc(sizeof(GLushort), _indexCount);
+        
+        for (GLsizei i = 0; i < _indexCount; i++) {
+            shortIndices[i] = (GLushort)indices[i];
+        }
+        free(indices);
+        
+        _indices   = shortIndices;
+        _indexType = GL_UNSIGNED_SHORT;
+        _indexSize = sizeof(GLushort);
+    }
+    else{
+        _indices   = indices;
+        _indexType = GL_UNSIGNED_INT;
+        _indexSize = sizeof(GLuint);
+    }
+    
     // (Next: Initialize OpenGL ES Objects on main thread)
 }
 
 
 /**
  */
-- (void) loadMapObjects:(NSArray *)objectDictionaries fromMap:(TileMap *)tileMap {
+- (void) loadMapObjects:(const TileMapFileTile *)objects
+                  count:(NSUInteger) objectCount
+                fromMap:(TileMap *)tileMap {
 
     // metrics
     CGSize     sizeInTiles  = [tileMap layerSize];   // How many tiles wide and high
@@ -431,9 +643,9 @@ static NSString* const kObjectPositionKey     = @"Position";
     id<TileMapDataSource> mapDelegate = [tileMap dataSource];
     
     
-    for (NSDictionary* tileDictionary in objectDictionaries) {
+    for (NSUInteger i = 0; i < objectCount; i++) {
         
-        NSUInteger index      = [[tileDictionary objectForKey:kTilePaletteIndexKey] unsignedIntegerValue];
+        NSUInteger index      = objects[i].paletteIndex;
         NSString*  identifier = [_tileset mapObjectIdentifierForBrushIndex:index];
         
         if (identifier) {
@@ -445,10 +657,12 @@ static NSString* const kObjectPositionKey     = @"Position";
                 continue;
             }
             
-            CGPoint position = CGPointFromString([tileDictionary objectForKey:kTilePositionKey]);
+            NSUInteger x = objects[i].x;
+            NSUInteger y = objects[i].y;
             
-            NSUInteger x = position.x;
-            NSUInteger y = position.y;
+            if (x >= columnCount || y >= rowCount) {
+                continue; // (Outside the grid)
+            }
             
             CGPoint objectPosition = CGPointMake(left + x*tileSize,
                                                  top - y*tileSize);
@@ -476,6 +690,10 @@ static NSString* const kObjectPositionKey     = @"Position";
         // 2. Free array of rows:
         free(_objectGrid);
     }
+    
+    free(_vertices);
+    free(_indices);
+    free(_chunks);
 }
 
 
@@ -492,33 +710,33 @@ static NSString* const kObjectPositionKey     = @"Position";
     bindIndexBufferObject(0);
     
     // Create and bind a VAO
-    glGenVertexArrays(1, &_vao);
+    glDispatch.genVertexArrays(1, &_vao);
     bindVertexArrayObject(_vao);
     
     // Create and bind a BO for vertex data
-    glGenBuffers(1, &_vbo);
+    glDispatch.genBuffers(1, &_vbo);
     bindVertexBufferObject(_vbo);
     
     // copy data into the buffer object
-    glBufferData(GL_ARRAY_BUFFER,
-                 _vertexCount*sizeof(VertexData2D),
-                 &_vertices[0],
-                 GL_STATIC_DRAW);
+    glDispatch.bufferData(GL_ARRAY_BUFFER,
+                          _vertexCount*sizeof(VertexData2D),
+                          &_vertices[0],
+                          GL_STATIC_DRAW);
     
     // Create and bind a BO for index data
-    glGenBuffers(1, &_ibo);
+    glDispatch.genBuffers(1, &_ibo);
     bindIndexBufferObject(_ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 _indexCount*sizeof(GLushort),
-                 &_indices[0],
-                 GL_STATIC_DRAW);
+    glDispatch.bufferData(GL_ELEMENT_ARRAY_BUFFER,
+                          _indexCount*_indexSize,
+                          &_indices[0],
+                          GL_STATIC_DRAW);
     
     // set up vertex attributes
-    glEnableVertexAttribArray(positionLocation);
-    glEnableVertexAttribArray(textureCoordinateLocation);
+    glDispatch.enableVertexAttribArray(positionLocation);
+    glDispatch.enableVertexAttribArray(textureCoordinateLocation);
     
-    glVertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
-    glVertexAttribPointer(textureCoordinateLocation, 2, GL_FLOAT, GL_FALSE, stride2D, textureOffset2D);
+    glDispatch.vertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
+    glDispatch.vertexAttribPointer(textureCoordinateLocation, 2, GL_FLOAT, GL_FALSE, stride2D, textureOffset2D);
     
     
     /*
@@ -529,8 +747,8 @@ static NSString* const kObjectPositionKey     = @"Position";
      */
     bindVertexArrayObject(0);
     
-    glDisableVertexAttribArray(positionLocation);
-    glDisableVertexAttribArray(textureCoordinateLocation);
+    glDispatch.disableVertexAttribArray(positionLocation);
+    glDispatch.disableVertexAttribArray(textureCoordinateLocation);
     
     
     // Unbind VBO/IBO too
@@ -548,15 +766,61 @@ static NSString* const kObjectPositionKey     = @"Position";
 }
 
 
+- (BOOL) intersectsRect:(CGRect) rect {
+
+    // Test the bounds of the whole mesh first; chunks are culled individually
+    // in -render.
+    
+    if (_chunkCount == 0) {
+        return NO;
+    }
+    
+    GLfloat box[4];
+    
+    affine2f_TransformAABB([self worldAffineTransform], _bounds, box);
+    
+    if (box[2] < CGRectGetMinX(rect) || box[0] > CGRectGetMaxX(rect)) {
+        return NO;
+    }
+    if (box[3] < CGRectGetMinY(rect) || box[1] > CGRectGetMaxY(rect)) {
+        return NO;
+    }
+    
+    return YES;
+}
+
+
 - (void) render {
 
     // (called only on instances that return YES from -drawsSelf. (i.e.,
     // instances with a mesh to display, not just map object placeholders)
     
     static GLfloat  colorVector[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-    static GLfloat* modelview      = NULL;
+    static GLfloat  modelview[16];
+    
     
-    modelview = [self worldTransform];
+    // Bring the visible region into layer coordinates (this accounts for the
+    // parallax offset set by the map in -[TileMap setPosition:]):
+    
+    Affine2f inverse;
+    
+    if (!affine2f_Invert([self worldAffineTransform], &inverse)) {
+        return; // (Degenerate transform; nothing visible)
+    }
+    
+    // (Scenes that are part of a transition don't have a renderer of their own;
+    //  use the shared one)
+    CGRect visibleRect = [[[DNRSceneController defaultController] renderer] visibleRect];
+    
+    GLfloat visibleBox[4] = {
+        CGRectGetMinX(visibleRect), CGRectGetMinY(visibleRect),
+        CGRectGetMaxX(visibleRect), CGRectGetMaxY(visibleRect)
+    };
+    
+    affine2f_TransformAABB(&inverse, visibleBox, visibleBox);
+    
+    
+    [self getWorldTransform:modelview];
     
     CGFloat alpha = [self alpha];
     
@@ -571,11 +835,43 @@ static NSString* const kObjectPositionKey     = @"Position";
     uniform4fv(colorLocation, colorVector);    // Cached - calls glUniform4fv(colorLocation, colorVector) if necessary
     uniform1f(zLocation, [self z]);            // Cached - calls glUniform4fv(zLocation, [self z]) if necessary
     
-    glUniformMatrix4fv(modelviewLocation, 1, 0, modelview);
+    glDispatch.uniformMatrix4fv(modelviewLocation, 1, 0, modelview);
     
     bindVertexArrayObject(_vao);               // Cached - calls glBindVertexArrayOES(_vao) if necessary
     
-    glDrawElements(GL_TRIANGLE_STRIP, _indexCount, GL_UNSIGNED_SHORT, 0);
+    
+    // Draw the visible chunks; each run of successive visible chunks (bridged
+    // by degenerate triangles) takes a single draw call:
+    
+    GLsizei runOffset = 0;
+    GLsizei runCount  = 0;
+    
+    for (NSUInteger i = 0; i < _chunkCount; i++) {
+        
+        LayerChunk* chunk = &_chunks[i];
+        
+        BOOL visible = (chunk->bounds[2] >= visibleBox[0] &&
+                        chunk->bounds[0] <= visibleBox[2] &&
+                        chunk->bounds[3] >= visibleBox[1] &&
+                        chunk->bounds[1] <= visibleBox[3]);
+        
+        if (visible) {
+            if (runCount == 0) {
+                runOffset = chunk->indexOffset;
+            }
+            runCount = (chunk->indexOffset + chunk->indexCount) - runOffset;
+        }
+        else if (runCount > 0) {
+            glDispatch.drawElements(GL_TRIANGLE_STRIP, runCount, _indexType, (const GLvoid *)(runOffset*_indexSize));
+            profilerCount(ProfilerCounterDrawCalls, 1);
+            runCount = 0;
+        }
+    }
+    
+    if (runCount > 0) {
+        glDispatch.drawElements(GL_TRIANGLE_STRIP, runCount, _indexType, (const GLvoid *)(runOffset*_indexSize));
+        profilerCount(ProfilerCounterDrawCalls, 1);
+    }
     
     bindVertexArrayObject(0);
 }
@@ -0,0 +1,356 @@
+//
+//  DNRSpriteBatch.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-05.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <stddef.h>     // offsetof()
+
+#include "DNRSpriteBatch.h"
+
+#include "DNRGLCache.h"
+#include "DNRGLDispatch.h"
+#include "DNRProfiler.h"
+
+
+// Quads are indexed with GLushort, so one flush can reference at most 65536
+// vertices (4 per quad):
+#define MaxQuadsPerBatch        16384u
+
+#define VerticesPerQuad         4u
+#define IndicesPerQuad          6u
+
+
+/**
+ A sequence of consecutive quads that share the same render state, and hence
+ can be drawn with a single call.
+ */
+typedef struct tSpriteBatchRun {
+
+    GLuint      texture;
+    GLuint      program;
+    GLboolean   blending;
+
+    GLuint      firstQuad;
+    GLuint      quadCount;
+
+} SpriteBatchRun;
+
+
+struct tSpriteBatch {
+
+    // OpenGL objects
+    GLuint              program;
+    GLuint              vao;
+    GLuint              vbo;
+    GLuint              ibo;
+    GLuint              whiteTexture;
+
+    // Client-side storage (one frame's worth, or less)
+    GLuint              maxQuadCount;
+    GLuint              quadCount;
+    BatchVertexData2D*  vertices;
+
+    SpriteBatchRun*     runs;
+    GLuint              runCount;
+
+    // State requested for the next quads
+    GLboolean           blending;
+
+    // State actually set on the context (-1: unknown)
+    GLint               appliedBlending;
+
+    // Statistics
+    GLuint              drawCallCount;
+};
+
+
+#pragma mark - Internal
+
+
+static void applyBlending(SpriteBatch* batch, GLboolean enabled) {
+
+    if (batch->appliedBlending != (GLint)enabled) {
+
+        if (enabled) {
+            glDispatch.enable(GL_BLEND);
+        }
+        else{
+            glDispatch.disable(GL_BLEND);
+        }
+
+        batch->appliedBlending = (GLint)enabled;
+    }
+}
+
+
+#pragma mark - Lifecycle
+
+
+SpriteBatch* spriteBatchCreate(GLuint program, GLuint maxQuadCount) {
+
+    if (maxQuadCount == 0 || maxQuadCount > MaxQuadsPerBatch) {
+        maxQuadCount = MaxQuadsPerBatch;
+    }
+
+    SpriteBatch* batch = (SpriteBatch *)calloc(1, sizeof(SpriteBatch));
+
+    if (!batch) {
+        return NULL;
+    }
+
+    batch->program         = program;
+    batch->maxQuadCount    = maxQuadCount;
+    batch->vertices        = (BatchVertexData2D *)calloc(VerticesPerQuad*maxQuadCount, sizeof(BatchVertexData2D));
+    batch->runs            = (SpriteBatchRun *)calloc(maxQuadCount, sizeof(SpriteBatchRun));
+    batch->blending        = GL_TRUE;
+    batch->appliedBlending = -1;
+
+    if (!batch->vertices || !batch->runs) {
+        spriteBatchDestroy(batch);
+        return NULL;
+    }
+
+
+    // 1. Index data never changes: two triangles per quad, built from the
+    //    strip-ordered vertices (TL, BL, TR, BR):
+
+    GLushort* indices = (GLushort *)malloc(IndicesPerQuad*maxQuadCount*sizeof(GLushort));
+
+    if (!indices) {
+        spriteBatchDestroy(batch);
+        return NULL;
+    }
+
+    for (GLuint i = 0; i < maxQuadCount; i++) {
+
+        GLushort  base  = (GLushort)(VerticesPerQuad*i);
+        GLushort* quad  = &indices[IndicesPerQuad*i];
+
+        quad[0] = base + 0;
+        quad[1] = base + 1;
+        quad[2] = base + 2;
+
+        quad[3] = base + 2;
+        quad[4] = base + 1;
+        quad[5] = base + 3;
+    }
+
+
+    // 2. Geometry
+
+    GLint positionLocation = glDispatch.getAttribLocation(program, "Position");
+    GLint texCoordLocation = glDispatch.getAttribLocation(program, "TextureCoord");
+    GLint colorLocation    = glDispatch.getAttribLocation(program, "Color");
+
+    glDispatch.genVertexArrays(1, &(batch->vao));
+    bindVertexArrayObject(batch->vao);
+
+    glDispatch.genBuffers(1, &(batch->vbo));
+    bindVertexBufferObject(batch->vbo);
+
+    glDispatch.bufferData(GL_ARRAY_BUFFER,
+                          VerticesPerQuad*maxQuadCount*sizeof(BatchVertexData2D),
+                          NULL,
+                          GL_STREAM_DRAW);
+
+    glDispatch.genBuffers(1, &(batch->ibo));
+    bindIndexBufferObject(batch->ibo);
+
+    glDispatch.bufferData(GL_ELEMENT_ARRAY_BUFFER,
+                          IndicesPerQuad*maxQuadCount*sizeof(GLushort),
+                          indices,
+                          GL_STATIC_DRAW);
+
+    glDispatch.enableVertexAttribArray(positionLocation);
+    glDispatch.enableVertexAttribArray(texCoordLocation);
+    glDispatch.enableVertexAttribArray(colorLocation);
+
+    glDispatch.vertexAttribPointer(positionLocation, 3, GL_FLOAT,         GL_FALSE, sizeof(BatchVertexData2D), (GLvoid *)offsetof(BatchVertexData2D, position ));
+    glDispatch.vertexAttribPointer(texCoordLocation, 2, GL_FLOAT,         GL_FALSE, sizeof(BatchVertexData2D), (GLvoid *)offsetof(BatchVertexData2D, texCoords));
+    glDispatch.vertexAttribPointer(colorLocation,    4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(BatchVertexData2D), (GLvoid *)offsetof(BatchVertexData2D, color    ));
+
+    bindVertexArrayObject(0);
+
+    glDispatch.disableVertexAttribArray(positionLocation);
+    glDispatch.disableVertexAttribArray(texCoordLocation);
+    glDispatch.disableVertexAttribArray(colorLocation);
+
+    bindIndexBufferObject(0);
+    bindVertexBufferObject(0);
+
+    free(indices);
+
+
+    // 3. White texel, for flat (untextured) quads
+
+    static const GLubyte white[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+    glDispatch.genTextures(1, &(batch->whiteTexture));
+    bindTexture2D(batch->whiteTexture);
+
+    glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glDispatch.texImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+
+    bindTexture2D(0);
+
+    return batch;
+}
+
+
+void spriteBatchDestroy(SpriteBatch* batch) {
+
+    if (!batch) {
+        return;
+    }
+
+    // (Through the state cache, which forgets the bindings; no-ops for 0)
+    deleteVertexArrayObject(batch->vao);
+    deleteBufferObject(batch->vbo);
+    deleteBufferObject(batch->ibo);
+    deleteTexture2D(batch->whiteTexture);
+
+    free(batch->vertices);
+    free(batch->runs);
+    free(batch);
+}
+
+
+#pragma mark - Operation
+
+
+void spriteBatchBegin(SpriteBatch* batch) {
+
+    batch->quadCount       = 0;
+    batch->runCount        = 0;
+    batch->appliedBlending = -1;
+    batch->drawCallCount   = 0;
+}
+
+
+void spriteBatchSetBlendingEnabled(SpriteBatch* batch, GLboolean enabled) {
+
+    batch->blending = (enabled ? GL_TRUE : GL_FALSE);
+}
+
+
+void spriteBatchAppendQuad(SpriteBatch* batch,
+                           GLuint texture,
+                           GLuint program,
+                           const BatchVertexData2D* vertices) {
+
+    if (batch->quadCount == batch->maxQuadCount) {
+        // Buffer full; submit what we have so far and start over:
+        spriteBatchFlush(batch);
+    }
+
+    // Continue the current run if the state matches, otherwise start a new one:
+
+    SpriteBatchRun* run = NULL;
+
+    if (batch->runCount > 0) {
+        run = &(batch->runs[batch->runCount - 1]);
+
+        if (run->texture != texture || run->program != program || run->blending != batch->blending) {
+            run = NULL;
+        }
+    }
+
+    if (!run) {
+        run = &(batch->runs[batch->runCount++]);
+
+        run->texture   = texture;
+        run->program   = program;
+        run->blending  = batch->blending;
+        run->firstQuad = batch->quadCount;
+        run->quadCount = 0;
+    }
+
+    BatchVertexData2D* destination = &(batch->vertices[VerticesPerQuad*batch->quadCount]);
+
+    destination[0] = vertices[0];
+    destination[1] = vertices[1];
+    destination[2] = vertices[2];
+    destination[3] = vertices[3];
+
+    run->quadCount++;
+    batch->quadCount++;
+}
+
+
+void spriteBatchFlush(SpriteBatch* batch) {
+
+    if (batch->quadCount > 0) {
+
+        // 1. Upload (orphan the previous storage so the driver does not have
+        //    to wait for pending draws that still read from it):
+
+        bindVertexArrayObject(batch->vao);
+        bindVertexBufferObject(batch->vbo);
+
+        glDispatch.bufferData(GL_ARRAY_BUFFER,
+                              VerticesPerQuad*(batch->maxQuadCount)*sizeof(BatchVertexData2D),
+                              NULL,
+                              GL_STREAM_DRAW);
+
+        glDispatch.bufferSubData(GL_ARRAY_BUFFER,
+                                 0,
+                                 VerticesPerQuad*(batch->quadCount)*sizeof(BatchVertexData2D),
+                                 batch->vertices);
+
+
+        // 2. Draw one call per run
+
+        for (GLuint i = 0; i < batch->runCount; i++) {
+
+            SpriteBatchRun* run = &(batch->runs[i]);
+
+            applyBlending(batch, run->blending);
+
+            useProgram(run->program);
+            bindTexture2D(run->texture);
+
+            GLvoid* startIndex = (GLvoid *)(IndicesPerQuad*(run->firstQuad)*sizeof(GLushort));
+
+            glDispatch.drawElements(GL_TRIANGLES, IndicesPerQuad*(run->quadCount), GL_UNSIGNED_SHORT, startIndex);
+
+            batch->drawCallCount++;
+            profilerCount(ProfilerCounterDrawCalls, 1);
+        }
+
+        batch->quadCount = 0;
+        batch->runCount  = 0;
+    }
+
+    // Leave the context in the state requested last, for whatever gets drawn
+    // next outside of the batch:
+    applyBlending(batch, batch->blending);
+}
+
+
+#pragma mark - Accessors
+
+
+GLuint spriteBatchDefaultProgram(const SpriteBatch* batch) {
+
+    return batch->program;
+}
+
+
+GLuint spriteBatchWhiteTexture(const SpriteBatch* batch) {
+
+    return batch->whiteTexture;
+}
+
+
+GLuint spriteBatchDrawCallCount(const SpriteBatch* batch) {
+
+    return batch->drawCallCount;
+}
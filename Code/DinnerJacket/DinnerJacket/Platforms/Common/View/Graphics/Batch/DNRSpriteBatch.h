@@ -0,0 +1,97 @@
+//
+//  DNRSpriteBatch.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-11-05.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRSpriteBatch_h__
+#define __DNRSpriteBatch_h__
+
+#include "DNRBase.h"
+
+
+/**
+ Collects the quads of many sprites into a single streaming vertex buffer, and
+ submits them with as few draw calls as possible.
+
+ Quads are transformed on the CPU (the vertices appended are already in world
+ pixel coordinates, with the depth baked in), so consecutive quads that share
+ the same texture, program and blending state are drawn together with one call
+ to glDrawElements. A new "run" is started each time any of those changes.
+
+ Pending quads are submitted when the buffer fills up, or when the batch is
+ explicitly flushed (e.g., before a node that issues its own draw calls renders,
+ and at the end of each pass).
+
+ The program must declare the same vertex attributes as SpriteBatch.vertsh
+ (Position, TextureCoord, Color) and a Projection uniform.
+ */
+typedef struct tSpriteBatch SpriteBatch;
+
+
+/**
+ Creates a batch that can hold up to maxQuadCount quads between flushes, and
+ the OpenGL objects that back it. Must be called on the main thread/context.
+ */
+SpriteBatch* spriteBatchCreate(GLuint program, GLuint maxQuadCount);
+
+
+/**
+ Deletes the OpenGL objects and frees the batch.
+ */
+void spriteBatchDestroy(SpriteBatch* batch);
+
+
+/**
+ Call at the beginning of each frame. Discards any cached blending state (the
+ renderer might have changed it in between frames).
+ */
+void spriteBatchBegin(SpriteBatch* batch);
+
+
+/**
+ Sets the blending state for the quads appended next.
+ */
+void spriteBatchSetBlendingEnabled(SpriteBatch* batch, GLboolean enabled);
+
+
+/**
+ Appends one quad (4 vertices, in triangle strip order: top left, bottom left,
+ top right, bottom right) to the current run.
+ */
+void spriteBatchAppendQuad(SpriteBatch* batch,
+                           GLuint texture,
+                           GLuint program,
+                           const BatchVertexData2D* vertices);
+
+
+/**
+ Uploads all pending quads and issues one draw call per run. On return, the
+ OpenGL blending state matches the last value passed to
+ spriteBatchSetBlendingEnabled().
+ */
+void spriteBatchFlush(SpriteBatch* batch);
+
+
+/**
+ The program the batch was created with.
+ */
+GLuint spriteBatchDefaultProgram(const SpriteBatch* batch);
+
+
+/**
+ A 1x1 opaque white texture, for drawing untextured (flat) quads with the
+ textured program (lets them batch together).
+ */
+GLuint spriteBatchWhiteTexture(const SpriteBatch* batch);
+
+
+/**
+ Number of draw calls issued since the last call to spriteBatchBegin().
+ */
+GLuint spriteBatchDrawCallCount(const SpriteBatch* batch);
+
+
+#endif  // #defined (__DNRSpriteBatch_h__)
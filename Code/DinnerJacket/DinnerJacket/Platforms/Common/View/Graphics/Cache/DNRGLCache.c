@@ -9,502 +9,957 @@
 #include "DNRBase.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "DNRGLCache.h"
+#include "DNRGLDispatch.h"
+#include "DNRProfiler.h"
 
 
 
 #define OPENGL_CACHE_ENABLED
 
-#define MaxPrograms                  20u
-#define MaxVector2fPerProgram        20u
-#define MaxVector3fPerProgram        20u
-#define MaxVector4fPerProgram        20u
-#define MaxScalarsPerProgram         20u
+// Value of cached object names that are not known (forces the next call)
+#define UnknownName                 ((GLuint)~0u)
 
+#define MinUniformsPerProgram       16u
+
+
+
+/**
+ Values last set to the uniforms of one program, indexed by location. Arrays
+ grow on demand; slots never set hold NaN (never equal to any value, so the
+ first call always goes through).
+ */
+typedef struct tProgramUniforms {
+
+    GLuint      name;
+
+    GLfloat*    scalars;
+    GLuint      scalarCount;
+
+    Vector2f*   vector2f;
+    GLuint      vector2fCount;
+
+    Vector3f*   vector3f;
+    GLuint      vector3fCount;
+
+    Vector4f*   vector4f;
+    GLuint      vector4fCount;
+
+}ProgramUniforms;
 
 
 /**
- Caches some of the state of one OpenGL ES context. Calls that attempt to
+ Caches some of the state of one OpenGL (ES) context. Calls that attempt to
  change state are issued only if they actually change the current value.
  When the call is meaningfull and the sate is changed, the new value is cached
  in order to evaluate further attempts to change.
- 
- I do not know if this is a performance improvement or not, but at least it 
- keeps the OpenGL ES performance analyzer from warning about redundant state 
- changes.
+
+ I do not know if this is a performance improvement or not, but at least it
+ keeps the OpenGL ES performance analyzer from warning about redundant state
+ changes. (Build with DNR_GLCACHE_STATS to see how many calls it elides.)
  */
-typedef struct tContextInfo {
+struct tGLCacheContext {
+
+    const void* glContext;              // Key (not retained)
+
+    GLCacheContext* next;               // Registry list
 
     GLuint currentFramebuffer;
-    
+
     GLuint currentRenderbuffer;
-    
+
     GLuint currentVBO;
     GLuint currentIBO;
     GLuint currentVAO;
     GLuint currentTexture;
-    GLuint currentBGTexture;
-    
+
     GLuint currentProgram;
-    
-    Color4f currentColor;
-    
+
     Color4f clearColor;
-    
+
     GLuint currentTransTexture;
-    
+
     GLint   viewPortX;
     GLint   viewPortY;
     GLsizei viewPortW;
     GLsizei viewPortH;
-    
-    GLfloat  scalars [MaxPrograms][MaxScalarsPerProgram];
-    Vector2f vector2f[MaxPrograms][MaxVector2fPerProgram];
-    Vector3f vector3f[MaxPrograms][MaxVector3fPerProgram];
-    Vector4f vector4f[MaxPrograms][MaxVector4fPerProgram];
-    
-}ContextInfo;
 
+    // Uniform caches; one per program used in this context, in order of
+    // first use (the position is the program's dense index).
+    ProgramUniforms*    programs;
+    GLuint              programCount;
+    GLuint              programCapacity;
+    ProgramUniforms*    currentUniforms;    // NULL for program 0
 
-static ContextInfo mainContextInfo       = {0};
-static ContextInfo backgroundContextInfo = {0};
+    // Value of textureDeletionCount when the texture bindings were last
+    // validated (names deleted in a shared context can be reused).
+    uint32_t            textureDeletionsSeen;
 
+    // Same, for the buffer object bindings (also shared)
+    uint32_t            bufferDeletionsSeen;
 
-/*
-void openGLCacheSetCurrentContext(GLuint context) {
+#if DNR_GLCACHE_STATS
+    GLCacheCounts       frameCounts[GLCacheEntryCount];         // In progress
+    GLCacheCounts       lastFrameCounts[GLCacheEntryCount];
+    GLCacheCounts       cumulativeCounts[GLCacheEntryCount];
+#endif
+};
 
-    if (context == OpenGLCacheMainContext) {
-        currentContextInfoPtr = &mainContextInfo;
-    }
-    else if(context == OpenGLCacheBackgroundContext){
-        currentContextInfoPtr = &backgroundContextInfo;
+
+static pthread_mutex_t  registryMutex = PTHREAD_MUTEX_INITIALIZER;
+static GLCacheContext*  registryHead  = NULL;
+
+static _Thread_local GLCacheContext* currentContext = NULL;
+
+static _Atomic(uint32_t) textureDeletionCount = 0;
+static _Atomic(uint32_t) bufferDeletionCount  = 0;
+
+
+static const char* entryNames[GLCacheEntryCount] = {
+    "viewPort",
+    "bindTexture2D",
+    "bindVertexBufferObject",
+    "bindIndexBufferObject",
+    "bindVertexArrayObject",
+    "clearColor",
+    "uniform1f",
+    "uniform2fv",
+    "uniform3fv",
+    "uniform4fv",
+    "useProgram",
+    "bindFramebuffer",
+    "bindRenderbuffer",
+    "attachTexture2D",
+};
+
+
+#pragma mark - Context Management
+
+
+static void contextForgetState(GLCacheContext* context) {
+
+    context->currentFramebuffer  = UnknownName;
+    context->currentRenderbuffer = UnknownName;
+    context->currentVBO          = UnknownName;
+    context->currentIBO          = UnknownName;
+    context->currentVAO          = UnknownName;
+    context->currentTexture      = UnknownName;
+    context->currentProgram      = UnknownName;
+    context->currentTransTexture = UnknownName;
+
+    context->clearColor = Color4fMake(NAN, NAN, NAN, NAN);
+
+    context->viewPortX = -1;
+    context->viewPortY = -1;
+    context->viewPortW = -1;
+    context->viewPortH = -1;
+
+    context->currentUniforms = NULL;
+
+    for (GLuint i = 0; i < context->programCount; i++) {
+        ProgramUniforms* uniforms = &(context->programs[i]);
+
+        free(uniforms->scalars);
+        free(uniforms->vector2f);
+        free(uniforms->vector3f);
+        free(uniforms->vector4f);
     }
+    context->programCount = 0;
+
+    context->textureDeletionsSeen = atomic_load(&textureDeletionCount);
+    context->bufferDeletionsSeen  = atomic_load(&bufferDeletionCount);
 }
-*/
 
-#pragma mark - Main Context
 
-// General
-void viewPort(GLint x, GLint y, GLsizei width, GLsizei height) {
+static GLCacheContext* contextCreate(const void* glContext) {
 
-    ContextInfo* info = &mainContextInfo;
-    
-	if(x != info->viewPortX || y != info->viewPortY || width != info->viewPortW || height != info->viewPortH){
-        // Set
-        glViewport(x, y, width, height);
-        
-        // Cache
-        info->viewPortX = x;
-		info->viewPortY = y;
-		info->viewPortW = width;
-		info->viewPortH = height;
+    GLCacheContext* context = calloc(1, sizeof(GLCacheContext));
+
+    if (context) {
+        context->glContext = glContext;
+
+        // A fresh OpenGL context is in its default state, but the cache may be
+        // created for one that has been in use for a while:
+        contextForgetState(context);
     }
+
+    return context;
 }
 
 
-void bindTexture2D(GLuint texture) {
+static void contextDestroy(GLCacheContext* context) {
 
-    ContextInfo* info = &mainContextInfo;
-    
-    if(texture != info->currentTexture){
-        // Set
-        glBindTexture(GL_TEXTURE_2D, texture);
-        
-        // Cache
-        info->currentTexture = texture;
-    }
+    contextForgetState(context);
+
+    free(context->programs);
+    free(context);
 }
 
 
-void bindVertexBufferObject(GLuint vbo) {
+GLCacheContext* glCacheMakeCurrent(const void* glContext) {
 
-    ContextInfo* info = &mainContextInfo;
-    
-    if(vbo != info->currentVBO){
-        // Set
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        
-        // Cache
-        info->currentVBO = vbo;
+    if (glContext == NULL) {
+        currentContext = NULL;
+        return NULL;
+    }
+
+    if (currentContext && currentContext->glContext == glContext) {
+        return currentContext;
+    }
+
+    pthread_mutex_lock(&registryMutex);
+
+    GLCacheContext* context = registryHead;
+
+    while (context && context->glContext != glContext) {
+        context = context->next;
+    }
+
+    if (context == NULL) {
+        if ((context = contextCreate(glContext))) {
+            context->next = registryHead;
+            registryHead  = context;
+        }
     }
+
+    pthread_mutex_unlock(&registryMutex);
+
+    currentContext = context;
+
+    return context;
 }
 
 
-void bindIndexBufferObject(GLuint ibo) {
+GLCacheContext* glCacheCurrentContext(void) {
+    return currentContext;
+}
 
-    ContextInfo* info = &mainContextInfo;
-    
-    if(ibo != info->currentIBO){
-        // Set
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        
-        // Cache
-        info->currentIBO = ibo;
+
+const void* glCacheCurrentGLContext(void) {
+    return currentContext ? currentContext->glContext : NULL;
+}
+
+
+void glCacheInvalidate(void) {
+
+    if (currentContext) {
+        contextForgetState(currentContext);
     }
 }
 
 
-void bindVertexArrayObject(GLuint vao) {
+void glCacheContextRemove(const void* glContext) {
 
-    ContextInfo* info = &mainContextInfo;
-    
-    if (vao != info->currentVAO) {
-        // Set new value:
-        //glBindVertexArrayOES(vao);
-        glBindVertexArray(vao);
-        
-        // Cache it to keep in sync
-        info->currentVAO = vao;
+    pthread_mutex_lock(&registryMutex);
+
+    GLCacheContext** link = &registryHead;
+
+    while (*link && (*link)->glContext != glContext) {
+        link = &((*link)->next);
+    }
+
+    GLCacheContext* context = *link;
+
+    if (context) {
+        *link = context->next;
+    }
+
+    pthread_mutex_unlock(&registryMutex);
+
+    if (context) {
+        if (currentContext == context) {
+            currentContext = NULL;
+        }
+        contextDestroy(context);
     }
 }
 
 
-void clearColor(Color4f newColor) {
+// .............................................................................
 
-    ContextInfo* info = &mainContextInfo;
-    
-    Color4f currentColor = (info->clearColor);
-    
-    if (currentColor.r != newColor.r || currentColor.g != newColor.g || currentColor.b != newColor.b || currentColor.a != newColor.a){
-        // Set
-        glClearColor(newColor.r, newColor.g, newColor.b, newColor.a);
-        
-        // Cache
-        info->clearColor = newColor;
+/**
+ Texture names deleted in any context of the share group can be handed out
+ again, so a cached binding might refer to a different texture than the one
+ about to be bound: forget it if anything was deleted since last checked.
+ */
+static void contextValidateTextures(GLCacheContext* context) {
+
+    uint32_t deletions = atomic_load_explicit(&textureDeletionCount, memory_order_acquire);
+
+    if (deletions != context->textureDeletionsSeen) {
+        context->currentTexture       = UnknownName;
+        context->currentTransTexture  = UnknownName;
+        context->textureDeletionsSeen = deletions;
     }
 }
 
 
-void clearColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
-    return clearColor(Color4fMake(red, green, blue, alpha));
+static void contextValidateBuffers(GLCacheContext* context) {
+
+    uint32_t deletions = atomic_load_explicit(&bufferDeletionCount, memory_order_acquire);
+
+    if (deletions != context->bufferDeletionsSeen) {
+        context->currentVBO          = UnknownName;
+        context->currentIBO          = UnknownName;
+        context->bufferDeletionsSeen = deletions;
+    }
 }
 
 
-void uniform1f(GLuint location, GLfloat scalar) {
+/**
+ Returns the uniforms of program (appending a new entry the first time it is
+ used in this context), or NULL on allocation failure.
+ */
+static ProgramUniforms* contextUniformsForProgram(GLCacheContext* context, GLuint program) {
 
-    ContextInfo* info = &mainContextInfo;
-    GLuint program = info->currentProgram;
-    GLfloat s = info->scalars[program][location];
-    
-    if (s != scalar) {
-        // Set
-        glUniform1f(location, scalar);
-        
-        // Cache
-        info->scalars[program][location] = scalar;
+    for (GLuint i = 0; i < context->programCount; i++) {
+        if (context->programs[i].name == program) {
+            return &(context->programs[i]);
+        }
     }
+
+    if (context->programCount == context->programCapacity) {
+        GLuint capacity = context->programCapacity ? (2 * context->programCapacity) : 8u;
+
+        ProgramUniforms* programs = realloc(context->programs, capacity * sizeof(ProgramUniforms));
+
+        if (!programs) {
+            return NULL;
+        }
+        context->programs        = programs;
+        context->programCapacity = capacity;
+    }
+
+    ProgramUniforms* uniforms = &(context->programs[context->programCount++]);
+
+    *uniforms = (ProgramUniforms){ 0 };
+    uniforms->name = program;
+
+    return uniforms;
 }
 
 
-void uniform2fv(GLuint location, GLfloat* vector) {
+/**
+ Makes sure *array (of *count elements of elementSize bytes, each made of
+ floats) has a slot for location. Returns 0 on failure (the caller should then
+ bypass the cache).
+ */
+static int growUniformArray(void** array, GLuint* count, GLuint location, size_t elementSize) {
 
-    ContextInfo* info = &mainContextInfo;
-    GLuint program = info->currentProgram;
-    Vector2f v = info->vector2f[program][location];
-	
-    if(vector[0] != v.x || vector[1] != v.y){
-        
-        // Set
-        glUniform2fv(location, 1, vector);
-        
-        // Cache
-        info->vector2f[program][location].x = vector[0];
-		info->vector2f[program][location].y = vector[1];
+    if (location < *count) {
+        return 1;
+    }
+
+    GLuint newCount = (*count) ? (*count) : MinUniformsPerProgram;
+
+    while (newCount <= location) {
+        newCount *= 2;
     }
+
+    GLfloat* newArray = realloc(*array, newCount * elementSize);
+
+    if (!newArray) {
+        return 0;
+    }
+
+    size_t firstFloat = ((*count) * elementSize) / sizeof(GLfloat);
+    size_t lastFloat  = (newCount * elementSize) / sizeof(GLfloat);
+
+    for (size_t i = firstFloat; i < lastFloat; i++) {
+        newArray[i] = NAN;
+    }
+
+    *array = newArray;
+    *count = newCount;
+
+    return 1;
 }
 
 
-void uniform3fv(GLuint location, GLfloat* vector) {
+/**
+ Returns the current program's uniforms if the cache can hold a value for
+ location, NULL otherwise (no current cache or program, location -1, etc.).
+ */
+static ProgramUniforms* currentUniformsForLocation(GLuint location) {
 
-    ContextInfo* info = &mainContextInfo;
-    GLuint program = info->currentProgram;
-    Vector3f v = info->vector3f[program][location];
-	
-    if(vector[0] != v.x || vector[1] != v.y || vector[2] != v.z){
-        // Set
-        glUniform3fv(location, 1, vector);
-        
-        // Cache
-        info->vector3f[program][location].x = vector[0];
-		info->vector3f[program][location].y = vector[1];
-		info->vector3f[program][location].z = vector[2];
+    GLCacheContext* context = currentContext;
+
+    if (!context || (GLint)location < 0) {
+        return NULL;
     }
+    return context->currentUniforms;
 }
 
 
-void uniform4fv(GLuint location, GLfloat* vector) {
+#pragma mark - Statistics
 
-    ContextInfo* info = &mainContextInfo;
-    GLuint program = info->currentProgram;
-    Vector4f v = info->vector4f[program][location];
-	
-    if(vector[0] != v.x || vector[1] != v.y || vector[2] != v.z || vector[3] != v.w){
-        // Set
-        glUniform4fv(location, 1, vector);
-        
-        // Cache
-        info->vector4f[program][location].x = vector[0];
-		info->vector4f[program][location].y = vector[1];
-		info->vector4f[program][location].z = vector[2];
-		info->vector4f[program][location].w = vector[3];
+
+/**
+ The call was elided.
+ */
+static inline void contextCountHit(GLCacheContext* context, GLCacheEntry entry) {
+
+#if DNR_GLCACHE_STATS
+    context->frameCounts[entry].hits++;
+#endif
+    profilerCount(ProfilerCounterStateChangesSkipped, 1);
+}
+
+
+/**
+ The call was issued.
+ */
+static inline void contextCountMiss(GLCacheContext* context, GLCacheEntry entry) {
+
+#if DNR_GLCACHE_STATS
+    context->frameCounts[entry].misses++;
+#endif
+}
+
+
+#if DNR_GLCACHE_STATS
+static GLCacheStats statsWithCounts(const GLCacheCounts* counts) {
+
+    GLCacheStats stats = { 0 };
+
+    for (int i = 0; i < GLCacheEntryCount; i++) {
+        stats.entries[i]     = counts[i];
+        stats.total.hits    += counts[i].hits;
+        stats.total.misses  += counts[i].misses;
     }
+
+    return stats;
 }
+#endif
 
 
-void useProgram(GLuint program) {
+void glCacheEndFrame(void) {
 
-    ContextInfo* info = &mainContextInfo;
-    
-    if(program != info->currentProgram){
-        // Set
-        glUseProgram(program);
-        
-        // Cache
-        info->currentProgram = program;
+#if DNR_GLCACHE_STATS
+    GLCacheContext* context = currentContext;
+
+    if (!context) {
+        return;
     }
+
+    for (int i = 0; i < GLCacheEntryCount; i++) {
+        context->lastFrameCounts[i] = context->frameCounts[i];
+
+        context->cumulativeCounts[i].hits   += context->frameCounts[i].hits;
+        context->cumulativeCounts[i].misses += context->frameCounts[i].misses;
+    }
+
+    memset(context->frameCounts, 0, sizeof(context->frameCounts));
+#endif
 }
 
 
-// Framebuffer
-void bindFramebuffer(GLuint framebuffer) {
+GLCacheStats glCacheFrameStats(void) {
 
-    ContextInfo* info = &mainContextInfo;
-    
-    if(framebuffer != info->currentFramebuffer){
-        // Set
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        
-        // Cache
-        info->currentFramebuffer = framebuffer;
+#if DNR_GLCACHE_STATS
+    if (currentContext) {
+        return statsWithCounts(currentContext->lastFrameCounts);
     }
+#endif
+    return (GLCacheStats){ 0 };
 }
 
 
-void bindRenderbuffer(GLuint renderbuffer) {
+GLCacheStats glCacheCumulativeStats(void) {
 
-    ContextInfo* info = &mainContextInfo;
-    
-    if(renderbuffer != info->currentRenderbuffer){
-        // Set
-        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
-        
-        // Cache
-        info->currentRenderbuffer = renderbuffer;
+#if DNR_GLCACHE_STATS
+    if (currentContext) {
+        return statsWithCounts(currentContext->cumulativeCounts);
     }
+#endif
+    return (GLCacheStats){ 0 };
 }
 
 
-void attachTexture2D(GLuint texture) {
+void glCacheResetStats(void) {
 
-    ContextInfo* info = &mainContextInfo;
-    
-	if(texture != info->currentTransTexture){
-        // Set
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-        
-		// Cache
-		info->currentTransTexture = texture;
-	}
+#if DNR_GLCACHE_STATS
+    GLCacheContext* context = currentContext;
+
+    if (context) {
+        memset(context->frameCounts,      0, sizeof(context->frameCounts));
+        memset(context->lastFrameCounts,  0, sizeof(context->lastFrameCounts));
+        memset(context->cumulativeCounts, 0, sizeof(context->cumulativeCounts));
+    }
+#endif
+}
+
+
+const char* glCacheEntryName(GLCacheEntry entry) {
+    return (entry < GLCacheEntryCount) ? entryNames[entry] : "unknown";
 }
 
 
-#pragma mark - Background Context
+#pragma mark - Cached State
 
 // General
-void viewPort_BG(GLint x, GLint y, GLsizei width, GLsizei height) {
+void viewPort(GLint x, GLint y, GLsizei width, GLsizei height) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.viewport(x, y, width, height);
+        return;
+    }
 
-    ContextInfo* info = &backgroundContextInfo;
-    
 	if(x != info->viewPortX || y != info->viewPortY || width != info->viewPortW || height != info->viewPortH){
         // Set
-        glViewport(x, y, width, height);
-        
+        glDispatch.viewport(x, y, width, height);
+
         // Cache
         info->viewPortX = x;
 		info->viewPortY = y;
 		info->viewPortW = width;
 		info->viewPortH = height;
+
+        contextCountMiss(info, GLCacheEntryViewPort);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryViewPort);
     }
 }
 
 
-void bindTexture2D_BG(GLuint texture) {
+void bindTexture2D(GLuint texture) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.bindTexture(GL_TEXTURE_2D, texture);
+        return;
+    }
+
+    contextValidateTextures(info);
 
-    ContextInfo* info = &backgroundContextInfo;
-    
     if(texture != info->currentTexture){
         // Set
-        glBindTexture(GL_TEXTURE_2D, texture);
-        
+        glDispatch.bindTexture(GL_TEXTURE_2D, texture);
+
         // Cache
         info->currentTexture = texture;
+
+        contextCountMiss(info, GLCacheEntryBindTexture2D);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryBindTexture2D);
+    }
+}
+
+
+void deleteTexture2D(GLuint texture) {
+
+    if (texture == 0) {
+        return;
     }
-    
+
+    // Invalidate the bindings cached by every context before the name can be
+    // reused (this context's own included).
+    atomic_fetch_add_explicit(&textureDeletionCount, 1, memory_order_release);
+
+    glDispatch.deleteTextures(1, &texture);
 }
 
 
-void bindVertexBufferObject_BG(GLuint vbo) {
+void bindVertexBufferObject(GLuint vbo) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.bindBuffer(GL_ARRAY_BUFFER, vbo);
+        return;
+    }
+
+    contextValidateBuffers(info);
 
-    ContextInfo* info = &backgroundContextInfo;
-    
     if(vbo != info->currentVBO){
         // Set
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        
+        glDispatch.bindBuffer(GL_ARRAY_BUFFER, vbo);
+
         // Cache
         info->currentVBO = vbo;
+
+        contextCountMiss(info, GLCacheEntryBindVertexBufferObject);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryBindVertexBufferObject);
     }
 }
 
 
-void bindIndexBufferObject_BG(GLuint ibo) {
+void bindIndexBufferObject(GLuint ibo) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        return;
+    }
+
+    contextValidateBuffers(info);
 
-    ContextInfo* info = &backgroundContextInfo;
-    
     if(ibo != info->currentIBO){
         // Set
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        
+        glDispatch.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
         // Cache
         info->currentIBO = ibo;
+
+        contextCountMiss(info, GLCacheEntryBindIndexBufferObject);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryBindIndexBufferObject);
+    }
+}
+
+
+void deleteBufferObject(GLuint buffer) {
+
+    if (buffer == 0) {
+        return;
     }
+
+    // Buffers are shared like textures: invalidate the bindings cached by
+    // every context before the name can be reused.
+    atomic_fetch_add_explicit(&bufferDeletionCount, 1, memory_order_release);
+
+    glDispatch.deleteBuffers(1, &buffer);
 }
 
 
-void bindVertexArrayObject_BG(GLuint vao) {
+void bindVertexArrayObject(GLuint vao) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.bindVertexArray(vao);
+        return;
+    }
 
-    ContextInfo* info = &backgroundContextInfo;
-    
     if (vao != info->currentVAO) {
-        // Set
+        // Set new value:
         //glBindVertexArrayOES(vao);
-        glBindVertexArray(vao);
-        
-        // Cache
+        glDispatch.bindVertexArray(vao);
+
+        // Cache it to keep in sync
         info->currentVAO = vao;
+
+        contextCountMiss(info, GLCacheEntryBindVertexArrayObject);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryBindVertexArrayObject);
+    }
+}
+
+
+void deleteVertexArrayObject(GLuint vao) {
+
+    if (vao == 0) {
+        return;
+    }
+
+    GLCacheContext* info = currentContext;
+
+    if (info && info->currentVAO == vao) {
+        // (Vertex arrays are not shared.) Deleting the bound one reverts to
+        // the default, whose element array binding we know nothing about:
+        info->currentVAO = 0;
+        info->currentIBO = UnknownName;
+    }
+
+    glDispatch.deleteVertexArrays(1, &vao);
+}
+
+
+void clearColor(Color4f newColor) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.clearColor(newColor.r, newColor.g, newColor.b, newColor.a);
+        return;
+    }
+
+    Color4f currentColor = (info->clearColor);
+
+    if (currentColor.r != newColor.r || currentColor.g != newColor.g || currentColor.b != newColor.b || currentColor.a != newColor.a){
+        // Set
+        glDispatch.clearColor(newColor.r, newColor.g, newColor.b, newColor.a);
+
+        // Cache
+        info->clearColor = newColor;
+
+        contextCountMiss(info, GLCacheEntryClearColor);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryClearColor);
     }
-    
 }
 
 
-void uniform1f_BG(GLuint location, GLfloat scalar) {
+void clearColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    return clearColor(Color4fMake(red, green, blue, alpha));
+}
+
+
+void uniform1f(GLuint location, GLfloat scalar) {
+
+    ProgramUniforms* uniforms = currentUniformsForLocation(location);
+
+    if (!uniforms || !growUniformArray((void**)&(uniforms->scalars), &(uniforms->scalarCount), location, sizeof(GLfloat))) {
+        glDispatch.uniform1f(location, scalar);
+        return;
+    }
+
+    GLfloat s = uniforms->scalars[location];
 
-    ContextInfo* info = &backgroundContextInfo;
-    GLuint program = info->currentProgram;
-    GLfloat s = info->scalars[program][location];
-    
     if (s != scalar) {
         // Set
-        glUniform1f(location, scalar);
-        
+        glDispatch.uniform1f(location, scalar);
+
         // Cache
-        info->scalars[program][location] = scalar;
+        uniforms->scalars[location] = scalar;
+
+        contextCountMiss(currentContext, GLCacheEntryUniform1f);
+    }
+    else {
+        contextCountHit(currentContext, GLCacheEntryUniform1f);
     }
 }
 
 
-void uniform2fv_BG(GLuint location, GLfloat* vector) {
+void uniform2fv(GLuint location, GLfloat* vector) {
+
+    ProgramUniforms* uniforms = currentUniformsForLocation(location);
+
+    if (!uniforms || !growUniformArray((void**)&(uniforms->vector2f), &(uniforms->vector2fCount), location, sizeof(Vector2f))) {
+        glDispatch.uniform2fv(location, 1, vector);
+        return;
+    }
+
+    Vector2f v = uniforms->vector2f[location];
 
-    ContextInfo* info = &backgroundContextInfo;
-    GLuint program = info->currentProgram;
-    Vector2f v = info->vector2f[program][location];
-	
     if(vector[0] != v.x || vector[1] != v.y){
-        
+
         // Set
-        glUniform2fv(location, 1, vector);
-        
+        glDispatch.uniform2fv(location, 1, vector);
+
         // Cache
-        info->vector2f[program][location].x = vector[0];
-		info->vector2f[program][location].y = vector[1];
+        uniforms->vector2f[location].x = vector[0];
+		uniforms->vector2f[location].y = vector[1];
+
+        contextCountMiss(currentContext, GLCacheEntryUniform2fv);
+    }
+    else {
+        contextCountHit(currentContext, GLCacheEntryUniform2fv);
     }
 }
 
 
-void uniform3fv_BG(GLuint location, GLfloat* vector) {
+void uniform3fv(GLuint location, GLfloat* vector) {
+
+    ProgramUniforms* uniforms = currentUniformsForLocation(location);
+
+    if (!uniforms || !growUniformArray((void**)&(uniforms->vector3f), &(uniforms->vector3fCount), location, sizeof(Vector3f))) {
+        glDispatch.uniform3fv(location, 1, vector);
+        return;
+    }
+
+    Vector3f v = uniforms->vector3f[location];
 
-    ContextInfo* info = &backgroundContextInfo;
-    GLuint program = info->currentProgram;
-    Vector3f v = info->vector3f[program][location];
-	
     if(vector[0] != v.x || vector[1] != v.y || vector[2] != v.z){
         // Set
-        glUniform3fv(location, 1, vector);
-        
+        glDispatch.uniform3fv(location, 1, vector);
+
         // Cache
-        info->vector3f[program][location].x = vector[0];
-		info->vector3f[program][location].y = vector[1];
-		info->vector3f[program][location].z = vector[2];
+        uniforms->vector3f[location].x = vector[0];
+		uniforms->vector3f[location].y = vector[1];
+		uniforms->vector3f[location].z = vector[2];
+
+        contextCountMiss(currentContext, GLCacheEntryUniform3fv);
+    }
+    else {
+        contextCountHit(currentContext, GLCacheEntryUniform3fv);
     }
 }
 
 
-void uniform4fv_BG(GLuint location, GLfloat* vector) {
+void uniform4fv(GLuint location, GLfloat* vector) {
+
+    ProgramUniforms* uniforms = currentUniformsForLocation(location);
+
+    if (!uniforms || !growUniformArray((void**)&(uniforms->vector4f), &(uniforms->vector4fCount), location, sizeof(Vector4f))) {
+        glDispatch.uniform4fv(location, 1, vector);
+        return;
+    }
+
+    Vector4f v = uniforms->vector4f[location];
 
-    ContextInfo* info = &backgroundContextInfo;
-    GLuint program = info->currentProgram;
-    Vector4f v = info->vector4f[program][location];
-	
     if(vector[0] != v.x || vector[1] != v.y || vector[2] != v.z || vector[3] != v.w){
         // Set
-        glUniform4fv(location, 1, vector);
-        
+        glDispatch.uniform4fv(location, 1, vector);
+
         // Cache
-        info->vector4f[program][location].x = vector[0];
-		info->vector4f[program][location].y = vector[1];
-		info->vector4f[program][location].z = vector[2];
-		info->vector4f[program][location].w = vector[3];
+        uniforms->vector4f[location].x = vector[0];
+		uniforms->vector4f[location].y = vector[1];
+		uniforms->vector4f[location].z = vector[2];
+		uniforms->vector4f[location].w = vector[3];
+
+        contextCountMiss(currentContext, GLCacheEntryUniform4fv);
+    }
+    else {
+        contextCountHit(currentContext, GLCacheEntryUniform4fv);
     }
 }
 
 
-void useProgram_BG(GLuint program) {
+void useProgram(GLuint program) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.useProgram(program);
+        return;
+    }
 
-    ContextInfo* info = &backgroundContextInfo;
-    
     if(program != info->currentProgram){
-        
-        glUseProgram(program);
+        // Set
+        glDispatch.useProgram(program);
+
+        // Cache
         info->currentProgram = program;
+
+        // (Looked up only on program change; uniform calls index directly)
+        info->currentUniforms = (program != 0) ? contextUniformsForProgram(info, program) : NULL;
+
+        contextCountMiss(info, GLCacheEntryUseProgram);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryUseProgram);
     }
 }
 
 
+void deleteProgram(GLuint program) {
+
+    GLCacheContext* info = currentContext;
+
+    if (info && program != 0) {
+
+        // Drop the program's uniform cache (the name can be reused by a new
+        // program, whose uniforms start over)
+        for (GLuint i = 0; i < info->programCount; i++) {
+            ProgramUniforms* uniforms = &(info->programs[i]);
+
+            if (uniforms->name != program) {
+                continue;
+            }
+
+            free(uniforms->scalars);
+            free(uniforms->vector2f);
+            free(uniforms->vector3f);
+            free(uniforms->vector4f);
+
+            // Keep the array dense (the moved entry's address changes)
+            info->programs[i] = info->programs[--(info->programCount)];
+            break;
+        }
+
+        if (info->currentProgram == program) {
+            // (Stays in use until another program is installed)
+            info->currentProgram = UnknownName;
+        }
+
+        info->currentUniforms = NULL;
+
+        if (info->currentProgram != UnknownName && info->currentProgram != 0) {
+            info->currentUniforms = contextUniformsForProgram(info, info->currentProgram);
+        }
+    }
+
+    glDispatch.deleteProgram(program);
+}
+
+
 // Framebuffer
-void bindFramebuffer_BG(GLuint framebuffer) {
+void bindFramebuffer(GLuint framebuffer) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        return;
+    }
 
-    ContextInfo* info = &backgroundContextInfo;
-    
     if(framebuffer != info->currentFramebuffer){
-        
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        // Set
+        glDispatch.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+        // Cache
         info->currentFramebuffer = framebuffer;
+
+        contextCountMiss(info, GLCacheEntryBindFramebuffer);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryBindFramebuffer);
     }
 }
 
 
-void bindRenderbuffer_BG(GLuint renderbuffer) {
+void bindRenderbuffer(GLuint renderbuffer) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.bindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        return;
+    }
 
-    ContextInfo* info = &backgroundContextInfo;
-    
     if(renderbuffer != info->currentRenderbuffer){
-        
-        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        // Set
+        glDispatch.bindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+
+        // Cache
         info->currentRenderbuffer = renderbuffer;
+
+        contextCountMiss(info, GLCacheEntryBindRenderbuffer);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryBindRenderbuffer);
     }
 }
 
 
-void attachTexture2D_BG(GLuint texture) {
+void attachTexture2D(GLuint texture) {
+
+    GLCacheContext* info = currentContext;
+
+    if (!info) {
+        glDispatch.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        return;
+    }
+
+    contextValidateTextures(info);
 
-    ContextInfo* info = &backgroundContextInfo;
-    
 	if(texture != info->currentTransTexture){
         // Set
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-        
+		glDispatch.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
 		// Cache
 		info->currentTransTexture = texture;
-	}
-}
 
+        contextCountMiss(info, GLCacheEntryAttachTexture2D);
+    }
+    else {
+        contextCountHit(info, GLCacheEntryAttachTexture2D);
+    }
+}
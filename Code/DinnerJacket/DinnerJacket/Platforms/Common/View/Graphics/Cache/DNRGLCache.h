@@ -11,14 +11,159 @@
 
 #include "DNRBase.h"
 
-// MAIN CONTEXT
+
+/*
+ State cache: the functions below issue the OpenGL call only when it actually
+ changes the state of the current context.
+
+ One cache is kept per OpenGL context, and each thread has its own "current"
+ cache. Whenever a thread makes an OpenGL context current, it must also call
+ glCacheMakeCurrent() with that same context (e.g., the EAGLContext or
+ NSOpenGLContext, bridged to a pointer); any number of threads can then use
+ the functions safely, each on its own context. Threads that have no current
+ cache get the calls passed straight to OpenGL (uncached).
+ */
+typedef struct tGLCacheContext GLCacheContext;
+
+
+// Context
+
+/**
+ Makes the cache of the OpenGL context glContext (created on first use)
+ current on the calling thread. Pass NULL to leave the thread without a cache.
+ Returns the cache, or NULL.
+ */
+GLCacheContext* glCacheMakeCurrent(const void* glContext);
+
+/**
+ Returns the calling thread's current cache, or NULL.
+ */
+GLCacheContext* glCacheCurrentContext(void);
+
+/**
+ Returns the OpenGL context whose cache is current on the calling thread (as
+ passed to glCacheMakeCurrent()), or NULL. E.g., to make it current again
+ after temporarily switching contexts.
+ */
+const void* glCacheCurrentGLContext(void);
+
+/**
+ Forgets the cached state of the current context, so that the next call to
+ each function is issued unconditionally. Call after modifying the state with
+ direct OpenGL calls (e.g., third-party code).
+ */
+void glCacheInvalidate(void);
+
+/**
+ Destroys the cache of glContext. Call when destroying the OpenGL context
+ (i.e., when no thread can have it current anymore).
+ */
+void glCacheContextRemove(const void* glContext);
+
+
+// Statistics
+
+/*
+ Hit (call elided) and miss (call issued) counts of each cached function, kept
+ per context. Compiled in when DNR_GLCACHE_STATS is nonzero: by default in
+ DEBUG builds only; define it (e.g., DNR_GLCACHE_STATS=1 in the preprocessor
+ macros) for profiling release builds, or as 0 to leave it out of debug ones.
+ When compiled out, the functions below do nothing and report zeros.
+
+ Calls that bypass the cache (no current cache, uniform location -1, no
+ program in use) are not counted.
+ */
+#ifndef DNR_GLCACHE_STATS
+#ifdef DEBUG
+#define DNR_GLCACHE_STATS   1
+#else
+#define DNR_GLCACHE_STATS   0
+#endif
+#endif
+
+
+/**
+ */
+typedef enum {
+
+    GLCacheEntryViewPort = 0,
+    GLCacheEntryBindTexture2D,
+    GLCacheEntryBindVertexBufferObject,
+    GLCacheEntryBindIndexBufferObject,
+    GLCacheEntryBindVertexArrayObject,
+    GLCacheEntryClearColor,
+    GLCacheEntryUniform1f,
+    GLCacheEntryUniform2fv,
+    GLCacheEntryUniform3fv,
+    GLCacheEntryUniform4fv,
+    GLCacheEntryUseProgram,
+    GLCacheEntryBindFramebuffer,
+    GLCacheEntryBindRenderbuffer,
+    GLCacheEntryAttachTexture2D,
+
+    GLCacheEntryCount
+
+}GLCacheEntry;
+
+
+/**
+ */
+typedef struct tGLCacheCounts {
+
+    uint64_t    hits;
+    uint64_t    misses;
+
+}GLCacheCounts;
+
+
+/**
+ Snapshot of the counts of one context.
+ */
+typedef struct tGLCacheStats {
+
+    GLCacheCounts   entries[GLCacheEntryCount];
+    GLCacheCounts   total;                      // Sum of all entries
+
+}GLCacheStats;
+
+
+/**
+ Closes the current context's frame: its counts become those of the last
+ frame, and are added to the cumulative ones. Called by DNRSceneController
+ once per tick.
+ */
+void glCacheEndFrame(void);
+
+/**
+ Counts of the current context's last complete frame.
+ */
+GLCacheStats glCacheFrameStats(void);
+
+/**
+ Counts of the current context since it was created (or reset), complete
+ frames only.
+ */
+GLCacheStats glCacheCumulativeStats(void);
+
+/**
+ Zeroes the current context's counts.
+ */
+void glCacheResetStats(void);
+
+/**
+ */
+const char* glCacheEntryName(GLCacheEntry entry);
+
 
 // General
 void viewPort(GLint x, GLint y, GLsizei width, GLsizei height);
 void bindTexture2D(GLuint texture);
+void deleteTexture2D(GLuint texture);
 void bindVertexBufferObject(GLuint vbo);
 void bindIndexBufferObject(GLuint ibo);
+void deleteBufferObject(GLuint buffer);
 void bindVertexArrayObject(GLuint vao);
+void deleteVertexArrayObject(GLuint vao);
 void clearColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
 void clearColor(Color4f newColor);
 
@@ -28,33 +173,11 @@ void uniform2fv(GLuint location, GLfloat* vector);
 void uniform3fv(GLuint location, GLfloat* vector);
 void uniform4fv(GLuint location, GLfloat* vector);
 void useProgram(GLuint program);
+void deleteProgram(GLuint program);
 
 // Framebuffer
 void bindFramebuffer(GLuint framebuffer);
 void bindRenderbuffer(GLuint renderbuffer);
 void attachTexture2D(GLuint texture);
 
-// BACKGROUND CONTEXT
-
-// General
-void viewPort_BG(GLint x, GLint y, GLsizei width, GLsizei height);
-void bindTexture2D_BG(GLuint texture);
-void bindVertexBufferObject_BG(GLuint vbo);
-void bindIndexBufferObject_BG(GLuint ibo);
-void bindVertexArrayObject_BG(GLuint vao);
-void clearColor4f_BG(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
-void clearColor_BG(Color4f newColor);
-
-// Shader
-void uniform1f_BG(GLuint location, GLfloat scalar);
-void uniform2fv_BG(GLuint location, GLfloat* vector);
-void uniform3fv_BG(GLuint location, GLfloat* vector);
-void uniform4fv_BG(GLuint location, GLfloat* vector);
-void useProgram_BG(GLuint program);
-
-// Framebuffer
-void bindFramebuffer_BG(GLuint framebuffer);
-void bindRenderbuffer_BG(GLuint renderbuffer);
-void attachTexture2D_BG(GLuint texture);
-
 #endif  // #defined (__DNROpenGLESCache_h__)
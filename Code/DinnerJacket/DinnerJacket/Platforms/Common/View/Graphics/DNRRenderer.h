@@ -11,6 +11,8 @@
 
 #import "Types.h"
 
+#import "DNRSpriteBatch.h"
+
 /**
  */
 @protocol DNRRenderer <NSObject>
@@ -29,6 +31,16 @@
 /// In points?
 @property (nonatomic, readwrite) CGPoint scrollOffset;
 
+/// The region of the world that is currently visible on screen, in pixels (the
+/// coordinate system of node world transforms), given the current zoomScale
+/// and scrollOffset. Nodes entirely outside of it are culled.
+@property (nonatomic, readonly) CGRect visibleRect;
+
+
+/// Collects the quads of all sprites drawn in a pass and submits them with one
+/// draw call per run of identical texture/program/blending state.
+@property (nonatomic, readonly) SpriteBatch* spriteBatch;
+
 
 // Static Frame
 
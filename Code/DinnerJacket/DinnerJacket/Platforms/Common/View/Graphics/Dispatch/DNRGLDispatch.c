@@ -0,0 +1,430 @@
+//
+//  DNRGLDispatch.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-06.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include "DNRGLDispatch.h"
+
+
+static GLDispatchCounters counters = { 0 };
+
+
+#pragma mark - Native Backend
+
+
+#ifdef DNRPlatformPhone
+#define nativeDiscardFramebuffer    glDiscardFramebufferEXT
+#else
+// (Not available in OpenGL 3.2; it is only a hint, anyway)
+static void nativeDiscardFramebuffer(GLenum target, GLsizei count, const GLenum* attachments) {
+    (void)target; (void)count; (void)attachments;
+}
+#endif
+
+
+// (Used twice: a const object is not a constant expression in C)
+#define NativeBackendInitializer {                                \
+                                                                  \
+    .viewport                   = glViewport,                     \
+    .scissor                    = glScissor,                      \
+    .clearColor                 = glClearColor,                   \
+    .clear                      = glClear,                        \
+    .enable                     = glEnable,                       \
+    .disable                    = glDisable,                      \
+    .blendFunc                  = glBlendFunc,                    \
+                                                                  \
+    .genTextures                = glGenTextures,                  \
+    .deleteTextures             = glDeleteTextures,               \
+    .bindTexture                = glBindTexture,                  \
+    .texImage2D                 = glTexImage2D,                   \
+    .texSubImage2D              = glTexSubImage2D,                \
+    .compressedTexImage2D       = glCompressedTexImage2D,         \
+    .texParameteri              = glTexParameteri,                \
+                                                                  \
+    .genBuffers                 = glGenBuffers,                   \
+    .deleteBuffers              = glDeleteBuffers,                \
+    .bindBuffer                 = glBindBuffer,                   \
+    .bufferData                 = glBufferData,                   \
+    .bufferSubData              = glBufferSubData,                \
+                                                                  \
+    .genVertexArrays            = glGenVertexArrays,              \
+    .deleteVertexArrays         = glDeleteVertexArrays,           \
+    .bindVertexArray            = glBindVertexArray,              \
+    .enableVertexAttribArray    = glEnableVertexAttribArray,      \
+    .disableVertexAttribArray   = glDisableVertexAttribArray,     \
+    .vertexAttribPointer        = glVertexAttribPointer,          \
+    .getAttribLocation          = glGetAttribLocation,            \
+                                                                  \
+    .useProgram                 = glUseProgram,                   \
+    .deleteProgram              = glDeleteProgram,                \
+    .getUniformLocation         = glGetUniformLocation,           \
+    .uniform1i                  = glUniform1i,                    \
+    .uniform1f                  = glUniform1f,                    \
+    .uniform2fv                 = glUniform2fv,                   \
+    .uniform3fv                 = glUniform3fv,                   \
+    .uniform4fv                 = glUniform4fv,                   \
+    .uniformMatrix4fv           = glUniformMatrix4fv,             \
+                                                                  \
+    .drawArrays                 = glDrawArrays,                   \
+    .drawElements               = glDrawElements,                 \
+                                                                  \
+    .genFramebuffers            = glGenFramebuffers,              \
+    .deleteFramebuffers         = glDeleteFramebuffers,           \
+    .bindFramebuffer            = glBindFramebuffer,              \
+    .framebufferTexture2D       = glFramebufferTexture2D,         \
+    .checkFramebufferStatus     = glCheckFramebufferStatus,       \
+    .genRenderbuffers           = glGenRenderbuffers,             \
+    .deleteRenderbuffers        = glDeleteRenderbuffers,          \
+    .bindRenderbuffer           = glBindRenderbuffer,             \
+    .renderbufferStorage        = glRenderbufferStorage,          \
+    .framebufferRenderbuffer    = glFramebufferRenderbuffer,      \
+    .getRenderbufferParameteriv = glGetRenderbufferParameteriv,   \
+                                                                  \
+    .discardFramebuffer         = nativeDiscardFramebuffer,       \
+}
+
+
+static const GLDispatch nativeBackend = NativeBackendInitializer;
+
+
+GLDispatch glDispatch = NativeBackendInitializer;
+
+
+const GLDispatch* glDispatchNativeBackend(void) {
+    return &nativeBackend;
+}
+
+
+#pragma mark - Null Backend
+
+
+static GLuint nullNextName     = 1;
+static GLint  nullNextLocation = 0;
+
+
+static void nullGenNames(GLsizei count, GLuint* names) {
+
+    glDispatchCountCall();
+
+    for (GLsizei i = 0; i < count; i++) {
+        names[i] = nullNextName++;
+    }
+}
+
+static void nullDeleteNames(GLsizei count, const GLuint* names) {
+    (void)count; (void)names;
+    glDispatchCountCall();
+}
+
+static GLint nullGetLocation(GLuint program, const GLchar* name) {
+    (void)program; (void)name;
+    glDispatchCountCall();
+    return nullNextLocation++;
+}
+
+
+static void nullViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    (void)x; (void)y; (void)width; (void)height;
+    glDispatchCountStateChange();
+}
+
+static void nullScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    (void)x; (void)y; (void)width; (void)height;
+    glDispatchCountStateChange();
+}
+
+static void nullClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    (void)red; (void)green; (void)blue; (void)alpha;
+    glDispatchCountStateChange();
+}
+
+static void nullClear(GLbitfield mask) {
+    (void)mask;
+    glDispatchCountCall();
+}
+
+static void nullCapability(GLenum capability) {
+    (void)capability;
+    glDispatchCountStateChange();
+}
+
+static void nullBlendFunc(GLenum sourceFactor, GLenum destinationFactor) {
+    (void)sourceFactor; (void)destinationFactor;
+    glDispatchCountStateChange();
+}
+
+static void nullBind(GLenum target, GLuint name) {
+    (void)target; (void)name;
+    glDispatchCountStateChange();
+}
+
+static void nullTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels) {
+    (void)target; (void)level; (void)internalFormat; (void)border;
+    glDispatchCountUpload(pixels ? glDispatchPixelDataSize(width, height, format, type) : 0);
+}
+
+static void nullTexSubImage2D(GLenum target, GLint level, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels) {
+    (void)target; (void)level; (void)xOffset; (void)yOffset; (void)pixels;
+    glDispatchCountUpload(glDispatchPixelDataSize(width, height, format, type));
+}
+
+static void nullCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data) {
+    (void)target; (void)level; (void)internalFormat; (void)width; (void)height; (void)border;
+    glDispatchCountUpload(data ? (size_t)imageSize : 0);
+}
+
+static void nullTexParameteri(GLenum target, GLenum parameter, GLint value) {
+    (void)target; (void)parameter; (void)value;
+    glDispatchCountStateChange();
+}
+
+static void nullBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage) {
+    (void)target; (void)usage;
+    glDispatchCountUpload(data ? (size_t)size : 0);
+}
+
+static void nullBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data) {
+    (void)target; (void)offset; (void)data;
+    glDispatchCountUpload((size_t)size);
+}
+
+static void nullBindName(GLuint name) {
+    (void)name;
+    glDispatchCountStateChange();
+}
+
+static void nullVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer) {
+    (void)index; (void)size; (void)type; (void)normalized; (void)stride; (void)pointer;
+    glDispatchCountStateChange();
+}
+
+static void nullDeleteProgram(GLuint program) {
+    (void)program;
+    glDispatchCountCall();
+}
+
+static void nullUniform1i(GLint location, GLint value) {
+    (void)location; (void)value;
+    glDispatchCountStateChange();
+}
+
+static void nullUniform1f(GLint location, GLfloat value) {
+    (void)location; (void)value;
+    glDispatchCountStateChange();
+}
+
+static void nullUniformfv(GLint location, GLsizei count, const GLfloat* value) {
+    (void)location; (void)count; (void)value;
+    glDispatchCountStateChange();
+}
+
+static void nullUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    (void)location; (void)count; (void)transpose; (void)value;
+    glDispatchCountStateChange();
+}
+
+static void nullDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    (void)mode; (void)first;
+    glDispatchCountDraw(count);
+}
+
+static void nullDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices) {
+    (void)mode; (void)type; (void)indices;
+    glDispatchCountDraw(count);
+}
+
+static void nullFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level) {
+    (void)target; (void)attachment; (void)textureTarget; (void)texture; (void)level;
+    glDispatchCountStateChange();
+}
+
+static GLenum nullCheckFramebufferStatus(GLenum target) {
+    (void)target;
+    glDispatchCountCall();
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void nullRenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height) {
+    (void)target; (void)internalFormat; (void)width; (void)height;
+    glDispatchCountCall();
+}
+
+static void nullFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer) {
+    (void)target; (void)attachment; (void)renderbufferTarget; (void)renderbuffer;
+    glDispatchCountStateChange();
+}
+
+static void nullGetRenderbufferParameteriv(GLenum target, GLenum parameter, GLint* value) {
+    (void)target; (void)parameter;
+    glDispatchCountCall();
+    *value = 0;
+}
+
+static void nullDiscardFramebuffer(GLenum target, GLsizei count, const GLenum* attachments) {
+    (void)target; (void)count; (void)attachments;
+    glDispatchCountCall();
+}
+
+
+static const GLDispatch nullBackend = {
+
+    .viewport                   = nullViewport,
+    .scissor                    = nullScissor,
+    .clearColor                 = nullClearColor,
+    .clear                      = nullClear,
+    .enable                     = nullCapability,
+    .disable                    = nullCapability,
+    .blendFunc                  = nullBlendFunc,
+
+    .genTextures                = nullGenNames,
+    .deleteTextures             = nullDeleteNames,
+    .bindTexture                = nullBind,
+    .texImage2D                 = nullTexImage2D,
+    .texSubImage2D              = nullTexSubImage2D,
+    .compressedTexImage2D       = nullCompressedTexImage2D,
+    .texParameteri              = nullTexParameteri,
+
+    .genBuffers                 = nullGenNames,
+    .deleteBuffers              = nullDeleteNames,
+    .bindBuffer                 = nullBind,
+    .bufferData                 = nullBufferData,
+    .bufferSubData              = nullBufferSubData,
+
+    .genVertexArrays            = nullGenNames,
+    .deleteVertexArrays         = nullDeleteNames,
+    .bindVertexArray            = nullBindName,
+    .enableVertexAttribArray    = nullBindName,
+    .disableVertexAttribArray   = nullBindName,
+    .vertexAttribPointer        = nullVertexAttribPointer,
+    .getAttribLocation          = nullGetLocation,
+
+    .useProgram                 = nullBindName,
+    .deleteProgram              = nullDeleteProgram,
+    .getUniformLocation         = nullGetLocation,
+    .uniform1i                  = nullUniform1i,
+    .uniform1f                  = nullUniform1f,
+    .uniform2fv                 = nullUniformfv,
+    .uniform3fv                 = nullUniformfv,
+    .uniform4fv                 = nullUniformfv,
+    .uniformMatrix4fv           = nullUniformMatrix4fv,
+
+    .drawArrays                 = nullDrawArrays,
+    .drawElements               = nullDrawElements,
+
+    .genFramebuffers            = nullGenNames,
+    .deleteFramebuffers         = nullDeleteNames,
+    .bindFramebuffer            = nullBind,
+    .framebufferTexture2D       = nullFramebufferTexture2D,
+    .checkFramebufferStatus     = nullCheckFramebufferStatus,
+    .genRenderbuffers           = nullGenNames,
+    .deleteRenderbuffers        = nullDeleteNames,
+    .bindRenderbuffer           = nullBind,
+    .renderbufferStorage        = nullRenderbufferStorage,
+    .framebufferRenderbuffer    = nullFramebufferRenderbuffer,
+    .getRenderbufferParameteriv = nullGetRenderbufferParameteriv,
+
+    .discardFramebuffer         = nullDiscardFramebuffer,
+};
+
+
+const GLDispatch* glDispatchNullBackend(void) {
+    return &nullBackend;
+}
+
+
+#pragma mark - Operation
+
+
+void glDispatchSetBackend(const GLDispatch* backend) {
+
+    glDispatch = backend ? *backend : nativeBackend;
+}
+
+
+GLDispatchCounters glDispatchCounters(void) {
+    return counters;
+}
+
+
+void glDispatchResetCounters(void) {
+    counters = (GLDispatchCounters){ 0 };
+}
+
+
+void glDispatchCountCall(void) {
+    counters.calls++;
+}
+
+
+void glDispatchCountStateChange(void) {
+    counters.calls++;
+    counters.stateChanges++;
+}
+
+
+void glDispatchCountDraw(GLsizei elementCount) {
+    counters.calls++;
+    counters.drawCalls++;
+    counters.elementCount += (uint64_t)elementCount;
+}
+
+
+void glDispatchCountUpload(size_t byteCount) {
+    counters.calls++;
+    counters.bytesUploaded += byteCount;
+}
+
+
+static size_t pixelSize(GLenum format, GLenum type) {
+
+    size_t components;
+
+    switch (format) {
+        case GL_RGBA:               components = 4; break;
+        case GL_RGB:                components = 3; break;
+#ifdef GL_LUMINANCE_ALPHA   // (Not in the core profile)
+        case GL_LUMINANCE_ALPHA:    components = 2; break;
+#endif
+        default:                    components = 1; break;     // GL_ALPHA, GL_LUMINANCE, GL_RED
+    }
+
+    switch (type) {
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+        case GL_UNSIGNED_SHORT_5_6_5:
+            return 2;
+
+        case GL_FLOAT:
+            return 4*components;
+
+        default:    // GL_UNSIGNED_BYTE
+            return components;
+    }
+}
+
+
+size_t glDispatchPixelRowSize(GLsizei width, GLenum format, GLenum type) {
+
+    if (width <= 0) {
+        return 0;
+    }
+
+    size_t alignment = GLDispatchUnpackAlignment;
+    size_t size      = (size_t)width * pixelSize(format, type);
+
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+
+size_t glDispatchPixelDataSize(GLsizei width, GLsizei height, GLenum format, GLenum type) {
+
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+
+    // (The last row is not padded)
+    return glDispatchPixelRowSize(width, format, type) * (size_t)(height - 1) + (size_t)width * pixelSize(format, type);
+}
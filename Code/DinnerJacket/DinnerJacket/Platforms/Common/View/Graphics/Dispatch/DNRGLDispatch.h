@@ -0,0 +1,197 @@
+//
+//  DNRGLDispatch.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-06.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRGLDispatch_h__
+#define __DNRGLDispatch_h__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "DNRBase.h"
+
+
+/*
+ The rendering code (state cache, sprite batch, sprites, tile map layers,
+ textures and renderers) calls OpenGL through the table glDispatch instead of directly, e.g.:
+
+    glDispatch.drawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, offset);
+
+ By default the table holds the native OpenGL functions (one indirect call of
+ overhead). It can be replaced with a different backend:
+
+   - Null: no OpenGL at all; calls are only counted (see GLDispatchCounters).
+     Names returned by glGen*() and locations are sequential, framebuffers
+     are always complete and renderbuffers report zero size. Lets the engine
+     run headless (e.g., CPU benchmarks on machines without a GPU).
+
+   - Recording: see DNRGLRecorder.h.
+
+   - Software: see DNRSoftwareRasterizer.h.
+
+ Backends are meant to be swapped while no OpenGL work is in flight (e.g., at
+ launch, or between frames on the main thread). The counters are not thread
+ safe; they reflect the main thread's work when nothing else is loading.
+ */
+
+
+/**
+ One entry per OpenGL function used by the rendering code; each has the exact
+ signature of the function it stands for (with the "gl" prefix dropped).
+ */
+typedef struct tGLDispatch {
+
+    // General state
+    void    (*viewport)(GLint x, GLint y, GLsizei width, GLsizei height);
+    void    (*scissor)(GLint x, GLint y, GLsizei width, GLsizei height);
+    void    (*clearColor)(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+    void    (*clear)(GLbitfield mask);
+    void    (*enable)(GLenum capability);
+    void    (*disable)(GLenum capability);
+    void    (*blendFunc)(GLenum sourceFactor, GLenum destinationFactor);
+
+    // Textures
+    void    (*genTextures)(GLsizei count, GLuint* textures);
+    void    (*deleteTextures)(GLsizei count, const GLuint* textures);
+    void    (*bindTexture)(GLenum target, GLuint texture);
+    void    (*texImage2D)(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels);
+    void    (*texSubImage2D)(GLenum target, GLint level, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels);
+    void    (*compressedTexImage2D)(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data);
+    void    (*texParameteri)(GLenum target, GLenum parameter, GLint value);
+
+    // Buffers
+    void    (*genBuffers)(GLsizei count, GLuint* buffers);
+    void    (*deleteBuffers)(GLsizei count, const GLuint* buffers);
+    void    (*bindBuffer)(GLenum target, GLuint buffer);
+    void    (*bufferData)(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage);
+    void    (*bufferSubData)(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data);
+
+    // Vertex arrays
+    void    (*genVertexArrays)(GLsizei count, GLuint* arrays);
+    void    (*deleteVertexArrays)(GLsizei count, const GLuint* arrays);
+    void    (*bindVertexArray)(GLuint array);
+    void    (*enableVertexAttribArray)(GLuint index);
+    void    (*disableVertexAttribArray)(GLuint index);
+    void    (*vertexAttribPointer)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer);
+    GLint   (*getAttribLocation)(GLuint program, const GLchar* name);
+
+    // Programs
+    void    (*useProgram)(GLuint program);
+    void    (*deleteProgram)(GLuint program);
+    GLint   (*getUniformLocation)(GLuint program, const GLchar* name);
+    void    (*uniform1i)(GLint location, GLint value);
+    void    (*uniform1f)(GLint location, GLfloat value);
+    void    (*uniform2fv)(GLint location, GLsizei count, const GLfloat* value);
+    void    (*uniform3fv)(GLint location, GLsizei count, const GLfloat* value);
+    void    (*uniform4fv)(GLint location, GLsizei count, const GLfloat* value);
+    void    (*uniformMatrix4fv)(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+
+    // Drawing
+    void    (*drawArrays)(GLenum mode, GLint first, GLsizei count);
+    void    (*drawElements)(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices);
+
+    // Framebuffers
+    void    (*genFramebuffers)(GLsizei count, GLuint* framebuffers);
+    void    (*deleteFramebuffers)(GLsizei count, const GLuint* framebuffers);
+    void    (*bindFramebuffer)(GLenum target, GLuint framebuffer);
+    void    (*framebufferTexture2D)(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level);
+    GLenum  (*checkFramebufferStatus)(GLenum target);
+    void    (*genRenderbuffers)(GLsizei count, GLuint* renderbuffers);
+    void    (*deleteRenderbuffers)(GLsizei count, const GLuint* renderbuffers);
+    void    (*bindRenderbuffer)(GLenum target, GLuint renderbuffer);
+    void    (*renderbufferStorage)(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height);
+    void    (*framebufferRenderbuffer)(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer);
+    void    (*getRenderbufferParameteriv)(GLenum target, GLenum parameter, GLint* value);
+
+    // glDiscardFramebufferEXT() on iOS; no-op where unavailable.
+    void    (*discardFramebuffer)(GLenum target, GLsizei count, const GLenum* attachments);
+
+}GLDispatch;
+
+
+/**
+ The table in use. Initially equal to *glDispatchNativeBackend().
+ */
+extern GLDispatch glDispatch;
+
+
+/**
+ Work counted by the null backend (also when it is the recorder's target). The
+ native backend counts nothing, to keep its overhead at one indirect call.
+ */
+typedef struct tGLDispatchCounters {
+
+    uint64_t    calls;              // Every call, of any kind
+    uint64_t    drawCalls;          // drawArrays, drawElements
+    uint64_t    elementCount;       // Vertices/indices drawn
+    uint64_t    stateChanges;       // Binds, enable/disable, blending, program,
+                                    // uniforms, viewport, scissor, clear color
+    uint64_t    bytesUploaded;      // Buffer and texture data
+
+}GLDispatchCounters;
+
+
+/**
+ Table that calls the native OpenGL functions.
+ */
+const GLDispatch* glDispatchNativeBackend(void);
+
+
+/**
+ Table that does no OpenGL work and only counts calls.
+ */
+const GLDispatch* glDispatchNullBackend(void);
+
+
+/**
+ Copies backend into glDispatch. Pass NULL to restore the native backend.
+ */
+void glDispatchSetBackend(const GLDispatch* backend);
+
+
+/**
+ Counts accumulated since the last reset.
+ */
+GLDispatchCounters glDispatchCounters(void);
+
+
+/**
+ */
+void glDispatchResetCounters(void);
+
+
+/**
+ For use by backends: each tallies one call (and, except for the first, what
+ kind of work it was).
+ */
+void glDispatchCountCall(void);
+void glDispatchCountStateChange(void);
+void glDispatchCountDraw(GLsizei elementCount);
+void glDispatchCountUpload(size_t byteCount);
+
+
+/**
+ Row alignment of the client pixel data passed to texImage2D() and
+ texSubImage2D(): the engine leaves GL_UNPACK_ALIGNMENT at its default (see
+ DNRTextureImageRowBytes()).
+ */
+#define GLDispatchUnpackAlignment   4u
+
+/**
+ Distance between the starts of successive rows of client pixel data (the
+ row's pixels, padded to GLDispatchUnpackAlignment).
+ */
+size_t glDispatchPixelRowSize(GLsizei width, GLenum format, GLenum type);
+
+/**
+ Size of the client data read by texImage2D() and texSubImage2D(): every row
+ but the last one padded to GLDispatchUnpackAlignment.
+ */
+size_t glDispatchPixelDataSize(GLsizei width, GLsizei height, GLenum format, GLenum type);
+
+
+#endif  // #defined (__DNRGLDispatch_h__)
@@ -0,0 +1,1622 @@
+//
+//  DNRGLRecorder.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-06.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "DNRGLRecorder.h"
+
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "The command stream is written in host byte order, which must be little endian"
+#endif
+
+
+#define RecorderSignature           "DNRGLREC"
+#define RecorderVersion             1u
+#define RecorderHeaderSize          16u
+
+// Recorded names above this are not remapped on replay (GL names are small,
+// consecutive integers in practice)
+#define MaxMappedName               (1u << 24)
+
+
+/**
+ Command opcodes. Values are part of the file format: append only.
+ */
+typedef enum {
+
+    OpFrame = 1,
+
+    OpViewport,
+    OpClearColor,
+    OpClear,
+    OpEnable,
+    OpDisable,
+    OpBlendFunc,
+
+    OpGenTextures,
+    OpDeleteTextures,
+    OpBindTexture,
+    OpTexImage2D,
+    OpTexParameteri,
+
+    OpGenBuffers,
+    OpDeleteBuffers,
+    OpBindBuffer,
+    OpBufferData,
+    OpBufferSubData,
+
+    OpGenVertexArrays,
+    OpDeleteVertexArrays,
+    OpBindVertexArray,
+    OpEnableVertexAttribArray,
+    OpDisableVertexAttribArray,
+    OpVertexAttribPointer,
+    OpGetAttribLocation,
+
+    OpUseProgram,
+    OpDeleteProgram,
+    OpGetUniformLocation,
+    OpUniform1i,
+    OpUniform1f,
+    OpUniform2fv,
+    OpUniform3fv,
+    OpUniform4fv,
+    OpUniformMatrix4fv,
+
+    OpDrawArrays,
+    OpDrawElements,
+
+    OpGenFramebuffers,
+    OpDeleteFramebuffers,
+    OpBindFramebuffer,
+    OpFramebufferTexture2D,
+    OpCheckFramebufferStatus,
+    OpGenRenderbuffers,
+    OpDeleteRenderbuffers,
+    OpBindRenderbuffer,
+    OpRenderbufferStorage,
+    OpFramebufferRenderbuffer,
+    OpGetRenderbufferParameteriv,
+
+    OpDiscardFramebuffer,
+
+    OpTexSubImage2D,
+    OpCompressedTexImage2D,
+
+    OpScissor,
+
+}GLRecorderOpcode;
+
+
+struct tGLRecorder {
+
+    uint8_t*    bytes;
+    size_t      size;
+    size_t      capacity;
+    int         failed;         // Ran out of memory; stream incomplete
+
+    GLDispatch  previousBackend;
+};
+
+
+static GLRecorder*  activeRecorder = NULL;
+static GLDispatch   target;
+
+
+#pragma mark - Writing
+
+
+static void recorderAppend(GLRecorder* recorder, const void* data, size_t size) {
+
+    if (recorder->failed) {
+        return;
+    }
+
+    if (recorder->size + size > recorder->capacity) {
+        size_t capacity = recorder->capacity ? recorder->capacity : 65536u;
+
+        while (capacity < recorder->size + size) {
+            capacity *= 2;
+        }
+
+        uint8_t* bytes = realloc(recorder->bytes, capacity);
+
+        if (!bytes) {
+            recorder->failed = 1;
+            return;
+        }
+        recorder->bytes    = bytes;
+        recorder->capacity = capacity;
+    }
+
+    memcpy(recorder->bytes + recorder->size, data, size);
+    recorder->size += size;
+}
+
+
+static void recorderAppendHeader(GLRecorder* recorder) {
+
+    uint32_t version  = RecorderVersion;
+    uint32_t reserved = 0;
+
+    recorderAppend(recorder, RecorderSignature, 8);
+    recorderAppend(recorder, &version,  4);
+    recorderAppend(recorder, &reserved, 4);
+}
+
+
+// (The emit functions write to the active recorder)
+
+static void emitOp(GLRecorderOpcode op) {
+    uint8_t value = (uint8_t)op;
+    recorderAppend(activeRecorder, &value, 1);
+}
+
+static void emitU8(uint8_t value) {
+    recorderAppend(activeRecorder, &value, 1);
+}
+
+static void emitU32(uint32_t value) {
+    recorderAppend(activeRecorder, &value, 4);
+}
+
+static void emitI32(int32_t value) {
+    recorderAppend(activeRecorder, &value, 4);
+}
+
+static void emitF32(GLfloat value) {
+    recorderAppend(activeRecorder, &value, 4);
+}
+
+static void emitU64(uint64_t value) {
+    recorderAppend(activeRecorder, &value, 8);
+}
+
+static void emitData(const void* data, size_t size) {
+    recorderAppend(activeRecorder, data, size);
+}
+
+static void emitString(const GLchar* string) {
+    uint32_t length = (uint32_t)strlen(string);
+    emitU32(length);
+    emitData(string, length);
+}
+
+static void emitFloats(const GLfloat* values, size_t count) {
+    emitData(values, count*sizeof(GLfloat));
+}
+
+
+#pragma mark - Recording Backend
+
+
+static void recordGenNames(GLRecorderOpcode op, GLsizei count, GLuint* names) {
+
+    emitOp(op);
+    emitI32(count);
+
+    for (GLsizei i = 0; i < count; i++) {
+        emitU32(names[i]);
+    }
+}
+
+static void recordDeleteNames(GLRecorderOpcode op, GLsizei count, const GLuint* names) {
+
+    emitOp(op);
+    emitI32(count);
+
+    for (GLsizei i = 0; i < count; i++) {
+        emitU32(names[i]);
+    }
+}
+
+
+static void recordViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    emitOp(OpViewport);
+    emitI32(x);
+    emitI32(y);
+    emitI32(width);
+    emitI32(height);
+    target.viewport(x, y, width, height);
+}
+
+static void recordScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    emitOp(OpScissor);
+    emitI32(x);
+    emitI32(y);
+    emitI32(width);
+    emitI32(height);
+    target.scissor(x, y, width, height);
+}
+
+static void recordClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    emitOp(OpClearColor);
+    emitF32(red);
+    emitF32(green);
+    emitF32(blue);
+    emitF32(alpha);
+    target.clearColor(red, green, blue, alpha);
+}
+
+static void recordClear(GLbitfield mask) {
+    emitOp(OpClear);
+    emitU32(mask);
+    target.clear(mask);
+}
+
+static void recordEnable(GLenum capability) {
+    emitOp(OpEnable);
+    emitU32(capability);
+    target.enable(capability);
+}
+
+static void recordDisable(GLenum capability) {
+    emitOp(OpDisable);
+    emitU32(capability);
+    target.disable(capability);
+}
+
+static void recordBlendFunc(GLenum sourceFactor, GLenum destinationFactor) {
+    emitOp(OpBlendFunc);
+    emitU32(sourceFactor);
+    emitU32(destinationFactor);
+    target.blendFunc(sourceFactor, destinationFactor);
+}
+
+
+static void recordGenTextures(GLsizei count, GLuint* textures) {
+    target.genTextures(count, textures);
+    recordGenNames(OpGenTextures, count, textures);
+}
+
+static void recordDeleteTextures(GLsizei count, const GLuint* textures) {
+    recordDeleteNames(OpDeleteTextures, count, textures);
+    target.deleteTextures(count, textures);
+}
+
+static void recordBindTexture(GLenum textureTarget, GLuint texture) {
+    emitOp(OpBindTexture);
+    emitU32(textureTarget);
+    emitU32(texture);
+    target.bindTexture(textureTarget, texture);
+}
+
+static void recordTexImage2D(GLenum textureTarget, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels) {
+    emitOp(OpTexImage2D);
+    emitU32(textureTarget);
+    emitI32(level);
+    emitI32(internalFormat);
+    emitI32(width);
+    emitI32(height);
+    emitI32(border);
+    emitU32(format);
+    emitU32(type);
+    emitU8(pixels != NULL);
+    if (pixels) {
+        size_t size = glDispatchPixelDataSize(width, height, format, type);
+        emitU64(size);
+        emitData(pixels, size);
+    }
+    target.texImage2D(textureTarget, level, internalFormat, width, height, border, format, type, pixels);
+}
+
+static void recordTexSubImage2D(GLenum textureTarget, GLint level, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels) {
+    emitOp(OpTexSubImage2D);
+    emitU32(textureTarget);
+    emitI32(level);
+    emitI32(xOffset);
+    emitI32(yOffset);
+    emitI32(width);
+    emitI32(height);
+    emitU32(format);
+    emitU32(type);
+    size_t size = glDispatchPixelDataSize(width, height, format, type);
+    emitU64(size);
+    emitData(pixels, size);
+    target.texSubImage2D(textureTarget, level, xOffset, yOffset, width, height, format, type, pixels);
+}
+
+static void recordCompressedTexImage2D(GLenum textureTarget, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data) {
+    emitOp(OpCompressedTexImage2D);
+    emitU32(textureTarget);
+    emitI32(level);
+    emitU32(internalFormat);
+    emitI32(width);
+    emitI32(height);
+    emitI32(border);
+    emitU8(data != NULL);
+    emitU64((uint64_t)imageSize);
+    if (data) {
+        emitData(data, (size_t)imageSize);
+    }
+    target.compressedTexImage2D(textureTarget, level, internalFormat, width, height, border, imageSize, data);
+}
+
+static void recordTexParameteri(GLenum textureTarget, GLenum parameter, GLint value) {
+    emitOp(OpTexParameteri);
+    emitU32(textureTarget);
+    emitU32(parameter);
+    emitI32(value);
+    target.texParameteri(textureTarget, parameter, value);
+}
+
+
+static void recordGenBuffers(GLsizei count, GLuint* buffers) {
+    target.genBuffers(count, buffers);
+    recordGenNames(OpGenBuffers, count, buffers);
+}
+
+static void recordDeleteBuffers(GLsizei count, const GLuint* buffers) {
+    recordDeleteNames(OpDeleteBuffers, count, buffers);
+    target.deleteBuffers(count, buffers);
+}
+
+static void recordBindBuffer(GLenum bufferTarget, GLuint buffer) {
+    emitOp(OpBindBuffer);
+    emitU32(bufferTarget);
+    emitU32(buffer);
+    target.bindBuffer(bufferTarget, buffer);
+}
+
+static void recordBufferData(GLenum bufferTarget, GLsizeiptr size, const GLvoid* data, GLenum usage) {
+    emitOp(OpBufferData);
+    emitU32(bufferTarget);
+    emitU32(usage);
+    emitU64((uint64_t)size);
+    emitU8(data != NULL);
+    if (data) {
+        emitData(data, (size_t)size);
+    }
+    target.bufferData(bufferTarget, size, data, usage);
+}
+
+static void recordBufferSubData(GLenum bufferTarget, GLintptr offset, GLsizeiptr size, const GLvoid* data) {
+    emitOp(OpBufferSubData);
+    emitU32(bufferTarget);
+    emitU64((uint64_t)offset);
+    emitU64((uint64_t)size);
+    emitData(data, (size_t)size);
+    target.bufferSubData(bufferTarget, offset, size, data);
+}
+
+
+static void recordGenVertexArrays(GLsizei count, GLuint* arrays) {
+    target.genVertexArrays(count, arrays);
+    recordGenNames(OpGenVertexArrays, count, arrays);
+}
+
+static void recordDeleteVertexArrays(GLsizei count, const GLuint* arrays) {
+    recordDeleteNames(OpDeleteVertexArrays, count, arrays);
+    target.deleteVertexArrays(count, arrays);
+}
+
+static void recordBindVertexArray(GLuint array) {
+    emitOp(OpBindVertexArray);
+    emitU32(array);
+    target.bindVertexArray(array);
+}
+
+static void recordEnableVertexAttribArray(GLuint index) {
+    emitOp(OpEnableVertexAttribArray);
+    emitU32(index);
+    target.enableVertexAttribArray(index);
+}
+
+static void recordDisableVertexAttribArray(GLuint index) {
+    emitOp(OpDisableVertexAttribArray);
+    emitU32(index);
+    target.disableVertexAttribArray(index);
+}
+
+static void recordVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer) {
+    emitOp(OpVertexAttribPointer);
+    emitU32(index);
+    emitI32(size);
+    emitU32(type);
+    emitU8(normalized);
+    emitI32(stride);
+    emitU64((uint64_t)(uintptr_t)pointer);
+    target.vertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+static GLint recordGetAttribLocation(GLuint program, const GLchar* name) {
+    GLint location = target.getAttribLocation(program, name);
+    emitOp(OpGetAttribLocation);
+    emitU32(program);
+    emitString(name);
+    emitI32(location);
+    return location;
+}
+
+
+static void recordUseProgram(GLuint program) {
+    emitOp(OpUseProgram);
+    emitU32(program);
+    target.useProgram(program);
+}
+
+static void recordDeleteProgram(GLuint program) {
+    emitOp(OpDeleteProgram);
+    emitU32(program);
+    target.deleteProgram(program);
+}
+
+static GLint recordGetUniformLocation(GLuint program, const GLchar* name) {
+    GLint location = target.getUniformLocation(program, name);
+    emitOp(OpGetUniformLocation);
+    emitU32(program);
+    emitString(name);
+    emitI32(location);
+    return location;
+}
+
+static void recordUniform1i(GLint location, GLint value) {
+    emitOp(OpUniform1i);
+    emitI32(location);
+    emitI32(value);
+    target.uniform1i(location, value);
+}
+
+static void recordUniform1f(GLint location, GLfloat value) {
+    emitOp(OpUniform1f);
+    emitI32(location);
+    emitF32(value);
+    target.uniform1f(location, value);
+}
+
+static void recordUniform2fv(GLint location, GLsizei count, const GLfloat* value) {
+    emitOp(OpUniform2fv);
+    emitI32(location);
+    emitI32(count);
+    emitFloats(value, 2*(size_t)count);
+    target.uniform2fv(location, count, value);
+}
+
+static void recordUniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+    emitOp(OpUniform3fv);
+    emitI32(location);
+    emitI32(count);
+    emitFloats(value, 3*(size_t)count);
+    target.uniform3fv(location, count, value);
+}
+
+static void recordUniform4fv(GLint location, GLsizei count, const GLfloat* value) {
+    emitOp(OpUniform4fv);
+    emitI32(location);
+    emitI32(count);
+    emitFloats(value, 4*(size_t)count);
+    target.uniform4fv(location, count, value);
+}
+
+static void recordUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    emitOp(OpUniformMatrix4fv);
+    emitI32(location);
+    emitI32(count);
+    emitU8(transpose);
+    emitFloats(value, 16*(size_t)count);
+    target.uniformMatrix4fv(location, count, transpose, value);
+}
+
+
+static void recordDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    emitOp(OpDrawArrays);
+    emitU32(mode);
+    emitI32(first);
+    emitI32(count);
+    target.drawArrays(mode, first, count);
+}
+
+static void recordDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices) {
+    emitOp(OpDrawElements);
+    emitU32(mode);
+    emitI32(count);
+    emitU32(type);
+    emitU64((uint64_t)(uintptr_t)indices);
+    target.drawElements(mode, count, type, indices);
+}
+
+
+static void recordGenFramebuffers(GLsizei count, GLuint* framebuffers) {
+    target.genFramebuffers(count, framebuffers);
+    recordGenNames(OpGenFramebuffers, count, framebuffers);
+}
+
+static void recordDeleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+    recordDeleteNames(OpDeleteFramebuffers, count, framebuffers);
+    target.deleteFramebuffers(count, framebuffers);
+}
+
+static void recordBindFramebuffer(GLenum framebufferTarget, GLuint framebuffer) {
+    emitOp(OpBindFramebuffer);
+    emitU32(framebufferTarget);
+    emitU32(framebuffer);
+    target.bindFramebuffer(framebufferTarget, framebuffer);
+}
+
+static void recordFramebufferTexture2D(GLenum framebufferTarget, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level) {
+    emitOp(OpFramebufferTexture2D);
+    emitU32(framebufferTarget);
+    emitU32(attachment);
+    emitU32(textureTarget);
+    emitU32(texture);
+    emitI32(level);
+    target.framebufferTexture2D(framebufferTarget, attachment, textureTarget, texture, level);
+}
+
+static GLenum recordCheckFramebufferStatus(GLenum framebufferTarget) {
+    emitOp(OpCheckFramebufferStatus);
+    emitU32(framebufferTarget);
+    return target.checkFramebufferStatus(framebufferTarget);
+}
+
+static void recordGenRenderbuffers(GLsizei count, GLuint* renderbuffers) {
+    target.genRenderbuffers(count, renderbuffers);
+    recordGenNames(OpGenRenderbuffers, count, renderbuffers);
+}
+
+static void recordDeleteRenderbuffers(GLsizei count, const GLuint* renderbuffers) {
+    recordDeleteNames(OpDeleteRenderbuffers, count, renderbuffers);
+    target.deleteRenderbuffers(count, renderbuffers);
+}
+
+static void recordBindRenderbuffer(GLenum renderbufferTarget, GLuint renderbuffer) {
+    emitOp(OpBindRenderbuffer);
+    emitU32(renderbufferTarget);
+    emitU32(renderbuffer);
+    target.bindRenderbuffer(renderbufferTarget, renderbuffer);
+}
+
+static void recordRenderbufferStorage(GLenum renderbufferTarget, GLenum internalFormat, GLsizei width, GLsizei height) {
+    emitOp(OpRenderbufferStorage);
+    emitU32(renderbufferTarget);
+    emitU32(internalFormat);
+    emitI32(width);
+    emitI32(height);
+    target.renderbufferStorage(renderbufferTarget, internalFormat, width, height);
+}
+
+static void recordFramebufferRenderbuffer(GLenum framebufferTarget, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer) {
+    emitOp(OpFramebufferRenderbuffer);
+    emitU32(framebufferTarget);
+    emitU32(attachment);
+    emitU32(renderbufferTarget);
+    emitU32(renderbuffer);
+    target.framebufferRenderbuffer(framebufferTarget, attachment, renderbufferTarget, renderbuffer);
+}
+
+static void recordGetRenderbufferParameteriv(GLenum renderbufferTarget, GLenum parameter, GLint* value) {
+    emitOp(OpGetRenderbufferParameteriv);
+    emitU32(renderbufferTarget);
+    emitU32(parameter);
+    target.getRenderbufferParameteriv(renderbufferTarget, parameter, value);
+}
+
+static void recordDiscardFramebuffer(GLenum framebufferTarget, GLsizei count, const GLenum* attachments) {
+    emitOp(OpDiscardFramebuffer);
+    emitU32(framebufferTarget);
+    emitI32(count);
+    for (GLsizei i = 0; i < count; i++) {
+        emitU32(attachments[i]);
+    }
+    target.discardFramebuffer(framebufferTarget, count, attachments);
+}
+
+
+static const GLDispatch recordingBackend = {
+
+    .viewport                   = recordViewport,
+    .scissor                    = recordScissor,
+    .clearColor                 = recordClearColor,
+    .clear                      = recordClear,
+    .enable                     = recordEnable,
+    .disable                    = recordDisable,
+    .blendFunc                  = recordBlendFunc,
+
+    .genTextures                = recordGenTextures,
+    .deleteTextures             = recordDeleteTextures,
+    .bindTexture                = recordBindTexture,
+    .texImage2D                 = recordTexImage2D,
+    .texSubImage2D              = recordTexSubImage2D,
+    .compressedTexImage2D       = recordCompressedTexImage2D,
+    .texParameteri              = recordTexParameteri,
+
+    .genBuffers                 = recordGenBuffers,
+    .deleteBuffers              = recordDeleteBuffers,
+    .bindBuffer                 = recordBindBuffer,
+    .bufferData                 = recordBufferData,
+    .bufferSubData              = recordBufferSubData,
+
+    .genVertexArrays            = recordGenVertexArrays,
+    .deleteVertexArrays         = recordDeleteVertexArrays,
+    .bindVertexArray            = recordBindVertexArray,
+    .enableVertexAttribArray    = recordEnableVertexAttribArray,
+    .disableVertexAttribArray   = recordDisableVertexAttribArray,
+    .vertexAttribPointer        = recordVertexAttribPointer,
+    .getAttribLocation          = recordGetAttribLocation,
+
+    .useProgram                 = recordUseProgram,
+    .deleteProgram              = recordDeleteProgram,
+    .getUniformLocation         = recordGetUniformLocation,
+    .uniform1i                  = recordUniform1i,
+    .uniform1f                  = recordUniform1f,
+    .uniform2fv                 = recordUniform2fv,
+    .uniform3fv                 = recordUniform3fv,
+    .uniform4fv                 = recordUniform4fv,
+    .uniformMatrix4fv           = recordUniformMatrix4fv,
+
+    .drawArrays                 = recordDrawArrays,
+    .drawElements               = recordDrawElements,
+
+    .genFramebuffers            = recordGenFramebuffers,
+    .deleteFramebuffers         = recordDeleteFramebuffers,
+    .bindFramebuffer            = recordBindFramebuffer,
+    .framebufferTexture2D       = recordFramebufferTexture2D,
+    .checkFramebufferStatus     = recordCheckFramebufferStatus,
+    .genRenderbuffers           = recordGenRenderbuffers,
+    .deleteRenderbuffers        = recordDeleteRenderbuffers,
+    .bindRenderbuffer           = recordBindRenderbuffer,
+    .renderbufferStorage        = recordRenderbufferStorage,
+    .framebufferRenderbuffer    = recordFramebufferRenderbuffer,
+    .getRenderbufferParameteriv = recordGetRenderbufferParameteriv,
+
+    .discardFramebuffer         = recordDiscardFramebuffer,
+};
+
+
+#pragma mark - Recorder
+
+
+GLRecorder* glRecorderCreate(void) {
+
+    GLRecorder* recorder = calloc(1, sizeof(GLRecorder));
+
+    if (recorder) {
+        recorderAppendHeader(recorder);
+    }
+
+    return recorder;
+}
+
+
+void glRecorderDestroy(GLRecorder* recorder) {
+
+    if (!recorder) {
+        return;
+    }
+
+    glRecorderStop(recorder);
+
+    free(recorder->bytes);
+    free(recorder);
+}
+
+
+void glRecorderStart(GLRecorder* recorder, const GLDispatch* targetBackend) {
+
+    if (activeRecorder) {
+        glRecorderStop(activeRecorder);
+    }
+
+    // (Copy first: targetBackend might be &glDispatch)
+    target = targetBackend ? *targetBackend : *glDispatchNullBackend();
+
+    recorder->previousBackend = glDispatch;
+    activeRecorder = recorder;
+
+    glDispatchSetBackend(&recordingBackend);
+}
+
+
+void glRecorderStop(GLRecorder* recorder) {
+
+    if (activeRecorder != recorder) {
+        return;
+    }
+
+    glDispatchSetBackend(&(recorder->previousBackend));
+    activeRecorder = NULL;
+}
+
+
+void glRecorderMarkFrame(GLRecorder* recorder) {
+
+    uint8_t op = OpFrame;
+    recorderAppend(recorder, &op, 1);
+}
+
+
+void glRecorderReset(GLRecorder* recorder) {
+
+    recorder->size   = 0;
+    recorder->failed = 0;
+
+    recorderAppendHeader(recorder);
+}
+
+
+const void* glRecorderBytes(const GLRecorder* recorder, size_t* size) {
+
+    if (recorder->failed) {
+        *size = 0;
+        return NULL;
+    }
+
+    *size = recorder->size;
+    return recorder->bytes;
+}
+
+
+int glRecorderWriteFile(const GLRecorder* recorder, const char* path) {
+
+    size_t      size;
+    const void* bytes = glRecorderBytes(recorder, &size);
+
+    if (!bytes) {
+        return 0;
+    }
+
+    FILE* file = fopen(path, "wb");
+
+    if (!file) {
+        return 0;
+    }
+
+    int success = (fwrite(bytes, 1, size, file) == size);
+
+    if (fclose(file) != 0) {
+        success = 0;
+    }
+
+    return success;
+}
+
+
+#pragma mark - Replay
+
+
+/**
+ Recorded name -> name handed out on replay. Names never mapped map to
+ themselves.
+ */
+typedef struct tNameMap {
+
+    GLuint* names;
+    GLuint  count;
+
+}NameMap;
+
+
+typedef struct tProgramLocations {
+
+    GLuint  program;
+    NameMap locations;
+
+}ProgramLocations;
+
+
+typedef struct tReplay {
+
+    const uint8_t*      cursor;
+    const uint8_t*      end;
+    int                 failed;
+
+    const GLDispatch*   gl;
+
+    NameMap             textures;
+    NameMap             buffers;
+    NameMap             arrays;
+    NameMap             framebuffers;
+    NameMap             renderbuffers;
+    NameMap             attributes;
+
+    ProgramLocations*   programs;
+    GLuint              programCount;
+    GLuint              programCapacity;
+    GLuint              currentProgram;
+
+    // Scratch storage (aligned copies of inline data)
+    void*               scratch;
+    size_t              scratchSize;
+
+}Replay;
+
+
+static void nameMapSet(NameMap* map, GLuint recorded, GLuint actual) {
+
+    if (recorded >= MaxMappedName) {
+        return;
+    }
+
+    if (recorded >= map->count) {
+        GLuint count = map->count ? map->count : 64u;
+
+        while (count <= recorded) {
+            count *= 2;
+        }
+
+        GLuint* names = realloc(map->names, count*sizeof(GLuint));
+
+        if (!names) {
+            return;
+        }
+
+        for (GLuint i = map->count; i < count; i++) {
+            names[i] = i;
+        }
+
+        map->names = names;
+        map->count = count;
+    }
+
+    map->names[recorded] = actual;
+}
+
+
+static GLuint nameMapGet(const NameMap* map, GLuint recorded) {
+
+    return (recorded < map->count) ? map->names[recorded] : recorded;
+}
+
+
+static GLint locationMapGet(const NameMap* map, GLint recorded) {
+
+    return (recorded < 0) ? recorded : (GLint)nameMapGet(map, (GLuint)recorded);
+}
+
+
+/**
+ Uniform locations of program (NULL if none were queried, unless create is
+ nonzero).
+ */
+static NameMap* replayLocationsForProgram(Replay* replay, GLuint program, int create) {
+
+    for (GLuint i = 0; i < replay->programCount; i++) {
+        if (replay->programs[i].program == program) {
+            return &(replay->programs[i].locations);
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    if (replay->programCount == replay->programCapacity) {
+        GLuint capacity = replay->programCapacity ? (2 * replay->programCapacity) : 8u;
+
+        ProgramLocations* programs = realloc(replay->programs, capacity*sizeof(ProgramLocations));
+
+        if (!programs) {
+            return NULL;
+        }
+        replay->programs        = programs;
+        replay->programCapacity = capacity;
+    }
+
+    ProgramLocations* entry = &(replay->programs[replay->programCount++]);
+
+    entry->program   = program;
+    entry->locations = (NameMap){ 0 };
+
+    return &(entry->locations);
+}
+
+
+static GLint replayMapUniformLocation(Replay* replay, GLint recorded) {
+
+    // (Few programs; a linear search per uniform call is cheap enough)
+    NameMap* locations = replayLocationsForProgram(replay, replay->currentProgram, 0);
+
+    return locations ? locationMapGet(locations, recorded) : recorded;
+}
+
+
+// .............................................................................
+
+static void readBytes(Replay* replay, void* destination, size_t size) {
+
+    if (replay->failed || (size_t)(replay->end - replay->cursor) < size) {
+        replay->failed = 1;
+        memset(destination, 0, size);
+        return;
+    }
+
+    memcpy(destination, replay->cursor, size);
+    replay->cursor += size;
+}
+
+static uint8_t readU8(Replay* replay) {
+    uint8_t value;
+    readBytes(replay, &value, 1);
+    return value;
+}
+
+static uint32_t readU32(Replay* replay) {
+    uint32_t value;
+    readBytes(replay, &value, 4);
+    return value;
+}
+
+static int32_t readI32(Replay* replay) {
+    int32_t value;
+    readBytes(replay, &value, 4);
+    return value;
+}
+
+static GLfloat readF32(Replay* replay) {
+    GLfloat value;
+    readBytes(replay, &value, 4);
+    return value;
+}
+
+static uint64_t readU64(Replay* replay) {
+    uint64_t value;
+    readBytes(replay, &value, 8);
+    return value;
+}
+
+
+/**
+ Copies size bytes of inline data into scratch storage (suitably aligned for
+ any type, with one extra byte) and returns it, or NULL if the stream is short.
+ */
+static void* readData(Replay* replay, uint64_t size) {
+
+    if (replay->failed || (uint64_t)(replay->end - replay->cursor) < size) {
+        replay->failed = 1;
+        return NULL;
+    }
+
+    if (size + 1 > replay->scratchSize) {
+        void* scratch = realloc(replay->scratch, (size_t)size + 1);
+
+        if (!scratch) {
+            replay->failed = 1;
+            return NULL;
+        }
+        replay->scratch     = scratch;
+        replay->scratchSize = (size_t)size + 1;
+    }
+
+    readBytes(replay, replay->scratch, (size_t)size);
+
+    return replay->scratch;
+}
+
+
+/**
+ Reads a length-prefixed string into scratch storage, NUL-terminated.
+ */
+static const GLchar* readString(Replay* replay) {
+
+    uint32_t length = readU32(replay);
+    GLchar*  string = readData(replay, length);
+
+    if (string) {
+        string[length] = '\0';
+    }
+
+    return string;
+}
+
+
+/**
+ Reads a count and that many names into scratch storage. Returns NULL if the
+ stream is short.
+ */
+static GLuint* readNames(Replay* replay, GLsizei* count) {
+
+    *count = readI32(replay);
+
+    if (*count < 0) {
+        replay->failed = 1;
+        return NULL;
+    }
+
+    return readData(replay, (uint64_t)(*count) * sizeof(GLuint));
+}
+
+
+// .............................................................................
+
+static void replayGen(Replay* replay, NameMap* map, void (*gen)(GLsizei, GLuint*)) {
+
+    GLsizei count;
+    GLuint* recorded = readNames(replay, &count);
+
+    if (!recorded || count == 0) {
+        return;
+    }
+
+    GLuint* actual = malloc((size_t)count * sizeof(GLuint));
+
+    if (!actual) {
+        replay->failed = 1;
+        return;
+    }
+
+    gen(count, actual);
+
+    for (GLsizei i = 0; i < count; i++) {
+        nameMapSet(map, recorded[i], actual[i]);
+    }
+
+    free(actual);
+}
+
+
+static void replayDelete(Replay* replay, NameMap* map, void (*deleteNames)(GLsizei, const GLuint*)) {
+
+    GLsizei count;
+    GLuint* names = readNames(replay, &count);
+
+    if (!names || count == 0) {
+        return;
+    }
+
+    for (GLsizei i = 0; i < count; i++) {
+        names[i] = nameMapGet(map, names[i]);
+    }
+
+    deleteNames(count, names);
+}
+
+
+static void replayUniformfv(Replay* replay, GLuint components, void (*uniform)(GLint, GLsizei, const GLfloat*)) {
+
+    GLint   location = readI32(replay);
+    GLsizei count    = readI32(replay);
+
+    if (count < 0) {
+        replay->failed = 1;
+        return;
+    }
+
+    const GLfloat* values = readData(replay, (uint64_t)count * components * sizeof(GLfloat));
+
+    if (values) {
+        uniform(replayMapUniformLocation(replay, location), count, values);
+    }
+}
+
+
+/**
+ Issues one command. Returns 0 at the end of the stream or on error.
+ */
+static int replayCommand(Replay* replay,
+                         GLRecorderFrameCallback frameCallback,
+                         void* userInfo,
+                         unsigned long* frameIndex) {
+
+    if (replay->cursor == replay->end) {
+        return 0;
+    }
+
+    const GLDispatch* gl = replay->gl;
+
+    GLRecorderOpcode op = (GLRecorderOpcode)readU8(replay);
+
+    switch (op) {
+
+        case OpFrame:
+            if (frameCallback) {
+                frameCallback(userInfo, *frameIndex);
+            }
+            (*frameIndex)++;
+            break;
+
+        case OpViewport: {
+            GLint   x      = readI32(replay);
+            GLint   y      = readI32(replay);
+            GLsizei width  = readI32(replay);
+            GLsizei height = readI32(replay);
+            if (!replay->failed) {
+                gl->viewport(x, y, width, height);
+            }
+            break;
+        }
+
+        case OpScissor: {
+            GLint   x      = readI32(replay);
+            GLint   y      = readI32(replay);
+            GLsizei width  = readI32(replay);
+            GLsizei height = readI32(replay);
+            if (!replay->failed) {
+                gl->scissor(x, y, width, height);
+            }
+            break;
+        }
+
+        case OpClearColor: {
+            GLfloat red   = readF32(replay);
+            GLfloat green = readF32(replay);
+            GLfloat blue  = readF32(replay);
+            GLfloat alpha = readF32(replay);
+            if (!replay->failed) {
+                gl->clearColor(red, green, blue, alpha);
+            }
+            break;
+        }
+
+        case OpClear: {
+            GLbitfield mask = readU32(replay);
+            if (!replay->failed) {
+                gl->clear(mask);
+            }
+            break;
+        }
+
+        case OpEnable:
+        case OpDisable: {
+            GLenum capability = readU32(replay);
+            if (!replay->failed) {
+                (op == OpEnable ? gl->enable : gl->disable)(capability);
+            }
+            break;
+        }
+
+        case OpBlendFunc: {
+            GLenum sourceFactor      = readU32(replay);
+            GLenum destinationFactor = readU32(replay);
+            if (!replay->failed) {
+                gl->blendFunc(sourceFactor, destinationFactor);
+            }
+            break;
+        }
+
+        // Textures
+
+        case OpGenTextures:
+            replayGen(replay, &(replay->textures), gl->genTextures);
+            break;
+
+        case OpDeleteTextures:
+            replayDelete(replay, &(replay->textures), gl->deleteTextures);
+            break;
+
+        case OpBindTexture: {
+            GLenum textureTarget = readU32(replay);
+            GLuint texture       = readU32(replay);
+            if (!replay->failed) {
+                gl->bindTexture(textureTarget, nameMapGet(&(replay->textures), texture));
+            }
+            break;
+        }
+
+        case OpTexImage2D: {
+            GLenum  textureTarget  = readU32(replay);
+            GLint   level          = readI32(replay);
+            GLint   internalFormat = readI32(replay);
+            GLsizei width          = readI32(replay);
+            GLsizei height         = readI32(replay);
+            GLint   border         = readI32(replay);
+            GLenum  format         = readU32(replay);
+            GLenum  type           = readU32(replay);
+            const void* pixels     = NULL;
+            if (readU8(replay)) {
+                uint64_t size = readU64(replay);
+                pixels = readData(replay, size);
+                if (!replay->failed && size < glDispatchPixelDataSize(width, height, format, type)) {
+                    replay->failed = 1;
+                }
+            }
+            if (!replay->failed) {
+                gl->texImage2D(textureTarget, level, internalFormat, width, height, border, format, type, pixels);
+            }
+            break;
+        }
+
+        case OpTexSubImage2D: {
+            GLenum      textureTarget = readU32(replay);
+            GLint       level         = readI32(replay);
+            GLint       xOffset       = readI32(replay);
+            GLint       yOffset       = readI32(replay);
+            GLsizei     width         = readI32(replay);
+            GLsizei     height        = readI32(replay);
+            GLenum      format        = readU32(replay);
+            GLenum      type          = readU32(replay);
+            uint64_t    size          = readU64(replay);
+            const void* pixels        = readData(replay, size);
+            if (!replay->failed && size < glDispatchPixelDataSize(width, height, format, type)) {
+                replay->failed = 1;
+            }
+            if (!replay->failed) {
+                gl->texSubImage2D(textureTarget, level, xOffset, yOffset, width, height, format, type, pixels);
+            }
+            break;
+        }
+
+        case OpCompressedTexImage2D: {
+            GLenum      textureTarget  = readU32(replay);
+            GLint       level          = readI32(replay);
+            GLenum      internalFormat = readU32(replay);
+            GLsizei     width          = readI32(replay);
+            GLsizei     height         = readI32(replay);
+            GLint       border         = readI32(replay);
+            int         hasData        = readU8(replay);
+            uint64_t    size           = readU64(replay);
+            const void* data           = NULL;
+            if (hasData) {
+                data = readData(replay, size);
+            }
+            if (!replay->failed) {
+                gl->compressedTexImage2D(textureTarget, level, internalFormat, width, height, border, (GLsizei)size, data);
+            }
+            break;
+        }
+
+        case OpTexParameteri: {
+            GLenum textureTarget = readU32(replay);
+            GLenum parameter     = readU32(replay);
+            GLint  value         = readI32(replay);
+            if (!replay->failed) {
+                gl->texParameteri(textureTarget, parameter, value);
+            }
+            break;
+        }
+
+        // Buffers
+
+        case OpGenBuffers:
+            replayGen(replay, &(replay->buffers), gl->genBuffers);
+            break;
+
+        case OpDeleteBuffers:
+            replayDelete(replay, &(replay->buffers), gl->deleteBuffers);
+            break;
+
+        case OpBindBuffer: {
+            GLenum bufferTarget = readU32(replay);
+            GLuint buffer       = readU32(replay);
+            if (!replay->failed) {
+                gl->bindBuffer(bufferTarget, nameMapGet(&(replay->buffers), buffer));
+            }
+            break;
+        }
+
+        case OpBufferData: {
+            GLenum      bufferTarget = readU32(replay);
+            GLenum      usage        = readU32(replay);
+            uint64_t    size         = readU64(replay);
+            const void* data         = NULL;
+            if (readU8(replay)) {
+                data = readData(replay, size);
+            }
+            if (!replay->failed) {
+                gl->bufferData(bufferTarget, (GLsizeiptr)size, data, usage);
+            }
+            break;
+        }
+
+        case OpBufferSubData: {
+            GLenum      bufferTarget = readU32(replay);
+            uint64_t    offset       = readU64(replay);
+            uint64_t    size         = readU64(replay);
+            const void* data         = readData(replay, size);
+            if (!replay->failed) {
+                gl->bufferSubData(bufferTarget, (GLintptr)offset, (GLsizeiptr)size, data);
+            }
+            break;
+        }
+
+        // Vertex arrays
+
+        case OpGenVertexArrays:
+            replayGen(replay, &(replay->arrays), gl->genVertexArrays);
+            break;
+
+        case OpDeleteVertexArrays:
+            replayDelete(replay, &(replay->arrays), gl->deleteVertexArrays);
+            break;
+
+        case OpBindVertexArray: {
+            GLuint array = readU32(replay);
+            if (!replay->failed) {
+                gl->bindVertexArray(nameMapGet(&(replay->arrays), array));
+            }
+            break;
+        }
+
+        case OpEnableVertexAttribArray:
+        case OpDisableVertexAttribArray: {
+            GLuint index = (GLuint)locationMapGet(&(replay->attributes), readI32(replay));
+            if (!replay->failed) {
+                (op == OpEnableVertexAttribArray ? gl->enableVertexAttribArray : gl->disableVertexAttribArray)(index);
+            }
+            break;
+        }
+
+        case OpVertexAttribPointer: {
+            GLuint    index      = (GLuint)locationMapGet(&(replay->attributes), readI32(replay));
+            GLint     size       = readI32(replay);
+            GLenum    type       = readU32(replay);
+            GLboolean normalized = readU8(replay);
+            GLsizei   stride     = readI32(replay);
+            uintptr_t offset     = (uintptr_t)readU64(replay);
+            if (!replay->failed) {
+                gl->vertexAttribPointer(index, size, type, normalized, stride, (const GLvoid *)offset);
+            }
+            break;
+        }
+
+        case OpGetAttribLocation: {
+            GLuint        program  = readU32(replay);
+            const GLchar* name     = readString(replay);
+            GLint         recorded = readI32(replay);
+            if (!replay->failed) {
+                GLint actual = gl->getAttribLocation(program, name);
+                if (recorded >= 0) {
+                    // (Attribute indices are global; the last query wins)
+                    nameMapSet(&(replay->attributes), (GLuint)recorded, (GLuint)actual);
+                }
+            }
+            break;
+        }
+
+        // Programs
+
+        case OpUseProgram: {
+            GLuint program = readU32(replay);
+            if (!replay->failed) {
+                gl->useProgram(program);
+                replay->currentProgram = program;
+            }
+            break;
+        }
+
+        case OpDeleteProgram: {
+            GLuint program = readU32(replay);
+            if (!replay->failed) {
+                gl->deleteProgram(program);
+            }
+            break;
+        }
+
+        case OpGetUniformLocation: {
+            GLuint        program  = readU32(replay);
+            const GLchar* name     = readString(replay);
+            GLint         recorded = readI32(replay);
+            if (!replay->failed) {
+                GLint actual = gl->getUniformLocation(program, name);
+                if (recorded >= 0) {
+                    NameMap* locations = replayLocationsForProgram(replay, program, 1);
+                    if (locations) {
+                        nameMapSet(locations, (GLuint)recorded, (GLuint)actual);
+                    }
+                }
+            }
+            break;
+        }
+
+        case OpUniform1i: {
+            GLint location = readI32(replay);
+            GLint value    = readI32(replay);
+            if (!replay->failed) {
+                gl->uniform1i(replayMapUniformLocation(replay, location), value);
+            }
+            break;
+        }
+
+        case OpUniform1f: {
+            GLint   location = readI32(replay);
+            GLfloat value    = readF32(replay);
+            if (!replay->failed) {
+                gl->uniform1f(replayMapUniformLocation(replay, location), value);
+            }
+            break;
+        }
+
+        case OpUniform2fv:
+            replayUniformfv(replay, 2, gl->uniform2fv);
+            break;
+
+        case OpUniform3fv:
+            replayUniformfv(replay, 3, gl->uniform3fv);
+            break;
+
+        case OpUniform4fv:
+            replayUniformfv(replay, 4, gl->uniform4fv);
+            break;
+
+        case OpUniformMatrix4fv: {
+            GLint     location  = readI32(replay);
+            GLsizei   count     = readI32(replay);
+            GLboolean transpose = readU8(replay);
+            if (count < 0) {
+                replay->failed = 1;
+                break;
+            }
+            const GLfloat* values = readData(replay, (uint64_t)count * 16 * sizeof(GLfloat));
+            if (values) {
+                gl->uniformMatrix4fv(replayMapUniformLocation(replay, location), count, transpose, values);
+            }
+            break;
+        }
+
+        // Drawing
+
+        case OpDrawArrays: {
+            GLenum  mode  = readU32(replay);
+            GLint   first = readI32(replay);
+            GLsizei count = readI32(replay);
+            if (!replay->failed) {
+                gl->drawArrays(mode, first, count);
+            }
+            break;
+        }
+
+        case OpDrawElements: {
+            GLenum    mode   = readU32(replay);
+            GLsizei   count  = readI32(replay);
+            GLenum    type   = readU32(replay);
+            uintptr_t offset = (uintptr_t)readU64(replay);
+            if (!replay->failed) {
+                gl->drawElements(mode, count, type, (const GLvoid *)offset);
+            }
+            break;
+        }
+
+        // Framebuffers
+
+        case OpGenFramebuffers:
+            replayGen(replay, &(replay->framebuffers), gl->genFramebuffers);
+            break;
+
+        case OpDeleteFramebuffers:
+            replayDelete(replay, &(replay->framebuffers), gl->deleteFramebuffers);
+            break;
+
+        case OpBindFramebuffer: {
+            GLenum framebufferTarget = readU32(replay);
+            GLuint framebuffer       = readU32(replay);
+            if (!replay->failed) {
+                gl->bindFramebuffer(framebufferTarget, nameMapGet(&(replay->framebuffers), framebuffer));
+            }
+            break;
+        }
+
+        case OpFramebufferTexture2D: {
+            GLenum framebufferTarget = readU32(replay);
+            GLenum attachment        = readU32(replay);
+            GLenum textureTarget     = readU32(replay);
+            GLuint texture           = readU32(replay);
+            GLint  level             = readI32(replay);
+            if (!replay->failed) {
+                gl->framebufferTexture2D(framebufferTarget, attachment, textureTarget, nameMapGet(&(replay->textures), texture), level);
+            }
+            break;
+        }
+
+        case OpCheckFramebufferStatus: {
+            GLenum framebufferTarget = readU32(replay);
+            if (!replay->failed) {
+                gl->checkFramebufferStatus(framebufferTarget);
+            }
+            break;
+        }
+
+        case OpGenRenderbuffers:
+            replayGen(replay, &(replay->renderbuffers), gl->genRenderbuffers);
+            break;
+
+        case OpDeleteRenderbuffers:
+            replayDelete(replay, &(replay->renderbuffers), gl->deleteRenderbuffers);
+            break;
+
+        case OpBindRenderbuffer: {
+            GLenum renderbufferTarget = readU32(replay);
+            GLuint renderbuffer       = readU32(replay);
+            if (!replay->failed) {
+                gl->bindRenderbuffer(renderbufferTarget, nameMapGet(&(replay->renderbuffers), renderbuffer));
+            }
+            break;
+        }
+
+        case OpRenderbufferStorage: {
+            GLenum  renderbufferTarget = readU32(replay);
+            GLenum  internalFormat     = readU32(replay);
+            GLsizei width              = readI32(replay);
+            GLsizei height             = readI32(replay);
+            if (!replay->failed) {
+                gl->renderbufferStorage(renderbufferTarget, internalFormat, width, height);
+            }
+            break;
+        }
+
+        case OpFramebufferRenderbuffer: {
+            GLenum framebufferTarget  = readU32(replay);
+            GLenum attachment         = readU32(replay);
+            GLenum renderbufferTarget = readU32(replay);
+            GLuint renderbuffer       = readU32(replay);
+            if (!replay->failed) {
+                gl->framebufferRenderbuffer(framebufferTarget, attachment, renderbufferTarget, nameMapGet(&(replay->renderbuffers), renderbuffer));
+            }
+            break;
+        }
+
+        case OpGetRenderbufferParameteriv: {
+            GLenum renderbufferTarget = readU32(replay);
+            GLenum parameter          = readU32(replay);
+            if (!replay->failed) {
+                GLint value;
+                gl->getRenderbufferParameteriv(renderbufferTarget, parameter, &value);
+            }
+            break;
+        }
+
+        case OpDiscardFramebuffer: {
+            GLenum  framebufferTarget = readU32(replay);
+            GLsizei count;
+            GLenum* attachments       = (GLenum *)readNames(replay, &count);
+            if (attachments) {
+                gl->discardFramebuffer(framebufferTarget, count, attachments);
+            }
+            break;
+        }
+
+        default:
+            replay->failed = 1;
+            break;
+    }
+
+    return !replay->failed;
+}
+
+
+long glRecorderReplay(const void* stream,
+                      size_t size,
+                      const GLDispatch* target,
+                      GLRecorderFrameCallback frameCallback,
+                      void* userInfo) {
+
+    const uint8_t* bytes = stream;
+
+    if (size < RecorderHeaderSize || memcmp(bytes, RecorderSignature, 8) != 0) {
+        return -1;
+    }
+
+    uint32_t version;
+    memcpy(&version, bytes + 8, 4);
+
+    if (version != RecorderVersion) {
+        return -1;
+    }
+
+    Replay replay = { 0 };
+
+    replay.cursor         = bytes + RecorderHeaderSize;
+    replay.end            = bytes + size;
+    replay.gl             = target ? target : glDispatchNullBackend();
+
+    long          commandCount = 0;
+    unsigned long frameIndex   = 0;
+
+    while (replayCommand(&replay, frameCallback, userInfo, &frameIndex)) {
+        commandCount++;
+    }
+
+
+    // Clean up
+
+    free(replay.textures.names);
+    free(replay.buffers.names);
+    free(replay.arrays.names);
+    free(replay.framebuffers.names);
+    free(replay.renderbuffers.names);
+    free(replay.attributes.names);
+
+    for (GLuint i = 0; i < replay.programCount; i++) {
+        free(replay.programs[i].locations.names);
+    }
+    free(replay.programs);
+    free(replay.scratch);
+
+    return replay.failed ? -1 : commandCount;
+}
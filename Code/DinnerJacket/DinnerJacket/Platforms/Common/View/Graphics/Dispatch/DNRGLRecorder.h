@@ -0,0 +1,115 @@
+//
+//  DNRGLRecorder.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-06.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRGLRecorder_h__
+#define __DNRGLRecorder_h__
+
+#include <stddef.h>
+
+#include "DNRGLDispatch.h"
+
+
+/*
+ Recording backend: while started, every call made through glDispatch is
+ appended to a compact binary command stream and then forwarded to a target
+ backend (the native one, to record while rendering normally; or the null
+ one, to run headless).
+
+ The stream can be saved and replayed later against any backend, e.g. to
+ measure the driver's cost of exactly the same frames on different devices,
+ or to inspect what a frame does. Object names returned by glGen*() and
+ locations returned by glGet*Location() are remapped on replay, so the stream
+ does not depend on the values the recording driver handed out (objects
+ created before recording started are assumed to keep their names).
+
+ Format (little endian): an 8 byte signature "DNRGLREC", a 32 bit version,
+ 32 reserved bits, and then the commands. Each command is a one byte opcode
+ followed by the arguments of the call it stands for (32 bit integers and
+ floats, 64 bit sizes and buffer offsets, and length-prefixed data). Buffer and
+ texture data are stored inline. Pointer arguments of vertexAttribPointer()
+ and drawElements() are stored as offsets into the bound buffer (client-side
+ arrays are not supported; the engine does not use them).
+
+ Recording is not thread safe: record from the main thread while nothing else
+ is using OpenGL.
+ */
+typedef struct tGLRecorder GLRecorder;
+
+
+/**
+ Called on replay at each frame mark.
+ */
+typedef void (*GLRecorderFrameCallback)(void* userInfo, unsigned long frameIndex);
+
+
+/**
+ Creates an empty recorder.
+ */
+GLRecorder* glRecorderCreate(void);
+
+
+/**
+ Frees the recorder and its stream. Stops it first if it is recording.
+ */
+void glRecorderDestroy(GLRecorder* recorder);
+
+
+/**
+ Installs the recording backend in glDispatch, with the calls forwarded to
+ target (NULL for the null backend). Commands are appended to whatever the
+ recorder already holds. Only one recorder can record at a time.
+ */
+void glRecorderStart(GLRecorder* recorder, const GLDispatch* target);
+
+
+/**
+ Restores the backend that was installed when recording started.
+ */
+void glRecorderStop(GLRecorder* recorder);
+
+
+/**
+ Appends a frame mark (e.g., after each tick), used to split the stream into
+ frames on replay.
+ */
+void glRecorderMarkFrame(GLRecorder* recorder);
+
+
+/**
+ Discards all recorded commands.
+ */
+void glRecorderReset(GLRecorder* recorder);
+
+
+/**
+ The stream recorded so far (signature included). Returns NULL if memory
+ ran out at some point while recording (the stream is incomplete).
+ */
+const void* glRecorderBytes(const GLRecorder* recorder, size_t* size);
+
+
+/**
+ Writes the stream to a file. Returns 0 on failure.
+ */
+int glRecorderWriteFile(const GLRecorder* recorder, const char* path);
+
+
+/**
+ Issues the commands in stream (as returned by glRecorderBytes() or read from
+ a file) through target (NULL for the null backend). frameCallback, if not
+ NULL, is called at each frame mark. Returns the number of commands replayed,
+ or -1 if the stream is malformed (commands before the error are issued).
+ */
+long glRecorderReplay(const void* stream,
+                      size_t size,
+                      const GLDispatch* target,
+                      GLRecorderFrameCallback frameCallback,
+                      void* userInfo);
+
+
+#endif  // #defined (__DNRGLRecorder_h__)
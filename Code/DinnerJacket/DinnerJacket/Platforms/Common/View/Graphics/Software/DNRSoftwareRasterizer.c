@@ -0,0 +1,2900 @@
+//
+//  DNRSoftwareRasterizer.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-07.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>         // sysconf()
+
+#include "DNRSoftwareRasterizer.h"
+
+
+#define TileSize                64u         // Pixels (tiles are square)
+#define MaxThreadCount          32u
+#define MaxAttributes           4u
+
+// Window coordinates are converted to fixed point with this many fractional
+// bits, and clamped to +/- GuardBand pixels (triangles reaching farther are
+// distorted, not clipped)
+#define SubpixelBits            8
+#define GuardBand               (1 << 20)
+
+// The queue is executed when it holds this many triangles
+#define MaxQueuedTriangles      (1u << 20)
+
+// Bin entries: triangle index, or draw index of a clear with this bit set
+#define ClearEntryFlag          0x80000000u
+
+// Image.pendingUse bits
+#define PendingTarget           1
+#define PendingSampled          2
+
+
+// Fixed locations (see SoftwareProgramKind)
+enum {
+    UniformProjection = 0,
+    UniformModelview,
+    UniformColor,
+    UniformZ,
+    UniformSampler,
+};
+
+enum {
+    AttributePosition = 0,
+    AttributeTextureCoord,
+    AttributeColor,
+};
+
+// Interpolated values, in Triangle.planes
+enum {
+    PlaneZ = 0,
+    PlaneS,
+    PlaneT,
+    PlaneRed,
+    PlaneGreen,
+    PlaneBlue,
+    PlaneAlpha,
+    PlaneCount
+};
+
+
+// .............................................................................
+#pragma mark - Types
+
+
+/**
+ Pixel storage shared by textures, renderbuffers and the queued work that
+ reads or writes it. Colors are RGBA8, depth is float; row 0 is the bottom
+ row (t = 0), as in OpenGL.
+ */
+typedef struct tSoftwareImage {
+
+    atomic_int  refCount;
+    GLsizei     width;
+    GLsizei     height;
+    int         pendingUse;     // Queued work that renders into/samples it
+                                // (drawing thread only)
+    void*       data;
+
+}SoftwareImage;
+
+
+typedef struct tSoftwareTexture {
+
+    int             exists;
+    SoftwareImage*  image;
+    GLenum          magFilter;
+    GLenum          wrapS;
+    GLenum          wrapT;
+
+}SoftwareTexture;
+
+
+typedef struct tSoftwareBuffer {
+
+    int         exists;
+    uint8_t*    data;
+    size_t      size;
+
+}SoftwareBuffer;
+
+
+typedef struct tSoftwareAttribute {
+
+    GLboolean   enabled;
+    GLint       size;
+    GLenum      type;
+    GLboolean   normalized;
+    GLsizei     stride;
+    size_t      offset;
+    GLuint      buffer;
+
+}SoftwareAttribute;
+
+
+typedef struct tSoftwareVertexArray {
+
+    int                 exists;
+    GLuint              elementBuffer;
+    SoftwareAttribute   attributes[MaxAttributes];
+
+}SoftwareVertexArray;
+
+
+typedef struct tSoftwareProgram {
+
+    int                 exists;
+    SoftwareProgramKind kind;
+    GLfloat             projection[16];
+    GLfloat             modelview[16];
+    GLfloat             color[4];
+    GLfloat             z;
+
+}SoftwareProgram;
+
+
+typedef struct tSoftwareFramebuffer {
+
+    int     exists;
+    GLuint  colorTexture;
+    GLuint  colorRenderbuffer;
+    GLuint  depthRenderbuffer;
+
+}SoftwareFramebuffer;
+
+
+typedef struct tSoftwareRenderbuffer {
+
+    int             exists;
+    GLenum          internalFormat;
+    SoftwareImage*  image;
+
+}SoftwareRenderbuffer;
+
+
+/**
+ Objects of one kind, indexed by name. Names are not reused.
+ */
+typedef struct tSoftwareTable {
+
+    uint8_t*    items;
+    size_t      itemSize;
+    GLuint      count;
+    GLuint      capacity;
+
+}SoftwareTable;
+
+
+/**
+ A vertex after the "vertex shader" ran, in window coordinates.
+ */
+typedef struct tSoftwareVertex {
+
+    GLfloat     x;
+    GLfloat     y;
+    GLfloat     values[PlaneCount];     // z, s, t, r, g, b, a
+    int         valid;                  // w > 0
+
+}SoftwareVertex;
+
+
+/**
+ State captured by each queued draw call (or clear).
+ */
+typedef struct tSoftwareDraw {
+
+    SoftwareImage*  target;         // Retained; NULL: no color attachment
+    SoftwareImage*  depth;          // Retained; NULL: no depth attachment
+    SoftwareImage*  texture;        // Retained; NULL: samples opaque black
+    GLint           bounds[4];      // Writable pixels: x0, y0, x1, y1 (inclusive)
+
+    GLbitfield      clearMask;      // Nonzero for clears
+    uint8_t         clearColor[4];
+
+    int             textured;
+    int             alphaTest;
+    int             blending;
+    int             depthTest;
+    GLenum          sourceFactor;
+    GLenum          destinationFactor;
+    int             linear;
+    GLenum          wrapS;
+    GLenum          wrapT;
+
+}SoftwareDraw;
+
+
+/**
+ A triangle, set up for rasterization. Edge functions are evaluated at pixel
+ centers in fixed point; each is >= 0 inside (the fill rule bias is folded
+ into c). Values are interpolated as v0 + l1*(v1 - v0) + l2*(v2 - v0).
+ */
+typedef struct tSoftwareTriangle {
+
+    int64_t     a[3];
+    int64_t     b[3];
+    int64_t     c[3];
+    GLfloat     inverseArea;
+    GLfloat     planes[PlaneCount][3];
+    GLint       bounds[4];          // Pixels: x0, y0, x1, y1 (inclusive)
+    uint32_t    draw;
+
+}SoftwareTriangle;
+
+
+typedef struct tSoftwareBin {
+
+    uint32_t*   entries;
+    uint32_t    count;
+    uint32_t    capacity;
+
+}SoftwareBin;
+
+
+typedef struct tSoftwareWorker {
+
+    SoftwareRasterizer* rasterizer;
+    pthread_t           thread;
+
+}SoftwareWorker;
+
+
+struct tSoftwareRasterizer {
+
+    // Objects (textures are shared with other threads, under textureLock)
+    pthread_mutex_t     textureLock;
+    SoftwareTable       textures;
+    SoftwareTable       buffers;
+    SoftwareTable       vertexArrays;
+    SoftwareTable       programs;
+    SoftwareTable       framebuffers;
+    SoftwareTable       renderbuffers;
+
+    // Default framebuffer
+    GLsizei             width;
+    GLsizei             height;
+    SoftwareImage*      colorBuffer;
+    SoftwareImage*      depthBuffer;
+
+    // State (drawing thread)
+    pthread_t           drawingThread;
+    GLint               viewport[4];
+    GLint               scissorBox[4];  // x, y, width, height
+    int                 scissorTest;
+    GLfloat             clearColor[4];
+    int                 blending;
+    int                 depthTest;
+    GLenum              sourceFactor;
+    GLenum              destinationFactor;
+    GLuint              arrayBuffer;
+    GLuint              vertexArray;
+    GLuint              program;
+    GLuint              framebuffer;
+    GLuint              renderbuffer;
+
+    // Queued work
+    SoftwareDraw*       draws;
+    uint32_t            drawCount;
+    uint32_t            drawCapacity;
+
+    SoftwareTriangle*   triangles;
+    uint32_t            triangleCount;
+    uint32_t            triangleCapacity;
+
+    SoftwareBin*        bins;
+    GLuint              tileColumns;
+    GLuint              tileRows;
+
+    SoftwareVertex*     vertices;       // Scratch (one draw call's worth)
+    size_t              vertexCapacity;
+
+    // Threads
+    SoftwareWorker*     workers;
+    unsigned            workerCount;
+    pthread_mutex_t     poolLock;
+    pthread_cond_t      workReady;
+    pthread_cond_t      workDone;
+    unsigned long       generation;
+    unsigned            busyWorkers;
+    int                 quitting;
+    atomic_uint         nextTile;
+    uint64_t            workerFragments;
+
+    SoftwareRasterizerStats stats;
+};
+
+
+static SoftwareRasterizer* current = NULL;
+
+// (Textures can be bound on any thread)
+static _Thread_local GLuint boundTexture = 0;
+
+
+// .............................................................................
+#pragma mark - Images
+
+
+static SoftwareImage* imageCreate(GLsizei width, GLsizei height, size_t texelSize) {
+
+    if (width <= 0 || height <= 0) {
+        return NULL;
+    }
+
+    SoftwareImage* image = (SoftwareImage *)calloc(1, sizeof(SoftwareImage));
+
+    if (!image) {
+        return NULL;
+    }
+
+    image->data = calloc((size_t)width * (size_t)height, texelSize);
+
+    if (!image->data) {
+        free(image);
+        return NULL;
+    }
+
+    atomic_init(&(image->refCount), 1);
+    image->width  = width;
+    image->height = height;
+
+    return image;
+}
+
+
+static SoftwareImage* imageRetain(SoftwareImage* image) {
+
+    if (image) {
+        atomic_fetch_add_explicit(&(image->refCount), 1, memory_order_relaxed);
+    }
+    return image;
+}
+
+
+static void imageRelease(SoftwareImage* image) {
+
+    if (image && atomic_fetch_sub_explicit(&(image->refCount), 1, memory_order_acq_rel) == 1) {
+        free(image->data);
+        free(image);
+    }
+}
+
+
+static void imageFillDepth(SoftwareImage* image, GLfloat value) {
+
+    GLfloat* depths = (GLfloat *)image->data;
+    size_t   count  = (size_t)image->width * (size_t)image->height;
+
+    for (size_t i = 0; i < count; i++) {
+        depths[i] = value;
+    }
+}
+
+
+/**
+ Converts one row of client pixel data to RGBA8. (Rows are only 4-byte
+ aligned, so packed texels are read with memcpy.)
+ */
+static void convertRow(uint8_t* destination, const uint8_t* source, GLsizei width, GLenum format, GLenum type) {
+
+    if (type == GL_UNSIGNED_SHORT_5_6_5 || type == GL_UNSIGNED_SHORT_4_4_4_4 || type == GL_UNSIGNED_SHORT_5_5_5_1) {
+
+        for (GLsizei x = 0; x < width; x++, source += 2, destination += 4) {
+            uint16_t p;
+            memcpy(&p, source, sizeof(p));
+
+            switch (type) {
+                case GL_UNSIGNED_SHORT_5_6_5:
+                    destination[0] = (uint8_t)(((p >> 11) & 0x1F) * 255 / 31);
+                    destination[1] = (uint8_t)(((p >>  5) & 0x3F) * 255 / 63);
+                    destination[2] = (uint8_t)(( p        & 0x1F) * 255 / 31);
+                    destination[3] = 255;
+                    break;
+
+                case GL_UNSIGNED_SHORT_4_4_4_4:
+                    destination[0] = (uint8_t)(((p >> 12) & 0xF) * 17);
+                    destination[1] = (uint8_t)(((p >>  8) & 0xF) * 17);
+                    destination[2] = (uint8_t)(((p >>  4) & 0xF) * 17);
+                    destination[3] = (uint8_t)(( p        & 0xF) * 17);
+                    break;
+
+                default:    // GL_UNSIGNED_SHORT_5_5_5_1
+                    destination[0] = (uint8_t)(((p >> 11) & 0x1F) * 255 / 31);
+                    destination[1] = (uint8_t)(((p >>  6) & 0x1F) * 255 / 31);
+                    destination[2] = (uint8_t)(((p >>  1) & 0x1F) * 255 / 31);
+                    destination[3] = (p & 1) ? 255 : 0;
+                    break;
+            }
+        }
+        return;
+    }
+
+    if (type != GL_UNSIGNED_BYTE) {
+        // (Floats etc.: not used by the engine)
+        memset(destination, 0, 4*(size_t)width);
+        return;
+    }
+
+    for (GLsizei x = 0; x < width; x++, destination += 4) {
+        switch (format) {
+            case GL_RGBA:
+                memcpy(destination, source, 4);
+                source += 4;
+                break;
+
+            case GL_RGB:
+                destination[0] = source[0];
+                destination[1] = source[1];
+                destination[2] = source[2];
+                destination[3] = 255;
+                source += 3;
+                break;
+
+#ifdef GL_LUMINANCE_ALPHA   // (Not in the core profile)
+            case GL_LUMINANCE_ALPHA:
+                destination[0] = destination[1] = destination[2] = source[0];
+                destination[3] = source[1];
+                source += 2;
+                break;
+
+            case GL_LUMINANCE:
+                destination[0] = destination[1] = destination[2] = source[0];
+                destination[3] = 255;
+                source += 1;
+                break;
+#endif
+            case GL_ALPHA:
+                destination[0] = destination[1] = destination[2] = 0;
+                destination[3] = source[0];
+                source += 1;
+                break;
+
+            default:        // GL_RED
+                destination[0] = source[0];
+                destination[1] = destination[2] = 0;
+                destination[3] = 255;
+                source += 1;
+                break;
+        }
+    }
+}
+
+
+static void imageStore(SoftwareImage* image, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels) {
+
+    size_t rowSize = glDispatchPixelRowSize(width, format, type);
+
+    for (GLsizei row = 0; row < height; row++) {
+        uint8_t*       destination = (uint8_t *)image->data + 4*((size_t)(yOffset + row)*(size_t)image->width + (size_t)xOffset);
+        const uint8_t* source      = (const uint8_t *)pixels + (size_t)row * rowSize;
+
+        convertRow(destination, source, width, format, type);
+    }
+}
+
+
+// .............................................................................
+#pragma mark - Object Tables
+
+
+static void tableInitialize(SoftwareTable* table, size_t itemSize) {
+
+    table->items    = (uint8_t *)calloc(1, itemSize);
+    table->itemSize = itemSize;
+    table->count    = 1;        // (Name 0 is never generated)
+    table->capacity = 1;
+}
+
+
+static void tableFree(SoftwareTable* table) {
+
+    free(table->items);
+    table->items = NULL;
+    table->count = table->capacity = 0;
+}
+
+
+static void* tableItem(const SoftwareTable* table, GLuint name) {
+
+    if (name >= table->count) {
+        return NULL;
+    }
+
+    int* item = (int *)(table->items + (size_t)name * table->itemSize);
+
+    return (*item) ? item : NULL;
+}
+
+
+/**
+ Returns the name of a new, zeroed object (marked as existing), or 0.
+ */
+static GLuint tableGenerate(SoftwareTable* table) {
+
+    if (table->count == table->capacity) {
+        GLuint   capacity = 2*table->capacity;
+        uint8_t* items    = (uint8_t *)realloc(table->items, (size_t)capacity * table->itemSize);
+
+        if (!items) {
+            return 0;
+        }
+        table->items    = items;
+        table->capacity = capacity;
+    }
+
+    GLuint name = table->count++;
+    int*   item = (int *)(table->items + (size_t)name * table->itemSize);
+
+    memset(item, 0, table->itemSize);
+    *item = 1;
+
+    return name;
+}
+
+
+// .............................................................................
+#pragma mark - Thread Pool
+
+
+static void executeTile(SoftwareRasterizer* rasterizer, uint32_t tileIndex, uint64_t* fragmentCount);
+
+
+static void runTiles(SoftwareRasterizer* rasterizer, uint64_t* fragmentCount) {
+
+    uint32_t tileCount = rasterizer->tileColumns * rasterizer->tileRows;
+
+    for (;;) {
+        uint32_t tile = atomic_fetch_add_explicit(&(rasterizer->nextTile), 1, memory_order_relaxed);
+
+        if (tile >= tileCount) {
+            break;
+        }
+        if (rasterizer->bins[tile].count > 0) {
+            executeTile(rasterizer, tile, fragmentCount);
+        }
+    }
+}
+
+
+static void* workerMain(void* argument) {
+
+    SoftwareWorker*     worker     = (SoftwareWorker *)argument;
+    SoftwareRasterizer* rasterizer = worker->rasterizer;
+    unsigned long       generation = 0;
+
+    pthread_mutex_lock(&(rasterizer->poolLock));
+
+    for (;;) {
+        while (!rasterizer->quitting && rasterizer->generation == generation) {
+            pthread_cond_wait(&(rasterizer->workReady), &(rasterizer->poolLock));
+        }
+        if (rasterizer->quitting) {
+            break;
+        }
+        generation = rasterizer->generation;
+
+        pthread_mutex_unlock(&(rasterizer->poolLock));
+
+        uint64_t fragmentCount = 0;
+        runTiles(rasterizer, &fragmentCount);
+
+        pthread_mutex_lock(&(rasterizer->poolLock));
+
+        rasterizer->workerFragments += fragmentCount;
+
+        if (--(rasterizer->busyWorkers) == 0) {
+            pthread_cond_signal(&(rasterizer->workDone));
+        }
+    }
+
+    pthread_mutex_unlock(&(rasterizer->poolLock));
+
+    return NULL;
+}
+
+
+/**
+ Executes the queued work with all threads (the caller's included), releases
+ what it retained and empties the queue.
+ */
+static void flushQueue(SoftwareRasterizer* rasterizer) {
+
+    if (rasterizer->drawCount == 0) {
+        return;
+    }
+
+    uint64_t fragmentCount = 0;
+
+    atomic_store_explicit(&(rasterizer->nextTile), 0, memory_order_relaxed);
+
+    if (rasterizer->workerCount > 0) {
+        pthread_mutex_lock(&(rasterizer->poolLock));
+        rasterizer->busyWorkers = rasterizer->workerCount;
+        rasterizer->generation++;
+        pthread_cond_broadcast(&(rasterizer->workReady));
+        pthread_mutex_unlock(&(rasterizer->poolLock));
+    }
+
+    runTiles(rasterizer, &fragmentCount);
+
+    if (rasterizer->workerCount > 0) {
+        pthread_mutex_lock(&(rasterizer->poolLock));
+        while (rasterizer->busyWorkers > 0) {
+            pthread_cond_wait(&(rasterizer->workDone), &(rasterizer->poolLock));
+        }
+        fragmentCount += rasterizer->workerFragments;
+        rasterizer->workerFragments = 0;
+        pthread_mutex_unlock(&(rasterizer->poolLock));
+    }
+
+    rasterizer->stats.fragments += fragmentCount;
+    rasterizer->stats.flushes++;
+
+
+    // Release
+
+    for (uint32_t i = 0; i < rasterizer->drawCount; i++) {
+        SoftwareDraw* draw = &(rasterizer->draws[i]);
+
+        SoftwareImage* images[3] = { draw->target, draw->depth, draw->texture };
+
+        for (int k = 0; k < 3; k++) {
+            if (images[k]) {
+                images[k]->pendingUse = 0;
+                imageRelease(images[k]);
+            }
+        }
+    }
+
+    uint32_t tileCount = rasterizer->tileColumns * rasterizer->tileRows;
+
+    for (uint32_t tile = 0; tile < tileCount; tile++) {
+        rasterizer->bins[tile].count = 0;
+    }
+
+    rasterizer->drawCount     = 0;
+    rasterizer->triangleCount = 0;
+}
+
+
+// .............................................................................
+#pragma mark - Fragment Processing
+
+
+static GLint wrapCoordinate(GLint coordinate, GLint size, GLenum mode) {
+
+    if (mode == GL_CLAMP_TO_EDGE) {
+        return (coordinate < 0) ? 0 : ((coordinate >= size) ? size - 1 : coordinate);
+    }
+
+    // GL_REPEAT (and GL_MIRRORED_REPEAT, approximated)
+    coordinate %= size;
+    return (coordinate < 0) ? coordinate + size : coordinate;
+}
+
+
+static void sampleTexture(const SoftwareDraw* draw, GLfloat s, GLfloat t, GLfloat color[4]) {
+
+    const SoftwareImage* image = draw->texture;
+
+    if (!image) {
+        color[0] = color[1] = color[2] = 0.0f;
+        color[3] = 1.0f;
+        return;
+    }
+
+    const uint8_t* texels = (const uint8_t *)image->data;
+    GLint          width  = image->width;
+    GLint          height = image->height;
+
+    if (!draw->linear) {
+        GLint x = wrapCoordinate((GLint)floorf(s * width),  width,  draw->wrapS);
+        GLint y = wrapCoordinate((GLint)floorf(t * height), height, draw->wrapT);
+
+        const uint8_t* texel = texels + 4*((size_t)y * (size_t)width + (size_t)x);
+
+        for (int k = 0; k < 4; k++) {
+            color[k] = texel[k] * (1.0f/255.0f);
+        }
+        return;
+    }
+
+    GLfloat u  = s * width  - 0.5f;
+    GLfloat v  = t * height - 0.5f;
+    GLfloat u0 = floorf(u);
+    GLfloat v0 = floorf(v);
+    GLfloat fu = u - u0;
+    GLfloat fv = v - v0;
+
+    GLint x0 = wrapCoordinate((GLint)u0,     width,  draw->wrapS);
+    GLint x1 = wrapCoordinate((GLint)u0 + 1, width,  draw->wrapS);
+    GLint y0 = wrapCoordinate((GLint)v0,     height, draw->wrapT);
+    GLint y1 = wrapCoordinate((GLint)v0 + 1, height, draw->wrapT);
+
+    const uint8_t* t00 = texels + 4*((size_t)y0 * (size_t)width + (size_t)x0);
+    const uint8_t* t10 = texels + 4*((size_t)y0 * (size_t)width + (size_t)x1);
+    const uint8_t* t01 = texels + 4*((size_t)y1 * (size_t)width + (size_t)x0);
+    const uint8_t* t11 = texels + 4*((size_t)y1 * (size_t)width + (size_t)x1);
+
+    for (int k = 0; k < 4; k++) {
+        GLfloat bottom = t00[k] + fu * (t10[k] - t00[k]);
+        GLfloat top    = t01[k] + fu * (t11[k] - t01[k]);
+
+        color[k] = (bottom + fv * (top - bottom)) * (1.0f/255.0f);
+    }
+}
+
+
+static GLfloat blendFactor(GLenum factor, int channel, const GLfloat source[4], const GLfloat destination[4]) {
+
+    switch (factor) {
+        case GL_ZERO:                   return 0.0f;
+        case GL_ONE:                    return 1.0f;
+        case GL_SRC_COLOR:              return source[channel];
+        case GL_ONE_MINUS_SRC_COLOR:    return 1.0f - source[channel];
+        case GL_DST_COLOR:              return destination[channel];
+        case GL_ONE_MINUS_DST_COLOR:    return 1.0f - destination[channel];
+        case GL_SRC_ALPHA:              return source[3];
+        case GL_ONE_MINUS_SRC_ALPHA:    return 1.0f - source[3];
+        case GL_DST_ALPHA:              return destination[3];
+        case GL_ONE_MINUS_DST_ALPHA:    return 1.0f - destination[3];
+        case GL_SRC_ALPHA_SATURATE: {
+            GLfloat f = fminf(source[3], 1.0f - destination[3]);
+            return (channel == 3) ? 1.0f : f;
+        }
+        default:                        return 1.0f;
+    }
+}
+
+
+static uint8_t toUnorm8(GLfloat value) {
+
+    if (!(value > 0.0f)) {
+        return 0;
+    }
+    if (value >= 1.0f) {
+        return 255;
+    }
+    return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+
+static void writeColor(const SoftwareDraw* draw, uint8_t* pixel, const GLfloat color[4]) {
+
+    if (!draw->blending) {
+        for (int k = 0; k < 4; k++) {
+            pixel[k] = toUnorm8(color[k]);
+        }
+        return;
+    }
+
+    if (draw->sourceFactor == GL_ONE && draw->destinationFactor == GL_ONE_MINUS_SRC_ALPHA) {
+        // Premultiplied alpha (the engine's default): integer fast path
+        uint8_t  source[4];
+        for (int k = 0; k < 4; k++) {
+            source[k] = toUnorm8(color[k]);
+        }
+        uint32_t inverseAlpha = 255u - source[3];
+
+        for (int k = 0; k < 4; k++) {
+            uint32_t value = source[k] + (pixel[k] * inverseAlpha + 127u) / 255u;
+            pixel[k] = (uint8_t)((value > 255u) ? 255u : value);
+        }
+        return;
+    }
+
+    GLfloat source[4];
+    GLfloat destination[4];
+
+    for (int k = 0; k < 4; k++) {
+        source[k]      = fminf(fmaxf(color[k], 0.0f), 1.0f);
+        destination[k] = pixel[k] * (1.0f/255.0f);
+    }
+
+    for (int k = 0; k < 4; k++) {
+        GLfloat value = source[k]      * blendFactor(draw->sourceFactor,      k, source, destination)
+                      + destination[k] * blendFactor(draw->destinationFactor, k, source, destination);
+        pixel[k] = toUnorm8(value);
+    }
+}
+
+
+static void rasterizeTriangle(const SoftwareTriangle* triangle, const SoftwareDraw* draw, const GLint tile[4], uint64_t* fragmentCount) {
+
+    GLint x0 = (triangle->bounds[0] > tile[0]) ? triangle->bounds[0] : tile[0];
+    GLint y0 = (triangle->bounds[1] > tile[1]) ? triangle->bounds[1] : tile[1];
+    GLint x1 = (triangle->bounds[2] < tile[2]) ? triangle->bounds[2] : tile[2];
+    GLint y1 = (triangle->bounds[3] < tile[3]) ? triangle->bounds[3] : tile[3];
+
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+
+    // Edge functions at the center of the first pixel, and their steps
+    const int64_t half = 1 << (SubpixelBits - 1);
+    int64_t px = ((int64_t)x0 << SubpixelBits) + half;
+    int64_t py = ((int64_t)y0 << SubpixelBits) + half;
+
+    int64_t row[3];
+    int64_t stepX[3];
+    int64_t stepY[3];
+
+    for (int i = 0; i < 3; i++) {
+        row[i]   = triangle->a[i] * px + triangle->b[i] * py + triangle->c[i];
+        stepX[i] = triangle->a[i] * (1 << SubpixelBits);
+        stepY[i] = triangle->b[i] * (1 << SubpixelBits);
+    }
+
+    uint8_t* colors = draw->target ? (uint8_t *)draw->target->data : NULL;
+    GLfloat* depths = (draw->depthTest && draw->depth) ? (GLfloat *)draw->depth->data : NULL;
+
+    GLint colorWidth = draw->target ? draw->target->width : 0;
+    GLint depthWidth = draw->depth  ? draw->depth->width  : 0;
+
+    const GLfloat (*planes)[3] = triangle->planes;
+    GLfloat inverseArea = triangle->inverseArea;
+
+    uint64_t count = 0;
+
+    for (GLint y = y0; y <= y1; y++) {
+
+        int64_t w0 = row[0];
+        int64_t w1 = row[1];
+        int64_t w2 = row[2];
+
+        for (GLint x = x0; x <= x1; x++, w0 += stepX[0], w1 += stepX[1], w2 += stepX[2]) {
+
+            if ((w0 | w1 | w2) < 0) {
+                continue;
+            }
+
+            GLfloat l1 = (GLfloat)w1 * inverseArea;
+            GLfloat l2 = (GLfloat)w2 * inverseArea;
+
+            #define Interpolate(plane)  (planes[plane][0] + l1*planes[plane][1] + l2*planes[plane][2])
+
+            // Depth (fragments beyond the near/far planes are discarded)
+            GLfloat z = Interpolate(PlaneZ);
+
+            if (z < 0.0f || z > 1.0f) {
+                continue;
+            }
+
+            GLfloat* depth = NULL;
+
+            if (depths) {
+                depth = &depths[(size_t)y * (size_t)depthWidth + (size_t)x];
+
+                if (!(z < *depth)) {
+                    continue;
+                }
+            }
+
+            // Color
+            GLfloat color[4] = {
+                Interpolate(PlaneRed),
+                Interpolate(PlaneGreen),
+                Interpolate(PlaneBlue),
+                Interpolate(PlaneAlpha)
+            };
+
+            if (draw->textured) {
+                GLfloat texel[4];
+                sampleTexture(draw, Interpolate(PlaneS), Interpolate(PlaneT), texel);
+
+                for (int k = 0; k < 4; k++) {
+                    color[k] *= texel[k];
+                }
+            }
+
+            #undef Interpolate
+
+            if (draw->alphaTest && color[3] < 0.1f) {
+                continue;
+            }
+
+            if (depth) {
+                *depth = z;
+            }
+
+            if (colors) {
+                writeColor(draw, &colors[4*((size_t)y * (size_t)colorWidth + (size_t)x)], color);
+            }
+
+            count++;
+        }
+
+        for (int i = 0; i < 3; i++) {
+            row[i] += stepY[i];
+        }
+    }
+
+    *fragmentCount += count;
+}
+
+
+static void executeClear(const SoftwareDraw* draw, const GLint tile[4]) {
+
+    GLint x0 = (draw->bounds[0] > tile[0]) ? draw->bounds[0] : tile[0];
+    GLint y0 = (draw->bounds[1] > tile[1]) ? draw->bounds[1] : tile[1];
+    GLint x1 = (draw->bounds[2] < tile[2]) ? draw->bounds[2] : tile[2];
+    GLint y1 = (draw->bounds[3] < tile[3]) ? draw->bounds[3] : tile[3];
+
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+
+    if ((draw->clearMask & GL_COLOR_BUFFER_BIT) && draw->target) {
+
+        uint32_t value;
+        memcpy(&value, draw->clearColor, 4);
+
+        for (GLint y = y0; y <= y1; y++) {
+            uint8_t* pixel = (uint8_t *)draw->target->data + 4*((size_t)y * (size_t)draw->target->width + (size_t)x0);
+
+            for (GLint x = x0; x <= x1; x++, pixel += 4) {
+                memcpy(pixel, &value, 4);
+            }
+        }
+    }
+
+    if ((draw->clearMask & GL_DEPTH_BUFFER_BIT) && draw->depth) {
+
+        for (GLint y = y0; y <= y1; y++) {
+            GLfloat* depth = (GLfloat *)draw->depth->data + (size_t)y * (size_t)draw->depth->width + (size_t)x0;
+
+            for (GLint x = x0; x <= x1; x++) {
+                *depth++ = 1.0f;
+            }
+        }
+    }
+}
+
+
+static void executeTile(SoftwareRasterizer* rasterizer, uint32_t tileIndex, uint64_t* fragmentCount) {
+
+    const SoftwareBin* bin = &(rasterizer->bins[tileIndex]);
+
+    GLint column = (GLint)(tileIndex % rasterizer->tileColumns);
+    GLint row    = (GLint)(tileIndex / rasterizer->tileColumns);
+
+    GLint tile[4] = {
+        column * (GLint)TileSize,
+        row    * (GLint)TileSize,
+        column * (GLint)TileSize + (GLint)TileSize - 1,
+        row    * (GLint)TileSize + (GLint)TileSize - 1
+    };
+
+    for (uint32_t i = 0; i < bin->count; i++) {
+
+        uint32_t entry = bin->entries[i];
+
+        if (entry & ClearEntryFlag) {
+            executeClear(&(rasterizer->draws[entry & ~ClearEntryFlag]), tile);
+        }
+        else{
+            const SoftwareTriangle* triangle = &(rasterizer->triangles[entry]);
+            rasterizeTriangle(triangle, &(rasterizer->draws[triangle->draw]), tile, fragmentCount);
+        }
+    }
+}
+
+
+// .............................................................................
+#pragma mark - Queueing
+
+
+/**
+ Makes room for tiles covering width x height pixels. Returns 0 if out of
+ memory.
+ */
+static int reserveTiles(SoftwareRasterizer* rasterizer, GLsizei width, GLsizei height) {
+
+    GLuint columns = ((GLuint)width  + TileSize - 1) / TileSize;
+    GLuint rows    = ((GLuint)height + TileSize - 1) / TileSize;
+
+    if (columns <= rasterizer->tileColumns && rows <= rasterizer->tileRows) {
+        return 1;
+    }
+
+    // (The bins are indexed by tile position: execute what they hold first)
+    flushQueue(rasterizer);
+
+    if (columns < rasterizer->tileColumns) {
+        columns = rasterizer->tileColumns;
+    }
+    if (rows < rasterizer->tileRows) {
+        rows = rasterizer->tileRows;
+    }
+
+    SoftwareBin* bins = (SoftwareBin *)calloc((size_t)columns * rows, sizeof(SoftwareBin));
+
+    if (!bins) {
+        return 0;
+    }
+
+    uint32_t tileCount = rasterizer->tileColumns * rasterizer->tileRows;
+
+    for (uint32_t tile = 0; tile < tileCount; tile++) {
+        free(rasterizer->bins[tile].entries);
+    }
+    free(rasterizer->bins);
+
+    rasterizer->bins        = bins;
+    rasterizer->tileColumns = columns;
+    rasterizer->tileRows    = rows;
+
+    return 1;
+}
+
+
+static void binEntry(SoftwareRasterizer* rasterizer, const GLint bounds[4], uint32_t entry) {
+
+    GLuint column0 = (GLuint)bounds[0] / TileSize;
+    GLuint row0    = (GLuint)bounds[1] / TileSize;
+    GLuint column1 = (GLuint)bounds[2] / TileSize;
+    GLuint row1    = (GLuint)bounds[3] / TileSize;
+
+    for (GLuint row = row0; row <= row1; row++) {
+        for (GLuint column = column0; column <= column1; column++) {
+
+            SoftwareBin* bin = &(rasterizer->bins[row * rasterizer->tileColumns + column]);
+
+            if (bin->count == bin->capacity) {
+                uint32_t  capacity = bin->capacity ? 2*bin->capacity : 64;
+                uint32_t* entries  = (uint32_t *)realloc(bin->entries, capacity * sizeof(uint32_t));
+
+                if (!entries) {
+                    continue;   // (Dropped)
+                }
+                bin->entries  = entries;
+                bin->capacity = capacity;
+            }
+
+            bin->entries[bin->count++] = entry;
+        }
+    }
+}
+
+
+/**
+ Resolves the color and depth images of the bound framebuffer (not retained),
+ and the pixels both can be written (inclusive bounds). Returns 0 if there is
+ nothing to draw into.
+ */
+static int resolveTarget(SoftwareRasterizer* rasterizer, SoftwareImage** color, SoftwareImage** depth, GLint bounds[4]) {
+
+    *color = NULL;
+    *depth = NULL;
+
+    if (rasterizer->framebuffer == 0) {
+        *color = rasterizer->colorBuffer;
+        *depth = rasterizer->depthBuffer;
+    }
+    else{
+        SoftwareFramebuffer* framebuffer = (SoftwareFramebuffer *)tableItem(&(rasterizer->framebuffers), rasterizer->framebuffer);
+
+        if (!framebuffer) {
+            return 0;
+        }
+
+        if (framebuffer->colorTexture) {
+            pthread_mutex_lock(&(rasterizer->textureLock));
+            SoftwareTexture* texture = (SoftwareTexture *)tableItem(&(rasterizer->textures), framebuffer->colorTexture);
+            *color = texture ? texture->image : NULL;
+            pthread_mutex_unlock(&(rasterizer->textureLock));
+        }
+        else if (framebuffer->colorRenderbuffer) {
+            SoftwareRenderbuffer* renderbuffer = (SoftwareRenderbuffer *)tableItem(&(rasterizer->renderbuffers), framebuffer->colorRenderbuffer);
+            *color = renderbuffer ? renderbuffer->image : NULL;
+        }
+
+        SoftwareRenderbuffer* renderbuffer = (SoftwareRenderbuffer *)tableItem(&(rasterizer->renderbuffers), framebuffer->depthRenderbuffer);
+        *depth = renderbuffer ? renderbuffer->image : NULL;
+    }
+
+    if (!(*color) && !(*depth)) {
+        return 0;
+    }
+
+    // (Attachments of different sizes: the common area is rendered)
+    GLsizei width  = *color ? (*color)->width  : (*depth)->width;
+    GLsizei height = *color ? (*color)->height : (*depth)->height;
+
+    if (*depth) {
+        width  = (width  < (*depth)->width ) ? width  : (*depth)->width;
+        height = (height < (*depth)->height) ? height : (*depth)->height;
+    }
+
+    bounds[0] = 0;
+    bounds[1] = 0;
+    bounds[2] = width  - 1;
+    bounds[3] = height - 1;
+
+    return 1;
+}
+
+
+/**
+ Appends a draw (or clear) with the current state to the queue, and returns
+ its index (or -1 if there is nothing to draw into). Executes the queued work
+ first when it renders into the texture sampled now, or samples the images
+ rendered into now.
+ */
+static int64_t queueDraw(SoftwareRasterizer* rasterizer, GLbitfield clearMask, const SoftwareProgram* program) {
+
+    SoftwareDraw draw;
+    memset(&draw, 0, sizeof(SoftwareDraw));
+
+    if (!resolveTarget(rasterizer, &draw.target, &draw.depth, draw.bounds)) {
+        return -1;
+    }
+
+    if (!reserveTiles(rasterizer, draw.bounds[2] + 1, draw.bounds[3] + 1)) {
+        return -1;
+    }
+
+    // (The scissor test applies to clears, too)
+    if (rasterizer->scissorTest) {
+        const GLint* box = rasterizer->scissorBox;
+
+        GLint x1 = box[0] + box[2] - 1;
+        GLint y1 = box[1] + box[3] - 1;
+
+        draw.bounds[0] = (draw.bounds[0] > box[0]) ? draw.bounds[0] : box[0];
+        draw.bounds[1] = (draw.bounds[1] > box[1]) ? draw.bounds[1] : box[1];
+        draw.bounds[2] = (draw.bounds[2] < x1)     ? draw.bounds[2] : x1;
+        draw.bounds[3] = (draw.bounds[3] < y1)     ? draw.bounds[3] : y1;
+
+        if (draw.bounds[0] > draw.bounds[2] || draw.bounds[1] > draw.bounds[3]) {
+            return -1;
+        }
+    }
+
+    draw.clearMask = clearMask;
+
+    if (clearMask) {
+        for (int k = 0; k < 4; k++) {
+            draw.clearColor[k] = toUnorm8(rasterizer->clearColor[k]);
+        }
+    }
+    else{
+        draw.textured          = (program->kind != SoftwareProgramFlat);
+        draw.alphaTest         = (program->kind == SoftwareProgramSpriteAlphaTest);
+        draw.blending          = rasterizer->blending;
+        draw.depthTest         = rasterizer->depthTest;
+        draw.sourceFactor      = rasterizer->sourceFactor;
+        draw.destinationFactor = rasterizer->destinationFactor;
+
+        if (draw.textured) {
+            pthread_mutex_lock(&(rasterizer->textureLock));
+
+            SoftwareTexture* texture = (SoftwareTexture *)tableItem(&(rasterizer->textures), boundTexture);
+
+            if (texture && texture->image) {
+                draw.texture = imageRetain(texture->image);
+                draw.linear  = (texture->magFilter == GL_LINEAR);
+                draw.wrapS   = texture->wrapS;
+                draw.wrapT   = texture->wrapT;
+            }
+
+            pthread_mutex_unlock(&(rasterizer->textureLock));
+        }
+    }
+
+    // Hazards: read after write, write after read
+    int hazard = 0;
+
+    if (draw.texture && (draw.texture->pendingUse & PendingTarget)) {
+        hazard = 1;
+    }
+    if (draw.target && (draw.target->pendingUse & PendingSampled)) {
+        hazard = 1;
+    }
+    if (draw.depth && (draw.depth->pendingUse & PendingSampled)) {
+        hazard = 1;
+    }
+    if (hazard || rasterizer->triangleCount >= MaxQueuedTriangles) {
+        flushQueue(rasterizer);
+    }
+
+    if (rasterizer->drawCount == rasterizer->drawCapacity) {
+        uint32_t      capacity = rasterizer->drawCapacity ? 2*rasterizer->drawCapacity : 256;
+        SoftwareDraw* draws    = (SoftwareDraw *)realloc(rasterizer->draws, capacity * sizeof(SoftwareDraw));
+
+        if (!draws) {
+            imageRelease(draw.texture);
+            return -1;
+        }
+        rasterizer->draws        = draws;
+        rasterizer->drawCapacity = capacity;
+    }
+
+    if (draw.target) {
+        imageRetain(draw.target)->pendingUse |= PendingTarget;
+    }
+    if (draw.depth) {
+        imageRetain(draw.depth)->pendingUse |= PendingTarget;
+    }
+    if (draw.texture) {
+        draw.texture->pendingUse |= PendingSampled;
+    }
+
+    uint32_t index = rasterizer->drawCount++;
+    rasterizer->draws[index] = draw;
+    rasterizer->stats.draws++;
+
+    return index;
+}
+
+
+static void queueTriangle(SoftwareRasterizer* rasterizer, uint32_t drawIndex, const SoftwareVertex* v0, const SoftwareVertex* v1, const SoftwareVertex* v2) {
+
+    if (!v0->valid || !v1->valid || !v2->valid) {
+        return;
+    }
+
+    // 1. Fixed point window coordinates
+    const SoftwareVertex* vertices[3] = { v0, v1, v2 };
+    int64_t x[3];
+    int64_t y[3];
+
+    for (int i = 0; i < 3; i++) {
+        GLfloat vx = fminf(fmaxf(vertices[i]->x, -GuardBand), GuardBand);
+        GLfloat vy = fminf(fmaxf(vertices[i]->y, -GuardBand), GuardBand);
+
+        x[i] = (int64_t)lrintf(vx * (1 << SubpixelBits));
+        y[i] = (int64_t)lrintf(vy * (1 << SubpixelBits));
+    }
+
+    // 2. Orientation (make the area positive)
+    int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+
+    if (area == 0) {
+        return;
+    }
+    if (area < 0) {
+        int64_t swap;
+        swap = x[1]; x[1] = x[2]; x[2] = swap;
+        swap = y[1]; y[1] = y[2]; y[2] = swap;
+
+        const SoftwareVertex* vertex = vertices[1];
+        vertices[1] = vertices[2];
+        vertices[2] = vertex;
+
+        area = -area;
+    }
+
+    // 3. Bounds (pixels whose centers might be covered), clipped
+    const SoftwareDraw* draw = &(rasterizer->draws[drawIndex]);
+
+    int64_t minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+
+    for (int i = 1; i < 3; i++) {
+        minX = (x[i] < minX) ? x[i] : minX;
+        maxX = (x[i] > maxX) ? x[i] : maxX;
+        minY = (y[i] < minY) ? y[i] : minY;
+        maxY = (y[i] > maxY) ? y[i] : maxY;
+    }
+
+    GLint bounds[4] = {
+        (GLint)(minX >> SubpixelBits),
+        (GLint)(minY >> SubpixelBits),
+        (GLint)(maxX >> SubpixelBits),
+        (GLint)(maxY >> SubpixelBits)
+    };
+
+    GLint viewport[4] = {
+        rasterizer->viewport[0],
+        rasterizer->viewport[1],
+        rasterizer->viewport[0] + rasterizer->viewport[2] - 1,
+        rasterizer->viewport[1] + rasterizer->viewport[3] - 1
+    };
+
+    for (int i = 0; i < 2; i++) {
+        bounds[i] = (bounds[i] > draw->bounds[i]) ? bounds[i] : draw->bounds[i];
+        bounds[i] = (bounds[i] > viewport[i])     ? bounds[i] : viewport[i];
+    }
+    for (int i = 2; i < 4; i++) {
+        bounds[i] = (bounds[i] < draw->bounds[i]) ? bounds[i] : draw->bounds[i];
+        bounds[i] = (bounds[i] < viewport[i])     ? bounds[i] : viewport[i];
+    }
+
+    if (bounds[0] > bounds[2] || bounds[1] > bounds[3]) {
+        return;
+    }
+
+    if (rasterizer->triangleCount == rasterizer->triangleCapacity) {
+        uint32_t          capacity  = rasterizer->triangleCapacity ? 2*rasterizer->triangleCapacity : 1024;
+        SoftwareTriangle* triangles = (SoftwareTriangle *)realloc(rasterizer->triangles, capacity * sizeof(SoftwareTriangle));
+
+        if (!triangles) {
+            return;
+        }
+        rasterizer->triangles        = triangles;
+        rasterizer->triangleCapacity = capacity;
+    }
+
+    uint32_t          index    = rasterizer->triangleCount++;
+    SoftwareTriangle* triangle = &(rasterizer->triangles[index]);
+
+    // 4. Edge functions: edge i is opposite to vertex i. The fill rule: edges
+    //    that are shared are traversed in opposite directions by the two
+    //    triangles, so exactly one of them owns the pixels centered on it.
+    for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        int k = (i + 2) % 3;
+
+        int64_t a = y[j] - y[k];
+        int64_t b = x[k] - x[j];
+        int64_t c = x[j] * y[k] - y[j] * x[k];
+
+        int owner = (a > 0) || (a == 0 && b < 0);
+
+        triangle->a[i] = a;
+        triangle->b[i] = b;
+        triangle->c[i] = owner ? c : c - 1;
+    }
+
+    triangle->inverseArea = 1.0f / (GLfloat)area;
+
+    // 5. Values
+    for (int plane = 0; plane < PlaneCount; plane++) {
+        GLfloat value0 = vertices[0]->values[plane];
+
+        triangle->planes[plane][0] = value0;
+        triangle->planes[plane][1] = vertices[1]->values[plane] - value0;
+        triangle->planes[plane][2] = vertices[2]->values[plane] - value0;
+    }
+
+    memcpy(triangle->bounds, bounds, sizeof(bounds));
+    triangle->draw = drawIndex;
+
+    rasterizer->stats.triangles++;
+
+    binEntry(rasterizer, bounds, index);
+}
+
+
+// .............................................................................
+#pragma mark - Vertex Processing
+
+
+static size_t typeSize(GLenum type) {
+
+    switch (type) {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:      return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:     return 2;
+        default:                    return 4;   // GL_FLOAT, GL_INT, GL_UNSIGNED_INT
+    }
+}
+
+
+/**
+ Reads attribute value number index. Returns 0 if it lies outside its buffer.
+ */
+static int fetchAttribute(const SoftwareRasterizer* rasterizer, const SoftwareAttribute* attribute, GLuint index, GLfloat value[4]) {
+
+    value[0] = value[1] = value[2] = 0.0f;
+    value[3] = 1.0f;
+
+    if (!attribute->enabled) {
+        return 1;
+    }
+
+    const SoftwareBuffer* buffer = (const SoftwareBuffer *)tableItem(&(rasterizer->buffers), attribute->buffer);
+
+    if (!buffer) {
+        return 0;
+    }
+
+    size_t componentSize = typeSize(attribute->type);
+    size_t stride        = attribute->stride ? (size_t)attribute->stride : componentSize * (size_t)attribute->size;
+    size_t start         = attribute->offset + (size_t)index * stride;
+
+    if (start + componentSize * (size_t)attribute->size > buffer->size) {
+        return 0;
+    }
+
+    const uint8_t* data = buffer->data + start;
+
+    for (GLint k = 0; k < attribute->size && k < 4; k++) {
+        switch (attribute->type) {
+            case GL_FLOAT: {
+                GLfloat component;
+                memcpy(&component, data + 4*k, 4);
+                value[k] = component;
+                break;
+            }
+            case GL_UNSIGNED_BYTE:
+                value[k] = attribute->normalized ? data[k] * (1.0f/255.0f) : data[k];
+                break;
+
+            case GL_BYTE:
+                value[k] = attribute->normalized ? fmaxf(((int8_t)data[k]) * (1.0f/127.0f), -1.0f) : (int8_t)data[k];
+                break;
+
+            case GL_UNSIGNED_SHORT: {
+                uint16_t component;
+                memcpy(&component, data + 2*k, 2);
+                value[k] = attribute->normalized ? component * (1.0f/65535.0f) : component;
+                break;
+            }
+            case GL_SHORT: {
+                int16_t component;
+                memcpy(&component, data + 2*k, 2);
+                value[k] = attribute->normalized ? fmaxf(component * (1.0f/32767.0f), -1.0f) : component;
+                break;
+            }
+            default: {
+                int32_t component;
+                memcpy(&component, data + 4*k, 4);
+                value[k] = (GLfloat)component;
+                break;
+            }
+        }
+    }
+
+    return 1;
+}
+
+
+static void transform(const GLfloat matrix[16], const GLfloat vector[4], GLfloat result[4]) {
+
+    // (Column-major, as uploaded with transpose = GL_FALSE)
+    for (int row = 0; row < 4; row++) {
+        result[row] = matrix[row]      * vector[0]
+                    + matrix[row +  4] * vector[1]
+                    + matrix[row +  8] * vector[2]
+                    + matrix[row + 12] * vector[3];
+    }
+}
+
+
+/**
+ The "vertex shader" of each program kind, plus the viewport transform.
+ Returns 0 if the vertex data is out of bounds.
+ */
+static int processVertex(const SoftwareRasterizer* rasterizer, const SoftwareProgram* program, const SoftwareVertexArray* vertexArray, GLuint index, SoftwareVertex* vertex) {
+
+    const SoftwareAttribute* attributes = vertexArray->attributes;
+
+    GLfloat position[4];
+    GLfloat textureCoord[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    GLfloat color[4];
+
+    if (!fetchAttribute(rasterizer, &attributes[AttributePosition], index, position)) {
+        return 0;
+    }
+
+    GLfloat clip[4];
+
+    if (program->kind == SoftwareProgramSpriteBatch) {
+        // Projection * vec4(Position, 1)
+        position[3] = 1.0f;
+        transform(program->projection, position, clip);
+
+        if (!fetchAttribute(rasterizer, &attributes[AttributeColor], index, color)) {
+            return 0;
+        }
+    }
+    else{
+        // Projection * Modelview * vec4(Position, Z, 1)
+        GLfloat eye[4];
+
+        position[2] = program->z;
+        position[3] = 1.0f;
+        transform(program->modelview,  position, eye);
+        transform(program->projection, eye,      clip);
+
+        memcpy(color, program->color, sizeof(color));
+    }
+
+    if (program->kind != SoftwareProgramFlat) {
+        if (!fetchAttribute(rasterizer, &attributes[AttributeTextureCoord], index, textureCoord)) {
+            return 0;
+        }
+    }
+
+    vertex->valid = (clip[3] > 0.0f);
+
+    if (!vertex->valid) {
+        return 1;
+    }
+
+    GLfloat inverseW = 1.0f / clip[3];
+    const GLint* viewport = rasterizer->viewport;
+
+    vertex->x = viewport[0] + (clip[0] * inverseW + 1.0f) * 0.5f * viewport[2];
+    vertex->y = viewport[1] + (clip[1] * inverseW + 1.0f) * 0.5f * viewport[3];
+
+    vertex->values[PlaneZ]     = (clip[2] * inverseW + 1.0f) * 0.5f;
+    vertex->values[PlaneS]     = textureCoord[0];
+    vertex->values[PlaneT]     = textureCoord[1];
+    vertex->values[PlaneRed]   = color[0];
+    vertex->values[PlaneGreen] = color[1];
+    vertex->values[PlaneBlue]  = color[2];
+    vertex->values[PlaneAlpha] = color[3];
+
+    return 1;
+}
+
+
+static GLuint readIndex(const uint8_t* indices, GLenum type, GLsizei i) {
+
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+            return indices[i];
+
+        case GL_UNSIGNED_SHORT: {
+            uint16_t index;
+            memcpy(&index, indices + 2*(size_t)i, 2);
+            return index;
+        }
+        default: {
+            uint32_t index;
+            memcpy(&index, indices + 4*(size_t)i, 4);
+            return index;
+        }
+    }
+}
+
+
+/**
+ Runs the vertices (indices, or first..first+count-1 if indices is NULL)
+ through the current program, and queues the resulting triangles.
+ */
+static void drawPrimitives(SoftwareRasterizer* rasterizer, GLenum mode, GLint first, GLsizei count, const uint8_t* indices, GLenum indexType) {
+
+    if (mode != GL_TRIANGLES && mode != GL_TRIANGLE_STRIP && mode != GL_TRIANGLE_FAN) {
+        return;     // (Points and lines: not used by the engine)
+    }
+    if (count < 3) {
+        return;
+    }
+
+    const SoftwareProgram*     program     = (const SoftwareProgram *)tableItem(&(rasterizer->programs), rasterizer->program);
+    const SoftwareVertexArray* vertexArray = (const SoftwareVertexArray *)tableItem(&(rasterizer->vertexArrays), rasterizer->vertexArray);
+
+    if (!program || !vertexArray) {
+        return;
+    }
+
+    if ((size_t)count > rasterizer->vertexCapacity) {
+        SoftwareVertex* vertices = (SoftwareVertex *)realloc(rasterizer->vertices, (size_t)count * sizeof(SoftwareVertex));
+
+        if (!vertices) {
+            return;
+        }
+        rasterizer->vertices       = vertices;
+        rasterizer->vertexCapacity = (size_t)count;
+    }
+
+    // 1. Vertices (any out of bounds drops the whole call)
+    SoftwareVertex* vertices = rasterizer->vertices;
+
+    for (GLsizei i = 0; i < count; i++) {
+        GLuint index = indices ? readIndex(indices, indexType, i) : (GLuint)(first + i);
+
+        if (!processVertex(rasterizer, program, vertexArray, index, &vertices[i])) {
+            return;
+        }
+    }
+
+    int64_t drawIndex = queueDraw(rasterizer, 0, program);
+
+    if (drawIndex < 0) {
+        return;
+    }
+
+    // 2. Triangles
+    switch (mode) {
+        case GL_TRIANGLES:
+            for (GLsizei i = 0; i + 2 < count; i += 3) {
+                queueTriangle(rasterizer, (uint32_t)drawIndex, &vertices[i], &vertices[i + 1], &vertices[i + 2]);
+            }
+            break;
+
+        case GL_TRIANGLE_STRIP:
+            for (GLsizei i = 0; i + 2 < count; i++) {
+                queueTriangle(rasterizer, (uint32_t)drawIndex, &vertices[i], &vertices[i + 1], &vertices[i + 2]);
+            }
+            break;
+
+        default:    // GL_TRIANGLE_FAN
+            for (GLsizei i = 1; i + 1 < count; i++) {
+                queueTriangle(rasterizer, (uint32_t)drawIndex, &vertices[0], &vertices[i], &vertices[i + 1]);
+            }
+            break;
+    }
+}
+
+
+// .............................................................................
+#pragma mark - Backend: General State
+
+
+static void swViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+
+    glDispatchCountStateChange();
+
+    if (current) {
+        current->viewport[0] = x;
+        current->viewport[1] = y;
+        current->viewport[2] = width;
+        current->viewport[3] = height;
+    }
+}
+
+static void swScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+
+    glDispatchCountStateChange();
+
+    if (current) {
+        current->scissorBox[0] = x;
+        current->scissorBox[1] = y;
+        current->scissorBox[2] = width;
+        current->scissorBox[3] = height;
+    }
+}
+
+static void swClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+
+    glDispatchCountStateChange();
+
+    if (current) {
+        current->clearColor[0] = red;
+        current->clearColor[1] = green;
+        current->clearColor[2] = blue;
+        current->clearColor[3] = alpha;
+    }
+}
+
+static void swClear(GLbitfield mask) {
+
+    glDispatchCountCall();
+
+    mask &= (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (!current || !mask) {
+        return;
+    }
+
+    int64_t drawIndex = queueDraw(current, mask, NULL);
+
+    if (drawIndex >= 0) {
+        binEntry(current, current->draws[drawIndex].bounds, (uint32_t)drawIndex | ClearEntryFlag);
+    }
+}
+
+static void swSetCapability(GLenum capability, int enabled) {
+
+    glDispatchCountStateChange();
+
+    if (!current) {
+        return;
+    }
+
+    switch (capability) {
+        case GL_BLEND:
+            current->blending = enabled;
+            break;
+
+        case GL_DEPTH_TEST:
+            current->depthTest = enabled;
+            break;
+
+        case GL_SCISSOR_TEST:
+            current->scissorTest = enabled;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void swEnable(GLenum capability) {
+    swSetCapability(capability, 1);
+}
+
+static void swDisable(GLenum capability) {
+    swSetCapability(capability, 0);
+}
+
+static void swBlendFunc(GLenum sourceFactor, GLenum destinationFactor) {
+
+    glDispatchCountStateChange();
+
+    if (current) {
+        current->sourceFactor      = sourceFactor;
+        current->destinationFactor = destinationFactor;
+    }
+}
+
+
+// .............................................................................
+#pragma mark - Backend: Textures
+
+
+static void swGenTextures(GLsizei count, GLuint* textures) {
+
+    glDispatchCountCall();
+
+    if (!current) {
+        memset(textures, 0, (size_t)count * sizeof(GLuint));
+        return;
+    }
+
+    pthread_mutex_lock(&(current->textureLock));
+
+    for (GLsizei i = 0; i < count; i++) {
+        textures[i] = tableGenerate(&(current->textures));
+
+        SoftwareTexture* texture = (SoftwareTexture *)tableItem(&(current->textures), textures[i]);
+
+        if (texture) {
+            texture->magFilter = GL_LINEAR;
+            texture->wrapS     = GL_REPEAT;
+            texture->wrapT     = GL_REPEAT;
+        }
+    }
+
+    pthread_mutex_unlock(&(current->textureLock));
+}
+
+static void swDeleteTextures(GLsizei count, const GLuint* textures) {
+
+    glDispatchCountCall();
+
+    if (!current) {
+        return;
+    }
+
+    pthread_mutex_lock(&(current->textureLock));
+
+    for (GLsizei i = 0; i < count; i++) {
+        SoftwareTexture* texture = (SoftwareTexture *)tableItem(&(current->textures), textures[i]);
+
+        if (texture) {
+            // (Queued draws keep their reference to the image)
+            imageRelease(texture->image);
+            memset(texture, 0, sizeof(SoftwareTexture));
+        }
+        if (boundTexture == textures[i]) {
+            boundTexture = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&(current->textureLock));
+}
+
+static void swBindTexture(GLenum target, GLuint texture) {
+
+    glDispatchCountStateChange();
+
+    if (target == GL_TEXTURE_2D) {
+        boundTexture = texture;
+    }
+}
+
+static void swTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels) {
+    (void)target; (void)internalFormat; (void)border;
+
+    glDispatchCountUpload(pixels ? glDispatchPixelDataSize(width, height, format, type) : 0);
+
+    if (!current || level != 0) {
+        return;
+    }
+
+    // (Queued draws keep reading the previous image, if any)
+    SoftwareImage* image = imageCreate(width, height, 4);
+
+    if (image && pixels) {
+        imageStore(image, 0, 0, width, height, format, type, pixels);
+    }
+
+    pthread_mutex_lock(&(current->textureLock));
+
+    SoftwareTexture* texture = (SoftwareTexture *)tableItem(&(current->textures), boundTexture);
+
+    if (texture) {
+        imageRelease(texture->image);
+        texture->image = image;
+        image = NULL;
+    }
+
+    pthread_mutex_unlock(&(current->textureLock));
+
+    imageRelease(image);
+}
+
+static void swTexSubImage2D(GLenum target, GLint level, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels) {
+    (void)target;
+
+    glDispatchCountUpload(glDispatchPixelDataSize(width, height, format, type));
+
+    if (!current || level != 0 || width <= 0 || height <= 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&(current->textureLock));
+
+    SoftwareTexture* texture = (SoftwareTexture *)tableItem(&(current->textures), boundTexture);
+    SoftwareImage*   image   = texture ? texture->image : NULL;
+
+    if (image && xOffset >= 0 && yOffset >= 0 && xOffset + width <= image->width && yOffset + height <= image->height) {
+
+        if (atomic_load(&(image->refCount)) > 1) {
+            // Queued draws reference the current contents
+
+            if ((image->pendingUse & PendingTarget) && pthread_equal(pthread_self(), current->drawingThread)) {
+                // ...and render into them: complete them first
+                flushQueue(current);
+            }
+
+            if (atomic_load(&(image->refCount)) > 1) {
+                // ...and sample them: give them a copy of their own
+                SoftwareImage* copy = imageCreate(image->width, image->height, 4);
+
+                if (copy) {
+                    memcpy(copy->data, image->data, 4*(size_t)image->width*(size_t)image->height);
+                    imageRelease(image);
+                    texture->image = image = copy;
+                }
+                else{
+                    image = NULL;
+                }
+            }
+        }
+
+        if (image) {
+            imageStore(image, xOffset, yOffset, width, height, format, type, pixels);
+        }
+    }
+
+    pthread_mutex_unlock(&(current->textureLock));
+}
+
+static void swCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data) {
+    (void)target; (void)internalFormat; (void)border;
+
+    glDispatchCountUpload(data ? (size_t)imageSize : 0);
+
+    if (!current || level != 0) {
+        return;
+    }
+
+    // Not decoded: opaque magenta
+    SoftwareImage* image = imageCreate(width, height, 4);
+
+    if (image) {
+        uint8_t* texel = (uint8_t *)image->data;
+        size_t   count = (size_t)width * (size_t)height;
+
+        for (size_t i = 0; i < count; i++, texel += 4) {
+            texel[0] = 255;
+            texel[1] = 0;
+            texel[2] = 255;
+            texel[3] = 255;
+        }
+    }
+
+    pthread_mutex_lock(&(current->textureLock));
+
+    SoftwareTexture* texture = (SoftwareTexture *)tableItem(&(current->textures), boundTexture);
+
+    if (texture) {
+        imageRelease(texture->image);
+        texture->image = image;
+        image = NULL;
+    }
+
+    pthread_mutex_unlock(&(current->textureLock));
+
+    imageRelease(image);
+}
+
+static void swTexParameteri(GLenum target, GLenum parameter, GLint value) {
+    (void)target;
+
+    glDispatchCountStateChange();
+
+    if (!current) {
+        return;
+    }
+
+    pthread_mutex_lock(&(current->textureLock));
+
+    SoftwareTexture* texture = (SoftwareTexture *)tableItem(&(current->textures), boundTexture);
+
+    if (texture) {
+        switch (parameter) {
+            case GL_TEXTURE_MAG_FILTER:
+                texture->magFilter = (GLenum)value;
+                break;
+
+            case GL_TEXTURE_WRAP_S:
+                texture->wrapS = (GLenum)value;
+                break;
+
+            case GL_TEXTURE_WRAP_T:
+                texture->wrapT = (GLenum)value;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    pthread_mutex_unlock(&(current->textureLock));
+}
+
+
+// .............................................................................
+#pragma mark - Backend: Buffers
+
+
+static void swGenBuffers(GLsizei count, GLuint* buffers) {
+
+    glDispatchCountCall();
+
+    for (GLsizei i = 0; i < count; i++) {
+        buffers[i] = current ? tableGenerate(&(current->buffers)) : 0;
+    }
+}
+
+static void swDeleteBuffers(GLsizei count, const GLuint* buffers) {
+
+    glDispatchCountCall();
+
+    if (!current) {
+        return;
+    }
+
+    for (GLsizei i = 0; i < count; i++) {
+        SoftwareBuffer* buffer = (SoftwareBuffer *)tableItem(&(current->buffers), buffers[i]);
+
+        if (buffer) {
+            free(buffer->data);
+            memset(buffer, 0, sizeof(SoftwareBuffer));
+        }
+        if (current->arrayBuffer == buffers[i]) {
+            current->arrayBuffer = 0;
+        }
+    }
+}
+
+static SoftwareBuffer* boundBuffer(GLenum target) {
+
+    if (target == GL_ARRAY_BUFFER) {
+        return (SoftwareBuffer *)tableItem(&(current->buffers), current->arrayBuffer);
+    }
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        SoftwareVertexArray* vertexArray = (SoftwareVertexArray *)tableItem(&(current->vertexArrays), current->vertexArray);
+        return vertexArray ? (SoftwareBuffer *)tableItem(&(current->buffers), vertexArray->elementBuffer) : NULL;
+    }
+    return NULL;
+}
+
+static void swBindBuffer(GLenum target, GLuint buffer) {
+
+    glDispatchCountStateChange();
+
+    if (!current) {
+        return;
+    }
+
+    if (target == GL_ARRAY_BUFFER) {
+        current->arrayBuffer = buffer;
+    }
+    else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        SoftwareVertexArray* vertexArray = (SoftwareVertexArray *)tableItem(&(current->vertexArrays), current->vertexArray);
+
+        if (vertexArray) {
+            vertexArray->elementBuffer = buffer;
+        }
+    }
+}
+
+static void swBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage) {
+    (void)usage;
+
+    glDispatchCountUpload(data ? (size_t)size : 0);
+
+    if (!current || size < 0) {
+        return;
+    }
+
+    SoftwareBuffer* buffer = boundBuffer(target);
+
+    if (!buffer) {
+        return;
+    }
+
+    // (Vertex data is consumed when the draw call is made; no need to keep
+    //  the previous contents around)
+    uint8_t* storage = (uint8_t *)realloc(buffer->data, size ? (size_t)size : 1);
+
+    if (!storage) {
+        return;
+    }
+
+    buffer->data = storage;
+    buffer->size = (size_t)size;
+
+    if (data) {
+        memcpy(buffer->data, data, (size_t)size);
+    }
+    else{
+        memset(buffer->data, 0, (size_t)size);
+    }
+}
+
+static void swBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data) {
+
+    glDispatchCountUpload((size_t)size);
+
+    if (!current || offset < 0 || size < 0) {
+        return;
+    }
+
+    SoftwareBuffer* buffer = boundBuffer(target);
+
+    if (buffer && (size_t)offset + (size_t)size <= buffer->size) {
+        memcpy(buffer->data + offset, data, (size_t)size);
+    }
+}
+
+
+// .............................................................................
+#pragma mark - Backend: Vertex Arrays
+
+
+static void swGenVertexArrays(GLsizei count, GLuint* arrays) {
+
+    glDispatchCountCall();
+
+    for (GLsizei i = 0; i < count; i++) {
+        arrays[i] = current ? tableGenerate(&(current->vertexArrays)) : 0;
+    }
+}
+
+static void swDeleteVertexArrays(GLsizei count, const GLuint* arrays) {
+
+    glDispatchCountCall();
+
+    if (!current) {
+        return;
+    }
+
+    for (GLsizei i = 0; i < count; i++) {
+        if (arrays[i] == 0) {
+            continue;
+        }
+
+        SoftwareVertexArray* vertexArray = (SoftwareVertexArray *)tableItem(&(current->vertexArrays), arrays[i]);
+
+        if (vertexArray) {
+            vertexArray->exists = 0;
+        }
+        if (current->vertexArray == arrays[i]) {
+            current->vertexArray = 0;
+        }
+    }
+}
+
+static void swBindVertexArray(GLuint array) {
+
+    glDispatchCountStateChange();
+
+    if (current) {
+        current->vertexArray = array;
+    }
+}
+
+static SoftwareAttribute* boundAttribute(GLuint index) {
+
+    SoftwareVertexArray* vertexArray = (SoftwareVertexArray *)tableItem(&(current->vertexArrays), current->vertexArray);
+
+    if (!vertexArray || index >= MaxAttributes) {
+        return NULL;
+    }
+    return &(vertexArray->attributes[index]);
+}
+
+static void swEnableVertexAttribArray(GLuint index) {
+
+    glDispatchCountStateChange();
+
+    SoftwareAttribute* attribute = current ? boundAttribute(index) : NULL;
+
+    if (attribute) {
+        attribute->enabled = GL_TRUE;
+    }
+}
+
+static void swDisableVertexAttribArray(GLuint index) {
+
+    glDispatchCountStateChange();
+
+    SoftwareAttribute* attribute = current ? boundAttribute(index) : NULL;
+
+    if (attribute) {
+        attribute->enabled = GL_FALSE;
+    }
+}
+
+static void swVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer) {
+
+    glDispatchCountStateChange();
+
+    SoftwareAttribute* attribute = current ? boundAttribute(index) : NULL;
+
+    if (attribute) {
+        attribute->size       = size;
+        attribute->type       = type;
+        attribute->normalized = normalized;
+        attribute->stride     = stride;
+        attribute->offset     = (size_t)pointer;
+        attribute->buffer     = current->arrayBuffer;
+    }
+}
+
+static GLint swGetAttribLocation(GLuint program, const GLchar* name) {
+
+    glDispatchCountCall();
+
+    const SoftwareProgram* object = current ? (const SoftwareProgram *)tableItem(&(current->programs), program) : NULL;
+
+    if (!object) {
+        return -1;
+    }
+
+    if (strcmp(name, "Position") == 0) {
+        return AttributePosition;
+    }
+    if (strcmp(name, "TextureCoord") == 0 && object->kind != SoftwareProgramFlat) {
+        return AttributeTextureCoord;
+    }
+    if (strcmp(name, "Color") == 0 && object->kind == SoftwareProgramSpriteBatch) {
+        return AttributeColor;
+    }
+    return -1;
+}
+
+
+// .............................................................................
+#pragma mark - Backend: Programs
+
+
+static SoftwareProgram* usedProgram(void) {
+    return current ? (SoftwareProgram *)tableItem(&(current->programs), current->program) : NULL;
+}
+
+static void swUseProgram(GLuint program) {
+
+    glDispatchCountStateChange();
+
+    if (current) {
+        current->program = program;
+    }
+}
+
+static void swDeleteProgram(GLuint program) {
+
+    glDispatchCountCall();
+
+    SoftwareProgram* object = current ? (SoftwareProgram *)tableItem(&(current->programs), program) : NULL;
+
+    if (object) {
+        object->exists = 0;
+    }
+}
+
+static GLint swGetUniformLocation(GLuint program, const GLchar* name) {
+
+    glDispatchCountCall();
+
+    const SoftwareProgram* object = current ? (const SoftwareProgram *)tableItem(&(current->programs), program) : NULL;
+
+    if (!object) {
+        return -1;
+    }
+
+    int batch    = (object->kind == SoftwareProgramSpriteBatch);
+    int textured = (object->kind != SoftwareProgramFlat);
+
+    if (strcmp(name, "Projection") == 0) {
+        return UniformProjection;
+    }
+    if (strcmp(name, "Modelview") == 0 && !batch) {
+        return UniformModelview;
+    }
+    if (strcmp(name, "Color") == 0 && !batch) {
+        return UniformColor;
+    }
+    if (strcmp(name, "Z") == 0 && !batch) {
+        return UniformZ;
+    }
+    if (strcmp(name, "Sampler") == 0 && textured) {
+        return UniformSampler;
+    }
+    return -1;
+}
+
+static void swUniform1i(GLint location, GLint value) {
+    (void)location; (void)value;
+
+    // (Sampler: only texture unit 0 exists)
+    glDispatchCountStateChange();
+}
+
+static void swUniform1f(GLint location, GLfloat value) {
+
+    glDispatchCountStateChange();
+
+    SoftwareProgram* program = usedProgram();
+
+    if (program && location == UniformZ) {
+        program->z = value;
+    }
+}
+
+static void swUniformfv(GLint location, GLsizei count, const GLfloat* value) {
+    (void)location; (void)count; (void)value;
+
+    // (No vec2/vec3 uniforms in the default programs)
+    glDispatchCountStateChange();
+}
+
+static void swUniform4fv(GLint location, GLsizei count, const GLfloat* value) {
+
+    glDispatchCountStateChange();
+
+    SoftwareProgram* program = usedProgram();
+
+    if (program && location == UniformColor && count > 0) {
+        memcpy(program->color, value, 4*sizeof(GLfloat));
+    }
+}
+
+static void swUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+
+    glDispatchCountStateChange();
+
+    SoftwareProgram* program = usedProgram();
+    GLfloat*         matrix  = NULL;
+
+    if (program && count > 0) {
+        if (location == UniformProjection) {
+            matrix = program->projection;
+        }
+        else if (location == UniformModelview) {
+            matrix = program->modelview;
+        }
+    }
+
+    if (!matrix) {
+        return;
+    }
+
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            matrix[4*column + row] = transpose ? value[4*row + column] : value[4*column + row];
+        }
+    }
+}
+
+
+// .............................................................................
+#pragma mark - Backend: Drawing
+
+
+static void swDrawArrays(GLenum mode, GLint first, GLsizei count) {
+
+    glDispatchCountDraw(count);
+
+    if (current && first >= 0) {
+        drawPrimitives(current, mode, first, count, NULL, 0);
+    }
+}
+
+static void swDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices) {
+
+    glDispatchCountDraw(count);
+
+    if (!current || count <= 0) {
+        return;
+    }
+
+    // Indices are an offset into the element array buffer (client-side
+    // arrays are not supported; the engine does not use them)
+    SoftwareBuffer* buffer = boundBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    size_t          offset = (size_t)indices;
+
+    if (!buffer || offset + (size_t)count * typeSize(type) > buffer->size) {
+        return;
+    }
+
+    drawPrimitives(current, mode, 0, count, buffer->data + offset, type);
+}
+
+
+// .............................................................................
+#pragma mark - Backend: Framebuffers
+
+
+static void swGenFramebuffers(GLsizei count, GLuint* framebuffers) {
+
+    glDispatchCountCall();
+
+    for (GLsizei i = 0; i < count; i++) {
+        framebuffers[i] = current ? tableGenerate(&(current->framebuffers)) : 0;
+    }
+}
+
+static void swDeleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+
+    glDispatchCountCall();
+
+    if (!current) {
+        return;
+    }
+
+    for (GLsizei i = 0; i < count; i++) {
+        SoftwareFramebuffer* framebuffer = (SoftwareFramebuffer *)tableItem(&(current->framebuffers), framebuffers[i]);
+
+        if (framebuffer) {
+            framebuffer->exists = 0;
+        }
+        if (current->framebuffer == framebuffers[i]) {
+            current->framebuffer = 0;
+        }
+    }
+}
+
+static void swBindFramebuffer(GLenum target, GLuint framebuffer) {
+    (void)target;
+
+    glDispatchCountStateChange();
+
+    if (current) {
+        current->framebuffer = framebuffer;
+    }
+}
+
+static void swFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textureTarget, GLuint texture, GLint level) {
+    (void)target; (void)textureTarget; (void)level;
+
+    glDispatchCountStateChange();
+
+    SoftwareFramebuffer* framebuffer = current ? (SoftwareFramebuffer *)tableItem(&(current->framebuffers), current->framebuffer) : NULL;
+
+    if (framebuffer && attachment == GL_COLOR_ATTACHMENT0) {
+        framebuffer->colorTexture      = texture;
+        framebuffer->colorRenderbuffer = 0;
+    }
+}
+
+static GLenum swCheckFramebufferStatus(GLenum target) {
+    (void)target;
+
+    glDispatchCountCall();
+
+    if (!current || current->framebuffer == 0) {
+        return GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    SoftwareFramebuffer* framebuffer = (SoftwareFramebuffer *)tableItem(&(current->framebuffers), current->framebuffer);
+
+    if (!framebuffer) {
+        return GL_FRAMEBUFFER_UNSUPPORTED;
+    }
+    if (!framebuffer->colorTexture && !framebuffer->colorRenderbuffer && !framebuffer->depthRenderbuffer) {
+        return GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT;
+    }
+
+    SoftwareImage* color;
+    SoftwareImage* depth;
+    GLint          bounds[4];
+
+    if (!resolveTarget(current, &color, &depth, bounds)) {
+        return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+    }
+    if ((framebuffer->colorTexture || framebuffer->colorRenderbuffer) && !color) {
+        return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+    }
+    if (framebuffer->depthRenderbuffer && !depth) {
+        return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+    }
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void swGenRenderbuffers(GLsizei count, GLuint* renderbuffers) {
+
+    glDispatchCountCall();
+
+    for (GLsizei i = 0; i < count; i++) {
+        renderbuffers[i] = current ? tableGenerate(&(current->renderbuffers)) : 0;
+    }
+}
+
+static void swDeleteRenderbuffers(GLsizei count, const GLuint* renderbuffers) {
+
+    glDispatchCountCall();
+
+    if (!current) {
+        return;
+    }
+
+    for (GLsizei i = 0; i < count; i++) {
+        SoftwareRenderbuffer* renderbuffer = (SoftwareRenderbuffer *)tableItem(&(current->renderbuffers), renderbuffers[i]);
+
+        if (renderbuffer) {
+            imageRelease(renderbuffer->image);
+            memset(renderbuffer, 0, sizeof(SoftwareRenderbuffer));
+        }
+        if (current->renderbuffer == renderbuffers[i]) {
+            current->renderbuffer = 0;
+        }
+    }
+}
+
+static void swBindRenderbuffer(GLenum target, GLuint renderbuffer) {
+    (void)target;
+
+    glDispatchCountStateChange();
+
+    if (current) {
+        current->renderbuffer = renderbuffer;
+    }
+}
+
+static int isDepthFormat(GLenum internalFormat) {
+
+    switch (internalFormat) {
+        case GL_DEPTH_COMPONENT:
+        case GL_DEPTH_COMPONENT16:
+#ifdef GL_DEPTH_COMPONENT24
+        case GL_DEPTH_COMPONENT24:
+#endif
+#ifdef GL_DEPTH24_STENCIL8
+        case GL_DEPTH24_STENCIL8:
+#endif
+#ifdef GL_DEPTH_COMPONENT24_OES
+        case GL_DEPTH_COMPONENT24_OES:
+#endif
+#ifdef GL_DEPTH24_STENCIL8_OES
+        case GL_DEPTH24_STENCIL8_OES:
+#endif
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static void swRenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height) {
+    (void)target;
+
+    glDispatchCountCall();
+
+    SoftwareRenderbuffer* renderbuffer = current ? (SoftwareRenderbuffer *)tableItem(&(current->renderbuffers), current->renderbuffer) : NULL;
+
+    if (!renderbuffer) {
+        return;
+    }
+
+    int isDepth = isDepthFormat(internalFormat);
+
+    // (Queued draws keep writing into the previous image, if any)
+    imageRelease(renderbuffer->image);
+
+    renderbuffer->internalFormat = internalFormat;
+    renderbuffer->image          = imageCreate(width, height, isDepth ? sizeof(GLfloat) : 4);
+
+    if (renderbuffer->image && isDepth) {
+        imageFillDepth(renderbuffer->image, 1.0f);
+    }
+}
+
+static void swFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer) {
+    (void)target; (void)renderbufferTarget;
+
+    glDispatchCountStateChange();
+
+    SoftwareFramebuffer* framebuffer = current ? (SoftwareFramebuffer *)tableItem(&(current->framebuffers), current->framebuffer) : NULL;
+
+    if (!framebuffer) {
+        return;
+    }
+
+    switch (attachment) {
+        case GL_COLOR_ATTACHMENT0:
+            framebuffer->colorRenderbuffer = renderbuffer;
+            framebuffer->colorTexture      = 0;
+            break;
+
+        case GL_DEPTH_ATTACHMENT:
+#ifdef GL_DEPTH_STENCIL_ATTACHMENT
+        case GL_DEPTH_STENCIL_ATTACHMENT:
+#endif
+            framebuffer->depthRenderbuffer = renderbuffer;
+            break;
+
+        default:    // (Stencil: not supported)
+            break;
+    }
+}
+
+static void swGetRenderbufferParameteriv(GLenum target, GLenum parameter, GLint* value) {
+    (void)target;
+
+    glDispatchCountCall();
+
+    SoftwareRenderbuffer* renderbuffer = current ? (SoftwareRenderbuffer *)tableItem(&(current->renderbuffers), current->renderbuffer) : NULL;
+    SoftwareImage*        image        = renderbuffer ? renderbuffer->image : NULL;
+
+    switch (parameter) {
+        case GL_RENDERBUFFER_WIDTH:
+            *value = image ? image->width : 0;
+            break;
+
+        case GL_RENDERBUFFER_HEIGHT:
+            *value = image ? image->height : 0;
+            break;
+
+        case GL_RENDERBUFFER_INTERNAL_FORMAT:
+            *value = renderbuffer ? (GLint)renderbuffer->internalFormat : GL_RGBA4;
+            break;
+
+        default:
+            *value = 0;
+            break;
+    }
+}
+
+static void swDiscardFramebuffer(GLenum target, GLsizei count, const GLenum* attachments) {
+    (void)target; (void)count; (void)attachments;
+    glDispatchCountCall();
+}
+
+
+static const GLDispatch softwareBackend = {
+
+    .viewport                   = swViewport,
+    .scissor                    = swScissor,
+    .clearColor                 = swClearColor,
+    .clear                      = swClear,
+    .enable                     = swEnable,
+    .disable                    = swDisable,
+    .blendFunc                  = swBlendFunc,
+
+    .genTextures                = swGenTextures,
+    .deleteTextures             = swDeleteTextures,
+    .bindTexture                = swBindTexture,
+    .texImage2D                 = swTexImage2D,
+    .texSubImage2D              = swTexSubImage2D,
+    .compressedTexImage2D       = swCompressedTexImage2D,
+    .texParameteri              = swTexParameteri,
+
+    .genBuffers                 = swGenBuffers,
+    .deleteBuffers              = swDeleteBuffers,
+    .bindBuffer                 = swBindBuffer,
+    .bufferData                 = swBufferData,
+    .bufferSubData              = swBufferSubData,
+
+    .genVertexArrays            = swGenVertexArrays,
+    .deleteVertexArrays         = swDeleteVertexArrays,
+    .bindVertexArray            = swBindVertexArray,
+    .enableVertexAttribArray    = swEnableVertexAttribArray,
+    .disableVertexAttribArray   = swDisableVertexAttribArray,
+    .vertexAttribPointer        = swVertexAttribPointer,
+    .getAttribLocation          = swGetAttribLocation,
+
+    .useProgram                 = swUseProgram,
+    .deleteProgram              = swDeleteProgram,
+    .getUniformLocation         = swGetUniformLocation,
+    .uniform1i                  = swUniform1i,
+    .uniform1f                  = swUniform1f,
+    .uniform2fv                 = swUniformfv,
+    .uniform3fv                 = swUniformfv,
+    .uniform4fv                 = swUniform4fv,
+    .uniformMatrix4fv           = swUniformMatrix4fv,
+
+    .drawArrays                 = swDrawArrays,
+    .drawElements               = swDrawElements,
+
+    .genFramebuffers            = swGenFramebuffers,
+    .deleteFramebuffers         = swDeleteFramebuffers,
+    .bindFramebuffer            = swBindFramebuffer,
+    .framebufferTexture2D       = swFramebufferTexture2D,
+    .checkFramebufferStatus     = swCheckFramebufferStatus,
+    .genRenderbuffers           = swGenRenderbuffers,
+    .deleteRenderbuffers        = swDeleteRenderbuffers,
+    .bindRenderbuffer           = swBindRenderbuffer,
+    .renderbufferStorage        = swRenderbufferStorage,
+    .framebufferRenderbuffer    = swFramebufferRenderbuffer,
+    .getRenderbufferParameteriv = swGetRenderbufferParameteriv,
+
+    .discardFramebuffer         = swDiscardFramebuffer,
+};
+
+
+// .............................................................................
+#pragma mark - Lifecycle
+
+
+static int createDefaultFramebuffer(SoftwareRasterizer* rasterizer, GLsizei width, GLsizei height) {
+
+    SoftwareImage* color = imageCreate(width, height, 4);
+    SoftwareImage* depth = imageCreate(width, height, sizeof(GLfloat));
+
+    if (!color || !depth || !reserveTiles(rasterizer, width, height)) {
+        imageRelease(color);
+        imageRelease(depth);
+        return 0;
+    }
+
+    imageFillDepth(depth, 1.0f);
+
+    imageRelease(rasterizer->colorBuffer);
+    imageRelease(rasterizer->depthBuffer);
+
+    rasterizer->colorBuffer = color;
+    rasterizer->depthBuffer = depth;
+    rasterizer->width       = width;
+    rasterizer->height      = height;
+
+    return 1;
+}
+
+
+SoftwareRasterizer* softwareRasterizerCreate(GLsizei width, GLsizei height, unsigned threadCount) {
+
+    SoftwareRasterizer* rasterizer = (SoftwareRasterizer *)calloc(1, sizeof(SoftwareRasterizer));
+
+    if (!rasterizer) {
+        return NULL;
+    }
+
+    pthread_mutex_init(&(rasterizer->textureLock), NULL);
+    pthread_mutex_init(&(rasterizer->poolLock), NULL);
+    pthread_cond_init(&(rasterizer->workReady), NULL);
+    pthread_cond_init(&(rasterizer->workDone), NULL);
+
+    tableInitialize(&(rasterizer->textures),      sizeof(SoftwareTexture));
+    tableInitialize(&(rasterizer->buffers),       sizeof(SoftwareBuffer));
+    tableInitialize(&(rasterizer->vertexArrays),  sizeof(SoftwareVertexArray));
+    tableInitialize(&(rasterizer->programs),      sizeof(SoftwareProgram));
+    tableInitialize(&(rasterizer->framebuffers),  sizeof(SoftwareFramebuffer));
+    tableInitialize(&(rasterizer->renderbuffers), sizeof(SoftwareRenderbuffer));
+
+    if (!rasterizer->textures.items || !rasterizer->buffers.items || !rasterizer->vertexArrays.items ||
+        !rasterizer->programs.items || !rasterizer->framebuffers.items || !rasterizer->renderbuffers.items) {
+        softwareRasterizerDestroy(rasterizer);
+        return NULL;
+    }
+
+    // (Vertex array 0 is the default one)
+    *(int *)(rasterizer->vertexArrays.items) = 1;
+
+    // OpenGL defaults (the viewport and scissor box are the initial surface)
+    rasterizer->viewport[2]       = width;
+    rasterizer->viewport[3]       = height;
+    rasterizer->scissorBox[2]     = width;
+    rasterizer->scissorBox[3]     = height;
+    rasterizer->sourceFactor      = GL_ONE;
+    rasterizer->destinationFactor = GL_ZERO;
+    rasterizer->drawingThread     = pthread_self();
+
+    if (!createDefaultFramebuffer(rasterizer, width, height)) {
+        softwareRasterizerDestroy(rasterizer);
+        return NULL;
+    }
+
+
+    // Threads
+
+    if (threadCount == 0) {
+        long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = (processorCount > 0) ? (unsigned)processorCount : 1;
+    }
+    if (threadCount > MaxThreadCount) {
+        threadCount = MaxThreadCount;
+    }
+
+    rasterizer->workers = (SoftwareWorker *)calloc(threadCount, sizeof(SoftwareWorker));
+
+    for (unsigned i = 0; rasterizer->workers && i + 1 < threadCount; i++) {
+
+        SoftwareWorker* worker = &(rasterizer->workers[i]);
+        worker->rasterizer = rasterizer;
+
+        if (pthread_create(&(worker->thread), NULL, workerMain, worker) != 0) {
+            break;  // (Fewer threads)
+        }
+        rasterizer->workerCount++;
+    }
+
+    return rasterizer;
+}
+
+
+void softwareRasterizerDestroy(SoftwareRasterizer* rasterizer) {
+
+    if (!rasterizer) {
+        return;
+    }
+
+    flushQueue(rasterizer);
+
+    if (current == rasterizer) {
+        current = NULL;
+    }
+
+
+    // 1. Threads
+
+    pthread_mutex_lock(&(rasterizer->poolLock));
+    rasterizer->quitting = 1;
+    pthread_cond_broadcast(&(rasterizer->workReady));
+    pthread_mutex_unlock(&(rasterizer->poolLock));
+
+    for (unsigned i = 0; i < rasterizer->workerCount; i++) {
+        pthread_join(rasterizer->workers[i].thread, NULL);
+    }
+    free(rasterizer->workers);
+
+
+    // 2. Objects
+
+    for (GLuint name = 1; name < rasterizer->textures.count; name++) {
+        SoftwareTexture* texture = (SoftwareTexture *)tableItem(&(rasterizer->textures), name);
+        if (texture) {
+            imageRelease(texture->image);
+        }
+    }
+    for (GLuint name = 1; name < rasterizer->buffers.count; name++) {
+        SoftwareBuffer* buffer = (SoftwareBuffer *)tableItem(&(rasterizer->buffers), name);
+        if (buffer) {
+            free(buffer->data);
+        }
+    }
+    for (GLuint name = 1; name < rasterizer->renderbuffers.count; name++) {
+        SoftwareRenderbuffer* renderbuffer = (SoftwareRenderbuffer *)tableItem(&(rasterizer->renderbuffers), name);
+        if (renderbuffer) {
+            imageRelease(renderbuffer->image);
+        }
+    }
+
+    tableFree(&(rasterizer->textures));
+    tableFree(&(rasterizer->buffers));
+    tableFree(&(rasterizer->vertexArrays));
+    tableFree(&(rasterizer->programs));
+    tableFree(&(rasterizer->framebuffers));
+    tableFree(&(rasterizer->renderbuffers));
+
+    imageRelease(rasterizer->colorBuffer);
+    imageRelease(rasterizer->depthBuffer);
+
+
+    // 3. Queue
+
+    uint32_t tileCount = rasterizer->tileColumns * rasterizer->tileRows;
+
+    for (uint32_t tile = 0; tile < tileCount; tile++) {
+        free(rasterizer->bins[tile].entries);
+    }
+    free(rasterizer->bins);
+    free(rasterizer->draws);
+    free(rasterizer->triangles);
+    free(rasterizer->vertices);
+
+    pthread_cond_destroy(&(rasterizer->workReady));
+    pthread_cond_destroy(&(rasterizer->workDone));
+    pthread_mutex_destroy(&(rasterizer->poolLock));
+    pthread_mutex_destroy(&(rasterizer->textureLock));
+
+    free(rasterizer);
+}
+
+
+// .............................................................................
+#pragma mark - Operation
+
+
+void softwareRasterizerMakeCurrent(SoftwareRasterizer* rasterizer) {
+
+    current = rasterizer;
+
+    if (rasterizer) {
+        rasterizer->drawingThread = pthread_self();
+    }
+}
+
+
+SoftwareRasterizer* softwareRasterizerCurrent(void) {
+    return current;
+}
+
+
+const GLDispatch* softwareRasterizerBackend(void) {
+    return &softwareBackend;
+}
+
+
+GLuint softwareRasterizerCreateProgram(SoftwareProgramKind kind) {
+
+    if (!current) {
+        return 0;
+    }
+
+    GLuint           name    = tableGenerate(&(current->programs));
+    SoftwareProgram* program = (SoftwareProgram *)tableItem(&(current->programs), name);
+
+    if (program) {
+        program->kind = kind;
+
+        // (Identity matrices: the uniforms are not initialized in OpenGL
+        //  either, but zero would hide everything)
+        for (int i = 0; i < 4; i++) {
+            program->projection[5*i] = 1.0f;
+            program->modelview[5*i]  = 1.0f;
+        }
+    }
+
+    return name;
+}
+
+
+void softwareRasterizerResize(SoftwareRasterizer* rasterizer, GLsizei width, GLsizei height) {
+
+    if (width == rasterizer->width && height == rasterizer->height) {
+        return;
+    }
+
+    flushQueue(rasterizer);
+
+    createDefaultFramebuffer(rasterizer, width, height);
+}
+
+
+void softwareRasterizerFinish(SoftwareRasterizer* rasterizer) {
+
+    flushQueue(rasterizer);
+}
+
+
+void softwareRasterizerReadPixels(SoftwareRasterizer* rasterizer, void* pixels, size_t rowBytes) {
+
+    flushQueue(rasterizer);
+
+    const uint8_t* source = (const uint8_t *)rasterizer->colorBuffer->data;
+    size_t         size   = 4*(size_t)rasterizer->width;
+
+    for (GLsizei row = 0; row < rasterizer->height; row++) {
+        // (Bottom row first in the framebuffer)
+        memcpy((uint8_t *)pixels + (size_t)row * rowBytes,
+               source + (size_t)(rasterizer->height - 1 - row) * size,
+               size);
+    }
+}
+
+
+SoftwareRasterizerStats softwareRasterizerStats(const SoftwareRasterizer* rasterizer) {
+    return rasterizer->stats;
+}
+
+
+void softwareRasterizerResetStats(SoftwareRasterizer* rasterizer) {
+    rasterizer->stats = (SoftwareRasterizerStats){ 0 };
+}
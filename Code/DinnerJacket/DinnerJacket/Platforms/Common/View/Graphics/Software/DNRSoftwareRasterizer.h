@@ -0,0 +1,154 @@
+//
+//  DNRSoftwareRasterizer.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-07.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#ifndef __DNRSoftwareRasterizer_h__
+#define __DNRSoftwareRasterizer_h__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "DNRGLDispatch.h"
+
+
+/*
+ Software backend: implements, on the CPU, the subset of OpenGL that the
+ rendering code uses (see GLDispatch), so that scenes can be drawn without a
+ GPU or a window (e.g., golden image tests and throughput measurements on
+ build machines). See DNRSoftwareRenderer for a renderer built on top of it.
+
+ Supported:
+   - Triangles, triangle strips and fans, indexed or not.
+   - The default programs (see SoftwareProgramKind). Shaders are not compiled;
+     each program kind reproduces the corresponding shader pair.
+   - Textures with RGBA, RGB, 565, 4444, 5551, luminance and alpha data
+     (stored as RGBA8, level 0 only, sampled with the magnification filter and
+     the wrap modes). Compressed data is not decoded: such textures sample as
+     opaque magenta, so they stand out in the images.
+   - Blending (any of the non-constant factors), the depth test (GL_LESS, with
+     writes), the scissor test and clears of color and depth.
+   - Framebuffers with a texture or renderbuffer for color and a renderbuffer
+     for depth; framebuffer 0 is the rasterizer's own surface.
+
+ Not supported: the stencil test, and clipping against the near and far
+ planes other than discarding the fragments outside of them.
+
+ Draw calls and clears are not executed right away: they are transformed and
+ set up on the calling thread, binned into square tiles of the surface, and
+ queued. The queue is executed when the results are needed (to read pixels,
+ to sample a texture that was rendered into, or when it grows too large), by
+ a pool of threads, each of which processes whole tiles in submission order.
+ The output does not depend on the number of threads.
+
+ The backend functions operate on the current rasterizer, which must be made
+ current on the thread that draws. Other threads may only create, upload and
+ delete textures (the texture binding is per thread, like a shared context);
+ uploads made while queued draws still read the previous contents copy them
+ first.
+ */
+typedef struct tSoftwareRasterizer SoftwareRasterizer;
+
+
+/**
+ The programs the rasterizer can emulate (see DNRShaderManager). Locations
+ are the same in all programs: -1 is returned for the uniforms and attributes
+ that a program's shaders do not declare.
+ */
+typedef enum {
+
+    SoftwareProgramSprite = 1,          // Sprite.vertsh + Sprite.fragsh
+    SoftwareProgramSpriteAlphaTest,     // As above, discards alpha < 0.1
+    SoftwareProgramFlat,                // Flat.vertsh + Flat.fragsh
+    SoftwareProgramSpriteBatch,         // SpriteBatch.vertsh + Sprite.fragsh
+
+}SoftwareProgramKind;
+
+
+/**
+ Work done since the last reset.
+ */
+typedef struct tSoftwareRasterizerStats {
+
+    uint64_t    draws;          // Draw calls and clears queued
+    uint64_t    triangles;      // Triangles set up (visible, not degenerate)
+    uint64_t    fragments;      // Pixels written
+    uint64_t    flushes;        // Times the queue was executed
+
+}SoftwareRasterizerStats;
+
+
+/**
+ Creates a rasterizer whose default framebuffer measures width x height
+ pixels, with threadCount threads (including the caller's) executing queued
+ work. Pass 0 for one thread per core.
+ */
+SoftwareRasterizer* softwareRasterizerCreate(GLsizei width, GLsizei height, unsigned threadCount);
+
+
+/**
+ Stops the threads and frees all objects and images.
+ */
+void softwareRasterizerDestroy(SoftwareRasterizer* rasterizer);
+
+
+/**
+ Makes rasterizer (can be NULL) the one the backend functions operate on, and
+ the calling thread the one that draws.
+ */
+void softwareRasterizerMakeCurrent(SoftwareRasterizer* rasterizer);
+
+
+/**
+ */
+SoftwareRasterizer* softwareRasterizerCurrent(void);
+
+
+/**
+ Table that calls the current rasterizer. Install it with
+ glDispatchSetBackend(), or pass it as the recorder's target (e.g., to replay a
+ recorded session into an image).
+ */
+const GLDispatch* softwareRasterizerBackend(void);
+
+
+/**
+ Creates a program of the given kind on the current rasterizer (in place of
+ compiling and linking shaders). Returns 0 on failure.
+ */
+GLuint softwareRasterizerCreateProgram(SoftwareProgramKind kind);
+
+
+/**
+ Resizes the default framebuffer (its contents become undefined).
+ */
+void softwareRasterizerResize(SoftwareRasterizer* rasterizer, GLsizei width, GLsizei height);
+
+
+/**
+ Executes all queued work and waits for it to complete.
+ */
+void softwareRasterizerFinish(SoftwareRasterizer* rasterizer);
+
+
+/**
+ Copies the default framebuffer into pixels (premultiplied RGBA8, top row
+ first, rows rowBytes apart). Executes the queued work first.
+ */
+void softwareRasterizerReadPixels(SoftwareRasterizer* rasterizer, void* pixels, size_t rowBytes);
+
+
+/**
+ */
+SoftwareRasterizerStats softwareRasterizerStats(const SoftwareRasterizer* rasterizer);
+
+
+/**
+ */
+void softwareRasterizerResetStats(SoftwareRasterizer* rasterizer);
+
+
+#endif  // #defined (__DNRSoftwareRasterizer_h__)
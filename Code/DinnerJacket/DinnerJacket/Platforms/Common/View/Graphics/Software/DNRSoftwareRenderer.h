@@ -0,0 +1,72 @@
+//
+//  DNRSoftwareRenderer.h
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-07.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#import "DNRBase.h"
+#import "DNRRenderer.h"
+
+#import "DNRSoftwareRasterizer.h"
+
+
+/**
+ Renderer that draws on the CPU, into an offscreen surface (see
+ DNRSoftwareRasterizer.h). Needs no view, window or GPU: meant for golden image
+ tests and for measuring throughput on build machines.
+
+ It draws through glDispatch: the software backend is installed on
+ initialization (and by -makeCurrent), and the native one on deallocation.
+ Whoever shares the thread with it must reinstall their own afterwards (see
+ DNRBenchmark). Create it on the thread that will render.
+ */
+@interface DNRSoftwareRenderer : NSObject <DNRRenderer>
+
+
+///
+@property (nonatomic, readonly) GLsizei width;
+
+
+///
+@property (nonatomic, readonly) GLsizei height;
+
+
+/// Work done by the rasterizer since the last call to -resetStats.
+@property (nonatomic, readonly) SoftwareRasterizerStats stats;
+
+
+/**
+ Pass 0 as threadCount for one thread per core.
+ */
+- (instancetype) initWithWidth:(GLsizei) width
+                        height:(GLsizei) height
+                   threadCount:(NSUInteger) threadCount;
+
+
+/**
+ Resizes the surface and the transition buffers.
+ */
+- (void) resizeWithWidth:(GLsizei) width height:(GLsizei) height;
+
+
+/**
+ Copies the last frame into pixels (premultiplied RGBA8, top row first, rows
+ rowBytes apart; at least 4 x width x height bytes).
+ */
+- (void) readPixels:(void *)pixels rowBytes:(size_t) rowBytes;
+
+
+/**
+ */
+- (void) resetStats;
+
+
+/**
+ Installs the renderer's rasterizer, backend and state cache on the calling
+ thread, as on initialization (e.g., after something else took them over).
+ */
+- (void) makeCurrent;
+
+@end
@@ -0,0 +1,587 @@
+//
+//  DNRSoftwareRenderer.m
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-07.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+#import "DNRSoftwareRenderer.h"         // Own header
+
+#import "DNRMatrix.h"                   // Math support
+
+#import "DNRGLCache.h"                  // OpenGL support
+#import "DNRGLDispatch.h"               // (All OpenGL calls go through it)
+#import "DNROpenGLUtilities.h"
+
+#import "DNRShaderManager.h"
+
+#import "DNRGlobals.h"                  // Stride, etc.
+
+
+// Maximum number of quads submitted with each flush of the sprite batch
+#define DNRRendererSpriteBatchCapacity  4096u
+
+
+@interface DNRSoftwareRenderer ()
+
+@property (nonatomic, readwrite) GLsizei width;
+@property (nonatomic, readwrite) GLsizei height;
+@property (nonatomic, readwrite) GLuint vao;
+@property (nonatomic, readwrite) GLuint vbo;
+@property (nonatomic, readwrite) GLuint ibo;
+@property (nonatomic, readwrite) GLuint currentFramebuffer;
+
+@property (nonatomic, readwrite) GLuint transFramebuffer;
+@property (nonatomic, readwrite) GLuint transTexture1;
+@property (nonatomic, readwrite) GLuint transTexture2;
+@property (nonatomic, readwrite) GLuint transDepthBuffer;
+@property (nonatomic, readwrite) GLuint spriteProgram;
+@property (nonatomic, readwrite) GLuint flatProgram;
+
+@property (nonatomic, readwrite) GLint modelviewLocation;
+@property (nonatomic, readwrite) GLint colorLocation;
+
+@property (nonatomic, readwrite) GLint positionLocation;
+@property (nonatomic, readwrite) GLint texCoordLocation;
+
+@property (nonatomic, readwrite) SpriteBatch* spriteBatch;
+
+@end
+
+// .............................................................................
+
+
+@implementation DNRSoftwareRenderer {
+    
+    SoftwareRasterizer* _rasterizer;
+    
+    GLfloat         _scaleMatrix[16];
+    
+    GLfloat         _zoomScale;
+    CGPoint         _scrollOffset;
+}
+
+// (Properties declared in a protocol won't be auto-synthesized)
+@synthesize backgroundClearColor = _backgroundClearColor;
+@synthesize sceneClearColor      = _sceneClearColor;
+@synthesize spriteBatch          = _spriteBatch;
+
+- (CGFloat) zoomScale {
+    return (CGFloat) _zoomScale;
+}
+
+- (void) setZoomScale:(CGFloat)zoomScale {
+
+    _zoomScale = (CGFloat) zoomScale;
+    [self updateProjectionMatrix];
+}
+
+- (CGPoint) scrollOffset {
+    return _scrollOffset;
+}
+
+- (void) setScrollOffset:(CGPoint)scrollOffset {
+    _scrollOffset = scrollOffset;
+    
+    glDispatch.viewport(_scrollOffset.x, -_scrollOffset.y, _width, _height);
+}
+
+- (CGRect) visibleRect {
+
+    // (Same as the OpenGL renderers)
+    
+    CGFloat width  = _width  * _zoomScale;
+    CGFloat height = _height * _zoomScale;
+    
+    CGFloat centerX = - _scrollOffset.x * _zoomScale;
+    CGFloat centerY = + _scrollOffset.y * _zoomScale;
+    
+    return CGRectMake(centerX - 0.5f*width, centerY - 0.5f*height, width, height);
+}
+
+- (SoftwareRasterizerStats) stats {
+    return softwareRasterizerStats(_rasterizer);
+}
+
+
+#pragma mark - Initialization
+
+
+- (instancetype) initWithWidth:(GLsizei) width
+                        height:(GLsizei) height
+                   threadCount:(NSUInteger) threadCount {
+    
+    if ((self = [super init])) {
+        
+        _width  = width;
+        _height = height;
+        
+        _scrollOffset = CGPointZero;
+        _zoomScale    = 1.0f;
+        
+        _rasterizer = softwareRasterizerCreate(width, height, (unsigned)threadCount);
+        
+        if (!_rasterizer) {
+            return (self = nil);
+        }
+        
+        // 0. Take over OpenGL (the rasterizer stands in for the context)
+        [self makeCurrent];
+        
+        // 1. Create drawables (the main framebuffer is the rasterizer's own)
+        if ([self createFramebuffers] == NO) {
+            return (self = nil);
+        }
+        
+        // 2. Configure shaders
+        if ([[DNRShaderManager defaultManager] initializeSoftwarePrograms] == NO) {
+            return ((self = nil));
+        }
+        [self initializeSpriteProgram];
+        
+        
+        // 3. Create geometry
+        if ([self createGeometry] == NO) {
+            return ((self = nil));
+        }
+        
+        // 3.b Create sprite batch (streaming geometry)
+        _spriteBatch = spriteBatchCreate([[DNRShaderManager defaultManager] spriteBatchProgram],
+                                         DNRRendererSpriteBatchCapacity);
+        if (_spriteBatch == NULL) {
+            return ((self = nil));
+        }
+        
+        // 4. Set default OpenGL State
+        [self restoreDefaultOpenGLStates];
+        
+        // 5. Setup modelview matrix
+        [self updateModelviewMatrix];
+    }
+    
+    return self;
+}
+
+
+- (void) dealloc {
+
+    if (_spriteBatch) {
+        spriteBatchDestroy(_spriteBatch);
+    }
+    
+    glCacheContextRemove((__bridge const void *)self);
+    
+    if (_rasterizer) {
+        glDispatchSetBackend(NULL);
+        softwareRasterizerDestroy(_rasterizer);
+    }
+}
+
+
+#pragma mark - DNRRenderer Protocol Methods (All Platform Renderers)
+
+
+- (void) beginFrame {
+
+    bindFramebuffer(0);
+    
+    _currentFramebuffer = 0;
+    
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+
+- (void) endFrame {
+
+    // (Nothing to present; complete the frame so it can be read)
+    softwareRasterizerFinish(_rasterizer);
+}
+
+
+- (void) initializeSequentialFade {
+
+    // Bind the Transition framebuffer:
+    bindFramebuffer(_transFramebuffer);
+    _currentFramebuffer = _transFramebuffer;
+    
+    // Attach texture #1 to its color attachment:
+    attachTexture2D(_transTexture1);
+}
+
+
+- (void) beginSequentialFadeFrame {
+
+    // 0. Bind the Transition framebuffer:
+    bindFramebuffer(_transFramebuffer);
+    _currentFramebuffer = _transFramebuffer;
+    
+    
+    // 1. Clear the screen:
+    clearColor(_sceneClearColor);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    
+    // (all geometry rendering follows...)
+}
+
+
+- (void) blendSequentialFadePassWithOpacity:(CGFloat) opacity {
+
+    glDispatch.disable(GL_DEPTH_TEST);
+    
+    GLfloat color4fv[4] = { opacity, opacity, opacity, opacity };
+    
+    
+    // Bind main framebuffer:
+    bindFramebuffer(0);
+    _currentFramebuffer = 0;
+    
+    clearColor(_backgroundClearColor);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    
+    
+    // Draw the scene texture on a full screen quad, modulated by opacity:
+    useProgram(_spriteProgram);
+    glDispatch.uniformMatrix4fv(_modelviewLocation, 1, 0, _scaleMatrix);
+    uniform4fv(_colorLocation, color4fv);
+    
+    bindTexture2D(_transTexture1);
+    bindVertexArrayObject(_vao);
+    
+    glDispatch.drawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
+    
+    glDispatch.enable(GL_DEPTH_TEST);
+}
+
+
+- (void) beginCrossDissolveFramePass1 {
+
+    // Bind the Transition framebuffer:
+    bindFramebuffer(_transFramebuffer);
+    _currentFramebuffer = _transFramebuffer;
+    
+    // Attach texture #1 to its color attachment:
+    attachTexture2D(_transTexture1);
+    
+    // Clear the screen:
+    clearColor(_sceneClearColor);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    
+    // (rendering of FIRST scene follows...)
+}
+
+
+- (void) beginCrossDissolveFramePass2 {
+
+    // Bind the Transition framebuffer:
+    bindFramebuffer(_transFramebuffer);
+    _currentFramebuffer = _transFramebuffer;
+    
+    // Attach texture #2 to its color attachment:
+    attachTexture2D(_transTexture2);
+    
+    // Clear the screen:
+    clearColor(_sceneClearColor);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    
+    // (rendering of SECOND scene follows...)
+}
+
+
+- (void) blendCrossDissolvePassesWithProgress:(CGFloat) progress {
+
+    // Disable depth culling. Both quads should be drawn!
+    glDispatch.disable(GL_DEPTH_TEST);
+    
+    GLfloat color4fv[4];
+    
+    
+    // Rendering to the screen:
+    bindFramebuffer(0);
+    _currentFramebuffer = 0;
+    
+    clearColor(_backgroundClearColor);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    
+    useProgram(_spriteProgram);
+    glDispatch.uniformMatrix4fv(_modelviewLocation, 1, 0, _scaleMatrix);
+    bindVertexArrayObject(_vao);
+    
+    // Scene 1 Fades OUT:
+    GLfloat opacity = 1.0f - progress;
+    color4fv[0] = color4fv[1] = color4fv[2] = color4fv[3] = opacity;
+    
+    uniform4fv(_colorLocation, color4fv);
+    bindTexture2D(_transTexture1);
+    glDispatch.drawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
+    
+    // Scene 2 Fades IN:
+    color4fv[0] = color4fv[1] = color4fv[2] = color4fv[3] = progress;
+    
+    uniform4fv(_colorLocation, color4fv);
+    bindTexture2D(_transTexture2);
+    glDispatch.drawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
+    
+    glDispatch.enable(GL_DEPTH_TEST);
+}
+
+
+#pragma mark - Public Interface
+
+
+- (void) resizeWithWidth:(GLsizei) width height:(GLsizei) height {
+
+    if (width == _width && height == _height) {
+        return;
+    }
+    
+    _width  = width;
+    _height = height;
+    
+    softwareRasterizerResize(_rasterizer, width, height);
+    
+    // Reallocate the transition buffers (same names):
+    
+    bindRenderbuffer(_transDepthBuffer);
+    glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _width, _height);
+    
+    GLuint textures[2] = { _transTexture1, _transTexture2 };
+    
+    for (NSUInteger i = 0; i < 2; i++) {
+        bindTexture2D(textures[i]);
+        glDispatch.texImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    }
+    
+    viewPort(_scrollOffset.x, -_scrollOffset.y, _width, _height);
+    
+    [self updateModelviewMatrix];
+    [self updateProjectionMatrix];
+}
+
+
+- (void) readPixels:(void *)pixels rowBytes:(size_t) rowBytes {
+
+    softwareRasterizerReadPixels(_rasterizer, pixels, rowBytes);
+}
+
+
+- (void) resetStats {
+
+    softwareRasterizerResetStats(_rasterizer);
+}
+
+
+- (void) makeCurrent {
+
+    softwareRasterizerMakeCurrent(_rasterizer);
+    glDispatchSetBackend(softwareRasterizerBackend());
+    glCacheMakeCurrent((__bridge const void *)self);
+}
+
+
+#pragma mark - Internal Operation
+
+
+- (BOOL) createFramebuffers {
+
+    // 1. Offscreen Framebuffer
+    
+    glDispatch.genFramebuffers(1, &_transFramebuffer);
+    bindFramebuffer(_transFramebuffer);
+    
+    
+    // 2. Offscreen Depth Renderbuffer
+    
+    glDispatch.genRenderbuffers(1, &_transDepthBuffer);
+    bindRenderbuffer(_transDepthBuffer);
+    
+    glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _width, _height);
+    glDispatch.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _transDepthBuffer);
+    
+    
+    // 3. Textures (Color attachment)
+    
+    GLuint* texPtrs[2] = {&_transTexture1, &_transTexture2};
+    
+    for (NSUInteger i = 0; i < 2; i++) {
+        GLuint* texPtr = texPtrs[i];
+        
+        glDispatch.genTextures(1, texPtr);
+        bindTexture2D(*texPtr);
+        
+        // Configure for pixel-aligned use:
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        
+        glDispatch.texImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _width, _height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        
+        glDispatch.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *texPtr, 0);
+        
+        GLenum framebufferStatus = glDispatch.checkFramebufferStatus(GL_FRAMEBUFFER);
+        
+        if (framebufferStatus != GL_FRAMEBUFFER_COMPLETE) {
+            DLog(@"-[DNRSoftwareRenderer createFramebuffers]: Failed to make complete framebuffer object (Code: %u)",
+                 (unsigned)framebufferStatus);
+            
+            return NO;
+        }
+    }
+    
+    
+    // Final State:
+    
+    bindFramebuffer(0);
+    bindTexture2D(0);
+    
+    return YES;
+}
+
+
+- (BOOL) createGeometry {
+
+    // (Same unit quad as the OpenGL renderers)
+    
+    VertexData2D vertexData[4];
+    
+    // Bottom right
+    vertexData[0].position.x   = +0.5f;
+    vertexData[0].position.y   = -0.5f;
+    vertexData[0].texCoords.s  = 1.0f;
+    vertexData[0].texCoords.t  = 1.0f;
+    
+    // Top right
+    vertexData[1].position.x   = +0.5f;
+    vertexData[1].position.y   = +0.5f;
+    vertexData[1].texCoords.s  = 1.0f;
+    vertexData[1].texCoords.t  = 0.0f;
+    
+    // Bottom left
+    vertexData[2].position.x   = -0.5f;
+    vertexData[2].position.y   = -0.5f;
+    vertexData[2].texCoords.s  = 0.0f;
+    vertexData[2].texCoords.t  = 1.0f;
+    
+    // Top left
+    vertexData[3].position.x   = -0.5f;
+    vertexData[3].position.y   = +0.5f;
+    vertexData[3].texCoords.s  = 0.0f;
+    vertexData[3].texCoords.t  = 0.0f;
+    
+    GLushort indices[4] = {0, 1, 2, 3};
+    
+    
+    glDispatch.genVertexArrays(1, &_vao);
+    bindVertexArrayObject(_vao);
+    
+    glDispatch.genBuffers(1, &_vbo);
+    bindVertexBufferObject(_vbo);
+    
+    glDispatch.bufferData(GL_ARRAY_BUFFER,
+                          4*sizeof(VertexData2D),
+                          &vertexData[0],
+                          GL_STATIC_DRAW);
+    
+    glDispatch.genBuffers(1, &_ibo);
+    bindIndexBufferObject(_ibo);
+    
+    glDispatch.bufferData(GL_ELEMENT_ARRAY_BUFFER,
+                          4*sizeof(GLushort),
+                          &indices[0],
+                          GL_STATIC_DRAW);
+    
+    glDispatch.enableVertexAttribArray(_positionLocation);
+    glDispatch.enableVertexAttribArray(_texCoordLocation);
+    
+    glDispatch.vertexAttribPointer(_positionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
+    glDispatch.vertexAttribPointer(_texCoordLocation, 2, GL_FLOAT, GL_FALSE, stride2D, textureOffset2D);
+    
+    bindVertexArrayObject(0);
+    bindIndexBufferObject(0);
+    bindVertexBufferObject(0);
+    
+    return YES;
+}
+
+
+- (void) restoreDefaultOpenGLStates {
+
+    // Depth
+    glDispatch.enable(GL_DEPTH_TEST);
+    
+    // Blending
+    glDispatch.enable(GL_BLEND);
+    glDispatch.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    
+    // Clear Color
+    clearColor(_backgroundClearColor);
+    
+    // Viewport
+    viewPort(0.0f, 0.0, _width, _height);
+}
+
+
+- (void) initializeSpriteProgram {
+
+    DNRShaderManager* shaderManager = [DNRShaderManager defaultManager];
+    
+    _spriteProgram = [shaderManager spriteProgram];
+    _flatProgram   = [shaderManager flatProgram];
+    
+    useProgram(_spriteProgram);
+    
+    _modelviewLocation = glDispatch.getUniformLocation(_spriteProgram, "Modelview");
+    _colorLocation     = glDispatch.getUniformLocation(_spriteProgram, "Color");
+    
+    _positionLocation  = glDispatch.getAttribLocation(_spriteProgram, "Position");
+    _texCoordLocation  = glDispatch.getAttribLocation(_spriteProgram, "TextureCoord");
+    
+    [self updateProjectionMatrix];
+    
+    useProgram(0);
+}
+
+
+- (void) updateModelviewMatrix {
+
+    // Scales the unit quad to fill the entire screen (Y reversed: in bitmap
+    // coords +Y is down, in OpenGL +Y is up)
+    
+    mat4f_LoadIdentity(_scaleMatrix);
+    
+    _scaleMatrix[ 0] = _width;
+    _scaleMatrix[ 5] = -_height;
+}
+
+
+- (void) updateProjectionMatrix {
+
+    GLfloat xMin = - 0.5f*(_width  * _zoomScale);
+    GLfloat xMax = + 0.5f*(_width  * _zoomScale);
+    GLfloat yMin = - 0.5f*(_height * _zoomScale);
+    GLfloat yMax = + 0.5f*(_height * _zoomScale);
+    
+    DNRShaderManager* shaderManager = [DNRShaderManager defaultManager];
+    
+    GLuint programs[4] = {
+        [shaderManager spriteProgram],
+        [shaderManager flatProgram],
+        [shaderManager spriteBatchProgram],
+        [shaderManager spriteProgramWithAlphaTest]
+    };
+    
+    for (NSUInteger i = 0; i < 4; i++) {
+        useProgram(programs[i]);
+        setOrthographicProjection(programs[i],
+                                  glDispatch.getUniformLocation(programs[i], "Projection"),
+                                  xMin,
+                                  xMax,
+                                  yMin,
+                                  yMax,
+                                  -1.0,
+                                  +1.0);
+    }
+}
+
+@end
@@ -9,6 +9,7 @@
 #include <stdio.h>
 
 #include "DNROpenGLUtilities.h"
+#include "DNRGLDispatch.h"
 
 
 void checkOpenGLError() {
@@ -56,6 +57,7 @@ void setOrthographicProjection(GLuint program,
                                GLfloat yMax,
                                GLfloat zMin,
                                GLfloat zMax) {
+    (void)program;
 
     /*
      WTF?
@@ -77,7 +79,7 @@ void setOrthographicProjection(GLuint program,
         0.0f,  0.0f,  0.0f,  1.0f
     };
     
-    glUniformMatrix4fv(projectionUniformLocation, 1, 0, &ortho[0]);
+    glDispatch.uniformMatrix4fv(projectionUniformLocation, 1, 0, &ortho[0]);
     
     /*
     float a = 1.0f / ((xMax - xMin)/2.0f);
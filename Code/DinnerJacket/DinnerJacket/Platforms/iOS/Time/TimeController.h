@@ -21,6 +21,21 @@
 //@property (nonatomic, readwrite) DNRSceneController *sceneController;
 
 
+/// When enabled, the scenes are simulated in steps of fixed duration
+/// (1/simulationRate), as many per display refresh as the time elapsed calls
+/// for, and drawn once per refresh with the remainder as interpolation (see
+/// DNRSceneController). Otherwise (the default), they are advanced once per
+/// refresh by the time elapsed.
+@property (nonatomic, readwrite, getter=isFixedTimestepEnabled) BOOL fixedTimestepEnabled;
+
+/// Simulation steps per second when fixedTimestepEnabled. Default is 60.
+@property (nonatomic, readwrite) NSUInteger simulationRate;
+
+/// Most steps simulated per display refresh; after a longer hitch, the time
+/// beyond is dropped. Default is 4.
+@property (nonatomic, readwrite) NSUInteger maximumStepsPerFrame;
+
+
 /// Singleton.
 + (instancetype) sharedController;
 
@@ -8,6 +8,8 @@
 
 #import "TimeController.h"
 #import "DNRSceneController.h"
+#import "DNRTextureLoader.h"
+#import "DNRFixedTimestep.h"
 
 
 @interface TimeController ()
@@ -21,7 +23,12 @@
 @end
 
 
-@implementation TimeController
+@implementation TimeController {
+    
+    FixedTimestep   _timestep;
+    
+    CFTimeInterval  _lastTimestamp;     // Of the previous refresh (0: none)
+}
 
 + (instancetype) sharedController {
     
@@ -44,6 +51,11 @@
     if (self = [super init]){
         self.sceneControllers = [NSMutableArray new];
 
+        _simulationRate       = 60;
+        _maximumStepsPerFrame = 4;
+        
+        fixedTimestepInit(&_timestep, (double)_simulationRate, (unsigned)_maximumStepsPerFrame);
+        
         [self registerNotifications];
     }
     
@@ -65,6 +77,35 @@
                              object:nil];
 }
 
+#pragma mark - Custom Accessors
+
+
+- (void) setFixedTimestepEnabled:(BOOL) fixedTimestepEnabled {
+    
+    _fixedTimestepEnabled = fixedTimestepEnabled;
+    
+    fixedTimestepReset(&_timestep);
+    
+    [_displayLink setPreferredFramesPerSecond:[self preferredFramesPerSecond]];
+}
+
+
+- (void) setSimulationRate:(NSUInteger) simulationRate {
+    
+    _simulationRate = MAX(simulationRate, 1);
+    
+    fixedTimestepInit(&_timestep, (double)_simulationRate, (unsigned)_maximumStepsPerFrame);
+}
+
+
+- (void) setMaximumStepsPerFrame:(NSUInteger) maximumStepsPerFrame {
+    
+    _maximumStepsPerFrame = MAX(maximumStepsPerFrame, 1);
+    
+    fixedTimestepInit(&_timestep, (double)_simulationRate, (unsigned)_maximumStepsPerFrame);
+}
+
+
 #pragma mark - Exposed Operation
 
 - (void) addSceneController:(DNRSceneController *) controller {
@@ -96,7 +137,11 @@
                                                    selector:@selector(displayLinkTicked:)];
         
         //[_displayLink setFrameInterval:1];            // Deprecated in iOS 10
-        [_displayLink setPreferredFramesPerSecond:60];  // Introduced in iOS 10
+        [_displayLink setPreferredFramesPerSecond:[self preferredFramesPerSecond]];  // Introduced in iOS 10
+        
+        // (Time spent paused is not simulated)
+        _lastTimestamp = 0.0;
+        fixedTimestepReset(&_timestep);
         
         [_displayLink addToRunLoop:[NSRunLoop currentRunLoop]
                            forMode:NSDefaultRunLoopMode];
@@ -104,13 +149,41 @@
 }
 
 
+- (NSInteger) preferredFramesPerSecond {
+    
+    // (At a fixed step, draw at whatever rate the display runs; e.g. 120 Hz)
+    return _fixedTimestepEnabled ? 0 : 60;
+}
+
+
 - (void) displayLinkTicked:(CADisplayLink *)displayLink {
     
     CFTimeInterval dt = [displayLink duration];
-
-    for (DNRSceneController *controller in _sceneControllers) {
-        [controller tick:dt];
+    
+    // (Actual time between refreshes; duration is the nominal one)
+    CFTimeInterval timestamp = [displayLink timestamp];
+    CFTimeInterval elapsed   = (_lastTimestamp > 0.0) ? (timestamp - _lastTimestamp) : dt;
+    
+    _lastTimestamp = timestamp;
+    
+    if (_fixedTimestepEnabled) {
+        double alpha = 0.0;
+        
+        NSUInteger stepCount = fixedTimestepAdvance(&_timestep, elapsed, &alpha);
+        
+        for (DNRSceneController *controller in _sceneControllers) {
+            [controller tick:_timestep.step steps:stepCount interpolation:(CGFloat)alpha];
+        }
     }
+    else{
+        for (DNRSceneController *controller in _sceneControllers) {
+            [controller tick:dt];
+        }
+    }
+    
+    // Upload textures decoded in the background (no longer than the
+    // loader's per-frame budget allows)
+    [[DNRTextureLoader sharedLoader] performPendingUploads];
 }
 
 
@@ -16,6 +16,7 @@
 #import "DNRMatrix.h"                   // Math support
 
 #import "DNRGLCache.h"            // OpenGL support
+#import "DNRGLDispatch.h"         // (All OpenGL calls go through it)
 #import "DNROpenGLUtilities.h"
 
 #import "DNRShaderManager.h"
@@ -23,6 +24,10 @@
 #import "DNRGlobals.h"                  // Stride, etc.
 
 
+// Maximum number of quads submitted with each flush of the sprite batch
+#define DNRRendererSpriteBatchCapacity  4096u
+
+
 @interface DNROpenGLES2Renderer ()
 
 @property (nonatomic, unsafe_unretained, readwrite) DNROpenGLESView* view;
@@ -53,6 +58,8 @@
 @property (nonatomic, readwrite) GLint positionLocation;
 @property (nonatomic, readwrite) GLint texCoordLocation;
 
+@property (nonatomic, readwrite) SpriteBatch* spriteBatch;
+
 @end
 
 // .............................................................................
@@ -67,10 +74,20 @@
 // Properties declared in a protocol won't be auto-synthesized:
 @synthesize backgroundClearColor = _backgroundClearColor;
 @synthesize sceneClearColor      = _sceneClearColor;
+@synthesize spriteBatch          = _spriteBatch;
 
 @synthesize zoomScale;
 @synthesize scrollOffset;
 
+
+- (CGRect) visibleRect {
+    
+    // (Zoom and scroll are not applied to the projection on this platform; the
+    //  visible region is the backing size, centered on the origin)
+    
+    return CGRectMake(-0.5f*_backingWidth, -0.5f*_backingHeight, _backingWidth, _backingHeight);
+}
+
 #pragma mark - DNROpenGLESRenderer Protocol Methods (All iOS Renderers)
 
 
@@ -115,6 +132,13 @@
             return ((self = nil));
         }
         
+        // 3.b Create sprite batch (streaming geometry)
+        _spriteBatch = spriteBatchCreate([[DNRShaderManager defaultManager] spriteBatchProgram],
+                                         DNRRendererSpriteBatchCapacity);
+        if (_spriteBatch == NULL) {
+            return ((self = nil));
+        }
+        
         // 4. Set default OpenGL State
         [self restoreDefaultOpenGLStates];
         
@@ -129,6 +153,7 @@
 - (BOOL) resizeFromLayer:(CAEAGLLayer *)layer {
 
     [EAGLContext setCurrentContext:_context];
+    glCacheMakeCurrent((__bridge const void *)_context);
     
     
     // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
@@ -145,8 +170,8 @@
                      fromDrawable:(CAEAGLLayer *)[_view layer]];
     
     // Query the new size:
-    glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH,  &_backingWidth);
-    glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, &_backingHeight);
+    glDispatch.getRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH,  &_backingWidth);
+    glDispatch.getRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, &_backingHeight);
     
     
     // 2. Resize the depth buffer too
@@ -156,23 +181,23 @@
     if (_usingStencilBuffer) {
         // Depth and stencil
         
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, _backingWidth, _backingHeight);
+        glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, _backingWidth, _backingHeight);
     }
     else{
         // Depth alone
         
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24_OES, _backingWidth, _backingHeight);
+        glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24_OES, _backingWidth, _backingHeight);
     }
     
     // Finally, validate the set:
     
-    GLenum framebufferStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    GLenum framebufferStatus = glDispatch.checkFramebufferStatus(GL_FRAMEBUFFER);
     
     if ( framebufferStatus != GL_FRAMEBUFFER_COMPLETE) {
         // Something went wrong!
         
         DLog(@"-[GPES2Renderer resizeFromLayer:]: Failed to make complete framebuffer object: %@",
-             [self stringFromFramebufferStauts:glCheckFramebufferStatus(GL_FRAMEBUFFER)]);
+             [self stringFromFramebufferStauts:glDispatch.checkFramebufferStatus(GL_FRAMEBUFFER)]);
         
         return NO;
     }
@@ -189,10 +214,10 @@
     bindRenderbuffer(_transDepthBuffer);
     
     if (_usingStencilBuffer) {
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, _backingWidth, _backingHeight);
+        glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, _backingWidth, _backingHeight);
     }
     else{
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24_OES, _backingWidth, _backingHeight);
+        glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24_OES, _backingWidth, _backingHeight);
     }
     
     
@@ -207,27 +232,27 @@
         bindTexture2D(*textureIDPointer);
         
         // Configure for pixel-aligned use:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         
         // Allocate storage:
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _backingWidth, _backingHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glDispatch.texImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _backingWidth, _backingHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
         
         
         // Attach:
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *textureIDPointer, 0);
+        glDispatch.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *textureIDPointer, 0);
         
         
         // Validate:
-        framebufferStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        framebufferStatus = glDispatch.checkFramebufferStatus(GL_FRAMEBUFFER);
         
         if ( framebufferStatus != GL_FRAMEBUFFER_COMPLETE) {
             // Something went wrong!
             
             DLog(@"-[GPES2Renderer resizeFromLayer:]: Failed to make complete framebuffer object: %@",
-                 [self stringFromFramebufferStauts:glCheckFramebufferStatus(GL_FRAMEBUFFER)]);
+                 [self stringFromFramebufferStauts:glDispatch.checkFramebufferStatus(GL_FRAMEBUFFER)]);
             
             return NO;
         }
@@ -245,7 +270,7 @@
     
     // 4. Viewport
     
-    glViewport(0, 0, _backingWidth, _backingHeight);
+    glDispatch.viewport(0, 0, _backingWidth, _backingHeight);
     
     
     //DLog(@"-[GPES2Renderer resizeFromLayer:] - SUCEEDED!");
@@ -258,6 +283,16 @@
 }
 
 
+- (void) dealloc {
+
+    spriteBatchDestroy(_spriteBatch);
+    
+    // (Both contexts are owned by the renderer and die with it)
+    glCacheContextRemove((__bridge const void *)_backgroundContext);
+    glCacheContextRemove((__bridge const void *)_context);
+}
+
+
 #pragma mark - DNRRenderer Protocol Methods (All Platform Renderers)
 
 
@@ -267,7 +302,7 @@
     
     _currentFramebuffer = _mainFramebuffer;
     
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
 
@@ -276,7 +311,7 @@
     static GLenum attachments[] = { GL_DEPTH_ATTACHMENT };
     
     // Discard depth buffer contents:
-    glDiscardFramebufferEXT(GL_FRAMEBUFFER, 1, attachments);
+    glDispatch.discardFramebuffer(GL_FRAMEBUFFER, 1, attachments);
     
     // Present color buffer to Core Animation:
     bindRenderbuffer(_mainColorbuffer);
@@ -310,7 +345,7 @@
     
     // 1. Clear the screen:
     clearColor(_sceneClearColor);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     
     // (must clear depth buffer too, otherwise 3D objects won't render properly
     //  during transitions)
@@ -323,7 +358,7 @@
 
     // Modulate Rendered Scene into the Screen, at the Appropriate Opacity
     
-    glDisable(GL_DEPTH_TEST);
+    glDispatch.disable(GL_DEPTH_TEST);
     
     static GLfloat color4fv[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
     
@@ -335,7 +370,7 @@
     
     // Clear the screen:
     clearColor(_backgroundClearColor);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     
     
     // Bind shaders
@@ -343,7 +378,7 @@
 
     
     // Upload scale matrix to shader:
-    glUniformMatrix4fv(_modelviewLocation, 1, 0, _scaleMatrix);
+    glDispatch.uniformMatrix4fv(_modelviewLocation, 1, 0, _scaleMatrix);
     // (alternatively, we could create the quad to screen size)
     
     
@@ -363,7 +398,7 @@
     bindVertexArrayObject(_vao);
     
     // Draw
-    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
+    glDispatch.drawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
     
     
     
@@ -371,7 +406,7 @@
 	// Discard Depth Buffer
     
 	static GLenum attachments[] = { GL_DEPTH_ATTACHMENT };
-	glDiscardFramebufferEXT(GL_FRAMEBUFFER, 1, attachments);
+	glDispatch.discardFramebuffer(GL_FRAMEBUFFER, 1, attachments);
 	
     
     // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
@@ -380,7 +415,7 @@
     bindRenderbuffer(_mainColorbuffer);
 	[_context presentRenderbuffer:GL_RENDERBUFFER];
     
-    glEnable(GL_DEPTH_TEST);
+    glDispatch.enable(GL_DEPTH_TEST);
 }
 
 
@@ -396,7 +431,7 @@
     // Clear the screen:
     
     clearColor(_sceneClearColor);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
     // (rendering of FIRST scene follows...)
 }
@@ -414,7 +449,7 @@
     
     // Clear the screen:
     clearColor(_sceneClearColor);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     
     // (rendering of SECOND scene follows...)
 }
@@ -423,7 +458,7 @@
 - (void) blendCrossDissolvePassesWithProgress:(CGFloat) progress {
 
     // Disable depth culling. Both quads should be drawn!
-    glDisable(GL_DEPTH_TEST);
+    glDispatch.disable(GL_DEPTH_TEST);
     
     static GLfloat color4fv[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
     
@@ -434,10 +469,10 @@
     
 
     clearColor(_backgroundClearColor);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     
     useProgram(_spriteProgram);
-    glUniformMatrix4fv(_modelviewLocation, 1, 0, _scaleMatrix);
+    glDispatch.uniformMatrix4fv(_modelviewLocation, 1, 0, _scaleMatrix);
     bindVertexArrayObject(_vao);
     
     // Scene 1 Fades OUT:
@@ -450,7 +485,7 @@
     
     uniform4fv(_colorLocation, color4fv);
     bindTexture2D(_transTexture1);
-    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
+    glDispatch.drawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
     
     // ---
     
@@ -462,18 +497,18 @@
     
     uniform4fv(_colorLocation, color4fv);
     bindTexture2D(_transTexture2);
-    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
+    glDispatch.drawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
     
 
     // Cleanup:
     static GLenum attachments[] = { GL_DEPTH_ATTACHMENT };
-    glDiscardFramebufferEXT(GL_FRAMEBUFFER, 1, attachments);
+    glDispatch.discardFramebuffer(GL_FRAMEBUFFER, 1, attachments);
     
     // Dsiplay composition:
     bindRenderbuffer(_mainColorbuffer);
     [_context presentRenderbuffer:GL_RENDERBUFFER];
     
-    glEnable(GL_DEPTH_TEST);
+    glDispatch.enable(GL_DEPTH_TEST);
 }
 
 
@@ -509,6 +544,7 @@
 - (BOOL) createFramebuffers {
 
     [EAGLContext setCurrentContext:_context];
+    glCacheMakeCurrent((__bridge const void *)_context);
     
     
     // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
@@ -517,13 +553,13 @@
     
     // 1. Framebuffer
     
-    glGenFramebuffers(1, &_mainFramebuffer);
+    glDispatch.genFramebuffers(1, &_mainFramebuffer);
     bindFramebuffer(_mainFramebuffer);
     //checkOpenGLError();
     
     // 2. Color buffer
     
-    glGenRenderbuffers(1, &_mainColorbuffer);
+    glDispatch.genRenderbuffers(1, &_mainColorbuffer);
     bindRenderbuffer(_mainColorbuffer);
     //checkOpenGLError();
     
@@ -542,18 +578,18 @@
     //checkOpenGLError();
     
     // Query new size:
-    glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH,  &_backingWidth);
-    glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, &_backingHeight);
+    glDispatch.getRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH,  &_backingWidth);
+    glDispatch.getRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, &_backingHeight);
     //checkOpenGLError();
     
     // Attach to color:
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _mainColorbuffer);
+    glDispatch.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _mainColorbuffer);
     //checkOpenGLError();
     
     
     // 3. Depth buffer
     
-    glGenRenderbuffers(1, &_depthBuffer);
+    glDispatch.genRenderbuffers(1, &_depthBuffer);
     bindRenderbuffer(_depthBuffer);
     //checkOpenGLError();
     
@@ -561,33 +597,33 @@
         // Depth + Stencil
         
         // Allocate storage:
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, _backingWidth, _backingHeight);
+        glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, _backingWidth, _backingHeight);
         //checkOpenGLError();
         
         // Attach to depth:
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
+        glDispatch.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
         //checkOpenGLError();
         
         // Attach to stencil:
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
+        glDispatch.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
         //checkOpenGLError();
     }
     else{
         // Depth only
         
         // Allocate storage:
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24_OES, _backingWidth, _backingHeight);
+        glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24_OES, _backingWidth, _backingHeight);
         //checkOpenGLError();
         
         // Attachto depth:
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
+        glDispatch.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
         //checkOpenGLError();
     }
     
     
     // 4. Validate the set:
     
-    GLenum framebufferStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    GLenum framebufferStatus = glDispatch.checkFramebufferStatus(GL_FRAMEBUFFER);
     
     if (framebufferStatus != GL_FRAMEBUFFER_COMPLETE) {
         // Something went wrong!
@@ -605,37 +641,37 @@
     
     // 1. Framebuffer
     
-    glGenFramebuffers(1, &_transFramebuffer);
+    glDispatch.genFramebuffers(1, &_transFramebuffer);
     bindFramebuffer(_transFramebuffer);
     //checkOpenGLError();
     
     
     // 2. Depth buffer
     
-    glGenRenderbuffers(1, &_transDepthBuffer);
+    glDispatch.genRenderbuffers(1, &_transDepthBuffer);
     bindRenderbuffer(_transDepthBuffer);
     //checkOpenGLError();
     
     if (_usingStencilBuffer) {
         // Allocate storage:
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, _backingWidth, _backingHeight);
+        glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, _backingWidth, _backingHeight);
         //checkOpenGLError();
         
         // Attach to depth:
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _transDepthBuffer);
+        glDispatch.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _transDepthBuffer);
         //checkOpenGLError();
         
         // Attach to stencil:
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _transDepthBuffer);
+        glDispatch.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _transDepthBuffer);
         //checkOpenGLError();
     }
     else{
         // Allocate storage
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24_OES, _backingWidth, _backingHeight);
+        glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24_OES, _backingWidth, _backingHeight);
         //checkOpenGLError();
         
         // Attach to depth:
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _transDepthBuffer);
+        glDispatch.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _transDepthBuffer);
         //checkOpenGLError();
     }
     
@@ -649,24 +685,24 @@
         
         GLuint* texPtr = texPtrs[i];
         
-        glGenTextures(1, texPtr);
+        glDispatch.genTextures(1, texPtr);
         
         bindTexture2D(*texPtr);
         
         // Configure for pixel-aligned use:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         
         // Allocate storage:
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _backingWidth, _backingHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glDispatch.texImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _backingWidth, _backingHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
         
         
         // Attach:
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *texPtr, 0);
+        glDispatch.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *texPtr, 0);
         
-        framebufferStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        framebufferStatus = glDispatch.checkFramebufferStatus(GL_FRAMEBUFFER);
         
         // Validate:
         
@@ -700,36 +736,36 @@
 - (void) destroyFramebuffers {
 
     if (_mainFramebuffer) {
-        glDeleteFramebuffers(1, &_mainFramebuffer);
+        glDispatch.deleteFramebuffers(1, &_mainFramebuffer);
         _mainFramebuffer = 0;
     }
     
     if (_mainColorbuffer) {
-        glDeleteRenderbuffers(1, &_mainColorbuffer);
+        glDispatch.deleteRenderbuffers(1, &_mainColorbuffer);
         _mainColorbuffer = 0;
     }
     
     if (_depthBuffer) {
-        glDeleteRenderbuffers(1, &_depthBuffer);
+        glDispatch.deleteRenderbuffers(1, &_depthBuffer);
     }
     
     if (_transFramebuffer) {
-        glDeleteFramebuffers(1, &_transFramebuffer);
+        glDispatch.deleteFramebuffers(1, &_transFramebuffer);
         _transFramebuffer = 0;
     }
     
     if (_transTexture1) {
-        glDeleteTextures(1, &_transTexture1);
+        glDispatch.deleteTextures(1, &_transTexture1);
         _transTexture1 = 0;
     }
     
     if (_transTexture2) {
-        glDeleteTextures(1, &_transTexture2);
+        glDispatch.deleteTextures(1, &_transTexture2);
         _transTexture2 = 0;
     }
     
     if (_transDepthBuffer) {
-        glDeleteRenderbuffers(1, &_transDepthBuffer);
+        glDispatch.deleteRenderbuffers(1, &_transDepthBuffer);
         _transDepthBuffer = 0;
     }
 }
@@ -775,33 +811,33 @@
     // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
     // VAO VERSION
     
-    glGenVertexArrays(1, &_vao);
+    glDispatch.genVertexArrays(1, &_vao);
     bindVertexArrayObject(_vao);
     
     
-    glGenBuffers(1, &_vbo);
+    glDispatch.genBuffers(1, &_vbo);
     bindVertexBufferObject(_vbo);
     
-    glBufferData(GL_ARRAY_BUFFER,
-                 4*sizeof(VertexData2D),
-                 &vertexData[0],
-                 GL_STATIC_DRAW);
+    glDispatch.bufferData(GL_ARRAY_BUFFER,
+                          4*sizeof(VertexData2D),
+                          &vertexData[0],
+                          GL_STATIC_DRAW);
     
     
-    glGenBuffers(1, &_ibo);
+    glDispatch.genBuffers(1, &_ibo);
     bindIndexBufferObject(_ibo);
     
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 4*sizeof(GLushort),
-                 &indices[0],
-                 GL_STATIC_DRAW);
+    glDispatch.bufferData(GL_ELEMENT_ARRAY_BUFFER,
+                          4*sizeof(GLushort),
+                          &indices[0],
+                          GL_STATIC_DRAW);
     
     
-    glEnableVertexAttribArray(_positionLocation);
-    glEnableVertexAttribArray(_texCoordLocation);
+    glDispatch.enableVertexAttribArray(_positionLocation);
+    glDispatch.enableVertexAttribArray(_texCoordLocation);
 
-    glVertexAttribPointer(_positionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
-    glVertexAttribPointer(_texCoordLocation, 2, GL_FLOAT, GL_FALSE, stride2D, textureOffset2D);
+    glDispatch.vertexAttribPointer(_positionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
+    glDispatch.vertexAttribPointer(_texCoordLocation, 2, GL_FLOAT, GL_FALSE, stride2D, textureOffset2D);
     
     
     // At this point the VAO is set up with two vertex attributes
@@ -811,8 +847,8 @@
     // with it.
     bindVertexArrayObject(0);
     
-    glDisableVertexAttribArray(_positionLocation);
-    glDisableVertexAttribArray(_texCoordLocation);
+    glDispatch.disableVertexAttribArray(_positionLocation);
+    glDispatch.disableVertexAttribArray(_texCoordLocation);
     
     bindIndexBufferObject(0);
     bindVertexBufferObject(0);
@@ -828,16 +864,16 @@
 - (void) restoreDefaultOpenGLStates {
 
     // Depth
-    glEnable(GL_DEPTH_TEST);
+    glDispatch.enable(GL_DEPTH_TEST);
     
     // Blending
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDispatch.enable(GL_BLEND);
+    glDispatch.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     // (OpenGL default blend function is: GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
     
     
     // Scissor
-    glDisable(GL_SCISSOR_TEST);
+    glDispatch.disable(GL_SCISSOR_TEST);
     
     
     // Clear Color
@@ -861,21 +897,21 @@
     
     // 1. Cache Access Points
     
-	_samplerLocation = glGetUniformLocation(_spriteProgram, "Sampler");
-	glUniform1i(_samplerLocation, 0);
+	_samplerLocation = glDispatch.getUniformLocation(_spriteProgram, "Sampler");
+	glDispatch.uniform1i(_samplerLocation, 0);
 	
-	_modelviewLocation	 = glGetUniformLocation(_spriteProgram, "Modelview");
-	_projectionLocation  = glGetUniformLocation(_spriteProgram, "Projection");
-	_colorLocation       = glGetUniformLocation(_spriteProgram, "Color");
+	_modelviewLocation	 = glDispatch.getUniformLocation(_spriteProgram, "Modelview");
+	_projectionLocation  = glDispatch.getUniformLocation(_spriteProgram, "Projection");
+	_colorLocation       = glDispatch.getUniformLocation(_spriteProgram, "Color");
 	
-	_positionLocation  = glGetAttribLocation(_spriteProgram, "Position");
-	_texCoordLocation  = glGetAttribLocation(_spriteProgram, "TextureCoord");
+	_positionLocation  = glDispatch.getAttribLocation(_spriteProgram, "Position");
+	_texCoordLocation  = glDispatch.getAttribLocation(_spriteProgram, "TextureCoord");
     
     
     // Set Projection Matrix (once)
     
     setOrthographicProjection(_spriteProgram,
-                              glGetUniformLocation(_spriteProgram, "Projection"),
+                              glDispatch.getUniformLocation(_spriteProgram, "Projection"),
                               -0.5*(_backingWidth),
                               +0.5*(_backingWidth),
                               -0.5*(_backingHeight),
@@ -891,7 +927,22 @@
     useProgram(flatProgram);
     
     setOrthographicProjection(flatProgram,
-                              glGetUniformLocation(_spriteProgram, "Projection"),
+                              glDispatch.getUniformLocation(_spriteProgram, "Projection"),
+                              -0.5*(_backingWidth),
+                              +0.5*(_backingWidth),
+                              -0.5*(_backingHeight),
+                              +0.5*(_backingHeight),
+                              -1.0,
+                              +1.0);
+    
+    // ...and for the batch program
+    
+    GLuint spriteBatchProgram = [shaderManager spriteBatchProgram];
+    
+    useProgram(spriteBatchProgram);
+    
+    setOrthographicProjection(spriteBatchProgram,
+                              glDispatch.getUniformLocation(spriteBatchProgram, "Projection"),
                               -0.5*(_backingWidth),
                               +0.5*(_backingWidth),
                               -0.5*(_backingHeight),
@@ -905,7 +956,7 @@
     useProgram(alphaProgram);
     
     setOrthographicProjection(alphaProgram,
-                              glGetUniformLocation(_spriteProgram, "Projection"),
+                              glDispatch.getUniformLocation(_spriteProgram, "Projection"),
                               -0.5*(_backingWidth),
                               +0.5*(_backingWidth),
                               -0.5*(_backingHeight),
@@ -29,7 +29,7 @@
 @property (nonatomic, readonly) id<DNRRenderer> renderer;
 
 
-///
+/// The first instance created (nil until then).
 + (instancetype) sharedController;
 
 
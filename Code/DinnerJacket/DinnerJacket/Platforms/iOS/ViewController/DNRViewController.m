@@ -33,10 +33,7 @@ static DNRViewController *sharedInstance = nil;
 
 + (instancetype) sharedController {
     
-    if (sharedInstance == nil){
-        sharedInstance = [self init];
-    }
-    
+    // (Set on initialization; there is none when running headless)
     return sharedInstance;
 }
 
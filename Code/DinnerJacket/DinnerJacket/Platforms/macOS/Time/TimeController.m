@@ -8,6 +8,8 @@
 
 #import "TimeController.h"
 #import "DNRSceneController.h"
+#import "DNRTextureLoader.h"
+#import "DNRFixedTimestep.h"
 
 
 @interface TimeController ()
@@ -46,7 +48,10 @@ static CVReturn MyDisplayLinkCallback(CVDisplayLinkRef displayLink,
 }
 
 
-@implementation TimeController
+@implementation TimeController {
+    
+    FixedTimestep   _timestep;
+}
 
 
 + (instancetype) sharedController {
@@ -82,6 +87,11 @@ static CVReturn MyDisplayLinkCallback(CVDisplayLinkRef displayLink,
 
         _currentTime = 0.0f;
         _dt          = 0.0f;
+        
+        _simulationRate       = 60;
+        _maximumStepsPerFrame = 4;
+        
+        fixedTimestepInit(&_timestep, (double)_simulationRate, (unsigned)_maximumStepsPerFrame);
     }
     
     return self;
@@ -104,6 +114,33 @@ static CVReturn MyDisplayLinkCallback(CVDisplayLinkRef displayLink,
 
 }
 
+#pragma mark - Custom Accessors
+
+
+- (void) setFixedTimestepEnabled:(BOOL) fixedTimestepEnabled {
+    
+    _fixedTimestepEnabled = fixedTimestepEnabled;
+    
+    fixedTimestepReset(&_timestep);
+}
+
+
+- (void) setSimulationRate:(NSUInteger) simulationRate {
+    
+    _simulationRate = MAX(simulationRate, 1);
+    
+    fixedTimestepInit(&_timestep, (double)_simulationRate, (unsigned)_maximumStepsPerFrame);
+}
+
+
+- (void) setMaximumStepsPerFrame:(NSUInteger) maximumStepsPerFrame {
+    
+    _maximumStepsPerFrame = MAX(maximumStepsPerFrame, 1);
+    
+    fixedTimestepInit(&_timestep, (double)_simulationRate, (unsigned)_maximumStepsPerFrame);
+}
+
+
 #pragma mark - Exposed Operation
 
 - (void) addSceneController:(DNRSceneController *) controller {
@@ -140,6 +177,10 @@ static CVReturn MyDisplayLinkCallback(CVDisplayLinkRef displayLink,
         CVDisplayLinkSetOutputCallback(_displayLink, &MyDisplayLinkCallback, (__bridge void *)(self));
         
         
+        // (Time spent paused is not simulated)
+        _currentTime = 0.0;
+        fixedTimestepReset(&_timestep);
+        
         // Activate the display link
         CVDisplayLinkStart(_displayLink);
         
@@ -165,9 +206,25 @@ static CVReturn MyDisplayLinkCallback(CVDisplayLinkRef displayLink,
 
     _currentTime = newCurrentTime;
 
-    for (DNRSceneController* controller in _sceneControllers) {
-        [controller tick:dt];
+    if (_fixedTimestepEnabled) {
+        double alpha = 0.0;
+        
+        // (Wall clock time may step back; that counts as no time)
+        NSUInteger stepCount = fixedTimestepAdvance(&_timestep, dt, &alpha);
+        
+        for (DNRSceneController* controller in _sceneControllers) {
+            [controller tick:_timestep.step steps:stepCount interpolation:(CGFloat)alpha];
+        }
+    }
+    else{
+        for (DNRSceneController* controller in _sceneControllers) {
+            [controller tick:dt];
+        }
     }
+    
+    // Upload textures decoded in the background (no longer than the
+    // loader's per-frame budget allows)
+    [[DNRTextureLoader sharedLoader] performPendingUploads];
 }
 
 
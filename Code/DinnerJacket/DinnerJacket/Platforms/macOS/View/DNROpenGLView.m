@@ -16,6 +16,7 @@
 #import "DNRSceneController.h"
 #import "../Time/TimeController.h"
 #import "DNROpenGLUtilities.h"
+#import "DNRGLCache.h"
 
 #import "DNRPointerInput.h"
 #import "DNRInputClaimPair.h"
@@ -135,6 +136,7 @@ static NSOpenGLContext* sharedContext = nil;
 
     // TEST
     [context makeCurrentContext];
+    glCacheMakeCurrent((__bridge const void *)context);
 
     _renderer = [[DNROpenGL3Renderer alloc] initWithView:self stencilBufferBits:0];
 }
@@ -154,6 +156,9 @@ static NSOpenGLContext* sharedContext = nil;
     // Release the display link AFTER display link has been released
     renderer = nil;
      */
+
+    // (The context is owned by the view)
+    glCacheContextRemove((__bridge const void *)[self openGLContext]);
 }
 
 
@@ -164,6 +169,7 @@ static NSOpenGLContext* sharedContext = nil;
     [super prepareOpenGL];
     
     [[self openGLContext] makeCurrentContext];
+    glCacheMakeCurrent((__bridge const void *)[self openGLContext]);
     
     GLint swapInterval = 1;
     [[self openGLContext] setValues:&swapInterval forParameter:NSOpenGLCPSwapInterval];
@@ -248,6 +254,7 @@ static NSOpenGLContext* sharedContext = nil;
     // fine with the flicker...
     
     [[self openGLContext] makeCurrentContext];
+    glCacheMakeCurrent((__bridge const void *)[self openGLContext]);
     
     CGLLockContext([[self openGLContext] CGLContextObj]);
     
@@ -15,6 +15,7 @@
 #import "DNRMatrix.h"                   // Math support
 
 #import "DNRGLCache.h"                  // OpenGL support
+#import "DNRGLDispatch.h"               // (All OpenGL calls go through it)
 #import "DNROpenGLUtilities.h"
 
 #import "DNRShaderManager.h"
@@ -22,6 +23,10 @@
 #import "DNRGlobals.h"                  // Stride, etc.
 
 
+// Maximum number of quads submitted with each flush of the sprite batch
+#define DNRRendererSpriteBatchCapacity  4096u
+
+
 @interface DNROpenGL3Renderer ()
 
 @property (nonatomic, unsafe_unretained, readwrite) DNROpenGLView* view;
@@ -53,6 +58,8 @@
 @property (nonatomic, readwrite) GLint positionLocation;
 @property (nonatomic, readwrite) GLint texCoordLocation;
 
+@property (nonatomic, readwrite) SpriteBatch* spriteBatch;
+
 @end
 
 // .............................................................................
@@ -70,6 +77,7 @@
 // (Properties declared in a protocol won't be auto-synthesized)
 @synthesize backgroundClearColor = _backgroundClearColor;
 @synthesize sceneClearColor      = _sceneClearColor;
+@synthesize spriteBatch          = _spriteBatch;
 
 - (id) context {
     return _openGLContext;
@@ -96,7 +104,22 @@
 - (void) setScrollOffset:(CGPoint)scrollOffset {
     _scrollOffset = scrollOffset;
     
-    glViewport(_scrollOffset.x, -_scrollOffset.y, _backingWidth, _backingHeight);
+    glDispatch.viewport(_scrollOffset.x, -_scrollOffset.y, _backingWidth, _backingHeight);
+}
+
+- (CGRect) visibleRect {
+    
+    // The projection spans the backing size times the zoom scale, centered on
+    // the origin; the viewport is shifted by the scroll offset (in window
+    // pixels, i.e. scaled by zoom in world pixels), in the opposite direction.
+    
+    CGFloat width  = _backingWidth  * _zoomScale;
+    CGFloat height = _backingHeight * _zoomScale;
+    
+    CGFloat centerX = - _scrollOffset.x * _zoomScale;
+    CGFloat centerY = + _scrollOffset.y * _zoomScale;
+    
+    return CGRectMake(centerX - 0.5f*width, centerY - 0.5f*height, width, height);
 }
 
 
@@ -157,6 +180,13 @@
             return ((self = nil));
         }
         
+        // 3.b Create sprite batch (streaming geometry)
+        _spriteBatch = spriteBatchCreate([[DNRShaderManager defaultManager] spriteBatchProgram],
+                                         DNRRendererSpriteBatchCapacity);
+        if (_spriteBatch == NULL) {
+            return ((self = nil));
+        }
+        
         // 4. Set default OpenGL State
         [self restoreDefaultOpenGLStates];
         
@@ -168,6 +198,15 @@
 }
 
 
+- (void) dealloc {
+
+    spriteBatchDestroy(_spriteBatch);
+    
+    // (The main context belongs to the view)
+    glCacheContextRemove((__bridge const void *)_backgroundOpenGLContext);
+}
+
+
 #pragma mark - DNRRenderer Protocol Methods (All Platform Renderers)
 
 
@@ -177,7 +216,7 @@
     
     _currentFramebuffer = _mainFramebuffer;
     
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
 
@@ -212,7 +251,7 @@
     
     // 1. Clear the screen:
     clearColor(_sceneClearColor);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     
     // (must clear depth buffer too, otherwise 3D objects won't render properly
     //  during transitions)
@@ -225,7 +264,7 @@
 
     // Modulate Rendered Scene into the Screen, at the Appropriate Opacity
     
-    glDisable(GL_DEPTH_TEST);
+    glDispatch.disable(GL_DEPTH_TEST);
     
     static GLfloat color4fv[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
     
@@ -237,7 +276,7 @@
     
     // Clear the screen:
     clearColor(_backgroundClearColor);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDispatch.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     
     
     // Bind shaders
@@ -245,7 +284,7 @@
 
     
     // Upload scale matrix to shader:
-    glUniformMatrix4fv(_modelviewLocation, 1, 0, _scaleMatrix);
+    glDispatch.uniformMatrix4fv(_modelviewLocation, 1, 0, _scaleMatrix);
     // (alternatively, we could create the quad to screen size)
     
     
@@ -265,7 +304,7 @@
     bindVertexArrayObject(_vao);
     
     // Draw
-    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
+    glDispatch.drawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, 0);
     
     
     
@@ -282,7 +321,7 @@
     //bindRenderbuffer(_mainColorbuffer);
 	//[_context presentRenderbuffer:GL_RENDERBUFFER];
     
-    glEnable(GL_DEPTH_TEST);
+    glDispatch.enable(GL_DEPTH_TEST);
 }
 
 
@@ -436,7 +475,7 @@
     
     // 1. Offscreen Framebuffer
     
-    glGenFramebuffers(1, &_transFramebuffer);
+    glDispatch.genFramebuffers(1, &_transFramebuffer);
     checkOpenGLError();
     
     bindFramebuffer(_transFramebuffer);
@@ -445,14 +484,14 @@
     
     // 2. Offscreen Depth Renderbuffer
     
-    glGenRenderbuffers(1, &_transDepthBuffer);
+    glDispatch.genRenderbuffers(1, &_transDepthBuffer);
     bindRenderbuffer(_transDepthBuffer);
     checkOpenGLError();
     
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _backingWidth, _backingHeight);
+    glDispatch.renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _backingWidth, _backingHeight);
     checkOpenGLError();
     
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _transDepthBuffer);
+    glDispatch.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _transDepthBuffer);
     checkOpenGLError();
     
     // 3. Textures (Color attachment)
@@ -462,23 +501,23 @@
     for (NSUInteger i = 0; i < 2; i++) {
         GLuint* texPtr = texPtrs[i];
         
-        glGenTextures(1, texPtr);
+        glDispatch.genTextures(1, texPtr);
         bindTexture2D(*texPtr);
         
         // Configure for pixel-aligned use:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glDispatch.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _backingWidth, _backingHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glDispatch.texImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _backingWidth, _backingHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
         checkOpenGLError();
         
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *texPtr, 0);
+        glDispatch.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *texPtr, 0);
         
         checkOpenGLError();
         
-        framebufferStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        framebufferStatus = glDispatch.checkFramebufferStatus(GL_FRAMEBUFFER);
         
         if ( framebufferStatus != GL_FRAMEBUFFER_COMPLETE) {
             // Something went wrong!
@@ -500,36 +539,36 @@
     
     
     if (_mainFramebuffer) {
-        glDeleteFramebuffers(1, &_mainFramebuffer);
+        glDispatch.deleteFramebuffers(1, &_mainFramebuffer);
         _mainFramebuffer = 0;
     }
     
     if (_mainColorbuffer) {
-        glDeleteRenderbuffers(1, &_mainColorbuffer);
+        glDispatch.deleteRenderbuffers(1, &_mainColorbuffer);
         _mainColorbuffer = 0;
     }
     
     if (_depthBuffer) {
-        glDeleteRenderbuffers(1, &_depthBuffer);
+        glDispatch.deleteRenderbuffers(1, &_depthBuffer);
     }
     
     if (_transFramebuffer) {
-        glDeleteFramebuffers(1, &_transFramebuffer);
+        glDispatch.deleteFramebuffers(1, &_transFramebuffer);
         _transFramebuffer = 0;
     }
     
     if (_transTexture1) {
-        glDeleteTextures(1, &_transTexture1);
+        glDispatch.deleteTextures(1, &_transTexture1);
         _transTexture1 = 0;
     }
     
     if (_transTexture2) {
-        glDeleteTextures(1, &_transTexture2);
+        glDispatch.deleteTextures(1, &_transTexture2);
         _transTexture2 = 0;
     }
     
     if (_transDepthBuffer) {
-        glDeleteRenderbuffers(1, &_transDepthBuffer);
+        glDispatch.deleteRenderbuffers(1, &_transDepthBuffer);
         _transDepthBuffer = 0;
     }
     
@@ -578,33 +617,33 @@
     // .. ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ... ..
     // VAO VERSION
     
-    glGenVertexArrays(1, &_vao);
+    glDispatch.genVertexArrays(1, &_vao);
     bindVertexArrayObject(_vao);
     
     
-    glGenBuffers(1, &_vbo);
+    glDispatch.genBuffers(1, &_vbo);
     bindVertexBufferObject(_vbo);
     
-    glBufferData(GL_ARRAY_BUFFER,
-                 4*sizeof(VertexData2D),
-                 &vertexData[0],
-                 GL_STATIC_DRAW);
+    glDispatch.bufferData(GL_ARRAY_BUFFER,
+                          4*sizeof(VertexData2D),
+                          &vertexData[0],
+                          GL_STATIC_DRAW);
     
     
-    glGenBuffers(1, &_ibo);
+    glDispatch.genBuffers(1, &_ibo);
     bindIndexBufferObject(_ibo);
     
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 4*sizeof(GLushort),
-                 &indices[0],
-                 GL_STATIC_DRAW);
+    glDispatch.bufferData(GL_ELEMENT_ARRAY_BUFFER,
+                          4*sizeof(GLushort),
+                          &indices[0],
+                          GL_STATIC_DRAW);
     
     
-    glEnableVertexAttribArray(_positionLocation);
-    glEnableVertexAttribArray(_texCoordLocation);
+    glDispatch.enableVertexAttribArray(_positionLocation);
+    glDispatch.enableVertexAttribArray(_texCoordLocation);
 
-    glVertexAttribPointer(_positionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
-    glVertexAttribPointer(_texCoordLocation, 2, GL_FLOAT, GL_FALSE, stride2D, textureOffset2D);
+    glDispatch.vertexAttribPointer(_positionLocation, 2, GL_FLOAT, GL_FALSE, stride2D, positionOffset2D);
+    glDispatch.vertexAttribPointer(_texCoordLocation, 2, GL_FLOAT, GL_FALSE, stride2D, textureOffset2D);
     
     
     // At this point the VAO is set up with two vertex attributes
@@ -614,8 +653,8 @@
     // with it.
     bindVertexArrayObject(0);
     
-    glDisableVertexAttribArray(_positionLocation);
-    glDisableVertexAttribArray(_texCoordLocation);
+    glDispatch.disableVertexAttribArray(_positionLocation);
+    glDispatch.disableVertexAttribArray(_texCoordLocation);
     
     bindIndexBufferObject(0);
     bindVertexBufferObject(0);
@@ -631,16 +670,16 @@
 - (void) restoreDefaultOpenGLStates {
 
     // Depth
-    glEnable(GL_DEPTH_TEST);
+    glDispatch.enable(GL_DEPTH_TEST);
     
     // Blending
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDispatch.enable(GL_BLEND);
+    glDispatch.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     // (OpenGL default blend function is: GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
     
     
     // Scissor
-    glDisable(GL_SCISSOR_TEST);
+    glDispatch.disable(GL_SCISSOR_TEST);
     
     
     // Clear Color
@@ -665,21 +704,21 @@
     
     // 1. Cache Access Points
     
-	_samplerLocation = glGetUniformLocation(_spriteProgram, "Sampler");
-	glUniform1i(_samplerLocation, 0);
+	_samplerLocation = glDispatch.getUniformLocation(_spriteProgram, "Sampler");
+	glDispatch.uniform1i(_samplerLocation, 0);
 	
-	_modelviewLocation	 = glGetUniformLocation(_spriteProgram, "Modelview");
-	_projectionLocation  = glGetUniformLocation(_spriteProgram, "Projection");
-	_colorLocation       = glGetUniformLocation(_spriteProgram, "Color");
+	_modelviewLocation	 = glDispatch.getUniformLocation(_spriteProgram, "Modelview");
+	_projectionLocation  = glDispatch.getUniformLocation(_spriteProgram, "Projection");
+	_colorLocation       = glDispatch.getUniformLocation(_spriteProgram, "Color");
 	
-	_positionLocation  = glGetAttribLocation(_spriteProgram, "Position");
-	_texCoordLocation  = glGetAttribLocation(_spriteProgram, "TextureCoord");
+	_positionLocation  = glDispatch.getAttribLocation(_spriteProgram, "Position");
+	_texCoordLocation  = glDispatch.getAttribLocation(_spriteProgram, "TextureCoord");
     
     
     // Set Projection Matrix (once)
     
     setOrthographicProjection(_spriteProgram,
-                              glGetUniformLocation(_spriteProgram, "Projection"),
+                              glDispatch.getUniformLocation(_spriteProgram, "Projection"),
                               -0.5*(_backingWidth),
                               +0.5*(_backingWidth),
                               -0.5*(_backingHeight),
@@ -695,7 +734,22 @@
     useProgram(_flatProgram);
     
     setOrthographicProjection(_flatProgram,
-                              glGetUniformLocation(_flatProgram, "Projection"),
+                              glDispatch.getUniformLocation(_flatProgram, "Projection"),
+                              -0.5*(_backingWidth),
+                              +0.5*(_backingWidth),
+                              -0.5*(_backingHeight),
+                              +0.5*(_backingHeight),
+                              -1.0,
+                              +1.0);
+    
+    // ...and for the batch program
+    
+    GLuint spriteBatchProgram = [shaderManager spriteBatchProgram];
+    
+    useProgram(spriteBatchProgram);
+    
+    setOrthographicProjection(spriteBatchProgram,
+                              glDispatch.getUniformLocation(spriteBatchProgram, "Projection"),
                               -0.5*(_backingWidth),
                               +0.5*(_backingWidth),
                               -0.5*(_backingHeight),
@@ -709,7 +763,7 @@
     useProgram(alphaProgram);
     
     setOrthographicProjection(alphaProgram,
-                              glGetUniformLocation(_spriteProgram, "Projection"),
+                              glDispatch.getUniformLocation(_spriteProgram, "Projection"),
                               -0.5*(_backingWidth),
                               +0.5*(_backingWidth),
                               -0.5*(_backingHeight),
@@ -747,7 +801,7 @@
     
     useProgram(_spriteProgram);
     setOrthographicProjection(_spriteProgram,
-                              glGetUniformLocation(_spriteProgram, "Projection"),
+                              glDispatch.getUniformLocation(_spriteProgram, "Projection"),
                               xMin,
                               xMax,
                               yMin,
@@ -757,7 +811,19 @@
     
     useProgram(_flatProgram);
     setOrthographicProjection(_flatProgram,
-                              glGetUniformLocation(_flatProgram, "Projection"),
+                              glDispatch.getUniformLocation(_flatProgram, "Projection"),
+                              xMin,
+                              xMax,
+                              yMin,
+                              yMax,
+                              -1.0,
+                              +1.0);
+    
+    GLuint spriteBatchProgram = [[DNRShaderManager defaultManager] spriteBatchProgram];
+    
+    useProgram(spriteBatchProgram);
+    setOrthographicProjection(spriteBatchProgram,
+                              glDispatch.getUniformLocation(spriteBatchProgram, "Projection"),
                               xMin,
                               xMax,
                               yMin,
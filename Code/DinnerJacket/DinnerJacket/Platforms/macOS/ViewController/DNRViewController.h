@@ -30,6 +30,7 @@
 @property (nonatomic, readonly) id<DNRRenderer> renderer;
 
 
+/// The first instance created (nil until then).
 + (instancetype) sharedController;
 
 
@@ -0,0 +1,219 @@
+//
+//  DNRFixedTimestepTests.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-13.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+/*
+ Checks the step counts and interpolation alpha that fixedTimestepAdvance()
+ returns: display rates above and below the simulation rate, the catch-up
+ limit (and the whole steps dropped beyond it), negative elapsed times, and
+ that alpha always stays in [0, 1).
+
+ Most cases use a step of 1/4 s, so the expected values are exact.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "DNRFixedTimestep.h"
+
+
+#define RandomFrameCount    100000
+
+
+static uint32_t randomState = 0x2545F491u;
+
+static unsigned failureCount = 0;
+
+
+// .............................................................................
+
+/*
+ xorshift32; the same sequence on every platform (unlike rand()).
+ */
+static uint32_t nextRandom(void) {
+
+    uint32_t x = randomState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return (randomState = x);
+}
+
+
+/**
+ Advances by elapsed, and checks the steps returned and the alpha after them.
+ */
+static void checkAdvance(const char* what, FixedTimestep* timestep, double elapsed, unsigned expectedSteps, double expectedAlpha) {
+
+    double   alpha     = -1.0;
+    unsigned stepCount = fixedTimestepAdvance(timestep, elapsed, &alpha);
+
+    if (stepCount != expectedSteps || alpha != expectedAlpha) {
+        fprintf(stderr, "%s: %u steps, alpha %g; expected %u steps, alpha %g\n",
+                what, stepCount, alpha, expectedSteps, expectedAlpha);
+        failureCount++;
+    }
+}
+
+
+// .............................................................................
+
+static void testStepCounts(void) {
+
+    FixedTimestep timestep;
+    fixedTimestepInit(&timestep, 4.0, 8);
+
+    checkAdvance("nothing elapsed", &timestep, 0.0, 0, 0.0);
+
+    // Display faster than the simulation: steps on some refreshes only
+    checkAdvance("half a step", &timestep, 0.125, 0, 0.5);
+    checkAdvance("another half", &timestep, 0.125, 1, 0.0);
+
+    // Display slower than the simulation: several steps per refresh
+    checkAdvance("two and a half steps", &timestep, 0.625, 2, 0.5);
+    checkAdvance("one and a half more", &timestep, 0.375, 2, 0.0);
+
+    // Exactly one step
+    checkAdvance("one step", &timestep, 0.25, 1, 0.0);
+
+    // Resetting discards the fraction accumulated
+    checkAdvance("three quarters", &timestep, 0.1875, 0, 0.75);
+    fixedTimestepReset(&timestep);
+    checkAdvance("after reset", &timestep, 0.0, 0, 0.0);
+
+    // alpha is optional
+    if (fixedTimestepAdvance(&timestep, 0.5, NULL) != 2) {
+        fprintf(stderr, "NULL alpha: wrong step count\n");
+        failureCount++;
+    }
+}
+
+
+static void testCatchUpLimit(void) {
+
+    FixedTimestep timestep;
+    fixedTimestepInit(&timestep, 4.0, 3);
+
+    // A hitch of 8.5 steps: 3 taken, the 5 whole steps left are dropped, the
+    // fraction is kept
+    checkAdvance("hitch", &timestep, 2.125, 3, 0.5);
+    checkAdvance("after hitch", &timestep, 0.0, 0, 0.5);
+    checkAdvance("recovered", &timestep, 0.125, 1, 0.0);
+
+    // Exactly at the limit: nothing dropped
+    checkAdvance("at the limit", &timestep, 0.75, 3, 0.0);
+
+    // Just over: the whole step beyond is dropped
+    checkAdvance("one step over", &timestep, 1.0625, 3, 0.25);
+
+    // A limit of zero is raised to one
+    fixedTimestepInit(&timestep, 4.0, 0);
+
+    if (timestep.maxStepsPerFrame != 1) {
+        fprintf(stderr, "maxStepsPerFrame 0: raised to %u, expected 1\n", timestep.maxStepsPerFrame);
+        failureCount++;
+    }
+    checkAdvance("limit of one", &timestep, 0.5, 1, 0.0);
+}
+
+
+static void testNegativeElapsed(void) {
+
+    FixedTimestep timestep;
+    fixedTimestepInit(&timestep, 4.0, 8);
+
+    checkAdvance("quarter step", &timestep, 0.0625, 0, 0.25);
+
+    // Counts as zero: no steps, the fraction accumulated stays
+    checkAdvance("negative", &timestep, -1.0, 0, 0.25);
+    checkAdvance("negative, tiny", &timestep, -1.0e-9, 0, 0.25);
+    checkAdvance("after negative", &timestep, 0.1875, 1, 0.0);
+}
+
+
+/*
+ Random refresh intervals (from 0 to 3 steps, with the occasional hitch or
+ negative value) at a 60 Hz simulation: alpha stays in [0, 1), no frame
+ exceeds the limit, and unless a frame was capped, the time simulated plus
+ the fraction left accounts for all the time elapsed.
+ */
+static void testRandomFrames(void) {
+
+    FixedTimestep timestep;
+    fixedTimestepInit(&timestep, 60.0, 5);
+
+    double elapsedTotal   = 0.0;
+    double simulatedTotal = 0.0;
+
+    for (int frame = 0; frame < RandomFrameCount; frame++) {
+
+        uint32_t r       = nextRandom();
+        double   elapsed = (double)(r >> 8) / (double)(1u << 24) * 3.0 * timestep.step;
+
+        switch (r & 0x3F) {
+            case 0:
+                elapsed = 0.5;          // Hitch
+                break;
+
+            case 1:
+                elapsed = -elapsed;     // Clock went backwards
+                break;
+
+            default:
+                break;
+        }
+
+        double   alpha;
+        unsigned stepCount = fixedTimestepAdvance(&timestep, elapsed, &alpha);
+
+        if (!(alpha >= 0.0 && alpha < 1.0) || stepCount > timestep.maxStepsPerFrame) {
+            fprintf(stderr, "frame %d: %u steps, alpha %g\n", frame, stepCount, alpha);
+            failureCount++;
+            return;
+        }
+
+        if (elapsed == 0.5) {
+            // Capped: restart the bookkeeping from what was kept
+            elapsedTotal   = timestep.accumulator;
+            simulatedTotal = 0.0;
+            continue;
+        }
+
+        elapsedTotal   += (elapsed > 0.0) ? elapsed : 0.0;
+        simulatedTotal += stepCount * timestep.step;
+
+        if (fabs(elapsedTotal - (simulatedTotal + alpha*timestep.step)) > 1.0e-9) {
+            fprintf(stderr, "frame %d: %g s elapsed, %g s simulated + alpha %g\n",
+                    frame, elapsedTotal, simulatedTotal, alpha);
+            failureCount++;
+            return;
+        }
+    }
+}
+
+
+// .............................................................................
+
+int main(void) {
+
+    testStepCounts();
+    testCatchUpLimit();
+    testNegativeElapsed();
+    testRandomFrames();
+
+    if (failureCount > 0) {
+        fprintf(stderr, "fixed timestep: %u failures\n", failureCount);
+        return 1;
+    }
+
+    printf("fixed timestep: step counts, alpha and catch-up limit as expected\n");
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+//
+//  DNRGLRecorderTests.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-13.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+/*
+ Records texture uploads whose rows are padded to the unpack alignment (odd
+ widths of 16 bit formats, 1 pixel wide mip levels), replays them, and checks
+ that the data read back is exactly what was uploaded, and that the null
+ backend counts the same number of bytes.
+
+ The client buffers are allocated with the exact size OpenGL reads (no
+ padding after the last row), so recording too much shows up under a memory
+ checker (e.g., -fsanitize=address).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DNRGLDispatch.h"
+#include "DNRGLRecorder.h"
+
+
+typedef struct tUpload {
+
+    const char* what;
+    int         subImage;
+    GLsizei     width;
+    GLsizei     height;
+    GLenum      format;
+    GLenum      type;
+    size_t      expectedSize;
+
+    unsigned char* pixels;
+
+}Upload;
+
+
+static Upload uploads[] = {
+    { "565, 3x5",               0, 3, 5, GL_RGB,  GL_UNSIGNED_SHORT_5_6_5,   8*4 + 6,  NULL },
+    { "4444, 5x3",              0, 5, 3, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 12*2 + 10, NULL },
+    { "5551, 1x4 (sub image)",  1, 1, 4, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, 4*3 + 2,  NULL },
+    { "RGB8, 3x2",              0, 3, 2, GL_RGB,  GL_UNSIGNED_BYTE,          12 + 9,   NULL },
+    { "RGBA8, 3x2 (sub image)", 1, 3, 2, GL_RGBA, GL_UNSIGNED_BYTE,          12 + 12,  NULL },
+};
+
+#define UploadCount     (sizeof(uploads)/sizeof(uploads[0]))
+
+
+static unsigned replayedCount = 0;
+static unsigned failureCount  = 0;
+
+
+// .............................................................................
+
+static void fail(const char* what, const char* message) {
+
+    fprintf(stderr, "%s: %s\n", what, message);
+    failureCount++;
+}
+
+
+static void checkReplayed(GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels) {
+
+    if (replayedCount >= UploadCount) {
+        fail("replay", "more uploads than recorded");
+        return;
+    }
+
+    const Upload* upload = &uploads[replayedCount++];
+
+    if (width != upload->width || height != upload->height || format != upload->format || type != upload->type) {
+        fail(upload->what, "replayed with different parameters");
+    }
+    else if (!pixels || memcmp(pixels, upload->pixels, upload->expectedSize) != 0) {
+        fail(upload->what, "replayed pixels differ from the uploaded ones");
+    }
+}
+
+
+static void captureTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels) {
+    (void)target; (void)level; (void)internalFormat; (void)border;
+    checkReplayed(width, height, format, type, pixels);
+}
+
+
+static void captureTexSubImage2D(GLenum target, GLint level, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels) {
+    (void)target; (void)level; (void)xOffset; (void)yOffset;
+    checkReplayed(width, height, format, type, pixels);
+}
+
+
+// .............................................................................
+
+int main(void) {
+
+    // 1. Sizes
+
+    size_t totalSize = 0;
+
+    for (unsigned i = 0; i < UploadCount; i++) {
+
+        Upload* upload = &uploads[i];
+
+        size_t size = glDispatchPixelDataSize(upload->width, upload->height, upload->format, upload->type);
+
+        if (size != upload->expectedSize) {
+            fprintf(stderr, "%s: glDispatchPixelDataSize() returned %zu, expected %zu\n",
+                    upload->what, size, upload->expectedSize);
+            return 1;
+        }
+
+        upload->pixels = malloc(size);
+
+        for (size_t j = 0; j < size; j++) {
+            upload->pixels[j] = (unsigned char)(7*j + 13*i + 1);
+        }
+
+        totalSize += size;
+    }
+
+    // 2. Record (forwarded to the null backend, which counts the bytes)
+
+    GLRecorder* recorder = glRecorderCreate();
+
+    glDispatchResetCounters();
+    glRecorderStart(recorder, NULL);
+
+    GLuint texture;
+    glDispatch.genTextures(1, &texture);
+    glDispatch.bindTexture(GL_TEXTURE_2D, texture);
+
+    for (unsigned i = 0; i < UploadCount; i++) {
+
+        const Upload* upload = &uploads[i];
+
+        if (upload->subImage) {
+            glDispatch.texSubImage2D(GL_TEXTURE_2D, 0, 0, 0, upload->width, upload->height, upload->format, upload->type, upload->pixels);
+        }
+        else{
+            glDispatch.texImage2D(GL_TEXTURE_2D, 0, (GLint)upload->format, upload->width, upload->height, 0, upload->format, upload->type, upload->pixels);
+        }
+    }
+
+    glRecorderStop(recorder);
+
+    if (glDispatchCounters().bytesUploaded != totalSize) {
+        fprintf(stderr, "null backend counted %llu bytes uploaded, expected %zu\n",
+                (unsigned long long)glDispatchCounters().bytesUploaded, totalSize);
+        failureCount++;
+    }
+
+    // 3. Replay into a backend that checks the data
+
+    GLDispatch capture = *glDispatchNullBackend();
+
+    capture.texImage2D    = captureTexImage2D;
+    capture.texSubImage2D = captureTexSubImage2D;
+
+    size_t      streamSize = 0;
+    const void* stream     = glRecorderBytes(recorder, &streamSize);
+
+    if (glRecorderReplay(stream, streamSize, &capture, NULL, NULL) < 0) {
+        fail("replay", "stream is malformed");
+    }
+    if (replayedCount != UploadCount) {
+        fail("replay", "fewer uploads than recorded");
+    }
+
+    glRecorderDestroy(recorder);
+
+    for (unsigned i = 0; i < UploadCount; i++) {
+        free(uploads[i].pixels);
+    }
+
+    if (failureCount > 0) {
+        return 1;
+    }
+
+    printf("%u padded uploads recorded and replayed intact\n", (unsigned)UploadCount);
+
+    return 0;
+}
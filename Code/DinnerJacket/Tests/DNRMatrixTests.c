@@ -0,0 +1,259 @@
+//
+//  DNRMatrixTests.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-11.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+/*
+ Checks that the default (vectorized, where available) matrix kernels produce
+ exactly the same bits as their scalar reference implementations, for random
+ inputs, also when the output aliases an input. The affine point transform is
+ also checked against the 4x4 one on the equivalent matrix.
+
+ Built twice by CMakeLists.txt: as is (SSE/NEON, depending on the target) and
+ with DNR_MATRIX_NO_SIMD (scalar fallback). Exits with a non-zero status on
+ the first mismatch.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "DNRMatrix.h"
+
+
+#define TrialCount      200000
+
+#define PointCount      7       // Odd, so no kernel can assume pairs
+#define VertexFloats    5       // Interleaved: x, y plus 3 other attributes
+
+
+static uint32_t randomState = 0x2545F491u;
+
+static unsigned failureCount = 0;
+
+
+// .............................................................................
+
+/*
+ xorshift32; the same sequence on every platform (unlike rand()).
+ */
+static uint32_t nextRandom(void) {
+
+    uint32_t x = randomState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return (randomState = x);
+}
+
+
+/*
+ Mostly in [-100, 100), with the occasional exact zero and one (common in
+ transforms, and worth covering).
+ */
+static float randomFloat(void) {
+
+    uint32_t r = nextRandom();
+
+    switch (r & 0x1F) {
+        case 0:
+            return 0.0f;
+
+        case 1:
+            return 1.0f;
+
+        default:
+            return ((float)(r >> 8) / (float)(1u << 24)) * 200.0f - 100.0f;
+    }
+}
+
+
+static void fillRandom(float* values, size_t count) {
+
+    for (size_t i = 0; i < count; i++) {
+        values[i] = randomFloat();
+    }
+}
+
+
+static void check(int trial, const char* what, const void* result, const void* expected, size_t size) {
+
+    if (memcmp(result, expected, size) != 0) {
+
+        if (failureCount == 0) {
+            fprintf(stderr, "Trial %d: %s differs from the scalar reference\n", trial, what);
+        }
+        failureCount++;
+    }
+}
+
+
+// .............................................................................
+
+static void testMultiplyMat4f(int trial) {
+
+    float m1[16], m2[16], expected[16], result[16];
+
+    fillRandom(m1, 16);
+    fillRandom(m2, 16);
+
+    mat4f_MultiplyMat4f_Scalar(m1, m2, expected);
+
+    mat4f_MultiplyMat4f(m1, m2, result);
+    check(trial, "mat4f_MultiplyMat4f", result, expected, sizeof(result));
+
+    // Output aliasing either operand:
+
+    memcpy(result, m1, sizeof(result));
+    mat4f_MultiplyMat4f(result, m2, result);
+    check(trial, "mat4f_MultiplyMat4f (mout == m1)", result, expected, sizeof(result));
+
+    memcpy(result, m2, sizeof(result));
+    mat4f_MultiplyMat4f(m1, result, result);
+    check(trial, "mat4f_MultiplyMat4f (mout == m2)", result, expected, sizeof(result));
+
+    // Squaring (all three the same):
+
+    mat4f_MultiplyMat4f_Scalar(m1, m1, expected);
+
+    memcpy(result, m1, sizeof(result));
+    mat4f_MultiplyMat4f(result, result, result);
+    check(trial, "mat4f_MultiplyMat4f (m1 == m2 == mout)", result, expected, sizeof(result));
+}
+
+
+static void testMultiplyVec4f(int trial) {
+
+    float m[16], v[4], expected[4], result[4];
+
+    fillRandom(m, 16);
+    fillRandom(v, 4);
+
+    mat4f_MultiplyVec4f_Scalar(m, v, expected);
+
+    mat4f_MultiplyVec4f(m, v, result);
+    check(trial, "mat4f_MultiplyVec4f", result, expected, sizeof(result));
+
+    memcpy(result, v, sizeof(result));
+    mat4f_MultiplyVec4f(m, result, result);
+    check(trial, "mat4f_MultiplyVec4f (vout == vin)", result, expected, sizeof(result));
+}
+
+
+static void testTransformVec2Array(int trial) {
+
+    float m[16];
+    float packed[PointCount * 2];
+    float vertices[PointCount * VertexFloats];
+    float expected[PointCount * VertexFloats];
+    float result[PointCount * VertexFloats];
+
+    fillRandom(m, 16);
+    fillRandom(packed, PointCount * 2);
+    fillRandom(vertices, PointCount * VertexFloats);
+
+    const size_t packedStride = 2 * sizeof(float);
+    const size_t vertexStride = VertexFloats * sizeof(float);
+
+    // Packed in, interleaved out (the other attributes must be left alone):
+
+    memcpy(expected, vertices, sizeof(vertices));
+    memcpy(result,   vertices, sizeof(vertices));
+
+    mat4f_TransformVec2Array_Scalar(m, packed, packedStride, expected, vertexStride, PointCount);
+    mat4f_TransformVec2Array(m, packed, packedStride, result, vertexStride, PointCount);
+    check(trial, "mat4f_TransformVec2Array", result, expected, sizeof(result));
+
+    // In place (interleaved):
+
+    float reference[PointCount * VertexFloats];
+
+    memcpy(reference, vertices, sizeof(vertices));
+    memcpy(expected,  vertices, sizeof(vertices));
+    memcpy(result,    vertices, sizeof(vertices));
+
+    mat4f_TransformVec2Array_Scalar(m, reference, vertexStride, expected, vertexStride, PointCount);
+    mat4f_TransformVec2Array(m, result, vertexStride, result, vertexStride, PointCount);
+    check(trial, "mat4f_TransformVec2Array (vout == vin)", result, expected, sizeof(result));
+}
+
+
+static void testAffineTransformVec2Array(int trial) {
+
+    float    components[6];
+    Affine2f m;
+    float    m4[16];
+    float    vertices[PointCount * VertexFloats];
+    float    expected[PointCount * VertexFloats];
+    float    result[PointCount * VertexFloats];
+
+    fillRandom(components, 6);
+    fillRandom(vertices, PointCount * VertexFloats);
+
+    m.a  = components[0];
+    m.b  = components[1];
+    m.c  = components[2];
+    m.d  = components[3];
+    m.tx = components[4];
+    m.ty = components[5];
+
+    const size_t vertexStride = VertexFloats * sizeof(float);
+
+    // Same bits as the 4x4 kernel on the expanded matrix (what it replaces):
+
+    affine2f_ToMat4f(&m, m4);
+
+    memcpy(expected, vertices, sizeof(vertices));
+    memcpy(result,   vertices, sizeof(vertices));
+
+    mat4f_TransformVec2Array_Scalar(m4, vertices, vertexStride, expected, vertexStride, PointCount);
+
+    affine2f_TransformVec2Array_Scalar(&m, vertices, vertexStride, result, vertexStride, PointCount);
+    check(trial, "affine2f_TransformVec2Array_Scalar (vs. 4x4)", result, expected, sizeof(result));
+
+    memcpy(result, vertices, sizeof(vertices));
+
+    affine2f_TransformVec2Array(&m, vertices, vertexStride, result, vertexStride, PointCount);
+    check(trial, "affine2f_TransformVec2Array", result, expected, sizeof(result));
+
+    // In place:
+
+    memcpy(result, vertices, sizeof(vertices));
+
+    affine2f_TransformVec2Array(&m, result, vertexStride, result, vertexStride, PointCount);
+    check(trial, "affine2f_TransformVec2Array (vout == vin)", result, expected, sizeof(result));
+}
+
+
+// .............................................................................
+
+int main(void) {
+
+#if defined(DNR_MATRIX_NO_SIMD)
+    const char* variant = "scalar (DNR_MATRIX_NO_SIMD)";
+#else
+    const char* variant = "default";
+#endif
+
+    for (int trial = 0; trial < TrialCount; trial++) {
+
+        testMultiplyMat4f(trial);
+        testMultiplyVec4f(trial);
+        testTransformVec2Array(trial);
+        testAffineTransformVec2Array(trial);
+    }
+
+    if (failureCount > 0) {
+        fprintf(stderr, "%s kernels: %u mismatches in %d trials\n", variant, failureCount, TrialCount);
+        return 1;
+    }
+
+    printf("%s kernels: %d trials, bit-exact\n", variant, TrialCount);
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+//
+//  DNRPNGDecoderTests.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-13.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+/*
+ Decodes PNG files and compares the pixels, byte for byte, with the RGBA8 KTX
+ files that scripts/convert_textures.py makes of them (premultiplied by its
+ own, independent decoder), then reports the decoding times.
+
+ Usage:
+
+    DNRPNGDecoderTests reference-directory image.png...
+
+ The reference of image.png is reference-directory/image.ktx.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "DNRPNGDecoder.h"
+#include "DNRKTXFile.h"
+
+
+#define TimedRunCount       5
+
+
+static double now(void) {
+
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return time.tv_sec + 1.0e-9 * time.tv_nsec;
+}
+
+
+/**
+ Returns the path of the reference of image (the caller frees it).
+ */
+static char* referencePath(const char* directory, const char* image) {
+
+    const char* name      = strrchr(image, '/');
+    const char* extension = strrchr(image, '.');
+
+    name = name ? name + 1 : image;
+
+    size_t nameLength = (extension && extension > name) ? (size_t)(extension - name) : strlen(name);
+    size_t size       = strlen(directory) + 1 + nameLength + sizeof(".ktx");
+    char*  path       = malloc(size);
+
+    if (path) {
+        snprintf(path, size, "%s/%.*s.ktx", directory, (int)nameLength, name);
+    }
+    return path;
+}
+
+
+/**
+ Returns 0 if the image does not decode or differs from its reference.
+ */
+static int checkImage(const char* directory, const char* imagePath) {
+
+    PNGImage image;
+
+    if (!pngDecodeFile(imagePath, &image)) {
+        fprintf(stderr, "%s: failed to decode\n", imagePath);
+        return 0;
+    }
+
+    char*    path      = referencePath(directory, imagePath);
+    KTXFile* reference = path ? ktxFileOpen(path) : NULL;
+    int      matches   = 0;
+
+    if (!reference) {
+        fprintf(stderr, "%s: no reference (%s)\n", imagePath, path ? path : "?");
+    }
+    else{
+        KTXFileLevel level = ktxFileLevel(reference, 0);
+
+        if (level.width != image.width || level.height != image.height || level.size != 4*image.width*image.height) {
+            fprintf(stderr, "%s: decoded %ux%u, reference is %ux%u (%u bytes)\n",
+                    imagePath, image.width, image.height, level.width, level.height, level.size);
+        }
+        else if (memcmp(level.data, image.pixels, level.size) != 0) {
+            const uint8_t* expected = level.data;
+
+            for (size_t i = 0; i < level.size; i++) {
+                if (expected[i] != image.pixels[i]) {
+                    size_t pixel = i / 4;
+                    fprintf(stderr, "%s: pixel (%zu, %zu), component %zu is %u, expected %u\n",
+                            imagePath, pixel % image.width, pixel / image.width, i % 4,
+                            image.pixels[i], expected[i]);
+                    break;
+                }
+            }
+        }
+        else{
+            matches = 1;
+        }
+        ktxFileClose(reference);
+    }
+
+    uint32_t width  = image.width;
+    uint32_t height = image.height;
+
+    free(path);
+    pngImageFree(&image);
+
+    if (!matches) {
+        return 0;
+    }
+
+    // Timings (the file stays in the page cache after the first run)
+
+    double best  = 1.0e9;
+    double total = 0.0;
+
+    for (int run = 0; run < TimedRunCount; run++) {
+
+        double start = now();
+
+        if (!pngDecodeFile(imagePath, &image)) {
+            return 0;
+        }
+
+        double elapsed = now() - start;
+
+        pngImageFree(&image);
+
+        best   = (elapsed < best) ? elapsed : best;
+        total += elapsed;
+    }
+
+    const char* name = strrchr(imagePath, '/');
+
+    printf("%-32s %5ux%-5u  best %7.2f ms  mean %7.2f ms  %6.1f Mpixel/s\n",
+           name ? name + 1 : imagePath,
+           width, height,
+           1.0e3 * best,
+           1.0e3 * total / TimedRunCount,
+           1.0e-6 * width * height / best);
+
+    return 1;
+}
+
+
+// .............................................................................
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s reference-directory image.png...\n", argv[0]);
+        return 1;
+    }
+
+    int failureCount = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (!checkImage(argv[1], argv[i])) {
+            failureCount++;
+        }
+    }
+
+    if (failureCount > 0) {
+        fprintf(stderr, "%d of %d images failed\n", failureCount, argc - 2);
+        return 1;
+    }
+
+    printf("%d images decoded identical to their references\n", argc - 2);
+
+    return 0;
+}
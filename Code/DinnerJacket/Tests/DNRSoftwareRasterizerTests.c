@@ -0,0 +1,443 @@
+//
+//  DNRSoftwareRasterizerTests.c
+//  DinnerJacket
+//
+//  Created by Nicolás Miari on 2016-12-13.
+//  Copyright © 2016 Nicolás Miari. All rights reserved.
+//
+
+/*
+ Draws known quads with the software rasterizer and checks exact pixels:
+ textures of every supported client format (3 texels wide, so 16 bit rows are
+ padded), the blend modes, the depth test and the scissor test (across a tile
+ boundary). The same frame is rendered with 1 and with several threads, and
+ the images must be identical.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "DNRGLDispatch.h"
+#include "DNRSoftwareRasterizer.h"
+
+
+#define SurfaceWidth        160     // 3 x 2 tiles
+#define SurfaceHeight       100
+
+#define TextureWidth        3
+#define TextureHeight       5
+
+#define ThreadCount         4
+
+
+typedef struct tTextureCase {
+
+    const char* what;
+    GLenum      format;
+    GLenum      type;
+    size_t      texelSize;
+    uint8_t     texels[4][4];       // Client data (byte formats)
+    uint16_t    packed[4];          // Client data (16 bit formats)
+    uint8_t     expected[4][4];     // RGBA8
+
+}TextureCase;
+
+
+static const TextureCase textureCases[] = {
+
+    { "RGBA8", GL_RGBA, GL_UNSIGNED_BYTE, 4,
+        { { 255, 0, 0, 255 }, { 0, 255, 0, 128 }, { 0, 0, 255, 0 }, { 10, 20, 30, 40 } },
+        { 0 },
+        { { 255, 0, 0, 255 }, { 0, 255, 0, 128 }, { 0, 0, 255, 0 }, { 10, 20, 30, 40 } } },
+
+    { "RGB8", GL_RGB, GL_UNSIGNED_BYTE, 3,
+        { { 255, 0, 0 },      { 0, 255, 0 },      { 0, 0, 255 },    { 10, 20, 30 } },
+        { 0 },
+        { { 255, 0, 0, 255 }, { 0, 255, 0, 255 }, { 0, 0, 255, 255 }, { 10, 20, 30, 255 } } },
+
+    { "565", GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 2,
+        { { 0 } },
+        { 0xF800, 0x07E0, 0x001F, 0xFFFF },
+        { { 255, 0, 0, 255 }, { 0, 255, 0, 255 }, { 0, 0, 255, 255 }, { 255, 255, 255, 255 } } },
+
+    { "4444", GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 2,
+        { { 0 } },
+        { 0xF00F, 0x0F08, 0x00F0, 0x1234 },
+        { { 255, 0, 0, 255 }, { 0, 255, 0, 136 }, { 0, 0, 255, 0 }, { 17, 34, 51, 68 } } },
+
+    { "5551", GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, 2,
+        { { 0 } },
+        { 0xF801, 0x07C0, 0x003F, 0xFFFF },
+        { { 255, 0, 0, 255 }, { 0, 255, 0, 0 }, { 0, 0, 255, 255 }, { 255, 255, 255, 255 } } },
+
+#ifdef GL_LUMINANCE_ALPHA   // (Not in the core profile)
+    { "luminance alpha", GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 2,
+        { { 255, 255 },         { 128, 0 },         { 0, 128 },     { 7, 9 } },
+        { 0 },
+        { { 255, 255, 255, 255 }, { 128, 128, 128, 0 }, { 0, 0, 0, 128 }, { 7, 7, 7, 9 } } },
+
+    { "luminance", GL_LUMINANCE, GL_UNSIGNED_BYTE, 1,
+        { { 255 },                { 128 },                { 0 },          { 7 } },
+        { 0 },
+        { { 255, 255, 255, 255 }, { 128, 128, 128, 255 }, { 0, 0, 0, 255 }, { 7, 7, 7, 255 } } },
+#endif
+
+    { "alpha", GL_ALPHA, GL_UNSIGNED_BYTE, 1,
+        { { 255 },          { 128 },          { 0 },          { 7 } },
+        { 0 },
+        { { 0, 0, 0, 255 }, { 0, 0, 0, 128 }, { 0, 0, 0, 0 }, { 0, 0, 0, 7 } } },
+};
+
+#define TextureCaseCount    (sizeof(textureCases)/sizeof(textureCases[0]))
+
+
+typedef struct tBlendCase {
+
+    const char* what;
+    int         blending;
+    GLenum      sourceFactor;
+    GLenum      destinationFactor;
+    GLfloat     color[4];
+    uint8_t     expected[4];        // Over the background (opaque blue)
+
+}BlendCase;
+
+
+static const BlendCase blendCases[] = {
+    { "no blending",   0, GL_ONE,       GL_ZERO,                { 0.5f,  0.25f, 0.0f, 0.5f  }, { 128,  64,   0, 128 } },
+    { "premultiplied", 1, GL_ONE,       GL_ONE_MINUS_SRC_ALPHA, { 0.5f,  0.0f,  0.0f, 0.5f  }, { 128,   0, 127, 255 } },
+    { "alpha",         1, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, { 1.0f,  0.0f,  0.0f, 0.75f }, { 191,   0,  64, 207 } },
+    { "additive",      1, GL_ONE,       GL_ONE,                 { 0.25f, 0.25f, 0.0f, 0.0f  }, {  64,  64, 255, 255 } },
+};
+
+#define BlendCaseCount      (sizeof(blendCases)/sizeof(blendCases[0]))
+
+
+static const uint8_t background[4] = { 0, 0, 255, 255 };
+
+static unsigned failureCount = 0;
+
+
+// .............................................................................
+#pragma mark - Drawing
+
+
+typedef struct tPrograms {
+
+    GLuint  sprite;
+    GLuint  flat;
+
+}Programs;
+
+
+/**
+ Sets an orthographic projection in pixels (origin at the bottom left) and an
+ identity modelview on the current program.
+ */
+static void setMatrices(const GLDispatch* gl, GLuint program) {
+
+    const GLfloat projection[16] = {
+        2.0f/SurfaceWidth, 0, 0, 0,
+        0, 2.0f/SurfaceHeight, 0, 0,
+        0, 0, 1, 0,
+        -1, -1, 0, 1
+    };
+    const GLfloat identity[16] = {
+        1, 0, 0, 0,
+        0, 1, 0, 0,
+        0, 0, 1, 0,
+        0, 0, 0, 1
+    };
+
+    gl->uniformMatrix4fv(gl->getUniformLocation(program, "Projection"), 1, GL_FALSE, projection);
+    gl->uniformMatrix4fv(gl->getUniformLocation(program, "Modelview"),  1, GL_FALSE, identity);
+}
+
+
+/**
+ Draws the rectangle x0..x1, y0..y1 (pixel edges) at depth z with the current
+ program; texture coordinates span [0, 1].
+ */
+static void drawQuad(const GLDispatch* gl, GLuint program, GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, GLfloat z) {
+
+    const GLfloat vertices[16] = {
+        x0, y0, 0, 0,
+        x1, y0, 1, 0,
+        x0, y1, 0, 1,
+        x1, y1, 1, 1
+    };
+
+    gl->uniform1f(gl->getUniformLocation(program, "Z"), z);
+    gl->bufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+    gl->drawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+
+static void drawFlatQuad(const GLDispatch* gl, const Programs* programs, const GLfloat color[4], GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, GLfloat z) {
+
+    gl->useProgram(programs->flat);
+    gl->uniform4fv(gl->getUniformLocation(programs->flat, "Color"), 1, color);
+
+    drawQuad(gl, programs->flat, x0, y0, x1, y1, z);
+}
+
+
+/**
+ Uploads the case's texels, laid out as texel (x + 2y) % 4 at (x, y), with
+ rows padded to the unpack alignment (the padding filled with garbage), from
+ a buffer of the exact size and at an odd address.
+ */
+static GLuint createTexture(const GLDispatch* gl, const TextureCase* textureCase) {
+
+    size_t rowSize  = glDispatchPixelRowSize(TextureWidth, textureCase->format, textureCase->type);
+    size_t dataSize = glDispatchPixelDataSize(TextureWidth, TextureHeight, textureCase->format, textureCase->type);
+
+    uint8_t* block  = (uint8_t *)malloc(dataSize + 1);
+    uint8_t* pixels = block + 1;
+
+    memset(pixels, 0xA5, dataSize);
+
+    for (int y = 0; y < TextureHeight; y++) {
+        for (int x = 0; x < TextureWidth; x++) {
+            int           index = (x + 2*y) % 4;
+            const void*   texel = (textureCase->type != GL_UNSIGNED_BYTE) ? (const void *)&(textureCase->packed[index])
+                                                                : (const void *)textureCase->texels[index];
+
+            memcpy(pixels + (size_t)y * rowSize + (size_t)x * textureCase->texelSize, texel, textureCase->texelSize);
+        }
+    }
+
+    GLuint texture;
+    gl->genTextures(1, &texture);
+    gl->bindTexture(GL_TEXTURE_2D, texture);
+    gl->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl->texImage2D(GL_TEXTURE_2D, 0, (GLint)textureCase->format, TextureWidth, TextureHeight, 0,
+                   textureCase->format, textureCase->type, pixels);
+
+    free(block);
+
+    return texture;
+}
+
+
+/**
+ Renders the test frame with threadCount threads, into pixels (top row first).
+ Returns 0 if the rasterizer can not be created.
+ */
+static int renderFrame(unsigned threadCount, uint8_t* pixels) {
+
+    SoftwareRasterizer* rasterizer = softwareRasterizerCreate(SurfaceWidth, SurfaceHeight, threadCount);
+
+    if (!rasterizer) {
+        return 0;
+    }
+
+    softwareRasterizerMakeCurrent(rasterizer);
+
+    const GLDispatch* gl = softwareRasterizerBackend();
+
+    Programs programs = {
+        .sprite = softwareRasterizerCreateProgram(SoftwareProgramSprite),
+        .flat   = softwareRasterizerCreateProgram(SoftwareProgramFlat)
+    };
+
+    const GLuint allPrograms[2] = { programs.sprite, programs.flat };
+
+    for (int i = 0; i < 2; i++) {
+        gl->useProgram(allPrograms[i]);
+        setMatrices(gl, allPrograms[i]);
+    }
+
+    const GLfloat white[4] = { 1, 1, 1, 1 };
+    gl->useProgram(programs.sprite);
+    gl->uniform4fv(gl->getUniformLocation(programs.sprite, "Color"), 1, white);
+    gl->uniform1i(gl->getUniformLocation(programs.sprite, "Sampler"), 0);
+
+    GLuint vertexArray;
+    GLuint buffer;
+
+    gl->genVertexArrays(1, &vertexArray);
+    gl->bindVertexArray(vertexArray);
+    gl->genBuffers(1, &buffer);
+    gl->bindBuffer(GL_ARRAY_BUFFER, buffer);
+    gl->enableVertexAttribArray((GLuint)gl->getAttribLocation(programs.sprite, "Position"));
+    gl->vertexAttribPointer((GLuint)gl->getAttribLocation(programs.sprite, "Position"), 2, GL_FLOAT, GL_FALSE, 4*sizeof(GLfloat), (const GLvoid *)0);
+    gl->enableVertexAttribArray((GLuint)gl->getAttribLocation(programs.sprite, "TextureCoord"));
+    gl->vertexAttribPointer((GLuint)gl->getAttribLocation(programs.sprite, "TextureCoord"), 2, GL_FLOAT, GL_FALSE, 4*sizeof(GLfloat), (const GLvoid *)(2*sizeof(GLfloat)));
+
+    // Background
+    gl->clearColor(0, 0, 1, 1);
+    gl->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // 1. Textures: one quad per format at (4 + 8i, 4), one texel per pixel
+    gl->useProgram(programs.sprite);
+
+    for (unsigned i = 0; i < TextureCaseCount; i++) {
+        GLuint texture = createTexture(gl, &textureCases[i]);
+        GLfloat x = 4.0f + 8.0f*i;
+
+        drawQuad(gl, programs.sprite, x, 4.0f, x + TextureWidth, 4.0f + TextureHeight, 0.0f);
+        gl->deleteTextures(1, &texture);
+    }
+
+    // 2. Blending: 6x6 quads at (4 + 10j, 20)
+    for (unsigned j = 0; j < BlendCaseCount; j++) {
+        const BlendCase* blendCase = &blendCases[j];
+        GLfloat x = 4.0f + 10.0f*j;
+
+        if (blendCase->blending) {
+            gl->enable(GL_BLEND);
+            gl->blendFunc(blendCase->sourceFactor, blendCase->destinationFactor);
+        }
+        drawFlatQuad(gl, &programs, blendCase->color, x, 20.0f, x + 6.0f, 26.0f, 0.0f);
+
+        gl->disable(GL_BLEND);
+    }
+
+    // 3. Depth test: red (z = 0.5), then green behind it, then blue in front
+    const GLfloat red[4]   = { 1, 0, 0, 1 };
+    const GLfloat green[4] = { 0, 1, 0, 1 };
+    const GLfloat blue[4]  = { 0, 0, 1, 1 };
+
+    gl->enable(GL_DEPTH_TEST);
+    drawFlatQuad(gl, &programs, red,   4.0f, 40.0f, 20.0f, 50.0f,  0.5f);
+    drawFlatQuad(gl, &programs, green, 12.0f, 40.0f, 28.0f, 50.0f, 0.8f);
+    drawFlatQuad(gl, &programs, blue,  16.0f, 40.0f, 24.0f, 50.0f, -0.5f);
+    gl->disable(GL_DEPTH_TEST);
+
+    // 4. Scissor box (56, 56)-(72, 68), across the tile boundary at x = 64:
+    //    clear to yellow, and draw a white strip wider than the box
+    gl->scissor(56, 56, 16, 12);
+    gl->enable(GL_SCISSOR_TEST);
+
+    gl->clearColor(1, 1, 0, 1);
+    gl->clear(GL_COLOR_BUFFER_BIT);
+    drawFlatQuad(gl, &programs, white, 50.0f, 60.0f, 80.0f, 64.0f, 0.0f);
+
+    gl->disable(GL_SCISSOR_TEST);
+
+    softwareRasterizerReadPixels(rasterizer, pixels, 4*SurfaceWidth);
+
+    softwareRasterizerMakeCurrent(NULL);
+    softwareRasterizerDestroy(rasterizer);
+
+    return 1;
+}
+
+
+// .............................................................................
+#pragma mark - Checks
+
+
+static const uint8_t* pixelAt(const uint8_t* pixels, int x, int y) {
+    // (Top row first)
+    return pixels + 4*((size_t)(SurfaceHeight - 1 - y) * SurfaceWidth + (size_t)x);
+}
+
+
+static void expectPixel(const uint8_t* pixels, int x, int y, const uint8_t expected[4], const char* what) {
+
+    const uint8_t* pixel = pixelAt(pixels, x, y);
+
+    if (memcmp(pixel, expected, 4) != 0) {
+        fprintf(stderr, "%s: pixel (%d, %d) is (%u, %u, %u, %u), expected (%u, %u, %u, %u)\n",
+                what, x, y,
+                pixel[0], pixel[1], pixel[2], pixel[3],
+                expected[0], expected[1], expected[2], expected[3]);
+        failureCount++;
+    }
+}
+
+
+static void expectRect(const uint8_t* pixels, int x0, int y0, int x1, int y1, const uint8_t expected[4], const char* what) {
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            expectPixel(pixels, x, y, expected, what);
+        }
+    }
+}
+
+
+static void checkFrame(const uint8_t* pixels) {
+
+    const uint8_t red[4]    = { 255,   0,   0, 255 };
+    const uint8_t green[4]  = {   0, 255,   0, 255 };
+    const uint8_t blue[4]   = {   0,   0, 255, 255 };
+    const uint8_t yellow[4] = { 255, 255,   0, 255 };
+    const uint8_t white[4]  = { 255, 255, 255, 255 };
+
+    // 1. Textures (and the background around them)
+    for (unsigned i = 0; i < TextureCaseCount; i++) {
+        const TextureCase* textureCase = &textureCases[i];
+        int x0 = 4 + 8*(int)i;
+
+        for (int y = 0; y < TextureHeight; y++) {
+            for (int x = 0; x < TextureWidth; x++) {
+                expectPixel(pixels, x0 + x, 4 + y, textureCase->expected[(x + 2*y) % 4], textureCase->what);
+            }
+        }
+        expectPixel(pixels, x0 - 1,            4, background, textureCase->what);
+        expectPixel(pixels, x0 + TextureWidth, 4, background, textureCase->what);
+        expectPixel(pixels, x0, 4 + TextureHeight, background, textureCase->what);
+    }
+
+    // 2. Blending
+    for (unsigned j = 0; j < BlendCaseCount; j++) {
+        int x0 = 4 + 10*(int)j;
+        expectRect(pixels, x0, 20, x0 + 6, 26, blendCases[j].expected, blendCases[j].what);
+    }
+
+    // 3. Depth test
+    expectRect(pixels,  4, 40, 16, 50, red,   "depth (nearer drawn first)");
+    expectRect(pixels, 16, 40, 24, 50, blue,  "depth (nearer drawn last)");
+    expectRect(pixels, 24, 40, 28, 50, green, "depth (alone)");
+
+    // 4. Scissor test
+    expectRect(pixels, 56, 56, 72, 60, yellow, "scissor (clear)");
+    expectRect(pixels, 56, 64, 72, 68, yellow, "scissor (clear)");
+    expectRect(pixels, 56, 60, 72, 64, white,  "scissor (draw)");
+    expectRect(pixels, 50, 60, 56, 64, background, "scissor (outside, left)");
+    expectRect(pixels, 72, 60, 80, 64, background, "scissor (outside, right)");
+    expectRect(pixels, 56, 55, 72, 56, background, "scissor (outside, below)");
+    expectRect(pixels, 56, 68, 72, 69, background, "scissor (outside, above)");
+}
+
+
+// .............................................................................
+
+int main(void) {
+
+    size_t   size       = 4 * (size_t)SurfaceWidth * SurfaceHeight;
+    uint8_t* single     = (uint8_t *)malloc(size);
+    uint8_t* concurrent = (uint8_t *)malloc(size);
+
+    if (!renderFrame(1, single) || !renderFrame(ThreadCount, concurrent)) {
+        fprintf(stderr, "Failed to create the rasterizer\n");
+        return 1;
+    }
+
+    checkFrame(single);
+
+    if (memcmp(single, concurrent, size) != 0) {
+        fprintf(stderr, "The images rendered with 1 and %u threads differ\n", ThreadCount);
+        failureCount++;
+    }
+
+    free(single);
+    free(concurrent);
+
+    if (failureCount > 0) {
+        fprintf(stderr, "%u failures\n", failureCount);
+        return 1;
+    }
+
+    printf("%u texture formats, %u blend modes, depth and scissor: exact, same with %u threads\n",
+           (unsigned)TextureCaseCount, (unsigned)BlendCaseCount, ThreadCount);
+
+    return 0;
+}
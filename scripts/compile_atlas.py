@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+compile_atlas.py - Converts a texture atlas property list into the compiled
+binary database loaded by DNRTextureAtlas (placed next to the property list,
+the atlas loads it instead, without parsing XML).
+
+Usage:
+    compile_atlas.py Sprites01.plist [Sprites01.atlasdb]
+
+The output defaults to the input path with the extension replaced by
+".atlasdb". The format is described in DNRAtlasFile.h; keep both in sync.
+
+Besides "Rectangle" and "Opaque", subimage entries may specify trimming
+information: "SourceSize" ("{w, h}", the size before trimming) and
+"TrimOffset" ("{x, y}", the position of the rectangle within it), and
+"Rotated" (the image is stored turned 90 degrees clockwise; the rectangle's
+size is still that of the image, so it occupies it transposed). Atlases
+produced by pack_atlas.py use all of them.
+"""
+
+import os
+import plistlib
+import re
+import struct
+import sys
+
+
+MAGIC   = b"DNRA"
+VERSION = 1
+
+SUBIMAGE_FLAG_OPAQUE  = 1 << 0
+SUBIMAGE_FLAG_ROTATED = 1 << 1
+
+HEADER_FORMAT   = "<4sHH6I"     # AtlasFileHeader
+SUBIMAGE_FORMAT = "<I8fI"       # AtlasFileSubimage
+
+NUMBER = r"\s*([-+0-9.eE]+)\s*"
+
+
+class StringTable(object):
+    """Interned, NUL-terminated UTF-8 strings (offset 0 is the empty string)."""
+
+    def __init__(self):
+        self.data = bytearray(b"\0")
+        self.offsets = {"": 0}
+
+    def add(self, string):
+        if string is None:
+            string = ""
+        if string not in self.offsets:
+            self.offsets[string] = len(self.data)
+            self.data += string.encode("utf-8") + b"\0"
+        return self.offsets[string]
+
+
+def parse_pair(string):
+    # CGPointFromString()/CGSizeFromString() format: "{a, b}"
+    match = re.match(r"\s*\{" + NUMBER + "," + NUMBER + r"\}\s*$", string)
+    if not match:
+        raise ValueError("Malformed pair: %r" % string)
+    return float(match.group(1)), float(match.group(2))
+
+
+def parse_rect(string):
+    # CGRectFromString() format: "{{x, y}, {w, h}}"
+    match = re.match(r"\s*\{\s*\{" + NUMBER + "," + NUMBER + r"\}\s*,\s*\{"
+                     + NUMBER + "," + NUMBER + r"\}\s*\}\s*$", string)
+    if not match:
+        raise ValueError("Malformed rectangle: %r" % string)
+    return tuple(float(match.group(i)) for i in range(1, 5))
+
+
+def compile_atlas(source):
+    strings = StringTable()
+
+    image_name = strings.add(source.get("ImageName"))
+    image_directory = strings.add(source.get("ImageDirectory"))
+
+    subimages = []
+
+    for name in sorted(source.get("Database", {})):
+        entry = source["Database"][name]
+
+        x, y, width, height = parse_rect(entry["Rectangle"])
+
+        source_width, source_height = width, height
+        if "SourceSize" in entry:
+            source_width, source_height = parse_pair(entry["SourceSize"])
+
+        trim_x, trim_y = 0.0, 0.0
+        if "TrimOffset" in entry:
+            trim_x, trim_y = parse_pair(entry["TrimOffset"])
+
+        flags = 0
+        if entry.get("Opaque"):
+            flags |= SUBIMAGE_FLAG_OPAQUE
+        if entry.get("Rotated"):
+            flags |= SUBIMAGE_FLAG_ROTATED
+
+        subimages.append((strings.add(name), x, y, width, height,
+                          source_width, source_height, trim_x, trim_y, flags))
+
+    subimages_offset = struct.calcsize(HEADER_FORMAT)
+    strings_offset = subimages_offset + len(subimages) * struct.calcsize(SUBIMAGE_FORMAT)
+
+    out = bytearray()
+    out += struct.pack(HEADER_FORMAT, MAGIC, VERSION, 0,
+                       image_name, image_directory,
+                       len(subimages), subimages_offset,
+                       strings_offset, len(strings.data))
+
+    for subimage in subimages:
+        out += struct.pack(SUBIMAGE_FORMAT, *subimage)
+
+    out += strings.data
+
+    return bytes(out)
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 1
+
+    source_path = argv[1]
+    output_path = argv[2] if len(argv) == 3 else os.path.splitext(source_path)[0] + ".atlasdb"
+
+    with open(source_path, "rb") as source_file:
+        source = plistlib.load(source_file)
+
+    data = compile_atlas(source)
+
+    with open(output_path, "wb") as output_file:
+        output_file.write(data)
+
+    print("%s: %d bytes -> %s: %d bytes" % (source_path, os.path.getsize(source_path),
+                                           output_path, len(data)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""
+compile_tilemap.py - Converts a tile map property list into the compiled
+binary format loaded by -[TileMap initWithContentsOfFile:dataSource:].
+
+Usage:
+    compile_tilemap.py Stage06.plist [Stage06.tilemap]
+
+The output defaults to the input path with the extension replaced by
+".tilemap". The format is described in TileMapFile.h; keep both in sync.
+"""
+
+import os
+import plistlib
+import re
+import struct
+import sys
+
+
+MAGIC   = b"DNRM"
+VERSION = 1
+
+LAYER_FLAG_NEEDS_BLENDING = 1 << 0
+LAYER_FLAG_SYMBOLIC       = 1 << 1
+
+TILE_FLAG_FLIP_X = 1 << 0
+TILE_FLAG_FLIP_Y = 1 << 1
+
+HEADER_FORMAT   = "<4sHHHH6I"   # TileMapFileHeader
+TILESET_FORMAT  = "<3I"         # TileMapFileTileset
+PALETTE_FORMAT  = "<2I"         # TileMapFilePaletteEntry
+LAYER_FORMAT    = "<2If5I"      # TileMapFileLayer
+TILE_FORMAT     = "<4H"         # TileMapFileTile
+
+NO_STRING = 0                   # Offset of the empty string (e.g., no class)
+
+# Layer property defaults, as read by -[TileMapLayer initWithContentsOfDictionary:...]
+# (absent keys are nil, and nil reads as 0)
+DEFAULT_SCROLL_FACTOR = 0.0
+
+
+class StringTable(object):
+    """Interned, NUL-terminated UTF-8 strings (offset 0 is the empty string)."""
+
+    def __init__(self):
+        self.data = bytearray(b"\0")
+        self.offsets = {"": 0}
+
+    def add(self, string):
+        if string is None:
+            string = ""
+        if string not in self.offsets:
+            self.offsets[string] = len(self.data)
+            self.data += string.encode("utf-8") + b"\0"
+        return self.offsets[string]
+
+
+def parse_point(string):
+    # CGPointFromString() format: "{x, y}"
+    match = re.match(r"\s*\{\s*([-+0-9.eE]+)\s*,\s*([-+0-9.eE]+)\s*\}\s*$", string)
+    if not match:
+        raise ValueError("Malformed point: %r" % string)
+    return int(float(match.group(1))), int(float(match.group(2)))
+
+
+def check_u16(value, what):
+    if not 0 <= value <= 0xFFFF:
+        raise ValueError("%s out of range: %d" % (what, value))
+    return value
+
+
+def pack_tiles(tile_dictionaries):
+    tiles = []
+    for tile in tile_dictionaries:
+        x, y = parse_point(tile["Position"])
+        flags = 0
+        if tile.get("FlipX"):
+            flags |= TILE_FLAG_FLIP_X
+        if tile.get("FlipY"):
+            flags |= TILE_FLAG_FLIP_Y
+        tiles.append((check_u16(x, "Tile x"),
+                      check_u16(y, "Tile y"),
+                      check_u16(int(tile.get("PaletteIndex", 0)), "Palette index"),
+                      flags))
+    return tiles
+
+
+def align4(offset):
+    return (offset + 3) & ~3
+
+
+def compile_map(source):
+    strings = StringTable()
+
+    layer_width, layer_height = parse_point(source["LayerSize"])
+    tile_size = int(source["TileSize"])
+
+    # Tilesets (sorted by name, so output is deterministic)
+
+    tilesets = []
+    for name in sorted(source.get("Tilesets", {})):
+        palette = []
+        for entry in source["Tilesets"][name].get("Palette", []):
+            # Brushes without a class are not named brushes; the loader leaves
+            # the key out for them, as the property list does
+            class_name = entry.get("Class")
+            palette.append((int(entry["Index"]),
+                            strings.add(class_name) if class_name else NO_STRING))
+        tilesets.append((strings.add(name), palette))
+
+    # Layers (in stacking order)
+
+    layers = []
+    for layer in source.get("Layers", []):
+        flags = 0
+        if layer.get("NeedsBlending"):
+            flags |= LAYER_FLAG_NEEDS_BLENDING
+        if "Tiles" not in layer:
+            flags |= LAYER_FLAG_SYMBOLIC
+
+        tiles = pack_tiles(layer.get("Tiles", []))
+        objects = pack_tiles(layer.get("Objects", []))
+
+        # Row-major order lets the mesh builder join horizontally adjacent
+        # tiles into the same strip (stable, so overlapping tiles keep their
+        # relative order):
+        tiles.sort(key=lambda tile: (tile[1], tile[0]))
+
+        layers.append((strings.add(layer.get("Name")),
+                       strings.add(layer.get("TilesetName")),
+                       float(layer.get("ScrollFactor", DEFAULT_SCROLL_FACTOR)),
+                       flags, tiles, objects))
+
+    # Layout
+
+    offset = struct.calcsize(HEADER_FORMAT)
+
+    tilesets_offset = offset
+    offset += len(tilesets) * struct.calcsize(TILESET_FORMAT)
+
+    palette_offsets = []
+    for _, palette in tilesets:
+        palette_offsets.append(offset)
+        offset += len(palette) * struct.calcsize(PALETTE_FORMAT)
+
+    layers_offset = offset
+    offset += len(layers) * struct.calcsize(LAYER_FORMAT)
+
+    tile_offsets = []
+    for layer in layers:
+        tiles_offset = offset
+        offset += len(layer[4]) * struct.calcsize(TILE_FORMAT)
+        objects_offset = offset
+        offset += len(layer[5]) * struct.calcsize(TILE_FORMAT)
+        tile_offsets.append((tiles_offset, objects_offset))
+
+    strings_offset = align4(offset)
+
+    # Output
+
+    out = bytearray()
+    out += struct.pack(HEADER_FORMAT, MAGIC, VERSION, check_u16(tile_size, "Tile size"),
+                       check_u16(layer_width, "Layer width"),
+                       check_u16(layer_height, "Layer height"),
+                       len(tilesets), tilesets_offset,
+                       len(layers), layers_offset,
+                       strings_offset, len(strings.data))
+
+    for (name, palette), palette_offset in zip(tilesets, palette_offsets):
+        out += struct.pack(TILESET_FORMAT, name, len(palette), palette_offset)
+
+    for _, palette in tilesets:
+        for index, class_name in palette:
+            out += struct.pack(PALETTE_FORMAT, index, class_name)
+
+    for layer, (tiles_offset, objects_offset) in zip(layers, tile_offsets):
+        name, tileset_name, scroll_factor, flags, tiles, objects = layer
+        out += struct.pack(LAYER_FORMAT, name, tileset_name, scroll_factor, flags,
+                           len(tiles), tiles_offset, len(objects), objects_offset)
+
+    for _, _, _, _, tiles, objects in layers:
+        for tile in tiles + objects:
+            out += struct.pack(TILE_FORMAT, *tile)
+
+    out += b"\0" * (strings_offset - len(out))
+    out += strings.data
+
+    return bytes(out)
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 1
+
+    source_path = argv[1]
+    output_path = argv[2] if len(argv) == 3 else os.path.splitext(source_path)[0] + ".tilemap"
+
+    with open(source_path, "rb") as source_file:
+        source = plistlib.load(source_file)
+
+    data = compile_map(source)
+
+    with open(output_path, "wb") as output_file:
+        output_file.write(data)
+
+    print("%s: %d bytes -> %s: %d bytes" % (source_path, os.path.getsize(source_path),
+                                           output_path, len(data)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
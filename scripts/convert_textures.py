@@ -0,0 +1,425 @@
+#!/usr/bin/env python3
+"""
+convert_textures.py - Converts PNG textures into KTX containers loaded by
+DNRTexture in place of the PNG (see DNRKTXFile.h), and reports the memory each
+texture takes on the GPU in every supported format.
+
+Usage:
+    convert_textures.py [--format FORMAT] [--mipmaps] [--etc-tool PATH]
+                        [--output-directory DIR] [--report-only] INPUT...
+
+Each INPUT is either:
+
+  - A texture atlas property list. Its image (every resolution variant found
+    next to the property list: Name.png, Name@2x.png, ...) is converted to
+    the format given by the atlas' "TextureFormat" hint, with mipmaps if its
+    "Mipmaps" hint is set.
+
+  - A PNG file, converted to --format (default: RGBA8).
+
+--format overrides the atlas hints. Formats:
+
+    RGBA8       32 bits per pixel
+    RGBA4444    16 bits per pixel
+    RGB565      16 bits per pixel, opaque images only (alpha is discarded)
+    ETC2        8 bits per pixel with alpha (RGBA8 ETC2 EAC), 4 if opaque
+                (RGB8 ETC2). Encoded by etc2comp's EtcTool (--etc-tool, or
+                EtcTool on the PATH). Not supported by the macOS renderer,
+                which falls back to the PNG.
+
+The output is written next to the input image (or into --output-directory),
+with the extension ".ktx" (e.g., Sprites01@2x.png -> Sprites01@2x.ktx). Color
+values are premultiplied by alpha, like DNRTexture does when it decodes a PNG
+(the RGBA8 output is also the reference of the PNG decoder's tests).
+"""
+
+import argparse
+import glob
+import os
+import plistlib
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+
+
+# OpenGL constants
+
+GL_UNSIGNED_BYTE                = 0x1401
+GL_UNSIGNED_SHORT_4_4_4_4       = 0x8033
+GL_UNSIGNED_SHORT_5_6_5         = 0x8363
+GL_RGB                          = 0x1907
+GL_RGBA                         = 0x1908
+GL_RGBA4                        = 0x8056
+GL_RGBA8                        = 0x8058
+GL_RGB565                       = 0x8D62
+GL_COMPRESSED_RGB8_ETC2         = 0x9274
+GL_COMPRESSED_RGBA8_ETC2_EAC    = 0x9278
+
+FORMATS = ("RGBA8", "RGBA4444", "RGB565", "ETC2")
+
+KTX_IDENTIFIER = b"\xabKTX 11\xbb\r\n\x1a\n"
+KTX_HEADER_FORMAT = "<12s13I"
+
+
+# .............................................................................
+# PNG decoding (8 bits per channel, non-interlaced)
+
+def read_png(path):
+    """Returns (width, height, pixels), with pixels as RGBA bytes, top row first."""
+
+    with open(path, "rb") as png_file:
+        data = png_file.read()
+
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("%s: not a PNG file" % path)
+
+    offset = 8
+    header = None
+    palette = b""
+    transparency = b""
+    compressed = bytearray()
+
+    while offset < len(data):
+        length, chunk_type = struct.unpack(">I4s", data[offset:offset + 8])
+        chunk = data[offset + 8:offset + 8 + length]
+        offset += 12 + length
+
+        if chunk_type == b"IHDR":
+            header = struct.unpack(">IIBBBBB", chunk)
+        elif chunk_type == b"PLTE":
+            palette = chunk
+        elif chunk_type == b"tRNS":
+            transparency = chunk
+        elif chunk_type == b"IDAT":
+            compressed += chunk
+        elif chunk_type == b"IEND":
+            break
+
+    width, height, bit_depth, color_type, _, _, interlace = header
+
+    if bit_depth != 8 or interlace != 0:
+        raise ValueError("%s: only 8-bit, non-interlaced images are supported" % path)
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    stride = width * channels
+
+    raw = zlib.decompress(bytes(compressed))
+    rows = []
+    previous = bytearray(stride)
+
+    for y in range(height):
+        start = y * (stride + 1)
+        filter_type = raw[start]
+        row = bytearray(raw[start + 1:start + 1 + stride])
+
+        if filter_type == 1:        # Sub
+            for i in range(channels, stride):
+                row[i] = (row[i] + row[i - channels]) & 0xFF
+        elif filter_type == 2:      # Up
+            row = bytearray((a + b) & 0xFF for a, b in zip(row, previous))
+        elif filter_type == 3:      # Average
+            for i in range(stride):
+                left = row[i - channels] if i >= channels else 0
+                row[i] = (row[i] + ((left + previous[i]) >> 1)) & 0xFF
+        elif filter_type == 4:      # Paeth
+            for i in range(stride):
+                a = row[i - channels] if i >= channels else 0
+                b = previous[i]
+                c = previous[i - channels] if i >= channels else 0
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                predictor = a if (pa <= pb and pa <= pc) else (b if pb <= pc else c)
+                row[i] = (row[i] + predictor) & 0xFF
+
+        rows.append(row)
+        previous = row
+
+    pixels = bytearray(width * height * 4)
+
+    for y, row in enumerate(rows):
+        out = y * width * 4
+        if color_type == 6:
+            pixels[out:out + width * 4] = row
+            continue
+        for x in range(width):
+            if color_type == 0:
+                r = g = b = row[x]; a = 255
+            elif color_type == 4:
+                r = g = b = row[2 * x]; a = row[2 * x + 1]
+            elif color_type == 2:
+                r, g, b = row[3 * x:3 * x + 3]; a = 255
+            else:
+                index = row[x]
+                r, g, b = palette[3 * index:3 * index + 3]
+                a = transparency[index] if index < len(transparency) else 255
+            pixels[out + 4 * x:out + 4 * x + 4] = bytes((r, g, b, a))
+
+    return width, height, pixels
+
+
+def write_png(path, width, height, pixels):
+    """Writes RGBA bytes as an (unfiltered) PNG; used to feed the ETC2 encoder."""
+
+    def chunk(chunk_type, payload):
+        return (struct.pack(">I", len(payload)) + chunk_type + payload
+                + struct.pack(">I", zlib.crc32(chunk_type + payload) & 0xFFFFFFFF))
+
+    stride = width * 4
+    raw = b"".join(b"\0" + bytes(pixels[y * stride:(y + 1) * stride]) for y in range(height))
+
+    with open(path, "wb") as png_file:
+        png_file.write(b"\x89PNG\r\n\x1a\n")
+        png_file.write(chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 6, 0, 0, 0)))
+        png_file.write(chunk(b"IDAT", zlib.compress(raw, 6)))
+        png_file.write(chunk(b"IEND", b""))
+
+
+# .............................................................................
+# Pixel processing
+
+def premultiply(pixels):
+    out = bytearray(pixels)
+    for i in range(0, len(out), 4):
+        a = out[i + 3]
+        if a != 255:
+            out[i]     = (out[i]     * a + 127) // 255
+            out[i + 1] = (out[i + 1] * a + 127) // 255
+            out[i + 2] = (out[i + 2] * a + 127) // 255
+    return out
+
+
+def is_opaque(pixels):
+    return all(alpha == 255 for alpha in pixels[3::4])
+
+
+def downsample(width, height, pixels):
+    """Next mipmap level (2x2 box filter; pixels are premultiplied)."""
+
+    new_width, new_height = max(1, width // 2), max(1, height // 2)
+    out = bytearray(new_width * new_height * 4)
+
+    for y in range(new_height):
+        y0 = min(2 * y, height - 1)
+        y1 = min(2 * y + 1, height - 1)
+        for x in range(new_width):
+            x0 = min(2 * x, width - 1)
+            x1 = min(2 * x + 1, width - 1)
+            for c in range(4):
+                total = (pixels[(y0 * width + x0) * 4 + c] + pixels[(y0 * width + x1) * 4 + c]
+                         + pixels[(y1 * width + x0) * 4 + c] + pixels[(y1 * width + x1) * 4 + c])
+                out[(y * new_width + x) * 4 + c] = (total + 2) // 4
+
+    return new_width, new_height, out
+
+
+def pad_rows(rows, row_bytes):
+    # (KTX rows are aligned to 4 bytes, i.e. GL_UNPACK_ALIGNMENT)
+    padding = b"\0" * ((4 - row_bytes % 4) % 4)
+    return b"".join(bytes(row) + padding for row in rows) if padding else b"".join(bytes(row) for row in rows)
+
+
+def pack_level(fmt, width, height, pixels):
+    if fmt == "RGBA8":
+        return pad_rows((pixels[y * width * 4:(y + 1) * width * 4] for y in range(height)), width * 4)
+
+    rows = []
+    for y in range(height):
+        row = bytearray(width * 2)
+        for x in range(width):
+            r, g, b, a = pixels[(y * width + x) * 4:(y * width + x) * 4 + 4]
+            if fmt == "RGBA4444":
+                value = ((r * 15 + 127) // 255 << 12) | ((g * 15 + 127) // 255 << 8) \
+                        | ((b * 15 + 127) // 255 << 4) | ((a * 15 + 127) // 255)
+            else:
+                value = ((r * 31 + 127) // 255 << 11) | ((g * 63 + 127) // 255 << 5) \
+                        | ((b * 31 + 127) // 255)
+            struct.pack_into("<H", row, 2 * x, value)
+        rows.append(row)
+
+    return pad_rows(rows, width * 2)
+
+
+def write_ktx(path, gl_type, type_size, gl_format, internal_format, base_format,
+              width, height, levels):
+    with open(path, "wb") as ktx_file:
+        ktx_file.write(struct.pack(KTX_HEADER_FORMAT, KTX_IDENTIFIER, 0x04030201,
+                                   gl_type, type_size, gl_format, internal_format, base_format,
+                                   width, height, 0, 0, 1, len(levels), 0))
+        for level in levels:
+            ktx_file.write(struct.pack("<I", len(level)))
+            ktx_file.write(level)
+            ktx_file.write(b"\0" * ((4 - len(level) % 4) % 4))
+
+
+# .............................................................................
+# Conversion
+
+def gpu_size(fmt, width, height, mipmaps, opaque):
+    """Bytes taken on the GPU by the texture (and its mipmaps)."""
+
+    total = 0
+    while True:
+        if fmt == "RGBA8":
+            total += ((width * 4 + 3) & ~3) * height
+        elif fmt in ("RGBA4444", "RGB565"):
+            total += ((width * 2 + 3) & ~3) * height
+        else:
+            blocks = ((width + 3) // 4) * ((height + 3) // 4)
+            total += blocks * (8 if opaque else 16)
+        if not mipmaps or (width == 1 and height == 1):
+            return total
+        width, height = max(1, width // 2), max(1, height // 2)
+
+
+def convert_etc2(source_path, output_path, width, height, pixels, mipmaps, opaque, etc_tool):
+    if not etc_tool:
+        raise RuntimeError("ETC2 needs etc2comp's EtcTool (pass --etc-tool, or add it to the PATH)")
+
+    temp_directory = tempfile.mkdtemp()
+    try:
+        premultiplied_path = os.path.join(temp_directory, "source.png")
+        write_png(premultiplied_path, width, height, pixels)
+
+        command = [etc_tool, premultiplied_path,
+                   "-format", "RGB8" if opaque else "RGBA8",
+                   "-output", output_path]
+        if mipmaps:
+            levels = 1
+            while (width >> levels) or (height >> levels):
+                levels += 1
+            command += ["-mipmaps", str(levels)]
+
+        subprocess.check_call(command, stdout=subprocess.DEVNULL)
+    finally:
+        shutil.rmtree(temp_directory)
+
+
+def convert_image(source_path, fmt, mipmaps, etc_tool, report_only, output_directory=None):
+    width, height, pixels = read_png(source_path)
+    opaque = is_opaque(pixels)
+
+    if fmt == "RGB565" and not opaque:
+        sys.stderr.write("warning: %s has transparent pixels; RGB565 discards them\n" % source_path)
+
+    output_path = os.path.splitext(source_path)[0] + ".ktx"
+
+    if output_directory:
+        output_path = os.path.join(output_directory, os.path.basename(output_path))
+
+    if not report_only:
+        pixels = premultiply(pixels)
+
+        if fmt == "ETC2":
+            convert_etc2(source_path, output_path, width, height, pixels, mipmaps, opaque, etc_tool)
+        else:
+            levels = []
+            level_width, level_height, level_pixels = width, height, pixels
+            while True:
+                levels.append(pack_level(fmt, level_width, level_height, level_pixels))
+                if not mipmaps or (level_width == 1 and level_height == 1):
+                    break
+                level_width, level_height, level_pixels = downsample(level_width, level_height, level_pixels)
+
+            if fmt == "RGBA8":
+                write_ktx(output_path, GL_UNSIGNED_BYTE, 1, GL_RGBA, GL_RGBA8, GL_RGBA, width, height, levels)
+            elif fmt == "RGBA4444":
+                write_ktx(output_path, GL_UNSIGNED_SHORT_4_4_4_4, 2, GL_RGBA, GL_RGBA4, GL_RGBA, width, height, levels)
+            else:
+                write_ktx(output_path, GL_UNSIGNED_SHORT_5_6_5, 2, GL_RGB, GL_RGB565, GL_RGB, width, height, levels)
+
+    return {
+        "path": source_path,
+        "output": output_path,
+        "format": fmt,
+        "width": width,
+        "height": height,
+        "opaque": opaque,
+        "mipmaps": mipmaps,
+        "sizes": dict((each, gpu_size(each, width, height, mipmaps, opaque)) for each in FORMATS),
+    }
+
+
+def atlas_images(plist_path):
+    """The image (all resolution variants) and the format hints of an atlas."""
+
+    with open(plist_path, "rb") as plist_file:
+        atlas = plistlib.load(plist_file)
+
+    image_name = os.path.splitext(atlas["ImageName"])[0]
+    directory = os.path.dirname(plist_path)
+
+    pattern = re.compile(re.escape(image_name) + r"(@\d+[xX])?\.png$")
+    images = sorted(path for path in glob.glob(os.path.join(glob.escape(directory), "*.png"))
+                    if pattern.match(os.path.basename(path)))
+
+    return images, atlas.get("TextureFormat", "RGBA8"), bool(atlas.get("Mipmaps", False))
+
+
+def print_report(results):
+    def kilobytes(size):
+        return "%.0f KB" % (size / 1024.0)
+
+    header = "%-36s %11s  " % ("Texture", "Size") + "".join("%11s" % fmt for fmt in FORMATS)
+    print(header)
+    print("-" * len(header))
+
+    totals = dict((fmt, 0) for fmt in FORMATS)
+    chosen_total = 0
+
+    for result in results:
+        cells = []
+        for fmt in FORMATS:
+            size = result["sizes"][fmt]
+            totals[fmt] += size
+            marker = "*" if fmt == result["format"] else " "
+            cells.append("%10s%s" % (kilobytes(size), marker))
+        chosen_total += result["sizes"][result["format"]]
+
+        dimensions = "%dx%d%s" % (result["width"], result["height"], "+mip" if result["mipmaps"] else "")
+        print("%-36s %11s  " % (os.path.basename(result["path"])[-36:], dimensions) + "".join(cells))
+
+    print("-" * len(header))
+    print("%-36s %11s  " % ("Total", "") + "".join("%11s " % kilobytes(totals[fmt]) for fmt in FORMATS))
+    print("\nChosen formats (*): %s, vs. %s as RGBA8 (%.0f%%)" % (
+        kilobytes(chosen_total), kilobytes(totals["RGBA8"]),
+        100.0 * chosen_total / max(1, totals["RGBA8"])))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("--format", choices=FORMATS, help="overrides the atlas hints")
+    parser.add_argument("--mipmaps", action="store_true", help="generate the full mipmap chain")
+    parser.add_argument("--etc-tool", default=shutil.which("EtcTool"), help="path to EtcTool")
+    parser.add_argument("--output-directory", help="where to write the output (default: next to each input)")
+    parser.add_argument("--report-only", action="store_true", help="do not write any file")
+    parser.add_argument("inputs", nargs="+")
+    arguments = parser.parse_args(argv[1:])
+
+    jobs = []
+    for input_path in arguments.inputs:
+        if input_path.endswith(".plist"):
+            images, fmt, mipmaps = atlas_images(input_path)
+            if fmt not in FORMATS:
+                raise ValueError("%s: unknown TextureFormat %r" % (input_path, fmt))
+            for image in images:
+                jobs.append((image, arguments.format or fmt, mipmaps or arguments.mipmaps))
+        else:
+            jobs.append((input_path, arguments.format or "RGBA8", arguments.mipmaps))
+
+    if arguments.output_directory and not arguments.report_only:
+        os.makedirs(arguments.output_directory, exist_ok=True)
+
+    results = [convert_image(path, fmt, mipmaps, arguments.etc_tool, arguments.report_only,
+                             arguments.output_directory)
+               for path, fmt, mipmaps in jobs]
+
+    print_report(results)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
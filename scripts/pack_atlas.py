@@ -0,0 +1,468 @@
+#!/usr/bin/env python3
+"""
+pack_atlas.py - Packs loose sprite images into a texture atlas: one sheet per
+screen scale (Name.png, Name@2x.png, ...) plus the database DNRTextureAtlas
+loads (Name.plist and, with --compile, Name.atlasdb; see compile_atlas.py).
+
+Usage:
+    pack_atlas.py [options] Name sprite.png ... | directory ...
+
+Sprites are named after their files (without extension or scale suffix). A
+file's scale is taken from its "@2x"/"@3x" suffix, and defaults to the highest
+of --scales; sheets for lower scales are resampled from it.
+
+Each sprite is trimmed to the bounding box of its non-transparent pixels (the
+database records the original size and offset, so sprites still position as
+if untrimmed), and placed with the MaxRects algorithm (best short side fit),
+turned 90 degrees clockwise when that fits better. Layout is done in points,
+so the same database is valid for all the sheets. Sprites whose trimmed
+rectangle is fully opaque are flagged "Opaque", and rendered in the
+depth-tested opaque pass.
+
+Options:
+    --scales 1,2,3          Sheets to produce (default: 1,2)
+    --padding N             Points between sprites (default: 2)
+    --max-size N            Largest sheet side, in pixels at the highest
+                            scale (default: 4096)
+    --power-of-two          Do not crop the sheets to the packed area
+    --no-rotation           Never turn sprites
+    --no-trim               Keep the transparent borders
+    --texture-format F      Hints for convert_textures.py ("TextureFormat"
+    --mipmaps               and "Mipmaps" keys of the property list)
+    --compile               Also write the compiled database
+    --output-dir DIR        Default: current directory
+"""
+
+import argparse
+import math
+import os
+import plistlib
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import compile_atlas                                        # noqa: E402
+from convert_textures import FORMATS, read_png, write_png   # noqa: E402
+
+
+SCALE_SUFFIX = re.compile(r"^(.*)@(\d+)x$")
+
+
+# .............................................................................
+# Sprites
+
+class Sprite(object):
+    """A source image, trimmed (all geometry in points, top left origin)."""
+
+    def __init__(self, path, name, scale, width, height, pixels):
+        self.path = path
+        self.name = name
+        self.scale = scale              # Pixels per point of the source file
+        self.pixel_width = width
+        self.pixel_height = height
+        self.pixels = pixels            # Straight (not premultiplied) RGBA
+
+        self.source_width = int(math.ceil(width / float(scale)))
+        self.source_height = int(math.ceil(height / float(scale)))
+
+        # Trimmed rectangle, within the source size
+        self.trim_x, self.trim_y = 0, 0
+        self.width, self.height = self.source_width, self.source_height
+
+        self.opaque = False
+
+        # Placement in the sheet
+        self.x, self.y = 0, 0
+        self.rotated = False
+
+    def alpha_bounds(self):
+        """Bounding box (x0, y0, x1, y1) of the visible pixels, or None."""
+
+        alpha = self.pixels[3::4]
+        width = self.pixel_width
+        rows = [y for y in range(self.pixel_height) if any(alpha[y * width:(y + 1) * width])]
+
+        if not rows:
+            return None
+
+        y0, y1 = rows[0], rows[-1] + 1
+        x0, x1 = width, 0
+
+        for y in range(y0, y1):
+            row = alpha[y * width:(y + 1) * width]
+            if not any(row):
+                continue
+            left = next(i for i, a in enumerate(row) if a)
+            right = width - next(i for i, a in enumerate(reversed(row)) if a)
+            x0, x1 = min(x0, left), max(x1, right)
+
+        return x0, y0, x1, y1
+
+    def trim(self):
+        bounds = self.alpha_bounds()
+
+        if bounds is None:
+            # (Fully transparent: keep a single point)
+            self.width, self.height = 1, 1
+            return
+
+        x0, y0, x1, y1 = bounds
+        scale = float(self.scale)
+
+        # Round outwards to whole points
+        self.trim_x = int(x0 // scale)
+        self.trim_y = int(y0 // scale)
+        self.width = int(math.ceil(x1 / scale)) - self.trim_x
+        self.height = int(math.ceil(y1 / scale)) - self.trim_y
+
+    def detect_opacity(self):
+        # Opaque if every pixel of the trimmed rectangle is (including any
+        # part that falls outside the source image, which is transparent)
+        x0, y0 = self.trim_x * self.scale, self.trim_y * self.scale
+        x1, y1 = x0 + self.width * self.scale, y0 + self.height * self.scale
+
+        if x1 > self.pixel_width or y1 > self.pixel_height:
+            self.opaque = False
+            return
+
+        stride = self.pixel_width * 4
+        self.opaque = all(
+            all(alpha == 255 for alpha in self.pixels[y * stride + x0 * 4 + 3:y * stride + x1 * 4:4])
+            for y in range(y0, y1))
+
+
+def sprite_files(inputs):
+    for input_path in inputs:
+        if os.path.isdir(input_path):
+            for directory, _, files in sorted(os.walk(input_path)):
+                for file_name in sorted(files):
+                    if file_name.lower().endswith(".png"):
+                        yield os.path.join(directory, file_name)
+        else:
+            yield input_path
+
+
+def load_sprites(inputs, default_scale):
+    sprites = {}
+
+    for path in sprite_files(inputs):
+        stem = os.path.splitext(os.path.basename(path))[0]
+        match = SCALE_SUFFIX.match(stem)
+        name, scale = (match.group(1), int(match.group(2))) if match else (stem, default_scale)
+
+        if name in sprites:
+            raise ValueError("%s: duplicate sprite name %r (also %s)" % (path, name, sprites[name].path))
+
+        width, height, pixels = read_png(path)
+        sprites[name] = Sprite(path, name, scale, width, height, pixels)
+
+    return [sprites[name] for name in sorted(sprites)]
+
+
+# .............................................................................
+# MaxRects packing
+
+class MaxRectsBin(object):
+    """
+    Keeps the list of maximal free rectangles: placing a rectangle splits
+    every free rectangle it overlaps into up to four (possibly overlapping)
+    maximal ones, and free rectangles contained in others are pruned.
+    """
+
+    def __init__(self, width, height):
+        self.width = width
+        self.height = height
+        self.free = [(0, 0, width, height)]
+
+    def find_position(self, width, height, allow_rotation):
+        """Best short side fit: (x, y, rotated), or None."""
+
+        best = None
+        best_score = None
+
+        for free_x, free_y, free_width, free_height in self.free:
+            for w, h, rotated in ((width, height, False), (height, width, True)):
+                if rotated and (not allow_rotation or width == height):
+                    continue
+                if w > free_width or h > free_height:
+                    continue
+                leftover_x, leftover_y = free_width - w, free_height - h
+                score = (min(leftover_x, leftover_y), max(leftover_x, leftover_y))
+                if best_score is None or score < best_score:
+                    best_score = score
+                    best = (free_x, free_y, rotated)
+
+        return best
+
+    def place(self, x, y, width, height):
+        new_free = []
+
+        for free in self.free:
+            free_x, free_y, free_width, free_height = free
+
+            if (x >= free_x + free_width or x + width <= free_x
+                    or y >= free_y + free_height or y + height <= free_y):
+                new_free.append(free)
+                continue
+
+            if x > free_x:
+                new_free.append((free_x, free_y, x - free_x, free_height))
+            if x + width < free_x + free_width:
+                new_free.append((x + width, free_y, free_x + free_width - x - width, free_height))
+            if y > free_y:
+                new_free.append((free_x, free_y, free_width, y - free_y))
+            if y + height < free_y + free_height:
+                new_free.append((free_x, y + height, free_width, free_y + free_height - y - height))
+
+        self.free = [rect for i, rect in enumerate(new_free)
+                     if not any(j != i and contains(other, rect) and (other != rect or j < i)
+                                for j, other in enumerate(new_free))]
+
+
+def contains(outer, inner):
+    return (inner[0] >= outer[0] and inner[1] >= outer[1]
+            and inner[0] + inner[2] <= outer[0] + outer[2]
+            and inner[1] + inner[3] <= outer[1] + outer[3])
+
+
+def pack(sprites, width, height, padding, allow_rotation):
+    """Places all sprites in a width x height bin, or returns False."""
+
+    bin_ = MaxRectsBin(width + padding, height + padding)
+
+    # (Largest first)
+    order = sorted(sprites, key=lambda s: (max(s.width, s.height), s.width * s.height), reverse=True)
+
+    for sprite in order:
+        position = bin_.find_position(sprite.width + padding, sprite.height + padding, allow_rotation)
+        if position is None:
+            return False
+
+        sprite.x, sprite.y, sprite.rotated = position
+
+        if sprite.rotated:
+            bin_.place(sprite.x, sprite.y, sprite.height + padding, sprite.width + padding)
+        else:
+            bin_.place(sprite.x, sprite.y, sprite.width + padding, sprite.height + padding)
+
+    return True
+
+
+def pack_smallest(sprites, padding, max_side, allow_rotation):
+    """Packs into the smallest power of two sheet (in points) that fits."""
+
+    area = sum((s.width + padding) * (s.height + padding) for s in sprites)
+    widest = max(max(s.width, s.height) if allow_rotation else s.width for s in sprites)
+    tallest = max(min(s.width, s.height) if allow_rotation else s.height for s in sprites)
+
+    sides = [1 << i for i in range(0, 16) if (1 << i) <= max_side]
+    candidates = sorted(((w, h) for w in sides for h in sides
+                         if w * h >= area and w >= widest and h >= tallest),
+                        key=lambda size: (size[0] * size[1], abs(size[0] - size[1]), size[1]))
+
+    for width, height in candidates:
+        if pack(sprites, width, height, padding, allow_rotation):
+            return width, height
+
+    raise ValueError("sprites do not fit in a %d x %d point sheet; raise --max-size or "
+                     "split the atlas" % (max_side, max_side))
+
+
+# .............................................................................
+# Rendering
+
+def box_weights(source_size, target_size, offset):
+    """
+    For each target pixel, the source pixels it covers and their coverage
+    (box filter; handles both reduction and enlargement). offset is the
+    position of the first target pixel in the source, in target pixels.
+    """
+
+    ratio = source_size / float(target_size)
+    weights = []
+
+    for i in range(target_size):
+        start, end = (offset + i) * ratio, (offset + i + 1) * ratio
+        taps = []
+        for j in range(int(math.floor(start)), int(math.ceil(end))):
+            coverage = min(end, j + 1) - max(start, j)
+            if coverage > 0:
+                taps.append((j, coverage))
+        weights.append(taps)
+
+    return weights
+
+
+def render_sprite(sprite, scale):
+    """Trimmed image of the sprite at the given scale: (width, height, RGBA)."""
+
+    width, height = sprite.width * scale, sprite.height * scale
+    source_scale = sprite.scale
+
+    source = sprite.pixels
+    stride = sprite.pixel_width * 4
+
+    def sample(x, y):
+        if x < 0 or y < 0 or x >= sprite.pixel_width or y >= sprite.pixel_height:
+            return (0, 0, 0, 0)
+        i = y * stride + x * 4
+        return source[i], source[i + 1], source[i + 2], source[i + 3]
+
+    out = bytearray(width * height * 4)
+
+    if source_scale == scale:
+        # Same resolution: copy the rows (the trimmed rectangle can extend
+        # past the image's right and bottom edges, by less than a point)
+        x0, y0 = sprite.trim_x * scale, sprite.trim_y * scale
+        columns = min(width, sprite.pixel_width - x0)
+        for y in range(min(height, sprite.pixel_height - y0)):
+            start = (y0 + y) * stride + x0 * 4
+            out[y * width * 4:y * width * 4 + columns * 4] = source[start:start + columns * 4]
+        return width, height, out
+
+    # Different resolution: box filter, weighted by alpha (i.e., in
+    # premultiplied space, so transparent pixels do not darken the edges)
+    columns = box_weights(sprite.source_width * source_scale, sprite.source_width * scale, sprite.trim_x * scale)
+    rows = box_weights(sprite.source_height * source_scale, sprite.source_height * scale, sprite.trim_y * scale)
+
+    for y, row_taps in enumerate(rows[:height]):
+        for x, column_taps in enumerate(columns[:width]):
+            r = g = b = a = total = 0.0
+            for sy, wy in row_taps:
+                for sx, wx in column_taps:
+                    weight = wx * wy
+                    pr, pg, pb, pa = sample(sx, sy)
+                    r += pr * pa * weight
+                    g += pg * pa * weight
+                    b += pb * pa * weight
+                    a += pa * weight
+                    total += weight
+            i = (y * width + x) * 4
+            if a > 0:
+                out[i:i + 4] = bytes((int(r / a + 0.5), int(g / a + 0.5), int(b / a + 0.5),
+                                      min(255, int(a / total + 0.5))))
+
+    return width, height, out
+
+
+def render_sheet(sprites, sheet_width, sheet_height, scale):
+    width, height = sheet_width * scale, sheet_height * scale
+    sheet = bytearray(width * height * 4)
+
+    for sprite in sprites:
+        sprite_width, sprite_height, pixels = render_sprite(sprite, scale)
+        left, top = sprite.x * scale, sprite.y * scale
+
+        if not sprite.rotated:
+            for y in range(sprite_height):
+                start = ((top + y) * width + left) * 4
+                sheet[start:start + sprite_width * 4] = pixels[y * sprite_width * 4:(y + 1) * sprite_width * 4]
+            continue
+
+        # Turned 90 degrees clockwise: sprite pixel (u, v) goes to
+        # (sprite_height - 1 - v, u) within the placed region
+        for v in range(sprite_height):
+            for u in range(sprite_width):
+                source = (v * sprite_width + u) * 4
+                target = ((top + u) * width + left + sprite_height - 1 - v) * 4
+                sheet[target:target + 4] = pixels[source:source + 4]
+
+    return width, height, sheet
+
+
+# .............................................................................
+# Database
+
+def database(name, sprites, texture_format, mipmaps):
+    entries = {}
+
+    for sprite in sprites:
+        entry = {"Rectangle": "{{%d,%d},{%d,%d}}" % (sprite.x, sprite.y, sprite.width, sprite.height)}
+
+        if (sprite.width, sprite.height) != (sprite.source_width, sprite.source_height):
+            entry["SourceSize"] = "{%d,%d}" % (sprite.source_width, sprite.source_height)
+            entry["TrimOffset"] = "{%d,%d}" % (sprite.trim_x, sprite.trim_y)
+        if sprite.rotated:
+            entry["Rotated"] = True
+        if sprite.opaque:
+            entry["Opaque"] = True
+
+        entries[sprite.name] = entry
+
+    atlas = {"ImageName": name, "Database": entries}
+
+    if texture_format:
+        atlas["TextureFormat"] = texture_format
+    if mipmaps:
+        atlas["Mipmaps"] = True
+
+    return atlas
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("--scales", default="1,2")
+    parser.add_argument("--padding", type=int, default=2)
+    parser.add_argument("--max-size", type=int, default=4096)
+    parser.add_argument("--power-of-two", action="store_true")
+    parser.add_argument("--no-rotation", action="store_true")
+    parser.add_argument("--no-trim", action="store_true")
+    parser.add_argument("--texture-format", choices=FORMATS)
+    parser.add_argument("--mipmaps", action="store_true")
+    parser.add_argument("--compile", action="store_true")
+    parser.add_argument("--output-dir", default=".")
+    parser.add_argument("name")
+    parser.add_argument("inputs", nargs="+")
+    arguments = parser.parse_args(argv[1:])
+
+    scales = sorted(set(int(scale) for scale in arguments.scales.split(",")))
+    sprites = load_sprites(arguments.inputs, scales[-1])
+
+    if not sprites:
+        sys.stderr.write("No sprites found.\n")
+        return 1
+
+    for sprite in sprites:
+        if not arguments.no_trim:
+            sprite.trim()
+        sprite.detect_opacity()
+
+    sheet_width, sheet_height = pack_smallest(sprites, arguments.padding,
+                                              arguments.max_size // scales[-1],
+                                              not arguments.no_rotation)
+
+    if not arguments.power_of_two:
+        # (Crop to the packed area)
+        sheet_width = max(s.x + (s.height if s.rotated else s.width) for s in sprites)
+        sheet_height = max(s.y + (s.width if s.rotated else s.height) for s in sprites)
+
+    if not os.path.isdir(arguments.output_dir):
+        os.makedirs(arguments.output_dir)
+
+    for scale in scales:
+        width, height, sheet = render_sheet(sprites, sheet_width, sheet_height, scale)
+        suffix = "@%dx" % scale if scale > 1 else ""
+        sheet_path = os.path.join(arguments.output_dir, arguments.name + suffix + ".png")
+        write_png(sheet_path, width, height, sheet)
+        print("%s: %d x %d" % (sheet_path, width, height))
+
+    atlas = database(arguments.name, sprites, arguments.texture_format, arguments.mipmaps)
+
+    plist_path = os.path.join(arguments.output_dir, arguments.name + ".plist")
+    with open(plist_path, "wb") as plist_file:
+        plistlib.dump(atlas, plist_file)
+
+    if arguments.compile:
+        with open(os.path.join(arguments.output_dir, arguments.name + ".atlasdb"), "wb") as compiled_file:
+            compiled_file.write(compile_atlas.compile_atlas(atlas))
+
+    used = sum(s.width * s.height for s in sprites)
+    print("%s: %d sprites (%d rotated, %d opaque) in %d x %d points, %.0f%% used" % (
+        plist_path, len(sprites), sum(s.rotated for s in sprites), sum(s.opaque for s in sprites),
+        sheet_width, sheet_height, 100.0 * used / (sheet_width * sheet_height)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))